@@ -0,0 +1,160 @@
+#ifndef GRAPHICS_A_STAR
+#define GRAPHICS_A_STAR
+
+#include "PathGrid.hpp"
+#include <algorithm>
+
+// A* path finder on a PathGrid
+// The open cells are in an indexed binary heap, so a cheaper way to a cell lowers its key in place instead of adding it again.
+// The state of the cells is kept in flat arrays between the searches, each search only uses the cells stamped with its generation,
+// so starting one doesn't have to reset the whole grid
+class AStarPathfinder {
+public:
+	// Work done by the last search
+	struct Stats {
+		// Cells taken from the heap and the ones added to it
+		unsigned long long expanded = 0;
+		unsigned long long pushed = 0;
+		// Cheaper ways found to the cells already in the heap
+		unsigned long long decreased = 0;
+	};
+
+	PathConnectivity connectivity = PathConnectivity::Four;
+	// Multiplies the heuristic, above 1 fewer cells are expanded but the path can be up to that many times longer than the shortest one
+	float heuristicWeight = 1.0f;
+
+private:
+	// Cost of the cheapest way found to the cells and the cells they were reached from
+	std::vector<PathCost> costs;
+	std::vector<int> parents;
+	// Search the cells were last reached in, the cell is open when it's the current generation and expanded when it's one more
+	std::vector<unsigned int> generations;
+	unsigned int generation = 0;
+	PathHeap open;
+	// Grid, goal and result of the last search
+	int gridWidth = 0;
+	int goalCell = -1;
+	vec2<int> goal;
+	PathCost pathCost = pathNoCost;
+	Stats stats;
+
+	// Estimated cost from the cell to the goal
+	PathCost estimate(_In_ int x, _In_ int y) const {
+		PathCost heuristic = pathHeuristic(vec2<int>(x, y), goal, connectivity);
+		return heuristicWeight == 1.0f ? heuristic : (PathCost)((float)heuristic * heuristicWeight);
+	}
+
+	// Reaches the neighbour (x, y) from the cell with the cost
+	void relax(_In_ int cell, _In_ int x, _In_ int y, _In_ PathCost cost) {
+		int neighbour = y * gridWidth + x;
+		unsigned int state = generations[neighbour];
+		// Expanded cells already have their cheapest cost
+		if (state == generation + 1) return;
+		if (state != generation) {
+			generations[neighbour] = generation;
+			costs[neighbour] = cost;
+			parents[neighbour] = cell;
+			open.push(neighbour, pathKey(cost + estimate(x, y), cost));
+			stats.pushed++;
+		}
+		else if (cost < costs[neighbour]) {
+			costs[neighbour] = cost;
+			parents[neighbour] = cell;
+			open.decrease(neighbour, pathKey(cost + estimate(x, y), cost));
+			stats.decreased++;
+		}
+	}
+
+	// Starts a search on the grid, the arrays are only cleared when the grid changes size or the generations run out
+	void begin(_In_ const PathGrid& grid) {
+		int cellCount = grid.size();
+		if ((int)generations.size() != cellCount || generation >= 0xFFFFFFF0u) {
+			costs.assign(cellCount, pathNoCost);
+			parents.assign(cellCount, -1);
+			generations.assign(cellCount, 0);
+			generation = 0;
+		}
+		generation += 2;
+		gridWidth = grid.width;
+		open.reset(cellCount);
+		stats = Stats();
+		pathCost = pathNoCost;
+	}
+
+public:
+	// Finds the cheapest path between the cells, returns false if there is none
+	bool findPath(_In_ const PathGrid& grid, _In_ vec2<int> start, _In_ vec2<int> target) {
+		begin(grid);
+		goalCell = -1;
+		if (!grid.isOpen(start.x, start.y) || !grid.isOpen(target.x, target.y)) return false;
+		int startCell = grid.index(start.x, start.y);
+		goalCell = grid.index(target.x, target.y);
+		goal = target;
+
+		generations[startCell] = generation;
+		costs[startCell] = 0;
+		parents[startCell] = -1;
+		open.push(startCell, pathKey(estimate(start.x, start.y), 0));
+		stats.pushed++;
+		bool diagonals = connectivity == PathConnectivity::Eight;
+		while (!open.empty()) {
+			int cell = open.pop();
+			generations[cell] = generation + 1;
+			stats.expanded++;
+			if (cell == goalCell) {
+				pathCost = costs[cell];
+				return true;
+			}
+			int x = cell % gridWidth;
+			int y = cell / gridWidth;
+			PathCost straight = costs[cell] + pathStraightCost;
+			bool left = grid.isOpen(x - 1, y);
+			bool right = grid.isOpen(x + 1, y);
+			bool up = grid.isOpen(x, y - 1);
+			bool down = grid.isOpen(x, y + 1);
+			if (left) relax(cell, x - 1, y, straight);
+			if (right) relax(cell, x + 1, y, straight);
+			if (up) relax(cell, x, y - 1, straight);
+			if (down) relax(cell, x, y + 1, straight);
+			if (!diagonals) continue;
+			// Diagonal steps need both of the cells next to them open
+			PathCost diagonal = costs[cell] + pathDiagonalCost;
+			if (left && up && grid.isOpen(x - 1, y - 1)) relax(cell, x - 1, y - 1, diagonal);
+			if (right && up && grid.isOpen(x + 1, y - 1)) relax(cell, x + 1, y - 1, diagonal);
+			if (left && down && grid.isOpen(x - 1, y + 1)) relax(cell, x - 1, y + 1, diagonal);
+			if (right && down && grid.isOpen(x + 1, y + 1)) relax(cell, x + 1, y + 1, diagonal);
+		}
+		return false;
+	}
+
+	// Cost of the path found by the last search, pathNoCost if there was none
+	PathCost getCost() const {
+		return pathCost;
+	}
+
+	// Cells of the path found by the last search from the start to the goal, empty if there was none
+	void getPath(_Out_ std::vector<vec2<int>>& path) const {
+		path.clear();
+		if (pathCost == pathNoCost) return;
+		for (int cell = goalCell; cell != -1; cell = parents[cell])
+			path.push_back(vec2<int>(cell % gridWidth, cell / gridWidth));
+		std::reverse(path.begin(), path.end());
+	}
+
+	// If the last search expanded the cell
+	bool isExpanded(_In_ int x, _In_ int y) const {
+		return !generations.empty() && generations[(size_t)y * gridWidth + x] == generation + 1;
+	}
+
+	// Work done by the last search
+	Stats getStats() const {
+		return stats;
+	}
+
+	// Bytes used by the state of the cells and the heap
+	size_t memoryUsage() const {
+		return costs.capacity() * sizeof(PathCost) + parents.capacity() * sizeof(int) + generations.capacity() * sizeof(unsigned int) + open.memoryUsage();
+	}
+};
+
+#endif // !GRAPHICS_A_STAR
@@ -0,0 +1,203 @@
+#ifndef GRAPHICS_BEZIER
+#define GRAPHICS_BEZIER
+
+#include "Platform.hpp"
+#include "Geometry.hpp"
+#include <cmath>
+#include <vector>
+
+// Maximum distance (in pixels) between a flattened curve and the real one
+const float bezierTolerance = 0.25f;
+// Upper limit of segments of a single flattened curve
+const int bezierMaxSegments = 1024;
+
+// Number of line segments keeping the polyline within the tolerance of the curve (Wang's formula)
+// x and y hold degree + 1 control points, stride is the distance between the consecutive control points
+inline int bezierSegmentCount(_In_ const float* x, _In_ const float* y, _In_ int degree, _In_opt_ int stride = 1) {
+	// Biggest second difference of the control points
+	float maxSq = 0.0f;
+	for (int i = 0; i + 2 <= degree; i++) {
+		float ddx = x[i * stride] - 2.0f * x[(i + 1) * stride] + x[(i + 2) * stride];
+		float ddy = y[i * stride] - 2.0f * y[(i + 1) * stride] + y[(i + 2) * stride];
+		float sq = ddx * ddx + ddy * ddy;
+		if (sq > maxSq) maxSq = sq;
+	}
+	float segments = ceilf(sqrtf((float)(degree * (degree - 1)) / 8.0f * sqrtf(maxSq) / bezierTolerance));
+	if (segments < 1.0f) return 1;
+	if (segments > (float)bezierMaxSegments) return bezierMaxSegments;
+	return (int)segments;
+}
+
+// Point of the curve at t, rounded to the nearest pixel
+inline vec2<int> bezierPoint(_In_ const float* x, _In_ const float* y, _In_ int degree, _In_ float t, _In_opt_ int stride = 1) {
+	float mt = 1.0f - t;
+	float px, py;
+	if (degree == 2) {
+		float a = mt * mt, b = 2.0f * (mt * t), c = t * t;
+		px = a * x[0] + b * x[stride] + c * x[2 * stride];
+		py = a * y[0] + b * y[stride] + c * y[2 * stride];
+	}
+	else {
+		float mt2 = mt * mt, t2 = t * t;
+		float a = mt2 * mt, b = 3.0f * (mt2 * t), c = 3.0f * (mt * t2), d = t2 * t;
+		px = a * x[0] + b * x[stride] + c * x[2 * stride] + d * x[3 * stride];
+		py = a * y[0] + b * y[stride] + c * y[2 * stride] + d * y[3 * stride];
+	}
+	return vec2<int>((int)lrintf(px), (int)lrintf(py));
+}
+
+// Flattens a single curve into segments + 1 points
+inline void flattenBezier(_In_ const float* x, _In_ const float* y, _In_ int degree, _In_ int segments, _Out_ vec2<int>* points, _In_opt_ int stride = 1) {
+	float step = 1.0f / (float)segments;
+	for (int k = 0; k <= segments; k++)
+		points[k] = bezierPoint(x, y, degree, k == segments ? 1.0f : (float)k * step, stride);
+}
+
+#ifdef GRAPHICS_SSE2
+// Flattens 4 curves at once, each lane evaluates a different curve
+// x[i * count] and y[i * count] are the i-th control points of the first curve
+inline void flattenBezier4SSE2(_In_ const float* x, _In_ const float* y, _In_ int count, _In_ int degree,
+	_In_ const int* segments, _In_ const int* offsets, _Out_ vec2<int>* points) {
+	__m128 px[4], py[4];
+	for (int i = 0; i <= degree; i++) {
+		px[i] = _mm_loadu_ps(x + i * count);
+		py[i] = _mm_loadu_ps(y + i * count);
+	}
+	__m128i laneSegments = _mm_loadu_si128((const __m128i*)segments);
+	__m128 step = _mm_div_ps(_mm_set1_ps(1.0f), _mm_cvtepi32_ps(laneSegments));
+	int maxSegments = segments[0];
+	for (int lane = 1; lane < 4; lane++)
+		if (segments[lane] > maxSegments) maxSegments = segments[lane];
+
+	__m128 one = _mm_set1_ps(1.0f);
+	alignas(16) int outX[4], outY[4];
+	for (int k = 0; k <= maxSegments; k++) {
+		// The last point of every lane is exactly t = 1
+		__m128 t = _mm_mul_ps(_mm_set1_ps((float)k), step);
+		__m128 end = _mm_castsi128_ps(_mm_cmpgt_epi32(_mm_set1_epi32(k), _mm_sub_epi32(laneSegments, _mm_set1_epi32(1))));
+		t = _mm_or_ps(_mm_and_ps(end, one), _mm_andnot_ps(end, t));
+		__m128 mt = _mm_sub_ps(one, t);
+		__m128 resultX, resultY;
+		if (degree == 2) {
+			__m128 a = _mm_mul_ps(mt, mt);
+			__m128 b = _mm_mul_ps(_mm_set1_ps(2.0f), _mm_mul_ps(mt, t));
+			__m128 c = _mm_mul_ps(t, t);
+			resultX = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a, px[0]), _mm_mul_ps(b, px[1])), _mm_mul_ps(c, px[2]));
+			resultY = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a, py[0]), _mm_mul_ps(b, py[1])), _mm_mul_ps(c, py[2]));
+		}
+		else {
+			__m128 mt2 = _mm_mul_ps(mt, mt);
+			__m128 t2 = _mm_mul_ps(t, t);
+			__m128 a = _mm_mul_ps(mt2, mt);
+			__m128 b = _mm_mul_ps(_mm_set1_ps(3.0f), _mm_mul_ps(mt2, t));
+			__m128 c = _mm_mul_ps(_mm_set1_ps(3.0f), _mm_mul_ps(mt, t2));
+			__m128 d = _mm_mul_ps(t2, t);
+			resultX = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(a, px[0]), _mm_mul_ps(b, px[1])), _mm_mul_ps(c, px[2])), _mm_mul_ps(d, px[3]));
+			resultY = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(a, py[0]), _mm_mul_ps(b, py[1])), _mm_mul_ps(c, py[2])), _mm_mul_ps(d, py[3]));
+		}
+		_mm_store_si128((__m128i*)outX, _mm_cvtps_epi32(resultX));
+		_mm_store_si128((__m128i*)outY, _mm_cvtps_epi32(resultY));
+		for (int lane = 0; lane < 4; lane++)
+			if (k <= segments[lane])
+				points[offsets[lane] + k] = vec2<int>(outX[lane], outY[lane]);
+	}
+}
+
+// Flattens 8 curves at once, each lane evaluates a different curve
+GRAPHICS_TARGET_AVX2 inline void flattenBezier8AVX2(_In_ const float* x, _In_ const float* y, _In_ int count, _In_ int degree,
+	_In_ const int* segments, _In_ const int* offsets, _Out_ vec2<int>* points) {
+	__m256 px[4], py[4];
+	for (int i = 0; i <= degree; i++) {
+		px[i] = _mm256_loadu_ps(x + i * count);
+		py[i] = _mm256_loadu_ps(y + i * count);
+	}
+	__m256i laneSegments = _mm256_loadu_si256((const __m256i*)segments);
+	__m256 step = _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_cvtepi32_ps(laneSegments));
+	int maxSegments = segments[0];
+	for (int lane = 1; lane < 8; lane++)
+		if (segments[lane] > maxSegments) maxSegments = segments[lane];
+
+	__m256 one = _mm256_set1_ps(1.0f);
+	alignas(32) int outX[8], outY[8];
+	for (int k = 0; k <= maxSegments; k++) {
+		// The last point of every lane is exactly t = 1
+		__m256 t = _mm256_mul_ps(_mm256_set1_ps((float)k), step);
+		t = _mm256_blendv_ps(t, one, _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(k), _mm256_sub_epi32(laneSegments, _mm256_set1_epi32(1)))));
+		__m256 mt = _mm256_sub_ps(one, t);
+		__m256 resultX, resultY;
+		if (degree == 2) {
+			__m256 a = _mm256_mul_ps(mt, mt);
+			__m256 b = _mm256_mul_ps(_mm256_set1_ps(2.0f), _mm256_mul_ps(mt, t));
+			__m256 c = _mm256_mul_ps(t, t);
+			resultX = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(a, px[0]), _mm256_mul_ps(b, px[1])), _mm256_mul_ps(c, px[2]));
+			resultY = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(a, py[0]), _mm256_mul_ps(b, py[1])), _mm256_mul_ps(c, py[2]));
+		}
+		else {
+			__m256 mt2 = _mm256_mul_ps(mt, mt);
+			__m256 t2 = _mm256_mul_ps(t, t);
+			__m256 a = _mm256_mul_ps(mt2, mt);
+			__m256 b = _mm256_mul_ps(_mm256_set1_ps(3.0f), _mm256_mul_ps(mt2, t));
+			__m256 c = _mm256_mul_ps(_mm256_set1_ps(3.0f), _mm256_mul_ps(mt, t2));
+			__m256 d = _mm256_mul_ps(t2, t);
+			resultX = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(a, px[0]), _mm256_mul_ps(b, px[1])), _mm256_mul_ps(c, px[2])), _mm256_mul_ps(d, px[3]));
+			resultY = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(a, py[0]), _mm256_mul_ps(b, py[1])), _mm256_mul_ps(c, py[2])), _mm256_mul_ps(d, py[3]));
+		}
+		_mm256_store_si256((__m256i*)outX, _mm256_cvtps_epi32(resultX));
+		_mm256_store_si256((__m256i*)outY, _mm256_cvtps_epi32(resultY));
+		for (int lane = 0; lane < 8; lane++)
+			if (k <= segments[lane])
+				points[offsets[lane] + k] = vec2<int>(outX[lane], outY[lane]);
+	}
+}
+#endif
+
+// Flattens many curves of the same degree (2 or 3) at once, the buffers are reused between the batches
+class BezierBatch {
+public:
+	// Control points in the SoA layout: x[i * count + curve] is the i-th control point of the curve
+	std::vector<float> x;
+	std::vector<float> y;
+	// Number of segments of each curve
+	std::vector<int> segments;
+	// Index of the first point of each curve, the last one is the total number of points
+	std::vector<int> offsets;
+	// Flattened polylines of all of the curves
+	std::vector<vec2<int>> points;
+	// Number of curves in the batch
+	int count = 0;
+
+	// Flattens the curves, controlPoints holds degree + 1 points per curve
+	void flatten(_In_ const vec2<int>* controlPoints, _In_ int curveCount, _In_ int degree) {
+		count = curveCount > 0 ? curveCount : 0;
+		size_t total = (size_t)count * (degree + 1);
+		x.resize(total);
+		y.resize(total);
+		for (int curve = 0; curve < count; curve++)
+			for (int i = 0; i <= degree; i++) {
+				x[i * count + curve] = (float)controlPoints[curve * (degree + 1) + i].x;
+				y[i * count + curve] = (float)controlPoints[curve * (degree + 1) + i].y;
+			}
+
+		segments.resize(count);
+		offsets.resize((size_t)count + 1);
+		offsets[0] = 0;
+		for (int curve = 0; curve < count; curve++) {
+			segments[curve] = bezierSegmentCount(&x[curve], &y[curve], degree, count);
+			offsets[curve + 1] = offsets[curve] + segments[curve] + 1;
+		}
+		points.resize(offsets[count]);
+
+		int curve = 0;
+#ifdef GRAPHICS_SSE2
+		if (cpuHasAVX2())
+			for (; curve + 8 <= count; curve += 8)
+				flattenBezier8AVX2(&x[curve], &y[curve], count, degree, &segments[curve], &offsets[curve], points.data());
+		for (; curve + 4 <= count; curve += 4)
+			flattenBezier4SSE2(&x[curve], &y[curve], count, degree, &segments[curve], &offsets[curve], points.data());
+#endif
+		for (; curve < count; curve++)
+			flattenBezier(&x[curve], &y[curve], degree, segments[curve], &points[offsets[curve]], count);
+	}
+};
+
+#endif // !GRAPHICS_BEZIER
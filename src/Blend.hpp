@@ -0,0 +1,235 @@
+#ifndef GRAPHICS_BLEND
+#define GRAPHICS_BLEND
+
+#include "Platform.hpp"
+#include <cstring>
+#include <cmath>
+
+// Blends the color over the destination pixel with the coverage (0 - 255)
+inline UINT32 blendColor(_In_ UINT32 destination, _In_ UINT32 color, _In_ unsigned int coverage) {
+	// Map 255 to 256 so that full coverage gives exactly the color
+	unsigned int alpha = coverage + (coverage >> 7);
+	// Red and blue are blended together, green separately
+	UINT32 redBlue = (((color & 0xFF00FF) * alpha + (destination & 0xFF00FF) * (256 - alpha)) >> 8) & 0xFF00FF;
+	UINT32 green = (((color & 0x00FF00) * alpha + (destination & 0x00FF00) * (256 - alpha)) >> 8) & 0x00FF00;
+	return redBlue | green;
+}
+
+// Blends the color over count pixels starting at pixel, each one with its own coverage (0 - 255)
+typedef void (*BlendSpanFunction)(UINT32* pixel, const unsigned char* coverage, size_t count, UINT32 color);
+
+// Scalar fallback
+inline void blendSpanScalar(_In_ UINT32* pixel, _In_ const unsigned char* coverage, _In_ size_t count, _In_ UINT32 color) {
+	for (size_t i = 0; i < count; i++) {
+		unsigned int value = coverage[i];
+		if (value == 255)
+			pixel[i] = color;
+		else if (value != 0)
+			pixel[i] = blendColor(pixel[i], color, value);
+	}
+}
+
+#ifdef GRAPHICS_SSE2
+// Blends 2 pixels per register, channels (and the coverage mapped to 0 - 256) are widened to 16 bits
+// color * alpha + destination * (256 - alpha) is at most 255 * 256 so it doesn't overflow,
+// giving exactly the same pixels as blendColor (the unused top bytes of the pixels stay 0)
+inline __m128i blendPixelsSSE2(_In_ __m128i destination, _In_ __m128i color, _In_ __m128i alpha) {
+	__m128i inverse = _mm_sub_epi16(_mm_set1_epi16(256), alpha);
+	return _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(color, alpha), _mm_mullo_epi16(destination, inverse)), 8);
+}
+
+// 1 - 3 pixels, loaded and stored 1 or 2 at a time so the pixels past the span aren't touched
+// Most of the spans along the anti-aliased edges are this short, the scalar loop mispredicts on every coverage
+inline void blendShortSpanSSE2(_In_ UINT32* pixel, _In_ const unsigned char* coverage, _In_ size_t count, _In_ UINT32 color) {
+	const __m128i zero = _mm_setzero_si128();
+	__m128i colorWide = _mm_unpacklo_epi8(_mm_set1_epi32((int)color), zero);
+	unsigned int packed = coverage[0];
+	__m128i destination;
+	if (count == 1)
+		destination = _mm_cvtsi32_si128((int)pixel[0]);
+	else {
+		packed |= (unsigned int)coverage[1] << 8;
+		destination = _mm_loadl_epi64((const __m128i*)pixel);
+		if (count == 3) {
+			packed |= (unsigned int)coverage[2] << 16;
+			destination = _mm_unpacklo_epi64(destination, _mm_cvtsi32_si128((int)pixel[2]));
+		}
+	}
+	// Coverage 0 blends the pixel with itself, it stays the same
+	__m128i alpha = _mm_unpacklo_epi8(_mm_cvtsi32_si128((int)packed), zero);
+	alpha = _mm_add_epi16(alpha, _mm_srli_epi16(alpha, 7));
+	alpha = _mm_unpacklo_epi16(alpha, alpha);
+	__m128i low = blendPixelsSSE2(_mm_unpacklo_epi8(destination, zero), colorWide, _mm_unpacklo_epi32(alpha, alpha));
+	__m128i high = blendPixelsSSE2(_mm_unpackhi_epi8(destination, zero), colorWide, _mm_unpackhi_epi32(alpha, alpha));
+	__m128i result = _mm_packus_epi16(low, high);
+	if (count == 1)
+		pixel[0] = (UINT32)_mm_cvtsi128_si32(result);
+	else {
+		_mm_storel_epi64((__m128i*)pixel, result);
+		if (count == 3)
+			pixel[2] = (UINT32)_mm_cvtsi128_si32(_mm_srli_si128(result, 8));
+	}
+}
+
+// 4 pixels per step
+inline void blendSpanSSE2(_In_ UINT32* pixel, _In_ const unsigned char* coverage, _In_ size_t count, _In_ UINT32 color) {
+	const __m128i zero = _mm_setzero_si128();
+	__m128i colorWide = _mm_unpacklo_epi8(_mm_set1_epi32((int)color), zero);
+	for (; count >= 4; count -= 4, pixel += 4, coverage += 4) {
+		int packed;
+		memcpy(&packed, coverage, sizeof(packed));
+		// Fully transparent and fully covered groups are common around the edges
+		if (packed == 0) continue;
+		if (packed == -1) {
+			_mm_storeu_si128((__m128i*)pixel, _mm_set1_epi32((int)color));
+			continue;
+		}
+		// Map 255 to 256 and repeat it for all 4 channels of every pixel
+		__m128i alpha = _mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero);
+		alpha = _mm_add_epi16(alpha, _mm_srli_epi16(alpha, 7));
+		alpha = _mm_unpacklo_epi16(alpha, alpha);
+		__m128i alphaLow = _mm_unpacklo_epi32(alpha, alpha);
+		__m128i alphaHigh = _mm_unpackhi_epi32(alpha, alpha);
+
+		__m128i destination = _mm_loadu_si128((const __m128i*)pixel);
+		__m128i low = blendPixelsSSE2(_mm_unpacklo_epi8(destination, zero), colorWide, alphaLow);
+		__m128i high = blendPixelsSSE2(_mm_unpackhi_epi8(destination, zero), colorWide, alphaHigh);
+		_mm_storeu_si128((__m128i*)pixel, _mm_packus_epi16(low, high));
+	}
+	if (count > 0)
+		blendShortSpanSSE2(pixel, coverage, count, color);
+}
+
+// 8 pixels per step
+GRAPHICS_TARGET_AVX2 inline void blendSpanAVX2(_In_ UINT32* pixel, _In_ const unsigned char* coverage, _In_ size_t count, _In_ UINT32 color) {
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i full = _mm256_set1_epi16(256);
+	__m256i colorWide = _mm256_unpacklo_epi8(_mm256_set1_epi32((int)color), zero);
+	for (; count >= 8; count -= 8, pixel += 8, coverage += 8) {
+		long long packed;
+		memcpy(&packed, coverage, sizeof(packed));
+		if (packed == 0) continue;
+		if (packed == -1) {
+			_mm256_storeu_si256((__m256i*)pixel, _mm256_set1_epi32((int)color));
+			continue;
+		}
+		// Coverage of pixels 0 - 3 ends up in the low lane and 4 - 7 in the high one, like the pixels
+		__m256i alpha = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)coverage));
+		alpha = _mm256_add_epi32(alpha, _mm256_srli_epi32(alpha, 7));
+		alpha = _mm256_packus_epi32(alpha, alpha);
+		alpha = _mm256_unpacklo_epi16(alpha, alpha);
+		__m256i alphaLow = _mm256_unpacklo_epi32(alpha, alpha);
+		__m256i alphaHigh = _mm256_unpackhi_epi32(alpha, alpha);
+
+		__m256i destination = _mm256_loadu_si256((const __m256i*)pixel);
+		__m256i low = _mm256_unpacklo_epi8(destination, zero);
+		__m256i high = _mm256_unpackhi_epi8(destination, zero);
+		low = _mm256_srli_epi16(_mm256_add_epi16(_mm256_mullo_epi16(colorWide, alphaLow), _mm256_mullo_epi16(low, _mm256_sub_epi16(full, alphaLow))), 8);
+		high = _mm256_srli_epi16(_mm256_add_epi16(_mm256_mullo_epi16(colorWide, alphaHigh), _mm256_mullo_epi16(high, _mm256_sub_epi16(full, alphaHigh))), 8);
+		_mm256_storeu_si256((__m256i*)pixel, _mm256_packus_epi16(low, high));
+	}
+	blendSpanSSE2(pixel, coverage, count, color);
+}
+#endif
+
+// Blends the color over 2 pixels anywhere in the frame with their own coverage, the 2 pixels of a step of the Wu's lines
+inline void blendPair(_Inout_ UINT32* first, _Inout_ UINT32* second, _In_ unsigned int firstCoverage, _In_ unsigned int secondCoverage, _In_ UINT32 color) {
+#ifdef GRAPHICS_SSE2
+	// Both pixels are blended in a register like in blendSpanSSE2, loaded before storing so they can be next to each other
+	const __m128i zero = _mm_setzero_si128();
+	__m128i destination = _mm_unpacklo_epi32(_mm_cvtsi32_si128((int)*first), _mm_cvtsi32_si128((int)*second));
+	__m128i alpha = _mm_cvtsi32_si128((int)((firstCoverage + (firstCoverage >> 7)) | (secondCoverage + (secondCoverage >> 7)) << 16));
+	alpha = _mm_unpacklo_epi16(alpha, alpha);
+	alpha = _mm_unpacklo_epi32(alpha, alpha);
+	__m128i colorWide = _mm_unpacklo_epi8(_mm_cvtsi32_si128((int)color), zero);
+	colorWide = _mm_unpacklo_epi64(colorWide, colorWide);
+	__m128i result = _mm_packus_epi16(blendPixelsSSE2(_mm_unpacklo_epi8(destination, zero), colorWide, alpha), zero);
+	*first = (UINT32)_mm_cvtsi128_si32(result);
+	*second = (UINT32)_mm_cvtsi128_si32(_mm_srli_si128(result, 4));
+#else
+	*first = blendColor(*first, color, firstCoverage);
+	*second = blendColor(*second, color, secondCoverage);
+#endif
+}
+
+// Picks the fastest kernel supported by the CPU, selected once on the first use
+inline BlendSpanFunction blendSpanKernel() {
+#ifdef GRAPHICS_SSE2
+	static const BlendSpanFunction kernel = cpuHasAVX2() ? blendSpanAVX2 : blendSpanSSE2;
+	return kernel;
+#else
+	return blendSpanScalar;
+#endif
+}
+
+// Rows ahead whose pixels are prefetched by the anti-aliased edges, they read a new row every pixel or 2 and the loads stall on it
+const int prefetchRows = 4;
+
+// Asks for the cache line of a pixel that's going to be blended
+inline void prefetchPixel(_In_ const void* pixel) {
+#ifdef GRAPHICS_SSE2
+	_mm_prefetch((const char*)pixel, _MM_HINT_T0);
+#else
+	(void)pixel;
+#endif
+}
+
+// Anti-aliased edges up to this many pixels wide are blended a pixel at a time, the longer ones as spans
+const int shortEdgeLength = 4;
+
+// Coverage (0 - 255) of the pixel x next to a straight edge, scale - |x * slope + offset| rounded and clamped like in linearCoverage
+inline unsigned int linearCoverageAt(_In_ int x, _In_ float slope, _In_ float offset, _In_ float scale) {
+	float value = scale - fabsf((float)x * slope + offset);
+#ifdef GRAPHICS_SSE2
+	// Rounds to the nearest even like _mm_cvtps_epi32, the values out of range become INT_MIN and end up 0 in both
+	int rounded = _mm_cvtss_si32(_mm_set_ss(value));
+	return rounded <= 0 ? 0 : rounded >= 255 ? 255 : (unsigned int)rounded;
+#else
+	return value <= 0.0f ? 0 : value >= 255.0f ? 255 : (unsigned int)(value + 0.5f);
+#endif
+}
+
+// Coverage (0 - 255) of count pixels next to a straight edge, pixel x gets scale - |x * slope + offset| rounded and clamped
+// Every pixel is computed on its own, so the coverage doesn't depend on where the span starts
+inline void linearCoverage(_Out_ unsigned char* coverage, _In_ int x, _In_ int count, _In_ float slope, _In_ float offset, _In_ float scale) {
+#ifdef GRAPHICS_SSE2
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+	__m128 slopes = _mm_set1_ps(slope);
+	__m128 offsets = _mm_set1_ps(offset);
+	__m128 scales = _mm_set1_ps(scale);
+	int i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m128 positions = _mm_cvtepi32_ps(_mm_setr_epi32(x + i, x + i + 1, x + i + 2, x + i + 3));
+		__m128 values = _mm_sub_ps(scales, _mm_andnot_ps(signMask, _mm_add_ps(_mm_mul_ps(positions, slopes), offsets)));
+		// Rounds to the nearest, both of the packs saturate so the values end up clamped to 0 - 255
+		__m128i bytes = _mm_cvtps_epi32(values);
+		bytes = _mm_packus_epi16(_mm_packs_epi32(bytes, bytes), bytes);
+		int packed = _mm_cvtsi128_si32(bytes);
+		memcpy(coverage + i, &packed, sizeof(packed));
+	}
+	for (; i < count; i++)
+		coverage[i] = (unsigned char)linearCoverageAt(x + i, slope, offset, scale);
+#else
+	for (int i = 0; i < count; i++)
+		coverage[i] = (unsigned char)linearCoverageAt(x + i, slope, offset, scale);
+#endif
+}
+
+// Blends the color over a span of pixels with the coverage of each one
+// The spans shorter than a step of the AVX2 kernel are blended inline with SSE2
+inline void blendSpan(_In_ UINT32* pixel, _In_ const unsigned char* coverage, _In_ size_t count, _In_ UINT32 color) {
+#ifdef GRAPHICS_SSE2
+	if (count == 0)
+		return;
+	if (count < 4)
+		blendShortSpanSSE2(pixel, coverage, count, color);
+	else if (count < 8)
+		blendSpanSSE2(pixel, coverage, count, color);
+	else
+		blendSpanKernel()(pixel, coverage, count, color);
+#else
+	blendSpanScalar(pixel, coverage, count, color);
+#endif
+}
+
+#endif // !GRAPHICS_BLEND
@@ -0,0 +1,221 @@
+#ifndef GRAPHICS_BLIT
+#define GRAPHICS_BLIT
+
+#include "Blend.hpp"
+
+// How the pixels of an image are combined with the pixels under them
+enum class BlitMode : unsigned char {
+	// Every pixel is copied, the alpha is ignored
+	Copy,
+	// Pixels with the color key (0x00RRGGBB) are skipped, the rest is copied
+	ColorKey,
+	// Pixels are blended with their own alpha (not premultiplied), 0 is skipped and 255 copied
+	Alpha,
+};
+
+// Combines count pixels of an image row (0xAARRGGBB, stored as BGRA bytes, not necessarily aligned) with the pixels starting at pixel
+// The written pixels always have the unused top byte 0, like the rest of the target
+typedef void (*BlitSpanFunction)(UINT32* pixel, const unsigned char* source, size_t count, UINT32 colorKey);
+
+// Spans shorter than this are blitted inline, without going thru the dispatched kernel
+const size_t shortBlitLength = 4;
+
+// Reads a pixel of an image, image rows (for example the ones mapped from a BMP file) don't have to be aligned
+inline UINT32 loadImagePixel(_In_ const unsigned char* source) {
+	UINT32 value;
+	memcpy(&value, source, sizeof(value));
+	return value;
+}
+
+// Scalar fallbacks
+inline void blitCopyScalar(_In_ UINT32* pixel, _In_ const unsigned char* source, _In_ size_t count, _In_ UINT32 colorKey) {
+	(void)colorKey;
+	for (size_t i = 0; i < count; i++)
+		pixel[i] = loadImagePixel(source + i * 4) & 0xFFFFFF;
+}
+
+inline void blitColorKeyScalar(_In_ UINT32* pixel, _In_ const unsigned char* source, _In_ size_t count, _In_ UINT32 colorKey) {
+	for (size_t i = 0; i < count; i++) {
+		UINT32 color = loadImagePixel(source + i * 4) & 0xFFFFFF;
+		if (color != colorKey)
+			pixel[i] = color;
+	}
+}
+
+inline void blitAlphaScalar(_In_ UINT32* pixel, _In_ const unsigned char* source, _In_ size_t count, _In_ UINT32 colorKey) {
+	(void)colorKey;
+	for (size_t i = 0; i < count; i++) {
+		UINT32 color = loadImagePixel(source + i * 4);
+		unsigned int alpha = color >> 24;
+		if (alpha == 255)
+			pixel[i] = color & 0xFFFFFF;
+		else if (alpha != 0)
+			pixel[i] = blendColor(pixel[i], color, alpha);
+	}
+}
+
+#ifdef GRAPHICS_SSE2
+// 4 pixels per step, unrolled to 16
+inline void blitCopySSE2(_In_ UINT32* pixel, _In_ const unsigned char* source, _In_ size_t count, _In_ UINT32 colorKey) {
+	const __m128i mask = _mm_set1_epi32(0xFFFFFF);
+	for (; count >= 16; count -= 16, pixel += 16, source += 64) {
+		__m128i a = _mm_loadu_si128((const __m128i*)source);
+		__m128i b = _mm_loadu_si128((const __m128i*)(source + 16));
+		__m128i c = _mm_loadu_si128((const __m128i*)(source + 32));
+		__m128i d = _mm_loadu_si128((const __m128i*)(source + 48));
+		_mm_storeu_si128((__m128i*)pixel, _mm_and_si128(a, mask));
+		_mm_storeu_si128((__m128i*)(pixel + 4), _mm_and_si128(b, mask));
+		_mm_storeu_si128((__m128i*)(pixel + 8), _mm_and_si128(c, mask));
+		_mm_storeu_si128((__m128i*)(pixel + 12), _mm_and_si128(d, mask));
+	}
+	for (; count >= 4; count -= 4, pixel += 4, source += 16)
+		_mm_storeu_si128((__m128i*)pixel, _mm_and_si128(_mm_loadu_si128((const __m128i*)source), mask));
+	blitCopyScalar(pixel, source, count, colorKey);
+}
+
+// 4 pixels per step, the keyed ones keep the destination
+inline void blitColorKeySSE2(_In_ UINT32* pixel, _In_ const unsigned char* source, _In_ size_t count, _In_ UINT32 colorKey) {
+	const __m128i mask = _mm_set1_epi32(0xFFFFFF);
+	const __m128i key = _mm_set1_epi32((int)colorKey);
+	for (; count >= 4; count -= 4, pixel += 4, source += 16) {
+		__m128i color = _mm_and_si128(_mm_loadu_si128((const __m128i*)source), mask);
+		__m128i keyed = _mm_cmpeq_epi32(color, key);
+		int keyedMask = _mm_movemask_epi8(keyed);
+		// Sprites are mostly either entirely keyed or entirely opaque
+		if (keyedMask == 0xFFFF) continue;
+		if (keyedMask != 0)
+			color = _mm_or_si128(_mm_and_si128(keyed, _mm_loadu_si128((const __m128i*)pixel)), _mm_andnot_si128(keyed, color));
+		_mm_storeu_si128((__m128i*)pixel, color);
+	}
+	blitColorKeyScalar(pixel, source, count, colorKey);
+}
+
+// 4 pixels per step, channels and alpha widened to 16 bits like in blendSpanSSE2, giving exactly the same pixels as blendColor
+inline void blitAlphaSSE2(_In_ UINT32* pixel, _In_ const unsigned char* source, _In_ size_t count, _In_ UINT32 colorKey) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i mask = _mm_set1_epi32(0xFFFFFF);
+	for (; count >= 4; count -= 4, pixel += 4, source += 16) {
+		__m128i color = _mm_loadu_si128((const __m128i*)source);
+		__m128i alpha = _mm_srli_epi32(color, 24);
+		int opaque = _mm_movemask_epi8(_mm_cmpeq_epi32(alpha, _mm_set1_epi32(255)));
+		// Transparent and opaque groups are common inside of the sprites
+		if (_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, zero)) == 0xFFFF) continue;
+		if (opaque == 0xFFFF) {
+			_mm_storeu_si128((__m128i*)pixel, _mm_and_si128(color, mask));
+			continue;
+		}
+		// Map 255 to 256 and repeat it for all 4 channels of every pixel
+		alpha = _mm_add_epi32(alpha, _mm_srli_epi32(alpha, 7));
+		alpha = _mm_packs_epi32(alpha, alpha);
+		alpha = _mm_unpacklo_epi16(alpha, alpha);
+		__m128i alphaLow = _mm_unpacklo_epi32(alpha, alpha);
+		__m128i alphaHigh = _mm_unpackhi_epi32(alpha, alpha);
+
+		__m128i destination = _mm_loadu_si128((const __m128i*)pixel);
+		__m128i low = blendPixelsSSE2(_mm_unpacklo_epi8(destination, zero), _mm_unpacklo_epi8(color, zero), alphaLow);
+		__m128i high = blendPixelsSSE2(_mm_unpackhi_epi8(destination, zero), _mm_unpackhi_epi8(color, zero), alphaHigh);
+		_mm_storeu_si128((__m128i*)pixel, _mm_and_si128(_mm_packus_epi16(low, high), mask));
+	}
+	blitAlphaScalar(pixel, source, count, colorKey);
+}
+
+// 8 pixels per step, unrolled to 32
+GRAPHICS_TARGET_AVX2 inline void blitCopyAVX2(_In_ UINT32* pixel, _In_ const unsigned char* source, _In_ size_t count, _In_ UINT32 colorKey) {
+	const __m256i mask = _mm256_set1_epi32(0xFFFFFF);
+	for (; count >= 32; count -= 32, pixel += 32, source += 128) {
+		__m256i a = _mm256_loadu_si256((const __m256i*)source);
+		__m256i b = _mm256_loadu_si256((const __m256i*)(source + 32));
+		__m256i c = _mm256_loadu_si256((const __m256i*)(source + 64));
+		__m256i d = _mm256_loadu_si256((const __m256i*)(source + 96));
+		_mm256_storeu_si256((__m256i*)pixel, _mm256_and_si256(a, mask));
+		_mm256_storeu_si256((__m256i*)(pixel + 8), _mm256_and_si256(b, mask));
+		_mm256_storeu_si256((__m256i*)(pixel + 16), _mm256_and_si256(c, mask));
+		_mm256_storeu_si256((__m256i*)(pixel + 24), _mm256_and_si256(d, mask));
+	}
+	for (; count >= 8; count -= 8, pixel += 8, source += 32)
+		_mm256_storeu_si256((__m256i*)pixel, _mm256_and_si256(_mm256_loadu_si256((const __m256i*)source), mask));
+	blitCopySSE2(pixel, source, count, colorKey);
+}
+
+// 8 pixels per step
+GRAPHICS_TARGET_AVX2 inline void blitColorKeyAVX2(_In_ UINT32* pixel, _In_ const unsigned char* source, _In_ size_t count, _In_ UINT32 colorKey) {
+	const __m256i mask = _mm256_set1_epi32(0xFFFFFF);
+	const __m256i key = _mm256_set1_epi32((int)colorKey);
+	for (; count >= 8; count -= 8, pixel += 8, source += 32) {
+		__m256i color = _mm256_and_si256(_mm256_loadu_si256((const __m256i*)source), mask);
+		__m256i keyed = _mm256_cmpeq_epi32(color, key);
+		int keyedMask = _mm256_movemask_epi8(keyed);
+		if (keyedMask == -1) continue;
+		if (keyedMask != 0)
+			color = _mm256_blendv_epi8(color, _mm256_loadu_si256((const __m256i*)pixel), keyed);
+		_mm256_storeu_si256((__m256i*)pixel, color);
+	}
+	blitColorKeySSE2(pixel, source, count, colorKey);
+}
+
+// 8 pixels per step, pixels 0 - 3 are in the low lane and 4 - 7 in the high one, the unpacks keep them there
+GRAPHICS_TARGET_AVX2 inline void blitAlphaAVX2(_In_ UINT32* pixel, _In_ const unsigned char* source, _In_ size_t count, _In_ UINT32 colorKey) {
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i full = _mm256_set1_epi16(256);
+	const __m256i mask = _mm256_set1_epi32(0xFFFFFF);
+	for (; count >= 8; count -= 8, pixel += 8, source += 32) {
+		__m256i color = _mm256_loadu_si256((const __m256i*)source);
+		__m256i alpha = _mm256_srli_epi32(color, 24);
+		if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(alpha, zero)) == -1) continue;
+		if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(alpha, _mm256_set1_epi32(255))) == -1) {
+			_mm256_storeu_si256((__m256i*)pixel, _mm256_and_si256(color, mask));
+			continue;
+		}
+		alpha = _mm256_add_epi32(alpha, _mm256_srli_epi32(alpha, 7));
+		alpha = _mm256_packs_epi32(alpha, alpha);
+		alpha = _mm256_unpacklo_epi16(alpha, alpha);
+		__m256i alphaLow = _mm256_unpacklo_epi32(alpha, alpha);
+		__m256i alphaHigh = _mm256_unpackhi_epi32(alpha, alpha);
+
+		__m256i destination = _mm256_loadu_si256((const __m256i*)pixel);
+		__m256i low = _mm256_unpacklo_epi8(destination, zero);
+		__m256i high = _mm256_unpackhi_epi8(destination, zero);
+		low = _mm256_srli_epi16(_mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(color, zero), alphaLow),
+			_mm256_mullo_epi16(low, _mm256_sub_epi16(full, alphaLow))), 8);
+		high = _mm256_srli_epi16(_mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(color, zero), alphaHigh),
+			_mm256_mullo_epi16(high, _mm256_sub_epi16(full, alphaHigh))), 8);
+		_mm256_storeu_si256((__m256i*)pixel, _mm256_and_si256(_mm256_packus_epi16(low, high), mask));
+	}
+	blitAlphaSSE2(pixel, source, count, colorKey);
+}
+#endif
+
+// Blit kernels picked for the current CPU, indexed by the BlitMode
+struct BlitKernels {
+	BlitSpanFunction spans[3];
+	// Name of the instruction set
+	const char* name;
+};
+
+// Picks the fastest kernels supported by the CPU
+inline BlitKernels selectBlitKernels() {
+#ifdef GRAPHICS_SSE2
+	if (cpuHasAVX2())
+		return { { blitCopyAVX2, blitColorKeyAVX2, blitAlphaAVX2 }, "AVX2" };
+	return { { blitCopySSE2, blitColorKeySSE2, blitAlphaSSE2 }, "SSE2" };
+#else
+	return { { blitCopyScalar, blitColorKeyScalar, blitAlphaScalar }, "scalar" };
+#endif
+}
+
+// Kernels are selected once, on the first use
+inline const BlitKernels& blitKernels() {
+	static const BlitKernels kernels = selectBlitKernels();
+	return kernels;
+}
+
+// Combines a row of an image with the pixels in the chosen mode
+inline void blitSpan(_In_ UINT32* pixel, _In_ const unsigned char* source, _In_ size_t count, _In_ BlitMode mode, _In_ UINT32 colorKey) {
+	static const BlitSpanFunction scalar[3] = { blitCopyScalar, blitColorKeyScalar, blitAlphaScalar };
+	if (count < shortBlitLength)
+		scalar[(int)mode](pixel, source, count, colorKey);
+	else
+		blitKernels().spans[(int)mode](pixel, source, count, colorKey);
+}
+
+#endif // !GRAPHICS_BLIT
@@ -0,0 +1,269 @@
+#ifndef GRAPHICS_D_STAR_LITE
+#define GRAPHICS_D_STAR_LITE
+
+#include "PathGrid.hpp"
+#include <algorithm>
+
+// Incremental path finder (D* Lite) for grids that change between the searches, like a map in an editor
+// It searches from the goal to the start and keeps the costs of the cells between the searches, so after a cell is blocked
+// or opened, or the start moves, the next search only repairs the cells whose cost changed instead of solving again.
+// Every cell has the cost of the cheapest way to the goal found so far and the one its neighbours give it (one step ahead),
+// the cells where they differ are in the heap, ordered like A* toward the start
+// A new goal, grid or connectivity starts over (the costs are all to the goal)
+class DStarLite {
+public:
+	// Work done by the searches
+	struct Stats {
+		// Cells expanded by the last search and by all of them
+		unsigned long long expanded = 0;
+		unsigned long long totalExpanded = 0;
+		// Searches and the ones that had to start over
+		unsigned long long searches = 0;
+		unsigned long long restarts = 0;
+	};
+
+private:
+	PathGrid grid;
+	PathConnectivity connectivity = PathConnectivity::Four;
+	// Cost from the cells to the goal, and the cheapest one through their neighbours
+	std::vector<PathCost> costs;
+	std::vector<PathCost> lookahead;
+	// Search the cells were last expanded in
+	std::vector<unsigned int> expandedIn;
+	unsigned int search = 0;
+	PathHeap open;
+	vec2<int> start;
+	vec2<int> goal;
+	// Start of the search the keys in the heap were made for, and the sum of the distances the start moved since the restart
+	// added to the new keys, so the old ones don't have to be recomputed
+	vec2<int> lastStart;
+	PathCost keyModifier = 0;
+	bool restartNeeded = true;
+	PathCost pathCost = pathNoCost;
+	Stats stats;
+
+	static PathCost add(_In_ PathCost a, _In_ PathCost b) {
+		return a == pathNoCost || b == pathNoCost ? pathNoCost : a + b;
+	}
+
+	// Cost of the step between neighbouring cells, pathNoCost if one of them is blocked or the step goes past a blocked corner
+	PathCost stepCost(_In_ int from, _In_ int to) const {
+		if (grid.blocked[from] || grid.blocked[to]) return pathNoCost;
+		int fromX = from % grid.width, fromY = from / grid.width;
+		int toX = to % grid.width, toY = to / grid.width;
+		if (fromX == toX || fromY == toY) return pathStraightCost;
+		return grid.isOpen(toX, fromY) && grid.isOpen(fromX, toY) ? pathDiagonalCost : pathNoCost;
+	}
+
+	// Calls the function with the neighbours of the cell
+	template<typename Function>
+	void forNeighbours(_In_ int cell, _In_ Function function) const {
+		static const int offsets[8][2] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 }, { 1, 1 }, { -1, 1 }, { 1, -1 }, { -1, -1 } };
+		int x = cell % grid.width, y = cell / grid.width;
+		int count = connectivity == PathConnectivity::Eight ? 8 : 4;
+		for (int i = 0; i < count; i++)
+			if (grid.isInside(x + offsets[i][0], y + offsets[i][1]))
+				function((y + offsets[i][1]) * grid.width + x + offsets[i][0]);
+	}
+
+	// Cheapest cost to the goal through the neighbours of the cell
+	PathCost bestNeighbour(_In_ int cell) const {
+		PathCost best = pathNoCost;
+		forNeighbours(cell, [&](int neighbour) {
+			best = std::min(best, add(stepCost(cell, neighbour), costs[neighbour]));
+		});
+		return best;
+	}
+
+	// Key of the cell in the heap, by the estimated cost of the path from the start through it and then by its cost
+	unsigned long long key(_In_ int cell) const {
+		PathCost cost = std::min(costs[cell], lookahead[cell]);
+		if (cost == pathNoCost) return ~0ull;
+		PathCost estimate = cost + pathHeuristic(start, grid.coords(cell), connectivity) + keyModifier;
+		return (unsigned long long)estimate << 32 | cost;
+	}
+
+	// Puts the cell in the heap if its costs differ, otherwise takes it out
+	void updateCell(_In_ int cell) {
+		bool queued = open.contains(cell);
+		if (costs[cell] != lookahead[cell]) {
+			if (queued) open.update(cell, key(cell));
+			else open.push(cell, key(cell));
+		}
+		else if (queued)
+			open.remove(cell);
+	}
+
+	// Starts over from the goal
+	void restart() {
+		int cellCount = grid.size();
+		costs.assign(cellCount, pathNoCost);
+		lookahead.assign(cellCount, pathNoCost);
+		if ((int)expandedIn.size() != cellCount)
+			expandedIn.assign(cellCount, 0);
+		open.reset(cellCount);
+		keyModifier = 0;
+		lastStart = start;
+		int goalCell = grid.index(goal.x, goal.y);
+		lookahead[goalCell] = 0;
+		open.push(goalCell, key(goalCell));
+		restartNeeded = false;
+		stats.restarts++;
+	}
+
+	// Expands the cells until the cost of the start can't change anymore
+	void repair() {
+		int startCell = grid.index(start.x, start.y);
+		int goalCell = grid.index(goal.x, goal.y);
+		while (!open.empty() && (open.topKey() < key(startCell) || lookahead[startCell] > costs[startCell])) {
+			int cell = open.top();
+			unsigned long long newKey = key(cell);
+			// The start moved since the cell was added
+			if (open.topKey() < newKey) {
+				open.update(cell, newKey);
+				continue;
+			}
+			expandedIn[cell] = search;
+			stats.expanded++;
+			// The cell got cheaper, so can its neighbours
+			if (costs[cell] > lookahead[cell]) {
+				costs[cell] = lookahead[cell];
+				open.remove(cell);
+				forNeighbours(cell, [&](int neighbour) {
+					if (neighbour == goalCell) return;
+					lookahead[neighbour] = std::min(lookahead[neighbour], add(stepCost(neighbour, cell), costs[cell]));
+					updateCell(neighbour);
+				});
+			}
+			// The cell got more expensive, the neighbours that went through it look for another way
+			else {
+				PathCost oldCost = costs[cell];
+				costs[cell] = pathNoCost;
+				forNeighbours(cell, [&](int neighbour) {
+					if (neighbour != goalCell && lookahead[neighbour] == add(stepCost(neighbour, cell), oldCost))
+						lookahead[neighbour] = bestNeighbour(neighbour);
+					updateCell(neighbour);
+				});
+				if (cell != goalCell)
+					lookahead[cell] = bestNeighbour(cell);
+				updateCell(cell);
+			}
+		}
+	}
+
+public:
+	// Copies the grid to search on, the next search starts over
+	bool create(_In_ const PathGrid& searchedGrid, _In_ PathConnectivity searchedConnectivity) {
+		grid = searchedGrid;
+		connectivity = searchedConnectivity;
+		restartNeeded = true;
+		pathCost = pathNoCost;
+		return grid.size() > 0;
+	}
+
+	// Blocks or opens a cell, the costs of it and its neighbours are updated for the next search
+	void setBlocked(_In_ int x, _In_ int y, _In_ bool isBlocked) {
+		if (!grid.isInside(x, y) || grid.isOpen(x, y) != isBlocked) return;
+		grid.setBlocked(x, y, isBlocked);
+		if (restartNeeded) return;
+		int cell = grid.index(x, y);
+		int goalCell = grid.index(goal.x, goal.y);
+		// The steps from the cell and its neighbours changed, the diagonal steps past its corners are between its neighbours too
+		if (cell != goalCell)
+			lookahead[cell] = bestNeighbour(cell);
+		updateCell(cell);
+		forNeighbours(cell, [&](int neighbour) {
+			if (neighbour != goalCell)
+				lookahead[neighbour] = bestNeighbour(neighbour);
+			updateCell(neighbour);
+		});
+	}
+
+	// Moves the start, the costs to the goal stay the same
+	void setStart(_In_ vec2<int> cell) {
+		start = cell;
+		if (restartNeeded || !grid.isInside(cell.x, cell.y)) return;
+		keyModifier += pathHeuristic(lastStart, start, connectivity);
+		lastStart = start;
+		// The keys have to fit next to the costs
+		if (keyModifier > (1u << 30))
+			restartNeeded = true;
+	}
+
+	// Moves the goal, which starts over
+	void setGoal(_In_ vec2<int> cell) {
+		if (cell.x != goal.x || cell.y != goal.y)
+			restartNeeded = true;
+		goal = cell;
+	}
+
+	// Finds the cheapest path with the changes since the last search, returns false if there is none
+	bool findPath() {
+		stats.expanded = 0;
+		pathCost = pathNoCost;
+		if (!grid.isOpen(start.x, start.y) || !grid.isOpen(goal.x, goal.y)) return false;
+		if (restartNeeded)
+			restart();
+		search++;
+		repair();
+		stats.searches++;
+		stats.totalExpanded += stats.expanded;
+		pathCost = lookahead[grid.index(start.x, start.y)];
+		return pathCost != pathNoCost;
+	}
+
+	// Cost of the path found by the last search, pathNoCost if there was none
+	PathCost getCost() const {
+		return pathCost;
+	}
+
+	// Cells of the path found by the last search from the start to the goal, empty if there was none
+	// Every step goes to the neighbour with the cheapest way to the goal
+	void getPath(_Out_ std::vector<vec2<int>>& path) const {
+		path.clear();
+		if (pathCost == pathNoCost) return;
+		int cell = grid.index(start.x, start.y);
+		int goalCell = grid.index(goal.x, goal.y);
+		path.push_back(start);
+		while (cell != goalCell && (int)path.size() <= grid.size()) {
+			PathCost best = pathNoCost;
+			int next = -1;
+			forNeighbours(cell, [&](int neighbour) {
+				PathCost cost = add(stepCost(cell, neighbour), costs[neighbour]);
+				if (cost < best) {
+					best = cost;
+					next = neighbour;
+				}
+			});
+			if (next < 0) {
+				path.clear();
+				return;
+			}
+			cell = next;
+			path.push_back(grid.coords(cell));
+		}
+	}
+
+	// Grid with the changes
+	const PathGrid& getGrid() const {
+		return grid;
+	}
+
+	// If the last search expanded the cell
+	bool isExpanded(_In_ int x, _In_ int y) const {
+		return !expandedIn.empty() && grid.isInside(x, y) && expandedIn[grid.index(x, y)] == search;
+	}
+
+	// Work done by the searches
+	Stats getStats() const {
+		return stats;
+	}
+
+	// Bytes used by the grid, the costs of the cells and the heap
+	size_t memoryUsage() const {
+		return grid.blocked.capacity() + (costs.capacity() + lookahead.capacity()) * sizeof(PathCost) + expandedIn.capacity() * sizeof(unsigned int)
+			+ open.memoryUsage();
+	}
+};
+
+#endif // !GRAPHICS_D_STAR_LITE
@@ -0,0 +1,79 @@
+#ifndef GRAPHICS_DIRTY_REGION
+#define GRAPHICS_DIRTY_REGION
+
+#include "Geometry.hpp"
+
+// Small set of rectangles covering everything drawn since the last present
+// Nearby rectangles are merged so that presenting them stays cheap
+class DirtyRegion {
+public:
+	// Maximum number of the separate rectangles
+	static const int maxRects = 16;
+	// Merging is allowed to add this many not damaged pixels to save a separate present
+	static const long long mergeWaste = 64 * 64;
+
+	Rect rects[maxRects];
+	int count = 0;
+
+	// Adds a damaged rectangle, it has to be already clipped to the bitmap
+	// Taken by reference, the callers build it a field at a time and a copy would load it back in bigger pieces
+	void add(_In_ const Rect& added) {
+		// Primitives made of smaller primitives keep hitting the rectangles that are already there
+		for (int i = count - 1; i >= 0; i--)
+			if (containsRect(rects[i], added))
+				return;
+
+		Rect rect = added;
+
+		// Merge with every rectangle that's close enough, merged rectangle can now reach further ones
+		bool merged = true;
+		while (merged) {
+			merged = false;
+			for (int i = 0; i < count; i++) {
+				Rect merge = unionRect(rects[i], rect);
+				if (rectArea(merge) - rectArea(rects[i]) - rectArea(rect) <= mergeWaste) {
+					rect = merge;
+					rects[i] = rects[--count];
+					merged = true;
+					break;
+				}
+			}
+		}
+
+		// Out of space, merge with the rectangle that grows the least
+		if (count == maxRects) {
+			int best = 0;
+			long long bestGrowth = -1;
+			for (int i = 0; i < count; i++) {
+				long long growth = rectArea(unionRect(rects[i], rect)) - rectArea(rects[i]);
+				if (bestGrowth < 0 || growth < bestGrowth) {
+					best = i;
+					bestGrowth = growth;
+				}
+			}
+			rect = unionRect(rects[best], rect);
+			rects[best] = rects[--count];
+		}
+
+		rects[count++] = rect;
+	}
+
+	// Removes all of the rectangles
+	void clear() {
+		count = 0;
+	}
+
+	bool isEmpty() const {
+		return count == 0;
+	}
+
+	// Number of the damaged pixels
+	long long area() const {
+		long long total = 0;
+		for (int i = 0; i < count; i++)
+			total += rectArea(rects[i]);
+		return total;
+	}
+};
+
+#endif // !GRAPHICS_DIRTY_REGION
@@ -0,0 +1,163 @@
+#ifndef GRAPHICS_DRAW_COMMAND
+#define GRAPHICS_DRAW_COMMAND
+
+#include "Platform.hpp"
+#include "Geometry.hpp"
+#include "Bezier.hpp"
+#include "Image.hpp"
+#include <vector>
+
+// Kinds of the draw calls
+enum class DrawCommandType : unsigned char {
+	Clear,
+	Pixel,
+	Rectangle,
+	Circle,
+	EmptyCircle,
+	Line,
+	QuadraticBezier,
+	CubicBezier,
+	Triangle,
+	Text,
+	AntialiasedLine,
+	AntialiasedCircle,
+	AntialiasedEmptyCircle,
+	Image,
+};
+
+// Single draw call, validated when it's made so that executing it only plots the pixels
+struct DrawCommand {
+	DrawCommandType type = DrawCommandType::Clear;
+	// If the bounds may have been cut off by the clip rectangle or the target, the command then keeps them as its clip
+	// and moving it needs the bounds computed again, the bounds of the rest are exact and only move with it
+	bool clipped = false;
+	// Thickness of the lines, outlines and curves, BlitMode of the images
+	unsigned short thickness = 0;
+	// Radius of the circles, size of the text, number of the points of the recorded curves
+	int size = 0;
+	// Index of the first character of the recorded text in the text pool,
+	// the first point of the recorded curve (flattened when recorded) in the point pool, or the image in the image pool
+	int data = 0;
+	// Color, or the color key of the images
+	UINT32 color = 0;
+	// Ends of the lines, control points of the curves, fixed point (subpixelBits) vertices of the triangles,
+	// both (max exclusive) corners of the rectangles, origin of the circles, the pen position of the text,
+	// the position, the source corner and the source size of the images
+	vec2<int> points[4];
+	// Pixels the command can change (max exclusive), clipped to the target
+	Rect bounds;
+
+	DrawCommand() {}
+	DrawCommand(_In_ DrawCommandType commandType, _In_ UINT32 commandColor) : type(commandType), color(commandColor) {}
+};
+
+// Recorded draw calls in the order they were made
+// Also used as a display list: static content recorded once and replayed with RenderTarget::replay() every frame
+class DrawCommandList {
+public:
+	// Recorded commands
+	std::vector<DrawCommand> commands;
+	// Characters of all of the recorded texts, each one terminated with 0
+	std::vector<wchar_t> textPool;
+	// Points of all of the flattened curves
+	std::vector<vec2<int>> pointPool;
+	// Images drawn by the commands, they aren't copied
+	std::vector<const Image*> imagePool;
+	// Union of the bounds of the commands, empty if there are none
+	Rect bounds;
+	// If the bounds of any of the commands were cut off
+	bool clipped = false;
+
+	// Appends a command, the ones entirely outside of the clip rectangle are left out before they get here
+	void add(_In_ const DrawCommand& command) {
+		commands.push_back(command);
+		addBounds(command);
+	}
+
+	// Adds the bounds of the command to the ones of the list
+	void addBounds(_In_ const DrawCommand& command) {
+		bounds = bounds.width > 0 ? unionRect(bounds, command.bounds) : command.bounds;
+		clipped = clipped || command.clipped;
+	}
+
+	// Copies the text into the pool, returns the index of its first character
+	int addText(_In_ const wchar_t* text) {
+		int index = (int)textPool.size();
+		do
+			textPool.push_back(*text);
+		while (*text++);
+		return index;
+	}
+
+	// Adds the image to the pool, returns its index
+	int addImage(_In_ const Image* image) {
+		imagePool.push_back(image);
+		return (int)imagePool.size() - 1;
+	}
+
+	// Flattens the curve of the command (degree + 1 control points) into the pool, sets its first point and the number of the points
+	void addCurve(_Inout_ DrawCommand& command, _In_ int degree) {
+		float x[4], y[4];
+		for (int i = 0; i <= degree; i++) {
+			x[i] = (float)command.points[i].x;
+			y[i] = (float)command.points[i].y;
+		}
+		int segments = bezierSegmentCount(x, y, degree);
+		command.data = (int)pointPool.size();
+		command.size = segments + 1;
+		pointPool.resize(pointPool.size() + segments + 1);
+		flattenBezier(x, y, degree, segments, &pointPool[command.data]);
+	}
+
+	// Appends a command of another list, its text or curve points are copied too (the points moved by the offset)
+	void append(_In_ const DrawCommand& command, _In_ const DrawCommandList& source, _In_ vec2<int> offset) {
+		DrawCommand copy = command;
+		if (command.type == DrawCommandType::Text)
+			copy.data = addText(source.getText(command));
+		else if (command.type == DrawCommandType::QuadraticBezier || command.type == DrawCommandType::CubicBezier) {
+			copy.data = (int)pointPool.size();
+			const vec2<int>* points = source.getPoints(command);
+			for (int i = 0; i < command.size; i++)
+				pointPool.push_back(vec2<int>(points[i].x + offset.x, points[i].y + offset.y));
+		}
+		else if (command.type == DrawCommandType::Image)
+			copy.data = addImage(source.getImage(command));
+		add(copy);
+	}
+
+	// Text of a recorded Text command
+	const wchar_t* getText(_In_ const DrawCommand& command) const {
+		return &textPool[command.data];
+	}
+
+	// Flattened points of a recorded curve, there are command.size of them
+	const vec2<int>* getPoints(_In_ const DrawCommand& command) const {
+		return &pointPool[command.data];
+	}
+
+	// Image of a recorded Image command
+	const Image* getImage(_In_ const DrawCommand& command) const {
+		return imagePool[command.data];
+	}
+
+	// Number of the recorded commands
+	size_t size() const {
+		return commands.size();
+	}
+
+	bool empty() const {
+		return commands.empty();
+	}
+
+	// Removes all of the commands, the memory is kept for the next frame
+	void clear() {
+		commands.clear();
+		textPool.clear();
+		pointPool.clear();
+		imagePool.clear();
+		bounds = Rect();
+		clipped = false;
+	}
+};
+
+#endif // !GRAPHICS_DRAW_COMMAND
@@ -0,0 +1,669 @@
+#ifndef GRAPHICS_DRAW_STREAM
+#define GRAPHICS_DRAW_STREAM
+
+#include "Platform.hpp"
+#include "DrawCommand.hpp"
+#include "GlyphAtlas.hpp"
+#include "InputQueue.hpp"
+#include "Triangle.hpp"
+#include "Blit.hpp"
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// Binary file of captured frames, replayed on a RenderTarget without the window or the app that drew them
+// Starts with the magic and the version, followed by chunks: the kind (1 byte), the payload size (4 bytes, little endian) and the payload
+// Numbers in the payloads are variable length (7 bits per byte, the signed ones zigzag encoded), so small coordinates take a byte or two
+const char drawStreamMagic[4] = { 'G', 'D', 'S', '1' };
+const unsigned int drawStreamVersion = 1;
+// Biggest radius (with the thickness) and text size in a stream, bigger ones would overflow the rasterizers
+const int drawStreamMaxRadius = 1 << 15;
+const int drawStreamMaxTextSize = glyphMaxSize;
+
+// Kinds of the chunks, readers skip the kinds they don't know
+enum class DrawStreamChunk : unsigned char {
+	// Pixels of an image used by the following frames: the id, the width, the height, hasAlpha and the BGRA rows
+	Image = 1,
+	// Draw calls and input events of a frame
+	Frame = 2,
+};
+
+// Frame read from a stream
+struct DrawStreamFrame {
+	// Size of the target the frame was drawn to
+	int width = 0;
+	int height = 0;
+	// When the frame was drawn (in nanoseconds since the capture started)
+	long long time = 0;
+	// Draw calls in the order they were drawn, replay them with RenderTarget::replay
+	DrawCommandList commands;
+	// Input events handled in the frame, timestamped in nanoseconds since the capture started
+	std::vector<InputEvent> events;
+};
+
+// Writes the variable length numbers of the chunk payloads
+class DrawStreamEncoder {
+public:
+	std::vector<unsigned char> bytes;
+
+	void putByte(_In_ unsigned char value) {
+		bytes.push_back(value);
+	}
+
+	void putUnsigned(_In_ unsigned long long value) {
+		while (value >= 0x80) {
+			bytes.push_back((unsigned char)(value | 0x80));
+			value >>= 7;
+		}
+		bytes.push_back((unsigned char)value);
+	}
+
+	// Zigzag encoded, the numbers close to 0 are short whatever their sign
+	void putSigned(_In_ long long value) {
+		putUnsigned(((unsigned long long)value << 1) ^ (unsigned long long)(value >> 63));
+	}
+
+	void putPoint(_In_ vec2<int> point) {
+		putSigned(point.x);
+		putSigned(point.y);
+	}
+
+	void putBytes(_In_ const void* data, _In_ size_t size) {
+		bytes.insert(bytes.end(), (const unsigned char*)data, (const unsigned char*)data + size);
+	}
+};
+
+// Reads the numbers written by DrawStreamEncoder, reading past the end of the payload fails the decoder and returns 0
+class DrawStreamDecoder {
+	const unsigned char* position;
+	const unsigned char* end;
+	bool failed = false;
+
+public:
+	DrawStreamDecoder(_In_ const unsigned char* data, _In_ size_t size) : position(data), end(data + size) {}
+
+	unsigned char getByte() {
+		if (position == end) {
+			failed = true;
+			return 0;
+		}
+		return *position++;
+	}
+
+	unsigned long long getUnsigned() {
+		unsigned long long value = 0;
+		for (int shift = 0; shift < 64; shift += 7) {
+			unsigned char byte = getByte();
+			value |= (unsigned long long)(byte & 0x7F) << shift;
+			if (!(byte & 0x80)) return value;
+		}
+		failed = true;
+		return 0;
+	}
+
+	long long getSigned() {
+		unsigned long long value = getUnsigned();
+		return (long long)(value >> 1) ^ -(long long)(value & 1);
+	}
+
+	// Unsigned number up to the limit, bigger ones fail the decoder
+	unsigned int getCount(_In_ unsigned long long limit) {
+		unsigned long long value = getUnsigned();
+		if (value > limit) {
+			failed = true;
+			return 0;
+		}
+		return (unsigned int)value;
+	}
+
+	// Signed number in [-limit, limit], the others fail the decoder
+	int getInt(_In_ long long limit) {
+		long long value = getSigned();
+		if (value < -limit || value > limit) {
+			failed = true;
+			return 0;
+		}
+		return (int)value;
+	}
+
+	vec2<int> getPoint(_In_ long long limit) {
+		int x = getInt(limit);
+		return vec2<int>(x, getInt(limit));
+	}
+
+	// Next size bytes, nullptr if there aren't as many left
+	const unsigned char* getBytes(_In_ size_t size) {
+		if ((size_t)(end - position) < size) {
+			failed = true;
+			return nullptr;
+		}
+		const unsigned char* bytes = position;
+		position += size;
+		return bytes;
+	}
+
+	size_t remaining() const {
+		return (size_t)(end - position);
+	}
+
+	void fail() {
+		failed = true;
+	}
+
+	bool hasFailed() const {
+		return failed;
+	}
+};
+
+// Writes the captured frames (RenderTarget::beginCapture) to a stream file
+// The images drawn by the frames are written once, before the first frame using them. They're told apart by a hash of their size
+// and pixels, so an image changed in place after it was drawn is written again and an image loaded again isn't
+class DrawStreamWriter {
+public:
+	// Amount of the data written so far
+	struct Stats {
+		unsigned long long frames = 0;
+		unsigned long long commands = 0;
+		unsigned long long inputEvents = 0;
+		unsigned long long images = 0;
+		unsigned long long bytes = 0;
+	};
+
+private:
+	FILE* file = nullptr;
+	// When the capture started (inputClock)
+	long long startTime = 0;
+	// Ids of the images written by the hash of their contents
+	std::unordered_map<unsigned long long, unsigned int> images;
+	unsigned int nextImageId = 0;
+	// Payload of the chunk being written, the memory is kept for the next one
+	DrawStreamEncoder chunk;
+	Stats stats;
+
+	// Writes the payload in the encoder as a chunk of the kind
+	bool writeChunk(_In_ DrawStreamChunk kind) {
+		unsigned char header[5] = { (unsigned char)kind };
+		for (int i = 0; i < 4; i++)
+			header[1 + i] = (unsigned char)(chunk.bytes.size() >> (i * 8));
+		bool written = fwrite(header, 1, sizeof(header), file) == sizeof(header)
+			&& fwrite(chunk.bytes.data(), 1, chunk.bytes.size(), file) == chunk.bytes.size();
+		stats.bytes += sizeof(header) + chunk.bytes.size();
+		chunk.bytes.clear();
+		return written;
+	}
+
+	// 64-bit hash of the size, hasAlpha and the pixels of the image, the rows are mixed in 8 bytes at a time
+	static unsigned long long hashImage(_In_ const Image* image) {
+		unsigned long long hash = ((unsigned long long)(unsigned int)image->width << 32 | (unsigned int)image->height) ^ (image->hasAlpha ? 1ULL << 63 : 0);
+		auto mix = [&hash](unsigned long long value) {
+			hash ^= value * 0xFF51AFD7ED558CCDULL;
+			hash = (hash << 31 | hash >> 33) * 0xC4CEB9FE1A85EC53ULL;
+		};
+		mix(0);
+		size_t rowSize = (size_t)image->width * 4;
+		for (int y = 0; y < image->height; y++) {
+			const unsigned char* row = image->getRowBytes(y);
+			size_t i = 0;
+			for (; i + 8 <= rowSize; i += 8) {
+				unsigned long long value;
+				memcpy(&value, row + i, sizeof(value));
+				mix(value);
+			}
+			if (i < rowSize) {
+				UINT32 value;
+				memcpy(&value, row + i, sizeof(value));
+				mix(value);
+			}
+		}
+		hash ^= hash >> 33;
+		return hash;
+	}
+
+	// Id of the image in the stream, writes its pixels first if they're new
+	bool imageId(_In_ const Image* image, _Out_ unsigned int& id) {
+		unsigned long long hash = hashImage(image);
+		auto found = images.find(hash);
+		if (found != images.end()) {
+			id = found->second;
+			return true;
+		}
+		id = nextImageId++;
+		images[hash] = id;
+		chunk.putUnsigned(id);
+		chunk.putUnsigned((unsigned int)image->width);
+		chunk.putUnsigned((unsigned int)image->height);
+		chunk.putByte(image->hasAlpha ? 1 : 0);
+		for (int y = 0; y < image->height; y++)
+			chunk.putBytes(image->getRowBytes(y), (size_t)image->width * 4);
+		stats.images++;
+		return writeChunk(DrawStreamChunk::Image);
+	}
+
+	// Writes the fields of the command its type uses
+	void putCommand(_In_ const DrawCommand& command) {
+		chunk.putByte((unsigned char)command.type);
+		chunk.putUnsigned(command.color);
+		chunk.putPoint(command.bounds.minPoint);
+		chunk.putUnsigned((unsigned int)command.bounds.width);
+		chunk.putUnsigned((unsigned int)command.bounds.height);
+		switch (command.type) {
+		case DrawCommandType::Clear:
+			break;
+		case DrawCommandType::Pixel:
+			chunk.putPoint(command.points[0]);
+			break;
+		case DrawCommandType::Rectangle:
+			chunk.putPoint(command.points[0]);
+			chunk.putPoint(command.points[1]);
+			break;
+		case DrawCommandType::Circle:
+		case DrawCommandType::AntialiasedCircle:
+			chunk.putPoint(command.points[0]);
+			chunk.putSigned(command.size);
+			break;
+		case DrawCommandType::EmptyCircle:
+		case DrawCommandType::AntialiasedEmptyCircle:
+			chunk.putPoint(command.points[0]);
+			chunk.putSigned(command.size);
+			chunk.putUnsigned(command.thickness);
+			break;
+		case DrawCommandType::Line:
+		case DrawCommandType::AntialiasedLine:
+			chunk.putPoint(command.points[0]);
+			chunk.putPoint(command.points[1]);
+			chunk.putUnsigned(command.thickness);
+			break;
+		case DrawCommandType::QuadraticBezier:
+		case DrawCommandType::CubicBezier:
+			chunk.putUnsigned(command.thickness);
+			chunk.putUnsigned((unsigned int)command.data);
+			chunk.putUnsigned((unsigned int)command.size);
+			break;
+		case DrawCommandType::Triangle:
+			for (int i = 0; i < 3; i++)
+				chunk.putPoint(command.points[i]);
+			break;
+		case DrawCommandType::Text:
+			chunk.putPoint(command.points[0]);
+			chunk.putSigned(command.size);
+			chunk.putUnsigned((unsigned int)command.data);
+			break;
+		case DrawCommandType::Image:
+			for (int i = 0; i < 3; i++)
+				chunk.putPoint(command.points[i]);
+			chunk.putUnsigned(command.thickness);
+			chunk.putUnsigned((unsigned int)command.data);
+			break;
+		}
+	}
+
+public:
+	DrawStreamWriter() {}
+	DrawStreamWriter(const DrawStreamWriter&) = delete;
+	DrawStreamWriter& operator=(const DrawStreamWriter&) = delete;
+
+	// Creates the file and starts the capture clock, returns false if it couldn't be created
+	bool open(_In_ const char* path) {
+		close();
+		file = fopen(path, "wb");
+		if (!file) return false;
+		unsigned char header[8];
+		memcpy(header, drawStreamMagic, 4);
+		for (int i = 0; i < 4; i++)
+			header[4 + i] = (unsigned char)(drawStreamVersion >> (i * 8));
+		if (fwrite(header, 1, sizeof(header), file) != sizeof(header)) {
+			close();
+			return false;
+		}
+		startTime = inputClock();
+		stats = Stats();
+		stats.bytes = sizeof(header);
+		return true;
+	}
+
+	bool isOpen() const {
+		return file != nullptr;
+	}
+
+	// Writes the draw calls captured in a frame of the size with the input events handled in it, returns false if they couldn't be written
+	// time is when the frame was drawn (inputClock), the images have to be alive until the frame is written
+	bool writeFrame(_In_ const DrawCommandList& list, _In_ int width, _In_ int height, _In_opt_ const InputEvent* events = nullptr,
+		_In_opt_ size_t eventCount = 0, _In_opt_ long long time = inputClock()) {
+		if (!file) return false;
+		std::vector<unsigned int> imageIds(list.imagePool.size());
+		for (size_t i = 0; i < list.imagePool.size(); i++)
+			if (!imageId(list.imagePool[i], imageIds[i])) return false;
+
+		chunk.putUnsigned((unsigned int)width);
+		chunk.putUnsigned((unsigned int)height);
+		chunk.putSigned(time - startTime);
+		chunk.putUnsigned(list.commands.size());
+		chunk.putUnsigned(list.textPool.size());
+		chunk.putUnsigned(list.pointPool.size());
+		chunk.putUnsigned(imageIds.size());
+		chunk.putUnsigned(eventCount);
+		for (const DrawCommand& command : list.commands)
+			putCommand(command);
+		for (wchar_t character : list.textPool)
+			chunk.putUnsigned((unsigned int)character);
+		// Points of the curves are close to the previous ones
+		vec2<int> previous(0, 0);
+		for (vec2<int> point : list.pointPool) {
+			chunk.putPoint(vec2<int>(point.x - previous.x, point.y - previous.y));
+			previous = point;
+		}
+		for (unsigned int id : imageIds)
+			chunk.putUnsigned(id);
+		for (size_t i = 0; i < eventCount; i++) {
+			chunk.putByte((unsigned char)events[i].type);
+			chunk.putSigned(events[i].code);
+			chunk.putPoint(vec2<int>(events[i].x, events[i].y));
+			chunk.putSigned(events[i].timestamp - startTime);
+		}
+		stats.frames++;
+		stats.commands += list.commands.size();
+		stats.inputEvents += eventCount;
+		return writeChunk(DrawStreamChunk::Frame);
+	}
+
+	// Amount of the data written since the file was opened
+	Stats getStats() const {
+		return stats;
+	}
+
+	// Closes the file, returns false if the data couldn't be written
+	bool close() {
+		if (!file) return true;
+		bool closed = fclose(file) == 0;
+		file = nullptr;
+		images.clear();
+		nextImageId = 0;
+		return closed;
+	}
+
+	~DrawStreamWriter() {
+		close();
+	}
+};
+
+// Reads the frames of a stream file written by DrawStreamWriter, the file is memory mapped
+// Every command is checked against the frame and the pools before it's returned, so damaged or hostile files can't make the
+// replay read or write outside of the target, and the glyphs of the texts are rasterized so that the frames can be replayed right away
+class DrawStreamReader {
+	const unsigned char* view = nullptr;
+	size_t viewSize = 0;
+	// Offset of the next chunk
+	size_t position = 0;
+	bool damaged = false;
+	// Images of the stream in the order of their ids
+	std::vector<std::unique_ptr<Image>> images;
+
+	// Reads an image chunk, the images already read before a rewind are kept
+	bool readImage(_Inout_ DrawStreamDecoder& decoder) {
+		unsigned int id = decoder.getCount(0xFFFFFFFF);
+		int width = (int)decoder.getCount(imageMaxSize);
+		int height = (int)decoder.getCount(imageMaxSize);
+		bool alpha = decoder.getByte() != 0;
+		if (decoder.hasFailed() || id > images.size()) return false;
+		if (id < images.size()) return true;
+		const unsigned char* pixels = decoder.getBytes((size_t)width * height * 4);
+		std::unique_ptr<Image> image(new Image());
+		if (!pixels || !image->create(width, height)) return false;
+		for (int y = 0; y < height; y++)
+			memcpy(image->getRow(y), pixels + (size_t)y * width * 4, (size_t)width * 4);
+		image->hasAlpha = alpha;
+		images.push_back(std::move(image));
+		return true;
+	}
+
+	// Reads the fields of a command, the pools aren't read yet so the indices are checked by readFrame
+	static void getCommand(_Inout_ DrawStreamDecoder& decoder, _Out_ DrawCommand& command) {
+		// Pixel coordinates, the triangles use fixed point ones
+		const long long limit = triangleMaxCoordinate;
+		command = DrawCommand();
+		unsigned int type = decoder.getByte();
+		if (type > (unsigned int)DrawCommandType::Image) {
+			decoder.fail();
+			return;
+		}
+		command.type = (DrawCommandType)type;
+		command.color = decoder.getCount(0xFFFFFFFF);
+		vec2<int> minPoint = decoder.getPoint(limit);
+		int boundsWidth = (int)decoder.getCount(limit);
+		command.bounds = Rect(minPoint, boundsWidth, (int)decoder.getCount(limit));
+		// The stream doesn't say if the bounds were cut off, so the commands keep them as their clip
+		command.clipped = true;
+		switch (command.type) {
+		case DrawCommandType::Clear:
+			break;
+		case DrawCommandType::Pixel:
+			command.points[0] = decoder.getPoint(limit);
+			break;
+		case DrawCommandType::Rectangle:
+			command.points[0] = decoder.getPoint(limit);
+			command.points[1] = decoder.getPoint(limit);
+			break;
+		case DrawCommandType::Circle:
+		case DrawCommandType::AntialiasedCircle:
+			command.points[0] = decoder.getPoint(limit);
+			command.size = decoder.getInt(drawStreamMaxRadius);
+			break;
+		case DrawCommandType::EmptyCircle:
+		case DrawCommandType::AntialiasedEmptyCircle:
+			command.points[0] = decoder.getPoint(limit);
+			command.size = decoder.getInt(drawStreamMaxRadius);
+			command.thickness = (unsigned short)decoder.getCount(drawStreamMaxRadius);
+			if (command.size + command.thickness > drawStreamMaxRadius)
+				decoder.fail();
+			break;
+		case DrawCommandType::Line:
+		case DrawCommandType::AntialiasedLine:
+			command.points[0] = decoder.getPoint(limit);
+			command.points[1] = decoder.getPoint(limit);
+			command.thickness = (unsigned short)decoder.getCount(0xFFFF);
+			break;
+		case DrawCommandType::QuadraticBezier:
+		case DrawCommandType::CubicBezier:
+			command.thickness = (unsigned short)decoder.getCount(0xFFFF);
+			command.data = (int)decoder.getCount(0x7FFFFFFF);
+			command.size = (int)decoder.getCount(0x7FFFFFFF);
+			break;
+		case DrawCommandType::Triangle:
+			for (int i = 0; i < 3; i++)
+				command.points[i] = decoder.getPoint(limit << subpixelBits);
+			break;
+		case DrawCommandType::Text:
+			command.points[0] = decoder.getPoint(limit);
+			command.size = decoder.getInt(drawStreamMaxTextSize);
+			command.data = (int)decoder.getCount(0x7FFFFFFF);
+			if (command.size <= 0)
+				decoder.fail();
+			break;
+		case DrawCommandType::Image:
+			command.points[0] = decoder.getPoint(limit);
+			command.points[1] = decoder.getPoint(imageMaxSize);
+			command.points[2] = decoder.getPoint(imageMaxSize);
+			command.thickness = (unsigned short)decoder.getCount((unsigned int)BlitMode::Alpha);
+			command.data = (int)decoder.getCount(0x7FFFFFFF);
+			break;
+		}
+	}
+
+	// Checks that the command only uses the pools and the part of the frame it's allowed to
+	bool isValid(_In_ const DrawCommand& command, _In_ const DrawStreamFrame& frame) const {
+		const Rect& bounds = command.bounds;
+		if (bounds.minPoint.x < 0 || bounds.minPoint.y < 0 || bounds.width <= 0 || bounds.height <= 0
+			|| bounds.maxPoint.x > frame.width || bounds.maxPoint.y > frame.height)
+			return false;
+		const DrawCommandList& list = frame.commands;
+		switch (command.type) {
+		case DrawCommandType::QuadraticBezier:
+		case DrawCommandType::CubicBezier:
+			return command.size >= 2 && (size_t)command.data + (size_t)command.size <= list.pointPool.size();
+		// The text pool ends with a 0, so every text in it is terminated
+		case DrawCommandType::Text:
+			return (size_t)command.data < list.textPool.size();
+		case DrawCommandType::Image: {
+			if ((size_t)command.data >= list.imagePool.size()) return false;
+			const Image& image = *list.imagePool[command.data];
+			return command.points[1].x >= 0 && command.points[1].y >= 0 && command.points[2].x > 0 && command.points[2].y > 0
+				&& command.points[1].x + command.points[2].x <= image.width && command.points[1].y + command.points[2].y <= image.height;
+		}
+		default:
+			return true;
+		}
+	}
+
+	// Reads a frame chunk into the frame
+	bool readFrame(_Inout_ DrawStreamDecoder& decoder, _Out_ DrawStreamFrame& frame) {
+		const long long limit = triangleMaxCoordinate;
+		frame.width = (int)decoder.getCount(imageMaxSize);
+		frame.height = (int)decoder.getCount(imageMaxSize);
+		frame.time = decoder.getSigned();
+		// Every command, character, point and image takes at least a byte, so the counts can't be bigger than the payload
+		size_t commandCount = decoder.getCount(decoder.remaining());
+		size_t textCount = decoder.getCount(decoder.remaining());
+		size_t pointCount = decoder.getCount(decoder.remaining());
+		size_t imageCount = decoder.getCount(decoder.remaining());
+		size_t eventCount = decoder.getCount(decoder.remaining());
+		if (decoder.hasFailed() || frame.width <= 0 || frame.height <= 0) return false;
+
+		DrawCommandList& list = frame.commands;
+		list.clear();
+		list.commands.resize(commandCount);
+		for (DrawCommand& command : list.commands)
+			getCommand(decoder, command);
+		list.textPool.resize(textCount);
+		for (wchar_t& character : list.textPool) {
+			unsigned int value = decoder.getCount(0x10FFFF);
+			character = (wchar_t)value;
+			if ((unsigned int)character != value)
+				decoder.fail();
+		}
+		if (textCount > 0 && list.textPool.back() != 0) return false;
+		list.pointPool.resize(pointCount);
+		vec2<int> previous(0, 0);
+		for (vec2<int>& point : list.pointPool) {
+			vec2<int> delta = decoder.getPoint(2 * limit);
+			point = vec2<int>(previous.x + delta.x, previous.y + delta.y);
+			if (point.x < -limit || point.x > limit || point.y < -limit || point.y > limit)
+				decoder.fail();
+			previous = point;
+		}
+		list.imagePool.resize(imageCount);
+		for (const Image*& image : list.imagePool) {
+			unsigned int id = decoder.getCount(0xFFFFFFFF);
+			if (id >= images.size()) return false;
+			image = images[id].get();
+		}
+		frame.events.resize(eventCount);
+		for (InputEvent& event : frame.events) {
+			unsigned int type = decoder.getByte();
+			if (type > (unsigned int)InputEventType::ButtonUp)
+				decoder.fail();
+			event.type = (InputEventType)type;
+			event.code = decoder.getInt(0x7FFFFFFF);
+			event.x = decoder.getInt(0x7FFFFFFF);
+			event.y = decoder.getInt(0x7FFFFFFF);
+			event.timestamp = decoder.getSigned();
+		}
+		if (decoder.hasFailed()) return false;
+
+		for (const DrawCommand& command : list.commands) {
+			if (!isValid(command, frame)) return false;
+			list.addBounds(command);
+			if (command.type == DrawCommandType::Text) {
+				GlyphAtlas& atlas = glyphCache().getAtlas(command.size);
+				for (const wchar_t* character = list.getText(command); *character; character++)
+					atlas.getGlyph(*character);
+			}
+		}
+		return true;
+	}
+
+public:
+	DrawStreamReader() {}
+	DrawStreamReader(const DrawStreamReader&) = delete;
+	DrawStreamReader& operator=(const DrawStreamReader&) = delete;
+
+	// Maps the file and checks its header, returns false if it isn't a stream of this version
+	bool open(_In_ const char* path) {
+		close();
+		view = (const unsigned char*)mapFile(path, viewSize);
+		if (!view) return false;
+		if (viewSize < 8 || memcmp(view, drawStreamMagic, 4) != 0
+			|| (unsigned int)(view[4] | view[5] << 8 | view[6] << 16 | (unsigned int)view[7] << 24) != drawStreamVersion) {
+			close();
+			return false;
+		}
+		position = 8;
+		return true;
+	}
+
+	bool isOpen() const {
+		return view != nullptr;
+	}
+
+	// Reads the next frame, returns false at the end of the stream or at damaged data (isDamaged)
+	bool nextFrame(_Out_ DrawStreamFrame& frame) {
+		if (!view || damaged) return false;
+		while (viewSize - position >= 5) {
+			const unsigned char* header = view + position;
+			size_t size = header[1] | header[2] << 8 | header[3] << 16 | (size_t)header[4] << 24;
+			if (viewSize - position - 5 < size) break;
+			position += 5 + size;
+			DrawStreamDecoder decoder(header + 5, size);
+			bool valid = true;
+			if (header[0] == (unsigned char)DrawStreamChunk::Image)
+				valid = readImage(decoder);
+			else if (header[0] == (unsigned char)DrawStreamChunk::Frame) {
+				valid = readFrame(decoder, frame);
+				if (valid) return true;
+			}
+			if (!valid) {
+				damaged = true;
+				position = viewSize;
+				return false;
+			}
+		}
+		// Anything but the end of the last chunk at the end of the file is damaged
+		damaged = position != viewSize;
+		position = viewSize;
+		return false;
+	}
+
+	// If the stream stopped at damaged data
+	bool isDamaged() const {
+		return damaged;
+	}
+
+	// Goes back to the first frame, the images are kept
+	void rewind() {
+		if (!view) return;
+		position = 8;
+		damaged = false;
+	}
+
+	// Number of the images read so far
+	size_t getImageCount() const {
+		return images.size();
+	}
+
+	// Unmaps the file and frees the images, the frames read from it can't be replayed anymore
+	void close() {
+		unmapFile(view, viewSize);
+		view = nullptr;
+		viewSize = 0;
+		position = 0;
+		damaged = false;
+		images.clear();
+	}
+
+	~DrawStreamReader() {
+		close();
+	}
+};
+
+#endif // !GRAPHICS_DRAW_STREAM
@@ -0,0 +1,71 @@
+#ifndef GRAPHICS_DYNAMIC_RESOLUTION
+#define GRAPHICS_DYNAMIC_RESOLUTION
+
+#include "Platform.hpp"
+#include "Geometry.hpp"
+#include <cmath>
+
+// Picks the scale of the internal resolution from the recent frame times
+// Long frames lower the scale so that the number of the pixels shrinks by the missing time, short ones raise it slowly back,
+// the scale is only changed after a few frames at the current one so the frames right after a resize don't count
+class DynamicResolution {
+public:
+	// Number of the frames averaged before the scale can change
+	static const int sampleCount = 8;
+	// Frame time to keep (in milliseconds)
+	float targetFrameTime = 1000.0f / 60.0f;
+	// Range of the scale
+	float minScale = 0.5f;
+	float maxScale = 1.0f;
+
+private:
+	float scale = 1.0f;
+	// Frame times at the current scale
+	float samples[sampleCount] = {};
+	int samplesTaken = 0;
+
+public:
+	// Adds the time of a frame (in milliseconds), returns true if the scale changed
+	bool addFrame(_In_ float frameTime) {
+		samples[samplesTaken++] = frameTime;
+		if (samplesTaken < sampleCount) return false;
+		samplesTaken = 0;
+		float average = 0.0f;
+		for (float sample : samples)
+			average += sample;
+		average /= sampleCount;
+
+		// The frame time is roughly proportional to the number of the pixels (scale squared)
+		float next = scale;
+		if (average > targetFrameTime * 1.05f)
+			next = scale * fmaxf(sqrtf(targetFrameTime / average), 0.75f);
+		else if (average < targetFrameTime * 0.75f)
+			next = scale * fminf(sqrtf(targetFrameTime / average), 1.1f);
+		next = fminf(fmaxf(next, minScale), maxScale);
+		// Small changes aren't worth a resize
+		if (fabsf(next - scale) < 0.02f && next != minScale && next != maxScale) return false;
+		if (next == scale) return false;
+		scale = next;
+		return true;
+	}
+
+	// Current scale
+	float getScale() const {
+		return scale;
+	}
+
+	// Starts over at the scale, clamped to the range
+	void reset(_In_ float startScale) {
+		scale = fminf(fmaxf(startScale, minScale), maxScale);
+		samplesTaken = 0;
+	}
+
+	// Internal size of the full size at the scale, the width is rounded to 8 pixels so that the rows fill whole SIMD steps
+	static vec2<int> scaledSize(_In_ vec2<int> size, _In_ float scale) {
+		int width = ((int)lrintf(size.x * scale) + 7) / 8 * 8;
+		int height = (int)lrintf(size.y * scale);
+		return vec2<int>(width < size.x ? width : size.x, height > 1 ? height : 1);
+	}
+};
+
+#endif // !GRAPHICS_DYNAMIC_RESOLUTION
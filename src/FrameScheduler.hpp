@@ -0,0 +1,197 @@
+#ifndef GRAPHICS_FRAME_SCHEDULER
+#define GRAPHICS_FRAME_SCHEDULER
+
+#include "Platform.hpp"
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+// Paces the main loop and splits the time into fixed update steps
+// The frames are started at the target frame rate by sleeping until their deadline, the last bit of the wait yields
+// instead since the OS wakes the thread up a bit late (by how much is measured, so it's usually well under a millisecond)
+// The time of the frames is added up and handed out in fixed steps, the part left over interpolates between the last two steps
+class FrameScheduler {
+public:
+	// Number of the frames the statistics are taken from
+	static const int historySize = 120;
+
+	// Statistics of the frame pacing
+	struct Stats {
+		// Frames ended so far and the ones that ended after their deadline
+		unsigned long long frames = 0;
+		unsigned long long missedFrames = 0;
+		// Fixed steps skipped because the frames were too long for maxStepsPerFrame
+		unsigned long long droppedSteps = 0;
+		// Time from the start of a frame to the start of the next one over the last frames, its standard deviation (the jitter)
+		// and the biggest difference from the target frame time (from the average without one), in milliseconds
+		double averageFrameTime = 0.0;
+		double jitter = 0.0;
+		double maxDeviation = 0.0;
+		// Share of the time spent sleeping
+		double sleepFraction = 0.0;
+	};
+
+	// Length of a fixed update step (in seconds)
+	double fixedTimestep = 1.0 / 60.0;
+	// Most fixed steps in one frame, the rest is dropped so that slow updates can't keep getting further behind
+	int maxStepsPerFrame = 8;
+
+private:
+	// Time between the frame starts (in nanoseconds), 0 doesn't wait at all
+	long long period = 0;
+	// When the next frame should start, 0 before the first frame
+	long long deadline = 0;
+	// How late the sleeps wake up, the sleeps end this much before the deadline
+	long long oversleep = 200000;
+	// Start of the current frame
+	long long frameStart = 0;
+	// Time not yet handed out in fixed steps (in nanoseconds) and when it was last added to
+	long long accumulated = 0;
+	long long lastUpdate = 0;
+	int stepsThisFrame = 0;
+	// Times between the last frame starts (in nanoseconds), the frame i is at i % historySize
+	long long intervals[historySize] = {};
+	long long slept[historySize] = {};
+	unsigned long long recorded = 0;
+	Stats counters;
+
+	// Length of a fixed step in nanoseconds
+	long long stepLength() const {
+		long long length = (long long)llround(fixedTimestep * 1e9);
+		return length > 0 ? length : 1;
+	}
+
+	// Sleeps until the time, yields for the part the OS could oversleep, returns the time it waited (in nanoseconds)
+	long long waitUntil(_In_ long long time) {
+		long long start = now();
+		long long sleepTime = time - start - oversleep;
+		if (sleepTime > 0) {
+			preciseSleep(sleepTime);
+			long long late = now() - (start + sleepTime);
+			// Follows waking up later faster than waking up sooner, but a single long wake up (like the OS
+			// running something else) doesn't make the next frames spin for all of that time
+			oversleep += (late - oversleep) / (late > oversleep ? 4 : 16);
+		}
+		long long current = now();
+		while (current < time) {
+			std::this_thread::yield();
+			current = now();
+		}
+		return current - start;
+	}
+
+public:
+	// Current time (in nanoseconds of the steady clock)
+	static long long now() {
+		return (long long)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	// Frames started per second, 0 starts them as soon as the previous one ends
+	void setTargetFrameRate(_In_ double framesPerSecond) {
+		period = framesPerSecond > 0.0 ? (long long)llround(1e9 / framesPerSecond) : 0;
+		deadline = 0;
+	}
+
+	// Frames started per second, 0 if they aren't paced
+	double getTargetFrameRate() const {
+		return period > 0 ? 1e9 / (double)period : 0.0;
+	}
+
+	// Starts a frame, the time since the last one is handed out by stepFixedUpdate
+	void beginFrame() {
+		long long current = now();
+		if (frameStart == 0)
+			frameStart = current;
+		if (lastUpdate != 0)
+			accumulated += current - lastUpdate;
+		lastUpdate = current;
+		stepsThisFrame = 0;
+	}
+
+	// Returns true while there is time left for another fixed step (call it in a loop every frame, after beginFrame)
+	bool stepFixedUpdate() {
+		long long step = stepLength();
+		if (accumulated < step) return false;
+		if (stepsThisFrame >= maxStepsPerFrame) {
+			// Too far behind, the simulation slows down instead
+			counters.droppedSteps += (unsigned long long)(accumulated / step);
+			accumulated %= step;
+			return false;
+		}
+		accumulated -= step;
+		stepsThisFrame++;
+		return true;
+	}
+
+	// Part of a fixed step left over (0 - 1), the frame shows the state this far between the last two steps
+	double getInterpolation() const {
+		return (double)accumulated / (double)stepLength();
+	}
+
+	// Leaves the time out of the fixed steps and the frame times, like the time spent waiting for input
+	void skipTime(_In_ long long nanoseconds) {
+		if (lastUpdate != 0)
+			lastUpdate += nanoseconds;
+		if (frameStart != 0)
+			frameStart += nanoseconds;
+		// The frames are paced again from the next one
+		deadline = 0;
+	}
+
+	// Ends the frame, waits until the next one should start
+	void endFrame() {
+		long long current = now();
+		long long waited = 0;
+		if (period > 0) {
+			// The first paced frame is timed from its start
+			if (deadline == 0)
+				deadline = frameStart != 0 ? frameStart : current;
+			deadline += period;
+			if (current > deadline) {
+				counters.missedFrames++;
+				// More than a frame behind, the next frames are paced from now instead of catching up
+				if (current - deadline > period)
+					deadline = current;
+			}
+			else
+				waited = waitUntil(deadline);
+			current = now();
+		}
+		counters.frames++;
+		if (frameStart != 0) {
+			intervals[recorded % historySize] = current - frameStart;
+			slept[recorded % historySize] = waited;
+			recorded++;
+		}
+		frameStart = current;
+	}
+
+	// Statistics of the last frames
+	Stats getStats() const {
+		Stats stats = counters;
+		int count = recorded < historySize ? (int)recorded : historySize;
+		if (count == 0) return stats;
+		double total = 0.0;
+		double sleptTotal = 0.0;
+		for (int i = 0; i < count; i++) {
+			total += (double)intervals[i];
+			sleptTotal += (double)slept[i];
+		}
+		double average = total / count;
+		double variance = 0.0;
+		double target = period > 0 ? (double)period : average;
+		for (int i = 0; i < count; i++) {
+			double difference = (double)intervals[i] - average;
+			variance += difference * difference;
+			double deviation = fabs((double)intervals[i] - target) / 1e6;
+			if (deviation > stats.maxDeviation)
+				stats.maxDeviation = deviation;
+		}
+		stats.averageFrameTime = average / 1e6;
+		stats.jitter = sqrt(variance / count) / 1e6;
+		stats.sleepFraction = total > 0.0 ? sleptTotal / total : 0.0;
+		return stats;
+	}
+};
+
+#endif // !GRAPHICS_FRAME_SCHEDULER
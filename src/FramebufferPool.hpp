@@ -0,0 +1,183 @@
+#ifndef GRAPHICS_FRAMEBUFFER_POOL
+#define GRAPHICS_FRAMEBUFFER_POOL
+
+#include "Platform.hpp"
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+// Owns the pixel buffers of the render targets and the swap chains
+// Released buffers are kept and handed out again, so resizing, switching the buffer count or recreating a target
+// of the same size doesn't go to the OS (and doesn't fault the fresh pages in again)
+// Buffers of at least a huge page can be backed by huge pages, so full frame passes miss the TLB much less often
+class FramebufferPool {
+public:
+	// Allocation statistics
+	struct Stats {
+		// Buffers allocated from the OS and handed out again from the pool
+		unsigned long long allocations = 0;
+		unsigned long long reuses = 0;
+		// Buffers given back to the OS
+		unsigned long long frees = 0;
+		// Buffers allocated with huge pages (with the transparent huge pages hint on Linux without the reserved ones)
+		unsigned long long hugePageAllocations = 0;
+		// Buffers in use and their size (in bytes)
+		int liveBuffers = 0;
+		size_t liveBytes = 0;
+		// Released buffers kept for reuse and their size (in bytes)
+		int cachedBuffers = 0;
+		size_t cachedBytes = 0;
+		// Most bytes allocated from the OS at once
+		size_t peakBytes = 0;
+	};
+
+private:
+	// Buffer allocated from the OS
+	struct Buffer {
+		void* pages;
+		// Allocated size (the requested one rounded up to the pages)
+		size_t capacity;
+		bool hugePages;
+	};
+
+	std::mutex mutex;
+	std::vector<Buffer> live;
+	// Released buffers, the oldest first
+	std::vector<Buffer> cached;
+	bool hugePages = false;
+	size_t maxCachedBytes = (size_t)128 << 20;
+	Stats stats;
+
+	// Returns the buffer to the OS
+	void freeBuffer(_In_ const Buffer& buffer) {
+		freePages(buffer.pages, buffer.capacity);
+		stats.frees++;
+	}
+
+	// Frees the oldest cached buffers until they take at most maxCachedBytes
+	void trimTo(_In_ size_t bytes) {
+		size_t freed = 0;
+		size_t count = 0;
+		while (count < cached.size() && stats.cachedBytes - freed > bytes) {
+			freeBuffer(cached[count]);
+			freed += cached[count].capacity;
+			count++;
+		}
+		cached.erase(cached.begin(), cached.begin() + (ptrdiff_t)count);
+		stats.cachedBytes -= freed;
+		stats.cachedBuffers = (int)cached.size();
+	}
+
+public:
+	FramebufferPool() {}
+	FramebufferPool(const FramebufferPool&) = delete;
+	FramebufferPool& operator=(const FramebufferPool&) = delete;
+
+	// Turns the huge pages on or off for the buffers allocated from now on, they're used only for buffers of at least a huge page
+	// On Windows they need the "Lock pages in memory" privilege, without it (or without any huge pages) the normal pages are used
+	void setHugePages(_In_ bool enabled) {
+		std::lock_guard<std::mutex> lock(mutex);
+		if (hugePages == enabled) return;
+		hugePages = enabled;
+		// The cached buffers have the other pages
+		trimTo(0);
+	}
+
+	// Most bytes of the released buffers kept for reuse, 0 frees every buffer right when it's released
+	void setMaxCachedBytes(_In_ size_t bytes) {
+		std::lock_guard<std::mutex> lock(mutex);
+		maxCachedBytes = bytes;
+		trimTo(maxCachedBytes);
+	}
+
+	// Page aligned memory for size bytes, zeroed unless zeroed is false, nullptr if it couldn't be allocated
+	void* acquire(_In_ size_t size, _In_opt_ bool zeroed = true) {
+		if (size == 0) return nullptr;
+		std::lock_guard<std::mutex> lock(mutex);
+		// The smallest cached buffer that fits, but not one much bigger than needed
+		size_t best = cached.size();
+		for (size_t i = 0; i < cached.size(); i++)
+			if (cached[i].capacity >= size && cached[i].capacity / 2 <= size && (best == cached.size() || cached[i].capacity < cached[best].capacity))
+				best = i;
+		if (best != cached.size()) {
+			Buffer buffer = cached[best];
+			cached.erase(cached.begin() + (ptrdiff_t)best);
+			stats.cachedBuffers--;
+			stats.cachedBytes -= buffer.capacity;
+			stats.reuses++;
+			live.push_back(buffer);
+			stats.liveBuffers++;
+			stats.liveBytes += buffer.capacity;
+			if (zeroed)
+				memset(buffer.pages, 0, size);
+			return buffer.pages;
+		}
+
+		// Fresh pages from the OS are always zeroed
+		Buffer buffer = Buffer{ nullptr, size, false };
+		size_t hugeSize = hugePageSize();
+		if (hugePages && hugeSize != 0 && size >= hugeSize) {
+			buffer.capacity = (size + hugeSize - 1) / hugeSize * hugeSize;
+			buffer.pages = allocateHugePages(buffer.capacity);
+			buffer.hugePages = buffer.pages != nullptr;
+		}
+		if (!buffer.pages) {
+			buffer.capacity = size;
+			buffer.pages = allocatePages(size);
+			// Freeing the cached buffers may make enough room
+			if (!buffer.pages && !cached.empty()) {
+				trimTo(0);
+				buffer.pages = allocatePages(size);
+			}
+			if (!buffer.pages) return nullptr;
+		}
+		stats.allocations++;
+		if (buffer.hugePages)
+			stats.hugePageAllocations++;
+		live.push_back(buffer);
+		stats.liveBuffers++;
+		stats.liveBytes += buffer.capacity;
+		if (stats.liveBytes + stats.cachedBytes > stats.peakBytes)
+			stats.peakBytes = stats.liveBytes + stats.cachedBytes;
+		return buffer.pages;
+	}
+
+	// Gives the buffer back to the pool, nullptr is ignored
+	void release(_In_opt_ void* pages) {
+		if (!pages) return;
+		std::lock_guard<std::mutex> lock(mutex);
+		for (size_t i = 0; i < live.size(); i++) {
+			if (live[i].pages != pages) continue;
+			Buffer buffer = live[i];
+			live[i] = live.back();
+			live.pop_back();
+			stats.liveBuffers--;
+			stats.liveBytes -= buffer.capacity;
+			cached.push_back(buffer);
+			stats.cachedBuffers++;
+			stats.cachedBytes += buffer.capacity;
+			trimTo(maxCachedBytes);
+			return;
+		}
+	}
+
+	// Frees all of the cached buffers
+	void trim() {
+		std::lock_guard<std::mutex> lock(mutex);
+		trimTo(0);
+	}
+
+	// Allocation statistics
+	Stats getStats() {
+		std::lock_guard<std::mutex> lock(mutex);
+		return stats;
+	}
+};
+
+// Pool of the process, never destroyed so the targets destroyed at the exit can still release their buffers to it
+inline FramebufferPool& framebufferPool() {
+	static FramebufferPool* instance = new FramebufferPool();
+	return *instance;
+}
+
+#endif // !GRAPHICS_FRAMEBUFFER_POOL
@@ -0,0 +1,63 @@
+#ifndef GRAPHICS_GEOMETRY
+#define GRAPHICS_GEOMETRY
+
+#include "Platform.hpp"
+
+// Circle equation check, in 64 bits so that radii over 46340 don't overflow
+#define CEQ(x, y, rSq) ((long long)(x) * (x) + (long long)(y) * (y) <= (rSq))
+
+template<class T>
+struct vec2 {
+	T x;
+	T y;
+	vec2() : x(0), y(0) {}
+	vec2(T x, T y) : x(x), y(y) {}
+};
+
+struct Rect {
+	vec2<int> minPoint;
+	vec2<int> maxPoint;
+	int width;
+	int height;
+
+	Rect() : minPoint(vec2<int>()), maxPoint(vec2<int>()), width(0), height(0) {};
+	Rect(vec2<int> min, vec2<int> max) : minPoint(min), maxPoint(max), width(max.x - min.x), height(max.y - min.y) {};
+	Rect(vec2<int> coords, int width, int height)
+		: maxPoint(vec2<int>(coords.x + width, coords.y + height)), minPoint(coords), width(width), height(height) {};
+
+	bool isPointInside(vec2<int> point) {
+		return point.x < maxPoint.x&& point.x > minPoint.x && point.y > minPoint.y && point.y < maxPoint.y;
+	}
+};
+
+// Area of the rectangle (in pixels)
+inline long long rectArea(_In_ const Rect& rect) {
+	return (long long)rect.width * (long long)rect.height;
+}
+
+// Smallest rectangle containing both rectangles
+inline Rect unionRect(_In_ const Rect& a, _In_ const Rect& b) {
+	return Rect(vec2<int>(a.minPoint.x < b.minPoint.x ? a.minPoint.x : b.minPoint.x, a.minPoint.y < b.minPoint.y ? a.minPoint.y : b.minPoint.y),
+		vec2<int>(a.maxPoint.x > b.maxPoint.x ? a.maxPoint.x : b.maxPoint.x, a.maxPoint.y > b.maxPoint.y ? a.maxPoint.y : b.maxPoint.y));
+}
+
+// Part of the rectangle a inside of the rectangle b, empty if they don't overlap
+inline Rect intersectRect(_In_ const Rect& a, _In_ const Rect& b) {
+	vec2<int> min = vec2<int>(a.minPoint.x > b.minPoint.x ? a.minPoint.x : b.minPoint.x, a.minPoint.y > b.minPoint.y ? a.minPoint.y : b.minPoint.y);
+	vec2<int> max = vec2<int>(a.maxPoint.x < b.maxPoint.x ? a.maxPoint.x : b.maxPoint.x, a.maxPoint.y < b.maxPoint.y ? a.maxPoint.y : b.maxPoint.y);
+	if (min.x >= max.x || min.y >= max.y) return Rect();
+	return Rect(min, max);
+}
+
+// Rectangle moved by the offset
+inline Rect offsetRect(_In_ const Rect& rect, _In_ vec2<int> offset) {
+	return Rect(vec2<int>(rect.minPoint.x + offset.x, rect.minPoint.y + offset.y), vec2<int>(rect.maxPoint.x + offset.x, rect.maxPoint.y + offset.y));
+}
+
+// Checks if the outer rectangle fully contains the inner one
+inline bool containsRect(_In_ const Rect& outer, _In_ const Rect& inner) {
+	return inner.minPoint.x >= outer.minPoint.x && inner.minPoint.y >= outer.minPoint.y
+		&& inner.maxPoint.x <= outer.maxPoint.x && inner.maxPoint.y <= outer.maxPoint.y;
+}
+
+#endif // !GRAPHICS_GEOMETRY
@@ -0,0 +1,232 @@
+#ifndef GRAPHICS_GLYPH_ATLAS
+#define GRAPHICS_GLYPH_ATLAS
+
+#include "Platform.hpp"
+#include "BuiltinFont.hpp"
+#include <vector>
+#include <memory>
+#include <unordered_map>
+
+// Biggest font size (in pixels), the atlases are never freed and a glyph of the built-in font takes 160 KB in this size
+const int glyphMaxSize = 512;
+
+// Coverage bitmap of a single glyph stored in the atlas
+struct Glyph {
+	// Index of the first coverage byte in the atlas
+	size_t offset = 0;
+	// Size of the coverage bitmap
+	int width = 0;
+	int height = 0;
+	// Position of the bitmap relative to the pen (pen is at the top left corner of the text line)
+	int left = 0;
+	int top = 0;
+	// Horizontal distance to the next glyph
+	int advance = 0;
+	// If the glyph has already been rasterized
+	bool loaded = false;
+};
+
+// Glyphs of one font in one size, each one rasterized once (on the first use) into a shared coverage (0 - 255) buffer
+class GlyphAtlas {
+private:
+	// Glyphs of the Latin-1 characters are looked up directly
+	Glyph latinGlyphs[256];
+	// All of the other characters
+	std::unordered_map<wchar_t, Glyph> otherGlyphs;
+#ifdef _WIN32
+	// Memory DC with the font selected, used only for rasterizing glyphs
+	HDC fontDC = nullptr;
+	HFONT font = nullptr;
+	HGDIOBJ oldFont = nullptr;
+	// Distance from the top of the line to the baseline
+	int ascent = 0;
+#endif
+
+	// Rasterizes the glyph using the built-in bitmap font, scaled to the size
+	void rasterizeBuiltin(_In_ wchar_t character, _In_ Glyph& glyph) {
+		int scale = builtinScale();
+		// Characters without a glyph are shown as a question mark
+		if (character < builtinFontFirst || character > builtinFontLast)
+			character = L'?';
+		const unsigned char* rows = builtinFont[character - builtinFontFirst];
+
+		glyph.width = builtinFontWidth * scale;
+		glyph.height = builtinFontHeight * scale;
+		glyph.advance = (builtinFontWidth + 1) * scale;
+		glyph.offset = coverage.size();
+		coverage.resize(coverage.size() + (size_t)glyph.width * glyph.height);
+
+		unsigned char* pixel = &coverage[glyph.offset];
+		for (int y = 0; y < glyph.height; y++)
+			for (int x = 0; x < glyph.width; x++)
+				*pixel++ = (rows[y / scale] >> (builtinFontWidth - 1 - x / scale)) & 1 ? 255 : 0;
+	}
+
+#ifdef _WIN32
+	// Rasterizes the glyph with GDI as an anti-aliased coverage bitmap
+	void rasterizeGDI(_In_ wchar_t character, _In_ Glyph& glyph) {
+		// Identity transformation
+		MAT2 matrix = { { 0, 1 }, { 0, 0 }, { 0, 0 }, { 0, 1 } };
+		GLYPHMETRICS metrics;
+		DWORD bufferSize = GetGlyphOutlineW(fontDC, character, GGO_GRAY8_BITMAP, &metrics, 0, nullptr, &matrix);
+		if (bufferSize == GDI_ERROR) {
+			// Glyph missing in the font
+			rasterizeBuiltin(character, glyph);
+			return;
+		}
+
+		glyph.advance = metrics.gmCellIncX;
+		glyph.left = metrics.gmptGlyphOrigin.x;
+		glyph.top = ascent - metrics.gmptGlyphOrigin.y;
+		glyph.offset = coverage.size();
+		// Whitespace has no bitmap, only the advance
+		if (bufferSize == 0)
+			return;
+
+		std::vector<unsigned char> buffer(bufferSize);
+		GetGlyphOutlineW(fontDC, character, GGO_GRAY8_BITMAP, &metrics, bufferSize, buffer.data(), &matrix);
+
+		glyph.width = metrics.gmBlackBoxX;
+		glyph.height = metrics.gmBlackBoxY;
+		coverage.resize(coverage.size() + (size_t)glyph.width * glyph.height);
+
+		// Rows of the GDI bitmap are DWORD aligned and have 65 levels of coverage (0 - 64)
+		int pitch = (glyph.width + 3) & ~3;
+		unsigned char* pixel = &coverage[glyph.offset];
+		for (int y = 0; y < glyph.height; y++)
+			for (int x = 0; x < glyph.width; x++) {
+				unsigned int level = buffer[y * pitch + x];
+				*pixel++ = (unsigned char)(level >= 64 ? 255 : level * 4);
+			}
+	}
+#endif
+
+	void rasterize(_In_ wchar_t character, _In_ Glyph& glyph) {
+#ifdef _WIN32
+		if (fontDC) {
+			rasterizeGDI(character, glyph);
+			glyph.loaded = true;
+			return;
+		}
+#endif
+		rasterizeBuiltin(character, glyph);
+		glyph.loaded = true;
+	}
+
+public:
+	// Font size (height of the font in pixels)
+	int size = 16;
+	// Height of a text line
+	int lineHeight = 0;
+	// Coverage of all of the rasterized glyphs
+	std::vector<unsigned char> coverage;
+
+	// Creates an atlas for the size, useGDI = false forces the built-in font
+	GlyphAtlas(_In_ int fontSize, _In_opt_ bool useGDI = true) : size(fontSize) {
+		lineHeight = builtinFontHeight * builtinScale();
+#ifdef _WIN32
+		if (!useGDI) return;
+		fontDC = CreateCompatibleDC(nullptr);
+		if (!fontDC) return;
+		font = CreateFont(size, 0, 0, 0, FW_NORMAL, FALSE, FALSE, FALSE, ANSI_CHARSET,
+			OUT_TT_PRECIS, CLIP_DEFAULT_PRECIS, DEFAULT_QUALITY,
+			DEFAULT_PITCH | FF_DONTCARE, L"Arial");
+		if (!font) {
+			DeleteDC(fontDC);
+			fontDC = nullptr;
+			return;
+		}
+		oldFont = SelectObject(fontDC, font);
+		TEXTMETRICW textMetrics;
+		GetTextMetricsW(fontDC, &textMetrics);
+		ascent = textMetrics.tmAscent;
+		lineHeight = textMetrics.tmHeight;
+#else
+		(void)useGDI;
+#endif
+	}
+
+	GlyphAtlas(const GlyphAtlas&) = delete;
+	GlyphAtlas& operator=(const GlyphAtlas&) = delete;
+
+	// Scale of the built-in font for the size
+	int builtinScale() const {
+		return size >= builtinFontHeight ? size / builtinFontHeight : 1;
+	}
+
+	// Returns the glyph of the character, rasterizing it if it's used for the first time
+	const Glyph& getGlyph(_In_ wchar_t character) {
+		Glyph& glyph = (unsigned int)character < 256 ? latinGlyphs[(unsigned int)character] : otherGlyphs[character];
+		if (!glyph.loaded)
+			rasterize(character, glyph);
+		return glyph;
+	}
+
+	// Returns the glyph of the character if it's already rasterized, nullptr otherwise
+	// Doesn't change the atlas, so it can be called from many threads at once
+	const Glyph* findGlyph(_In_ wchar_t character) const {
+		if ((unsigned int)character < 256)
+			return latinGlyphs[(unsigned int)character].loaded ? &latinGlyphs[(unsigned int)character] : nullptr;
+		auto glyph = otherGlyphs.find(character);
+		return glyph != otherGlyphs.end() && glyph->second.loaded ? &glyph->second : nullptr;
+	}
+
+	~GlyphAtlas() {
+#ifdef _WIN32
+		if (fontDC) {
+			SelectObject(fontDC, oldFont);
+			DeleteObject(font);
+			DeleteDC(fontDC);
+		}
+#endif
+	}
+};
+
+// Atlases of all of the used sizes, not thread safe
+// They're kept until the cache is cleared, the sizes are limited so there can only be glyphMaxSize of them
+class GlyphCache {
+private:
+	std::vector<std::unique_ptr<GlyphAtlas>> atlases;
+
+	// Size clamped to 1 - glyphMaxSize
+	static int clampSize(_In_ int size) {
+		return size < 1 ? 1 : size > glyphMaxSize ? glyphMaxSize : size;
+	}
+
+public:
+	// Use the built-in bitmap font even if GDI is available
+	bool forceBuiltinFont = false;
+
+	// Returns the atlas of the size, creating it if it's used for the first time, the size is clamped to 1 - glyphMaxSize
+	GlyphAtlas& getAtlas(_In_ int size) {
+		size = clampSize(size);
+		for (const std::unique_ptr<GlyphAtlas>& atlas : atlases)
+			if (atlas->size == size)
+				return *atlas;
+		atlases.push_back(std::unique_ptr<GlyphAtlas>(new GlyphAtlas(size, !forceBuiltinFont)));
+		return *atlases.back();
+	}
+
+	// Returns the atlas of the size if it's already created, nullptr otherwise
+	// Doesn't change the cache, so it can be called from many threads at once
+	const GlyphAtlas* findAtlas(_In_ int size) const {
+		size = clampSize(size);
+		for (const std::unique_ptr<GlyphAtlas>& atlas : atlases)
+			if (atlas->size == size)
+				return atlas.get();
+		return nullptr;
+	}
+
+	// Removes all of the atlases (for example after changing forceBuiltinFont)
+	void clear() {
+		atlases.clear();
+	}
+};
+
+// Glyph cache shared by all of the render targets
+inline GlyphCache& glyphCache() {
+	static GlyphCache cache;
+	return cache;
+}
+
+#endif // !GRAPHICS_GLYPH_ATLAS
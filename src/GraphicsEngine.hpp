@@ -2,105 +2,246 @@
 #define GRAPHICS_ENGINE
 
 #include <windows.h>
-
-// Circle equation check
-#define CEQ(x, y, rSq) ((x) * (x) + (y) * (y) <= rSq)
+#include "RenderTarget.hpp"
+#include "TileRenderer.hpp"
+#include "SwapChain.hpp"
+#include "Scale.hpp"
+#include "DynamicResolution.hpp"
+#include "InputQueue.hpp"
+#include "FrameScheduler.hpp"
+#include "DrawStream.hpp"
+#include <chrono>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
 
 // Processes the messages
 LRESULT CALLBACK WindowProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
 
-enum COLOR {
-	RED = 0xFF0000,
-	GREEN = 0x00FF00,
-	BLUE = 0x0000FF,
-	YELLOW = 0xFFFF00,
-	PINK = 0xFFC0CB,
-	PURPLE = 0x800080,
-	ORANGE = 0xFFA500,
-	WHITE = 0xFFFFFF,
-	BLACK = 0x000000,
-	GREY = 0x808080,
-};
-
-template<class T>
-struct vec2 {
-	T x;
-	T y;
-	vec2() : x(0), y(0) {}
-	vec2(T x, T y) : x(x), y(y) {}
-};
-
-struct Rect {
-	vec2<int> minPoint;
-	vec2<int> maxPoint;
-	int width;
-	int height;
-
-	Rect() : minPoint(vec2<int>()), maxPoint(vec2<int>()), width(0), height(0) {};
-	Rect(vec2<int> min, vec2<int> max) : minPoint(min), maxPoint(max), width(max.x - min.x), height(max.y - min.y) {};
-	Rect(vec2<int> coords, int width, int height)
-		: maxPoint(vec2<int>(coords.x + width, coords.y + height)), minPoint(coords), width(width), height(height) {};
-
-	bool isPointInside(vec2<int> point) {
-		return point.x < maxPoint.x&& point.x > minPoint.x && point.y > minPoint.y && point.y < maxPoint.y;
-	}
-};
+// Win32 window presenting a RenderTarget, the window is always 32bpp so the frames of the other formats are converted when presented
+template<class Format>
+class BasicGraphicsEngine : public BasicRenderTarget<Format> {
+public:
+	typedef typename Format::Pixel Pixel;
+	using BasicRenderTarget<Format>::bitmapWidth;
+	using BasicRenderTarget<Format>::bitmapHeight;
+	using BasicRenderTarget<Format>::create;
+	using BasicRenderTarget<Format>::markAllDirty;
+	using BasicRenderTarget<Format>::finishPresent;
+	using BasicRenderTarget<Format>::beginRecording;
+	using BasicRenderTarget<Format>::endRecording;
+	using BasicRenderTarget<Format>::beginCapture;
+	using BasicRenderTarget<Format>::endCapture;
+	using BasicRenderTarget<Format>::getCapture;
+	using BasicRenderTarget<Format>::drawImage;
+	using BasicRenderTarget<Format>::getClipRect;
+	using BasicRenderTarget<Format>::setClipRect;
+	using BasicRenderTarget<Format>::resetClipRect;
+#ifdef GRAPHICS_PROFILE
+	using BasicRenderTarget<Format>::drawFrameGraph;
+#endif
 
-class GraphicsEngine {
 private:
+	using BasicRenderTarget<Format>::memory;
+	using BasicRenderTarget<Format>::dirtyRegion;
+
 	// Name of the window class
 	const wchar_t* className = L"MyWindowClass";
 	// Handle to the current instance of the application.
 	HINSTANCE curInst = nullptr;
-	// Memory allocated for the DIB
-	void* memory = nullptr;
 	// Info about the DIB for the StretchDIBits
 	BITMAPINFO bitmapInfo = BITMAPINFO{};
 	// Window styles
 	int winStyle = WS_OVERLAPPED | WS_CAPTION | WS_SYSMENU | WS_MINIMIZEBOX | WS_VISIBLE;
-	// Windowed / fullscreen ratios to transform coordinates in the fullscreen mode
+	// Window / bitmap ratios to transform the mouse coordinates, in the fullscreen mode and at the lower internal resolutions
 	float transformW = 1.0f;
 	float transformH = 1.0f;
+	// Draws the recorded draw calls in the deferred mode, nullptr in the immediate mode
+	std::unique_ptr<BasicTileRenderer<Format>> tileRenderer;
+	// Draw calls recorded since the last present in the deferred mode
+	DrawCommandList deferredCommands;
+
+	// Presents the frames of the swap chain to the window on its present thread
+	class WindowSink : public BasicPresentSink<Format> {
+	public:
+		BasicGraphicsEngine* engine = nullptr;
+
+		void presentFrame(_In_ const Pixel* pixels, _In_ int, _In_ int, _In_ const DirtyRegion& region) override {
+			engine->presentPixels(pixels, region);
+			// The frames are presented in the order they were queued
+			long long inputTime = 0;
+			engine->frameInputTimes.pop(inputTime);
+			engine->addInputLatency(inputTime);
+		}
+	} windowSink;
+	// Buffers presented by another thread, inactive with a single buffer
+	BasicSwapChain<Format> swapChain;
+	// Frame converted to 32bpp for the window, only used by the formats other than BGRA32
+	std::vector<UINT32> presentBuffer;
+	// Scale of the internal resolution, the bitmap is the windowed size at 1
+	float renderScale = 1.0f;
+	// Picks the scale from the frame times in the dynamic resolution mode
+	DynamicResolution dynamicResolution;
+	bool dynamicResolutionEnabled = false;
+	// End of the previous frame in the dynamic resolution mode
+	std::chrono::steady_clock::time_point lastFrameEnd;
+	// Scales the frames of the lower internal resolutions up to the window instead of StretchDIBits
+	Upscaler upscaler;
+	// Upscaled frame of the size of the destination rectangle, from the framebuffer pool
+	UINT32* scaledPixels = nullptr;
+	BITMAPINFO scaledInfo = BITMAPINFO{};
+	// Input events for pollInput, written by the message pump
+	InputQueue inputEvents;
+	// Time of the first input event since the last frame was queued, 0 if there was none
+	long long pendingInputTime = 0;
+	// Input times of the frames queued to the swap chain and not presented yet
+	SpscRing<long long, 4> frameInputTimes;
+	// Paces the frames and hands out the fixed update steps
+	FrameScheduler scheduler;
+	// In the on-demand mode handleMessages waits for a message unless a frame was asked for with invalidate
+	bool onDemand = false;
+	std::atomic<bool> invalidated{ true };
+	// Set once the window was closed (WM_QUIT was received)
+	bool closed = false;
+	// Latency of the presented frames, also updated by the present thread
+	std::mutex inputLatencyMutex;
+	InputLatencyStats inputLatency;
+	// Draw calls and input events of the frame being captured, written to the stream at the end of the frame
+	DrawCommandList captureList;
+	std::vector<InputEvent> captureInputs;
+	DrawStreamWriter captureWriter;
+	// Pixels of the bitmap when the capture started, drawn first so that the replay starts from them
+	Image captureStart;
+
+	// Updates the latency with a presented frame that had its first input event at the time inputTime, 0 if it had none
+	void addInputLatency(_In_ long long inputTime) {
+		if (inputTime == 0) return;
+		long long now = inputClock();
+		std::lock_guard<std::mutex> lock(inputLatencyMutex);
+		inputLatency.add(inputTime, now);
+	}
+
+	// Timestamps an input event and queues it if the events are read
+	void recordInput(_In_ InputEventType type, _In_ int code) {
+		long long now = inputClock();
+		if (pendingInputTime == 0)
+			pendingInputTime = now;
+		if (queueInput)
+			inputEvents.push(InputEvent{ type, code, mouseX, mouseY, now });
+		if (captureWriter.isOpen())
+			captureInputs.push_back(InputEvent{ type, code, mouseX, mouseY, now });
+	}
 
-	// Clears entire screen (not just bitmap) with a chosen color
-	void clearEntireScreen(_In_ UINT32 color) {
-		if (memory) {
-			UINT32* pixel = (UINT32*)memory;
-			for (int index = 0; index < width * height; ++index) {
-				*pixel++ = color;
+	// Converts the regions of the frame to 32bpp, BGRA32 frames are presented as they are
+	const UINT32* convertPixels(_In_ const Pixel* pixels, _In_ const DirtyRegion& region) {
+		if constexpr (std::is_same<Format, BGRA32>::value)
+			return pixels;
+		else {
+			presentBuffer.resize((size_t)bitmapWidth * bitmapHeight);
+			for (int i = 0; i < region.count; i++) {
+				const Rect& rect = region.rects[i];
+				for (int y = rect.minPoint.y; y < rect.maxPoint.y; y++) {
+					size_t offset = (size_t)y * bitmapWidth + rect.minPoint.x;
+					Format::toBGRA(pixels + offset, presentBuffer.data() + offset, (size_t)rect.width);
+				}
 			}
+			return presentBuffer.data();
 		}
 	}
 
-	// Fills a triangle with 2 parallel bottom corners
-	void fillBottomFlatTriangle(_In_ vec2<int> v1, _In_ vec2<int> v2, _In_ vec2<int> v3, _In_  UINT32 color) {
-		// Get inverted slopes
-		float invslope1 = (float)(v2.x - v1.x) / (float)(v2.y - v1.y);
-		float invslope2 = (float)(v3.x - v1.x) / (float)(v3.y - v1.y);
-		// X of the left and right end of the current line
-		float curx1 = (float)v1.x;
-		float curx2 = (float)v1.x;
-		// Itarate thru the Y coordinates of the triangle down and draw lines calculating Xs of both ends using the inverted slope
-		for (int scanlineY = v1.y; scanlineY <= v2.y; scanlineY++) {
-			drawLine(vec2<int>((int)curx1, scanlineY), vec2<int>((int)curx2, scanlineY), color);
-			curx1 += invslope1;
-			curx2 += invslope2;
+	// Upscales the regions of a frame rendered at a lower resolution with the engine scaler and presents them without stretching
+	void presentScaled(_In_ const UINT32* pixels, _In_ const DirtyRegion& region, _In_ int destWidth, _In_ int destHeight) {
+		if (!scaledPixels || scaledInfo.bmiHeader.biWidth != destWidth || scaledInfo.bmiHeader.biHeight != -destHeight) {
+			// The whole frame is dirty after the window or the bitmap changed size, so the old pixels don't matter
+			framebufferPool().release(scaledPixels);
+			scaledPixels = (UINT32*)framebufferPool().acquire((size_t)destWidth * destHeight * sizeof(UINT32), false);
+			if (!scaledPixels) return;
+			scaledInfo = bitmapInfo;
+			scaledInfo.bmiHeader.biWidth = destWidth;
+			scaledInfo.bmiHeader.biHeight = -destHeight;
+		}
+		for (int i = 0; i < region.count; i++) {
+			Rect dest = Upscaler::destinationRect(region.rects[i], bitmapWidth, bitmapHeight, destWidth, destHeight);
+			upscaler.scale(pixels, bitmapWidth, bitmapHeight, scaledPixels, destWidth, destHeight, dest, scaleFilter);
+			StretchDIBits(hdc,
+				marginHorizontal + dest.minPoint.x, marginVertical + dest.minPoint.y, dest.width, dest.height,
+				dest.minPoint.x, destHeight - dest.maxPoint.y, dest.width, dest.height,
+				scaledPixels, &scaledInfo,
+				DIB_RGB_COLORS, SRCCOPY);
+		}
+	}
+
+	// Stretches the regions of the pixels of a frame to the window
+	void presentPixels(_In_ const Pixel* framePixels, _In_ const DirtyRegion& region) {
+		GRAPHICS_PROFILE_SCOPE("presentPixels");
+		const UINT32* pixels = convertPixels(framePixels, region);
+		// Size of the destination rectangle
+		int destWidth = width - marginHorizontal * 2;
+		int destHeight = height - marginVertical * 2;
+
+		// The lower internal resolutions are upscaled by the engine
+		if ((dynamicResolutionEnabled || renderScale != 1.0f) && (destWidth != bitmapWidth || destHeight != bitmapHeight)) {
+			presentScaled(pixels, region, destWidth, destHeight);
+			return;
+		}
+
+		// Only the regions that changed since the last frame get presented
+		for (int i = 0; i < region.count; i++) {
+			const Rect& rect = region.rects[i];
+			// Map the rectangle to the window, the edges are mapped the same way for every rectangle so that there are no seams
+			int destMinX = rect.minPoint.x * destWidth / bitmapWidth;
+			int destMinY = rect.minPoint.y * destHeight / bitmapHeight;
+			int destMaxX = rect.maxPoint.x * destWidth / bitmapWidth;
+			int destMaxY = rect.maxPoint.y * destHeight / bitmapHeight;
+
+			// Strech the rows and columns of the color data of the source rectangle
+			// to fit the destination rectangle
+			StretchDIBits(hdc,                                                       // The handle to the device context
+				marginHorizontal + destMinX, marginVertical + destMinY,              // The destination rectangle top left corner
+				destMaxX - destMinX, destMaxY - destMinY,                            // The destination rectangle size
+				// The source rectangle (bottom left corner coordinates and size), StretchDIBits
+				// measures the source rectangle from the bottom even if the DIB is top-down
+				rect.minPoint.x, bitmapHeight - rect.maxPoint.y, rect.width, rect.height,
+				pixels, &bitmapInfo,                                                 // A pointer to the image bitmap and bitmap info
+				DIB_RGB_COLORS, SRCCOPY);                                            // Specifies whether bmiColors contains RGB values or indexes, a raster-operation code 
 		}
 	}
 
-	// Fills a triangle with 2 parallel top corners
-	void fillTopFlatTriangle(_In_ vec2<int> v1, _In_ vec2<int> v2, _In_ vec2<int> v3, _In_  UINT32 color) {
-		// Get inverted slopes
-		float invslope1 = (float)(v3.x - v1.x) / (float)(v3.y - v1.y);
-		float invslope2 = (float)(v3.x - v2.x) / (float)(v3.y - v2.y);
-		// X of the left and right end of the current line
-		float curx1 = (float)v3.x;
-		float curx2 = (float)v3.x;
-		// Itarate thru the Y coordinates of the triangle up and draw lines calculating Xs of both ends using the inverted slope
-		for (int scanlineY = v3.y; scanlineY > v1.y; scanlineY--) {
-			drawLine(vec2<int>((int)curx1, scanlineY), vec2<int>((int)curx2, scanlineY), color);
-			curx1 -= invslope1;
-			curx2 -= invslope2;
+	// Maps the mouse from the window to the bitmap, at every internal resolution and in the fullscreen mode
+	void updateMouseTransform() {
+		transformW = (float)bitmapWidth / (float)(width - marginHorizontal * 2);
+		transformH = (float)bitmapHeight / (float)(height - marginVertical * 2);
+	}
+
+	// Makes the bitmap the windowed size at the scale, everything has to be drawn again afterwards
+	void resizeBitmap(_In_ float scale) {
+		flush();
+		renderScale = scale;
+		vec2<int> size = DynamicResolution::scaledSize(vec2<int>(windowedWidth, windowedHeight), scale);
+		if (size.x == bitmapWidth && size.y == bitmapHeight) return;
+		// The swap chain buffers are made again in the new size
+		int buffers = getBufferCount();
+		bool preserveContents = swapChain.preserveContents;
+		swapChain.detach(*this);
+		create(size.x, size.y);
+		bitmapInfo.bmiHeader.biWidth = bitmapWidth;
+		bitmapInfo.bmiHeader.biHeight = -bitmapHeight;
+		if (buffers > 1)
+			setBufferCount(buffers, preserveContents);
+		updateMouseTransform();
+	}
+
+	// Paints the margins around the stretched bitmap black in the fullscreen mode, nothing else draws over them
+	void clearMargins() {
+		if (marginHorizontal > 0) {
+			PatBlt(hdc, 0, 0, marginHorizontal, height, BLACKNESS);
+			PatBlt(hdc, width - marginHorizontal, 0, marginHorizontal, height, BLACKNESS);
+		}
+		if (marginVertical > 0) {
+			PatBlt(hdc, 0, 0, width, marginVertical, BLACKNESS);
+			PatBlt(hdc, 0, height - marginVertical, width, marginVertical, BLACKNESS);
 		}
 	}
 
@@ -120,11 +261,14 @@ public:
 	// Vertical and horizontal margin in fullscreen mode
 	int marginHorizontal = 0;
 	int marginVertical = 0;
-	// Size of the bitmap
-	int bitmapWidth = width;
-	int bitmapHeight = height;
 	// Title of the window
 	const wchar_t* title = L"GraphicsEngine";
+	// Filter upscaling the lower internal resolutions
+	ScaleFilter scaleFilter = ScaleFilter::Bilinear;
+#ifdef GRAPHICS_PROFILE
+	// If the frame time graph is drawn over the bottom left corner of every frame
+	bool showFrameGraph = false;
+#endif
 	// Mouse positon
 	int mouseX = 0;
 	int mouseY = 0;
@@ -137,6 +281,8 @@ public:
 	struct keyState {
 		bool isHeld;
 	} keys[256];
+	// If the input events are queued for pollInput besides updating the state above, only turn it on if something reads them
+	bool queueInput = false;
 
 	// Creates a window
 	int createWindow(_In_ HINSTANCE currentInstance, _In_opt_ int windowWidth = 800, _In_opt_ int windowHeight = 600,
@@ -144,10 +290,8 @@ public:
 		// Set the class variables
 		windowedWidth = windowWidth;
 		width = windowWidth;
-		bitmapWidth = windowWidth;
 		windowedHeight = windowHeight;
 		height = windowHeight;
-		bitmapHeight = windowHeight;
 		curInst = currentInstance;
 		title = windowTitle;
 
@@ -178,11 +322,8 @@ public:
 		// Get handle to the device context of the window
 		hdc = GetDC(hwnd);
 
-		// Allocate memory for the bitmap 
-		memory = VirtualAlloc(0,                    // Starting address of the region to allocate
-			width * height * sizeof(unsigned int),  // Size of the region (in bytes)
-			MEM_RESERVE | MEM_COMMIT,               // Type of memory allocation
-			PAGE_READWRITE);                        // Memory protection for the region
+		// Allocate memory for the bitmap
+		create(windowWidth, windowHeight);
 
 		// Allocate memory for the keys
 		memset(keys, 0, 256 * sizeof(keyState));
@@ -195,55 +336,81 @@ public:
 		bitmapInfo.bmiHeader.biPlanes = 1;
 		bitmapInfo.bmiHeader.biBitCount = 32;         // Number of bits used to represent each pixel  
 		bitmapInfo.bmiHeader.biCompression = BI_RGB;  // Compression of the bitmap
-		// When entering the fullscreen mode for the first time there appear defects on the margins
-		// Quickly enter and exit the fullscreen mode after creating the window
-		// So that defects don't appear if the user goes to the fullscreen mode
-		enterFullscreen();
-		exitFullscreen();
 
 		return 0;
 	}
 
-	// Handles messages
-	void handleMessages() {
+	// Handles messages and starts the frame, returns false once the window was closed
+	// In the on-demand mode it first waits for a message (input, resizing, uncovering the window...) or invalidate
+	bool handleMessages() {
+		GRAPHICS_PROFILE_SCOPE("handleMessages");
+		if (onDemand && !closed && !invalidated.exchange(false)) {
+			long long start = FrameScheduler::now();
+			WaitMessage();
+			// The time spent waiting is neither the frame time nor simulated time
+			long long waited = FrameScheduler::now() - start;
+			scheduler.skipTime(waited);
+			lastFrameEnd += std::chrono::nanoseconds(waited);
+		}
 		MSG msg;
 		while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE)) {
+			if (msg.message == WM_QUIT)
+				closed = true;
 			TranslateMessage(&msg);
 			DispatchMessage(&msg);
 		}
+		scheduler.beginFrame();
+		return !closed;
 	}
 
 	// Message processing
 	LRESULT CALLBACK processMessage(_In_ HWND hwnd, _In_ UINT msg, _In_ WPARAM wParam, _In_ LPARAM lParam) {
 		switch (msg) {
 		case WM_KEYDOWN:
-			keys[wParam].isHeld = true;
+			keys[wParam & 0xFF].isHeld = true;
+			recordInput(InputEventType::KeyDown, (int)(wParam & 0xFF));
 			break;
 		case WM_KEYUP:
-			keys[wParam].isHeld = false;
+			keys[wParam & 0xFF].isHeld = false;
+			recordInput(InputEventType::KeyUp, (int)(wParam & 0xFF));
 			break;
 		case WM_DESTROY:
 			PostQuitMessage(0);
 			return 0;
+		case WM_PAINT:
+			// The window got uncovered or resized, everything has to be presented again
+			markAllDirty();
+			if (marginHorizontal > 0 || marginVertical > 0) {
+				// The present thread can't draw to the window at the same time
+				swapChain.waitIdle();
+				clearMargins();
+			}
+			return DefWindowProc(hwnd, msg, wParam, lParam);
 		case WM_MOUSEMOVE:
 			mouseX = (int)((float)(LOWORD(lParam) - marginHorizontal) * transformW);
 			mouseY = (int)((float)(HIWORD(lParam) - marginVertical) * transformH);
+			recordInput(InputEventType::MouseMove, 0);
 			break;
 		case WM_LBUTTONDOWN:
 			lbPress = true;
+			recordInput(InputEventType::ButtonDown, (int)MouseButton::Left);
 			break;
 		case WM_LBUTTONUP:
+			// Two clicks in one frame are still a click, the events have both of them
 			if (lbPress)
-				lbClick = !lbClick;
+				lbClick = true;
 			lbPress = false;
+			recordInput(InputEventType::ButtonUp, (int)MouseButton::Left);
 			break;
 		case WM_RBUTTONDOWN:
 			rbPress = true;
+			recordInput(InputEventType::ButtonDown, (int)MouseButton::Right);
 			break;
 		case WM_RBUTTONUP:
 			if (rbPress)
-				rbClick = !rbClick;
+				rbClick = true;
 			rbPress = false;
+			recordInput(InputEventType::ButtonUp, (int)MouseButton::Right);
 			break;
 		default:
 			return DefWindowProc(hwnd, msg, wParam, lParam);
@@ -251,331 +418,268 @@ public:
 		return 0;
 	}
 
-	// Code that has to be run at the end of the main loop
-	void mainLoopEndEvents() {
-		// Strech the rows and columns of the color data of the source rectangle
-		// to fit the destination rectangle
-		StretchDIBits(hdc,                                              // The handle to the device context
-			marginHorizontal, marginVertical,                           // The destination rectangle top left corner
-			width - marginHorizontal * 2, height - marginVertical * 2,  // The destination rectangle size
-			0, 0, bitmapWidth, bitmapHeight,                            // The source rectangle (top left corner coordinates and size)  
-			memory, &bitmapInfo,                                        // A pointer to the image bitmap and bitmap info
-			DIB_RGB_COLORS, SRCCOPY);                                   // Specifies whether bmiColors contains RGB values or indexes, a raster-operation code 
-
-		// End button click event
-		rbClick = false;
-		lbClick = false;
+	// Starts the frames at the frame rate by sleeping at the end of mainLoopEndEvents, 0 doesn't wait
+	void setTargetFrameRate(_In_ double framesPerSecond) {
+		scheduler.setTargetFrameRate(framesPerSecond);
 	}
 
-	void destroy() {
-		DestroyWindow(hwnd);
+	// Splits the time into steps of the length (in seconds) for stepFixedUpdate, at most maxSteps per frame
+	void setFixedTimestep(_In_ double seconds, _In_opt_ int maxSteps = 8) {
+		scheduler.fixedTimestep = seconds;
+		scheduler.maxStepsPerFrame = maxSteps;
 	}
 
-	// Clears screen with a chosen color
-	void clearScreen(_In_ UINT32 color = BLACK) {
-		if (memory) {
-			UINT32* pixel = (UINT32*)memory;
-			for (int index = 0; index < bitmapWidth * bitmapHeight; ++index) {
-				*pixel++ = color;
-			}
-		}
+	// Length of a fixed update step (in seconds)
+	double getFixedTimestep() const {
+		return scheduler.fixedTimestep;
 	}
 
-	// Draws a pixel with custom color at specified coordinates
-	void drawPixel(_In_ int x, _In_ int y, _In_ UINT32 color) {
-		if (memory && x < bitmapWidth && y < bitmapHeight && x > 0 && y > 0) {
-			UINT32* pixel = (UINT32*)memory;
-			pixel += y * bitmapWidth + x;
-			*pixel = color;
-		}
+	// Returns true while the frame has time for another fixed update step, called in a loop after handleMessages
+	bool stepFixedUpdate() {
+		return scheduler.stepFixedUpdate();
 	}
 
-	// Draws text on the screen
-	void drawText(_In_ int x, _In_ int y, _In_ const wchar_t* text, _In_ int size = 16, _In_ UINT32 color = WHITE) {
-		if (!memory || !text) return;
-
-		// Create a memory DC compatible with the window DC
-		HDC memDC = CreateCompatibleDC(hdc);
-		if (!memDC) return;
-
-		// Create a BITMAPINFO structure
-		BITMAPINFO bmpInfo = {};
-		bmpInfo.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
-		bmpInfo.bmiHeader.biWidth = bitmapWidth;
-		bmpInfo.bmiHeader.biHeight = -bitmapHeight;  // Negative for top-down DIB
-		bmpInfo.bmiHeader.biPlanes = 1;
-		bmpInfo.bmiHeader.biBitCount = 32;
-		bmpInfo.bmiHeader.biCompression = BI_RGB;
-
-		// Create a DIB section linked to the memory
-		void* dibMemory = nullptr;
-		HBITMAP hBitmap = CreateDIBSection(memDC, &bmpInfo, DIB_RGB_COLORS, &dibMemory, NULL, 0);
-		if (!hBitmap) {
-			DeleteDC(memDC);
-			return;
-		}
-
-		// Copy existing pixel data from `memory` to `dibMemory`
-		memcpy(dibMemory, memory, bitmapWidth * bitmapHeight * sizeof(UINT32));
+	// Part of a fixed step (0 - 1) left after the updates, drawing the state this far between the last two steps makes the motion smooth
+	double getInterpolation() const {
+		return scheduler.getInterpolation();
+	}
 
-		// Select the bitmap into the memory DC
-		HBITMAP oldBitmap = (HBITMAP)SelectObject(memDC, hBitmap);
+	// Turns the on-demand mode on or off, in it handleMessages waits until there is a message or invalidate is called
+	// The loop doesn't use any CPU while nothing happens, animations have to call invalidate to get the next frame
+	void setOnDemand(_In_ bool enabled) {
+		onDemand = enabled;
+		invalidate();
+	}
 
-		// Set text color
-		COLORREF textColor = RGB(
-			(color >> 16) & 0xFF,  // Red
-			(color >> 8) & 0xFF,   // Green
-			color & 0xFF           // Blue
-		);
+	// If the frames are only drawn on demand
+	bool isOnDemand() const {
+		return onDemand;
+	}
 
-		SetTextColor(memDC, textColor);
-		SetBkMode(memDC, TRANSPARENT);
+	// Asks for another frame in the on-demand mode, can be called from any thread
+	void invalidate() {
+		invalidated = true;
+		// Wakes up a waiting handleMessages
+		if (hwnd)
+			PostMessage(hwnd, WM_NULL, 0, 0);
+	}
 
-		// Create a font (optional, if you want custom font)
-		HFONT hFont = CreateFont(size, 0, 0, 0, FW_NORMAL, FALSE, FALSE, FALSE, ANSI_CHARSET,
-			OUT_TT_PRECIS, CLIP_DEFAULT_PRECIS, DEFAULT_QUALITY,
-			DEFAULT_PITCH | FF_DONTCARE, L"Arial");
+	// Frame times, the jitter and the missed frames of the last frames
+	FrameScheduler::Stats getFrameStats() const {
+		return scheduler.getStats();
+	}
 
-		if (hFont) {
-			SelectObject(memDC, hFont);
+	// Writes every draw call and input event from now on to a stream file (DrawStream.hpp), until stopCapture
+	// The frames can then be replayed on a RenderTarget by src/bench/replay.cpp, in BGRA32. The replay starts from the current pixels
+	// and gives the same frames, unless the swap chain doesn't preserve its contents. Returns false if the file couldn't be created
+	bool startCapture(_In_ const char* path) {
+		stopCapture();
+		flush();
+		if (!captureStart.create(bitmapWidth, bitmapHeight) || !captureWriter.open(path)) {
+			captureStart.release();
+			return false;
 		}
+		for (int y = 0; y < bitmapHeight; y++)
+			Format::toBGRA((const Pixel*)memory + (size_t)y * bitmapWidth, captureStart.getRow(y), (size_t)bitmapWidth);
+		beginCapture(captureList);
+		// Same pixels as the bitmap already has, drawn over all of it whatever the clip rectangle is
+		Rect clip = getClipRect();
+		resetClipRect();
+		drawImage(captureStart, 0, 0);
+		setClipRect(clip);
+		return true;
+	}
 
-		// Draw text onto the memory bitmap
-		TextOutW(memDC, x, y, text, lstrlenW(text));
+	// Stops the capture and closes the stream file, the draw calls of the current frame aren't written
+	void stopCapture() {
+		// The recorded draw calls can still draw the first pixels
+		flush();
+		endCapture();
+		captureWriter.close();
+		captureList.clear();
+		captureInputs.clear();
+		captureStart.release();
+	}
 
-		// Copy the modified bitmap back to `memory`
-		memcpy(memory, dibMemory, bitmapWidth * bitmapHeight * sizeof(UINT32));
+	// If the frames are captured
+	bool isCapturing() const {
+		return captureWriter.isOpen();
+	}
 
-		// Cleanup
-		SelectObject(memDC, oldBitmap);
-		DeleteObject(hBitmap);
-		if (hFont) DeleteObject(hFont);
-		DeleteDC(memDC);
+	// Frames, draw calls, input events and bytes written by the capture
+	DrawStreamWriter::Stats getCaptureStats() const {
+		return captureWriter.getStats();
 	}
 
+	// Takes the oldest queued input event, returns false if there are none
+	// Events are only queued with queueInput, they can be read by another thread than the one handling the messages (but only one)
+	bool pollInput(_Out_ InputEvent& event) {
+		return inputEvents.pop(event);
+	}
 
-	// Draws a rectangle
-	void drawRectangle(_In_ vec2<int> coords, _In_ int recWidth, _In_ int recHeight, _In_ UINT32 color) {
-		UINT32* pixel = (UINT32*)memory;
-		pixel += coords.y * bitmapWidth + coords.x;
-		// For each row of the rectangle draw pixels
-		for (int y = 0; y < recHeight; ++y) {
-			for (int x = 0; x < recWidth; ++x)
-				*pixel++ = color;
-			pixel += bitmapWidth - recWidth;
-		}
+	// Number of the input events dropped because nothing read them fast enough
+	unsigned long long getDroppedInput() const {
+		return inputEvents.getDropped();
 	}
 
-	// Draws a rectangle from Rect
-	void drawRectangle(_In_ Rect rect, _In_ UINT32 color) {
-		drawRectangle(rect.minPoint, rect.width, rect.height, color);
-	}
-
-	// Draws a filled circle
-	void drawCircle(_In_ vec2<int> origin, _In_ int radius, _In_  UINT32 color) {
-		// Check for the trivial case of a 1 pixel radius circle
-		if (radius > 1) {
-			// Radius squared
-			int rSq = radius * radius;
-			// Traverse the y coordinates of the circle (from top (-) to bottom (+))
-			for (int y = -radius; y <= radius; y++)
-				// For each row length of the 2 radii
-				for (int x = -radius; x <= radius; x++)
-					// If the pixel is within the circle
-					if (CEQ(x, y, rSq))
-						drawPixel(origin.x + x, origin.y + y, color);
-		}
-		else
-			drawPixel(origin.x, origin.y, color);
-	}
-
-	// Draws and empty circle
-	void drawEmptyCircle(_In_ vec2<int> origin, _In_ int radius, _In_  UINT32 color, _In_opt_ unsigned short thickness = 1) {
-		// Radius squared
-		int rSq = radius * radius;
-		// Traverse the y coordinates of the circle (from top (-) to bottom (+))
-		for (int y = -radius; y <= radius; y++) {
-			// Traverse the circle's x coordinates (from left (-) to right (+))
-			for (int x = -radius; x <= radius; x++)
-				// If the pixel is within the circle
-				if (CEQ(x, y, rSq)) {
-					// Draw pixels of the circle until there is other pixel above or below
-					drawCircle(vec2<int>(origin.x + x, origin.y + y), thickness, color);
-					if (CEQ(x, y + 1, rSq) && CEQ(x, y - 1, rSq))
-						break;
-				}
-			// Traverse the circle's x coordinates (from right (+) to left (-))
-			for (int x = radius; x >= -radius; x--)
-				// If the pixel is within the circle
-				if (CEQ(x, y, rSq)) {
-					// Draw pixels of the circle until there is other pixel above or below
-					drawCircle(vec2<int>(origin.x + x, origin.y + y), thickness, color);
-					if (CEQ(x, y + 1, rSq) && CEQ(x, y - 1, rSq))
-						break;
-				}
+	// Time from the first input event of the frames to the end of presenting them
+	InputLatencyStats getInputLatency() {
+		std::lock_guard<std::mutex> lock(inputLatencyMutex);
+		return inputLatency;
+	}
 
+	// Turns the deferred mode on or off, in the deferred mode the draw calls are only recorded
+	// and drawn by a pool of threads (0 uses all of the hardware threads) right before presenting, returns if it's on
+	// The speedup over 1 thread hasn't been measured and on 1 thread the recording and the binning make it slower (0.8-0.9x),
+	// so with all of the hardware threads it stays off on single threaded machines, a thread count turns it on anyway
+	bool setDeferred(_In_ bool deferred, _In_opt_ int threads = 0) {
+		flush();
+		if (deferred && threads <= 0 && std::thread::hardware_concurrency() <= 1)
+			deferred = false;
+		if (deferred) {
+			tileRenderer.reset(new BasicTileRenderer<Format>(threads));
+			beginRecording(deferredCommands);
 		}
+		else if (tileRenderer) {
+			endRecording();
+			tileRenderer.reset();
+		}
+		return deferred;
 	}
 
-	// Draws a line
-	void drawLine(_In_ vec2<int> p1, _In_ vec2<int> p2, _In_ UINT32 color, _In_opt_ unsigned short thickness = 1) {
-		int x, y, e, pk;
-		int dx = p2.x - p1.x;
-		int dy = p2.y - p1.y;
-		int dxAbs = abs(dx);
-		int dyAbs = abs(dy);
-
-		// If the slope is greater than or equal to 1
-		if (dxAbs >= dyAbs) {
-			pk = 2 * dyAbs - dxAbs;
-
-			if (dx >= 0) {
-				x = p1.x;
-				y = p1.y;
-				e = p2.x;
-			}
-			else {
-				x = p2.x;
-				y = p2.y;
-				e = p1.x;
-			}
-
-			drawCircle(vec2<int>(x, y), thickness, color);
-
-			for (int i = 0; x < e; i++) {
-				x++;
-				if (pk < 0)
-					pk += 2 * dyAbs;
-				else {
-					if ((dx < 0 && dy < 0) || (dx > 0 && dy > 0)) y++;
-					else y--;
-					pk += +2 * (dyAbs - dxAbs);
-				}
-				drawCircle(vec2<int>(x, y), thickness, color);
-			}
-		}
-		// If the slope is less than 1
-		else {
-			pk = 2 * dxAbs - dyAbs;
+	// If the draw calls are deferred
+	bool isDeferred() const {
+		return tileRenderer != nullptr;
+	}
 
-			if (dy >= 0) {
-				x = p1.x;
-				y = p1.y;
-				e = p2.y;
-			}
-			else {
-				x = p2.x;
-				y = p2.y;
-				e = p1.y;
-			}
+	// Draws the draw calls recorded in the deferred mode, the pixels have to be flushed before reading them
+	void flush() {
+		if (!tileRenderer) return;
+		GRAPHICS_PROFILE_SCOPE("flush");
+		tileRenderer->render(*this, deferredCommands);
+		// The deferred draw calls are captured once they're drawn
+		if (DrawCommandList* capture = getCapture())
+			for (const DrawCommand& command : deferredCommands.commands)
+				capture->append(command, deferredCommands, vec2<int>(0, 0));
+		deferredCommands.clear();
+	}
 
-			drawCircle(vec2<int>(x, y), thickness, color);
+	// Sets the number of the framebuffers, with 2 or 3 the frames are presented by another thread while the next one is drawn
+	// Apps redrawing the entire frame every time can skip keeping the buffers up to date, returns false if the buffers couldn't be made
+	bool setBufferCount(_In_ int count, _In_opt_ bool preserveContents = true) {
+		flush();
+		swapChain.detach(*this);
+		swapChain.preserveContents = preserveContents;
+		if (count <= 1) return true;
+		windowSink.engine = this;
+		return swapChain.create(*this, count, windowSink);
+	}
 
-			for (int i = 0; y < e; i++) {
-				y++;
-				if (pk <= 0)
-					pk += 2 * dxAbs;
-				else {
-					if ((dx < 0 && dy < 0) || (dx > 0 && dy > 0)) x++;
-					else x--;
-					pk += +2 * (dxAbs - dyAbs);
-				}
-				drawCircle(vec2<int>(x, y), thickness, color);
-			}
-		}
+	// Number of the framebuffers
+	int getBufferCount() const {
+		return swapChain.isActive() ? swapChain.getBufferCount() : 1;
 	}
 
-	// Get point for Bezier curve
-	int getPt(int n1, int n2, float perc) {
-		int diff = n2 - n1;
+	// Renders at the scale (0 - 1] of the windowed size, the frames are upscaled to the window by the engine
+	// The bitmap is cleared and the draw calls are in its pixels, so they have to be scaled by getRenderScale() too
+	void setRenderScale(_In_ float scale) {
+		dynamicResolutionEnabled = false;
+		resizeBitmap(scale < 0.1f ? 0.1f : (scale > 1.0f ? 1.0f : scale));
+	}
 
-		return n1 + (int)(diff * perc);
+	// Turns the dynamic resolution on or off, with it the scale (minScale - 1) is picked from the recent frame times
+	// to keep them around targetFrameTime (in milliseconds), turning it off goes back to the full resolution
+	void setDynamicResolution(_In_ bool enabled, _In_opt_ float targetFrameTime = 1000.0f / 60.0f, _In_opt_ float minScale = 0.5f) {
+		dynamicResolutionEnabled = enabled;
+		dynamicResolution.targetFrameTime = targetFrameTime;
+		dynamicResolution.minScale = minScale;
+		dynamicResolution.reset(renderScale);
+		lastFrameEnd = std::chrono::steady_clock::now();
+		if (!enabled)
+			resizeBitmap(1.0f);
 	}
 
-	// Draws a quadratic Bezier curve
-	void drawBezierCurve(_In_ vec2<int> p1, _In_ vec2<int> p2, _In_ vec2<int> p3, _In_ UINT32 color, _In_opt_ unsigned short thickness = 1) {
-		int xa, ya, xb, yb, x, y;
-		for (float i = 0; i < 1; i += 0.0001f) {
-			// The leading line
-			xa = getPt(p1.x, p2.x, i);
-			ya = getPt(p1.y, p2.y, i);
-			xb = getPt(p2.x, p3.x, i);
-			yb = getPt(p2.y, p3.y, i);
+	// If the internal resolution is picked from the frame times
+	bool isDynamicResolution() const {
+		return dynamicResolutionEnabled;
+	}
 
-			// Current point
-			x = getPt(xa, xb, i);
-			y = getPt(ya, yb, i);
+	// Scale of the internal resolution, the bitmap is the windowed size times the scale
+	float getRenderScale() const {
+		return renderScale;
+	}
 
-			drawCircle(vec2<int>(x, y), thickness, color);
-		}
+	// Statistics of the frames presented with more than one buffer
+	typename BasicSwapChain<Format>::Stats getSwapChainStats() {
+		return swapChain.getStats();
 	}
 
-	// Draws a cubic Bezier curve
-	void drawBezierCurve(_In_ vec2<int> p1, _In_ vec2<int> p2, _In_ vec2<int> p3, _In_ vec2<int> p4, _In_ UINT32 color, _In_opt_ unsigned short thickness = 1) {
-		vec2<int> curPoint, pA, pB, pC, pM, pN;
-		for (float i = 0; i < 1; i += 0.0001f) {
-			// The leading line 1
-			pA.x = getPt(p1.x, p2.x, i);
-			pA.y = getPt(p1.y, p2.y, i);
-			pB.x = getPt(p2.x, p3.x, i);
-			pB.y = getPt(p2.y, p3.y, i);
-			pC.x = getPt(p3.x, p4.x, i);
-			pC.y = getPt(p3.y, p4.y, i);
+	// Code that has to be run at the end of the main loop
+	void mainLoopEndEvents() {
+#ifdef GRAPHICS_PROFILE
+		if (showFrameGraph)
+			drawFrameGraph(vec2<int>(10, bitmapHeight - 110));
+#endif
+		{
+			GRAPHICS_PROFILE_SCOPE("mainLoopEndEvents");
+			flush();
+
+			// The frame is captured once all of it is drawn, a frame that can't be written stops the capture
+			if (captureWriter.isOpen()) {
+				if (!captureWriter.writeFrame(captureList, bitmapWidth, bitmapHeight, captureInputs.data(), captureInputs.size()))
+					stopCapture();
+				captureList.clear();
+				captureInputs.clear();
+			}
 
-			// The leading line 2
-			pN.x = getPt(pA.x, pB.x, i);
-			pN.y = getPt(pA.y, pB.y, i);
-			pM.x = getPt(pB.x, pC.x, i);
-			pM.y = getPt(pB.y, pC.y, i);
+			// The input handled so far is in this frame
+			long long inputTime = pendingInputTime;
+			pendingInputTime = 0;
+			if (swapChain.isActive()) {
+				// Frames without any changes aren't queued at all
+				if (dirtyRegion.count > 0) {
+					frameInputTimes.push(inputTime);
+					swapChain.present(*this);
+				}
+			}
+			else {
+				presentPixels((const Pixel*)memory, dirtyRegion);
+				finishPresent();
+				addInputLatency(inputTime);
+			}
+		}
+		GRAPHICS_PROFILE_FRAME();
 
+		// The next frame is drawn at the new resolution, the time spent waiting for the frame rate doesn't count
+		if (dynamicResolutionEnabled) {
+			float frameTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - lastFrameEnd).count();
+			if (dynamicResolution.addFrame(frameTime))
+				resizeBitmap(dynamicResolution.getScale());
+		}
 
-			// The current point
-			curPoint.x = getPt(pN.x, pM.x, i);
-			curPoint.y = getPt(pN.y, pM.y, i);
+		// End button click event
+		rbClick = false;
+		lbClick = false;
 
-			drawCircle(curPoint, thickness, color);
+		{
+			GRAPHICS_PROFILE_SCOPE("waitForFrame");
+			scheduler.endFrame();
 		}
+		lastFrameEnd = std::chrono::steady_clock::now();
 	}
 
-	// Draws a triangle
-	void drawTriangle(_In_ vec2<int> v1, _In_ vec2<int> v2, _In_ vec2<int> v3, _In_ UINT32 color) {
-		// Bonus vertice, used as temp for vertices sorting and as a spliting vertice in the general case
-		vec2<int> v4;
-		// Set vertices so that Y of the first one <= Y of the second one <= Y of the third one
-		if (v1.y > v2.y) {
-			v4 = v1;
-			v1 = v2;
-			v2 = v1;
-		}
-		if (v2.y > v3.y) {
-			v4 = v2;
-			v2 = v3;
-			v3 = v2;
-		}
-		if (v1.y > v2.y) {
-			v4 = v1;
-			v1 = v2;
-			v2 = v1;
-		}
-		// Check for trivial case of a bottom-flat triangle
-		if (v2.y == v3.y) {
-			fillBottomFlatTriangle(v1, v2, v3, color);
-		}
-		// Check for trivial case of a top-flat triangle
-		else if (v1.y == v2.y) {
-			fillTopFlatTriangle(v1, v2, v3, color);
-		}
-		else {
-			// Create a bonus vertice spliting with v2 the triangle in a half
-			v4 = vec2<int>((int)(v1.x + (float)(v2.y - v1.y) / (float)(v3.y - v1.y) * (v3.x - v1.x)), v2.y);
-			// Draw the bottom-flat and the top-flat triangle
-			fillBottomFlatTriangle(v1, v2, v4, color);
-			fillTopFlatTriangle(v2, v4, v3, color);
-		}
+	void destroy() {
+		stopCapture();
+		swapChain.detach(*this);
+		framebufferPool().release(scaledPixels);
+		scaledPixels = nullptr;
+		DestroyWindow(hwnd);
 	}
 
 	// Exit fullscreen mode
 	void exitFullscreen() {
+		// The present thread can't draw to the window while it changes
+		swapChain.waitIdle();
 		SetWindowLongPtr(hwnd, GWL_STYLE, winStyle); // Set the window styles
 		SetWindowLongPtr(hwnd, GWL_EXSTYLE, WS_EX_LEFT); // Set the extended window styles
 
@@ -586,18 +690,21 @@ public:
 		marginHorizontal = 0;
 		marginVertical = 0;
 		// Set mouse ratios to fix mouse coordinates
-		transformW = 1.0f;
-		transformH = 1.0f;
+		updateMouseTransform();
 		// Resize and reposition the window
 		SetWindowPos(hwnd, HWND_NOTOPMOST,
 			GetSystemMetrics(SM_CXSCREEN) / 10,      // Window position X
 			GetSystemMetrics(SM_CYSCREEN) / 10,      // Window position Y
 			windowedWidth + 15, windowedHeight + 39, // Window size (there is the bonus size because of the bitmap size and windowed size issues)
 			SWP_SHOWWINDOW);
+		// Whole bitmap has to be presented in the new window size
+		markAllDirty();
 	}
 
 	// Enter fullscreen mode
 	void enterFullscreen() {
+		// The present thread can't draw to the window while it changes
+		swapChain.waitIdle();
 		MONITORINFO monitorInfo; // Get the monitor info
 		monitorInfo.cbSize = sizeof(monitorInfo);
 		GetMonitorInfo(MonitorFromWindow(hwnd, MONITOR_DEFAULTTONEAREST), &monitorInfo);
@@ -623,46 +730,20 @@ public:
 		if ((isScreenWider && screenHeightRatioed < screenWidth) || (!isScreenWider && screenWidthRatioed > screenHeight)) {
 			// Set width based on the screen height
 			width = (int)((double)screenHeight * ratioW);
-			// Set coordinate transform
-			transformW = (float)windowedWidth / (float)screenHeight;
-			transformH = (float)windowedWidth / (float)screenHeight;
 			// Set horizonal margins
 			marginHorizontal = (screenWidth - width) / 2;
 		}
 		else {
 			// Set height based on the screen width
 			height = (int)((double)screenWidth * ratioH);
-			// Set coordinate transform
-			transformW = (float)windowedHeight / (float)screenWidth;
-			transformH = (float)windowedHeight / (float)screenWidth;
 			// Set vertical margins
 			marginVertical = (screenHeight - height) / 2;
 		}
 
 		width = screenWidth;
 		height = screenHeight;
-
-		// Save current bitmap memory
-		void* memorySave = memory;
-
-		// Allocate memory for the entire screen to clear it
-		memory = VirtualAlloc(0,                    // Starting address of the region to allocate
-			width * height * sizeof(unsigned int),  // Size of the region (in bytes)
-			MEM_RESERVE | MEM_COMMIT,               // Type of memory allocation
-			PAGE_READWRITE);                        // Memory protection for the region
-
-		// Clear the entire screen to remove the defects appearing on the margins
-		clearEntireScreen(0x000000);
-
-		// Update entire screen
-		StretchDIBits(hdc,
-			0, 0, width, height,
-			0, 0, bitmapWidth, bitmapHeight,
-			memory, &bitmapInfo,
-			DIB_RGB_COLORS, SRCCOPY);
-
-		// Restore bitmap
-		memory = memorySave;
+		// Set coordinate transform
+		updateMouseTransform();
 
 		// Resize, move, and refresh the window
 		SetWindowPos(
@@ -671,6 +752,10 @@ public:
 			monitorInfo.rcMonitor.left, monitorInfo.rcMonitor.top,
 			width, height,
 			SWP_NOZORDER | SWP_NOACTIVATE | SWP_FRAMECHANGED);
+		// The margins aren't covered by the bitmap, without clearing them they show whatever was there before
+		clearMargins();
+		// Whole bitmap has to be presented in the new window size
+		markAllDirty();
 	}
 
 	// Toggle fullscreen mode
@@ -690,11 +775,9 @@ public:
 			isFullscreen = false;
 		}
 	}
-
-	// Destructor
-	~GraphicsEngine() {
-		if (memory != nullptr) VirtualFree(memory, 0, MEM_RELEASE);
-	}
 };
 
+// Window with the native 32bpp frames
+typedef BasicGraphicsEngine<BGRA32> GraphicsEngine;
+
 #endif // !GRAPHICS_ENGINE
\ No newline at end of file
@@ -0,0 +1,109 @@
+#ifndef GRAPHICS_HEADLESS_PRESENTER
+#define GRAPHICS_HEADLESS_PRESENTER
+
+#include "RenderTarget.hpp"
+#include "SwapChain.hpp"
+#include <cstdio>
+
+// Writes the RenderTarget to a binary PPM (P6) file, returns false if the file couldn't be written
+template<class Format>
+bool writePPM(_In_ const BasicRenderTarget<Format>& target, _In_ const char* path) {
+	FILE* file = fopen(path, "wb");
+	if (!file) return false;
+
+	fprintf(file, "P6\n%d %d\n255\n", target.bitmapWidth, target.bitmapHeight);
+
+	// Convert each row from the pixel format to packed RGB
+	unsigned char* row = new unsigned char[(size_t)target.bitmapWidth * 3];
+	const typename Format::Pixel* pixel = target.getPixels();
+	bool written = true;
+	for (int y = 0; y < target.bitmapHeight && written; y++) {
+		for (int x = 0; x < target.bitmapWidth; x++) {
+			UINT32 color = Format::toRGB(*pixel++);
+			row[x * 3] = (color >> 16) & 0xFF;     // Red
+			row[x * 3 + 1] = (color >> 8) & 0xFF;  // Green
+			row[x * 3 + 2] = color & 0xFF;         // Blue
+		}
+		written = fwrite(row, 3, target.bitmapWidth, file) == (size_t)target.bitmapWidth;
+	}
+
+	delete[] row;
+	fclose(file);
+	return written;
+}
+
+// Present sink that doesn't need a window
+// Counts the presented frames and bytes (as if the dirty region was pushed to a window)
+// and optionally dumps the frames as PPM files
+class HeadlessPresenter {
+public:
+	// printf pattern of the dumped frames path (for example "frame_%05d.ppm"), nullptr disables dumping
+	const char* outputPattern = nullptr;
+	// Number of the presented frames
+	int frameCount = 0;
+
+	HeadlessPresenter() {}
+	HeadlessPresenter(_In_opt_ const char* pattern) : outputPattern(pattern) {}
+
+	// Presents the frame
+	template<class Format>
+	void present(_In_ BasicRenderTarget<Format>& target) {
+		if (outputPattern) {
+			char path[512];
+			snprintf(path, sizeof(path), outputPattern, frameCount);
+			writePPM(target, path);
+		}
+		target.finishPresent();
+		frameCount++;
+	}
+};
+
+// Present sink of a SwapChain that doesn't need a window
+// Copies the presented regions to its own surface like a window would, can take extra time like a slow driver
+// or a display would, and optionally dumps the frames as PPM files
+template<class Format>
+class BasicHeadlessSink : public BasicPresentSink<Format> {
+public:
+	typedef typename Format::Pixel Pixel;
+
+	// Pixels shown in the "window"
+	BasicRenderTarget<Format> surface;
+	// printf pattern of the dumped frames path (for example "frame_%05d.ppm"), nullptr disables dumping
+	const char* outputPattern = nullptr;
+	// Extra time every present takes (in microseconds)
+	int presentDelay = 0;
+	// Number of the presented frames and bytes, read them after SwapChain::waitIdle
+	int frameCount = 0;
+	unsigned long long presentedBytes = 0;
+
+	BasicHeadlessSink() {}
+	BasicHeadlessSink(_In_opt_ const char* pattern, _In_opt_ int delay = 0) : outputPattern(pattern), presentDelay(delay) {}
+
+	// Copies the region to the surface
+	void presentFrame(_In_ const Pixel* pixels, _In_ int width, _In_ int height, _In_ const DirtyRegion& region) override {
+		if (surface.bitmapWidth != width || surface.bitmapHeight != height)
+			surface.create(width, height);
+		Pixel* destination = surface.getPixels();
+		for (int i = 0; i < region.count; i++) {
+			const Rect& rect = region.rects[i];
+			for (int y = rect.minPoint.y; y < rect.maxPoint.y; y++) {
+				size_t offset = (size_t)y * width + rect.minPoint.x;
+				memcpy(destination + offset, pixels + offset, (size_t)rect.width * sizeof(Pixel));
+			}
+		}
+		presentedBytes += (unsigned long long)region.area() * sizeof(Pixel);
+		if (presentDelay > 0)
+			std::this_thread::sleep_for(std::chrono::microseconds(presentDelay));
+		if (outputPattern) {
+			char path[512];
+			snprintf(path, sizeof(path), outputPattern, frameCount);
+			writePPM(surface, path);
+		}
+		frameCount++;
+	}
+};
+
+// Headless sink of the SwapChain
+typedef BasicHeadlessSink<BGRA32> HeadlessSink;
+
+#endif // !GRAPHICS_HEADLESS_PRESENTER
@@ -0,0 +1,253 @@
+#ifndef GRAPHICS_IMAGE
+#define GRAPHICS_IMAGE
+
+#include "Platform.hpp"
+#include <cctype>
+#include <cstring>
+
+// Biggest width and height of a loaded image
+const int imageMaxSize = 1 << 15;
+
+// 32bpp image (0xAARRGGBB, stored as BGRA bytes) drawn with RenderTarget::drawImage
+// 32-bit BMP and raw BGRA files are memory mapped and drawn straight from the mapping without copying the pixels,
+// other formats are converted once when loaded. The image has to outlive the draw lists it's recorded to
+class Image {
+protected:
+	// Top row of the pixels, rows of mapped files don't have to be aligned
+	const unsigned char* pixels = nullptr;
+	// Distance between the rows (in bytes), negative for the bottom-up BMP files
+	ptrdiff_t pitch = 0;
+	// View of the mapped file
+	const void* view = nullptr;
+	size_t viewSize = 0;
+	// Pixels allocated by the image
+	void* memory = nullptr;
+	size_t memorySize = 0;
+
+	// Reads a little endian value of the file
+	static unsigned int readLittleEndian(_In_ const unsigned char* bytes, _In_ int size) {
+		unsigned int value = 0;
+		for (int i = size - 1; i >= 0; i--)
+			value = value << 8 | bytes[i];
+		return value;
+	}
+
+	// Starts using the pixels of the mapped file
+	void useView(_In_ const void* fileView, _In_ size_t fileSize, _In_ const unsigned char* top, _In_ ptrdiff_t rowPitch, _In_ int imageWidth, _In_ int imageHeight) {
+		view = fileView;
+		viewSize = fileSize;
+		pixels = top;
+		pitch = rowPitch;
+		width = imageWidth;
+		height = imageHeight;
+	}
+
+	// Converts a 24-bit BMP (padded bottom-up or top-down BGR rows) into allocated pixels
+	bool convertBGR(_In_ const unsigned char* data, _In_ int imageWidth, _In_ int imageHeight, _In_ bool bottomUp) {
+		if (!create(imageWidth, imageHeight)) return false;
+		size_t rowBytes = ((size_t)imageWidth * 3 + 3) & ~(size_t)3;
+		for (int y = 0; y < height; y++) {
+			const unsigned char* source = data + (size_t)(bottomUp ? height - 1 - y : y) * rowBytes;
+			UINT32* row = getRow(y);
+			for (int x = 0; x < width; x++)
+				row[x] = 0xFF000000 | (UINT32)source[x * 3 + 2] << 16 | (UINT32)source[x * 3 + 1] << 8 | source[x * 3];
+		}
+		return true;
+	}
+
+public:
+	// Size of the image
+	int width = 0;
+	int height = 0;
+	// If the top bytes of the pixels are the alpha, BlitMode::Alpha copies the images without it
+	bool hasAlpha = false;
+
+	Image() {}
+	Image(const Image&) = delete;
+	Image& operator=(const Image&) = delete;
+
+	// Allocates a transparent (all pixels 0) image with alpha, its pixels can be written with getRow
+	bool create(_In_ int imageWidth, _In_ int imageHeight) {
+		release();
+		if (imageWidth <= 0 || imageHeight <= 0 || imageWidth > imageMaxSize || imageHeight > imageMaxSize) return false;
+		memorySize = (size_t)imageWidth * imageHeight * sizeof(UINT32);
+		memory = allocatePages(memorySize);
+		if (!memory) {
+			memorySize = 0;
+			return false;
+		}
+		pixels = (const unsigned char*)memory;
+		pitch = (ptrdiff_t)imageWidth * sizeof(UINT32);
+		width = imageWidth;
+		height = imageHeight;
+		hasAlpha = true;
+		return true;
+	}
+
+	// Loads an uncompressed 32-bit (mapped) or 24-bit (converted) BMP file, returns false if it couldn't be loaded
+	// 32-bit files have alpha only if their header has the alpha mask
+	bool loadBMP(_In_ const char* path) {
+		release();
+		size_t size;
+		const unsigned char* file = (const unsigned char*)mapFile(path, size);
+		if (!file) return false;
+		// File header (14 bytes) followed by at least a BITMAPINFOHEADER (40 bytes)
+		if (size < 54 || file[0] != 'B' || file[1] != 'M' || readLittleEndian(file + 14, 4) < 40) {
+			unmapFile(file, size);
+			return false;
+		}
+		size_t offset = readLittleEndian(file + 10, 4);
+		int imageWidth = (int)readLittleEndian(file + 18, 4);
+		int imageHeight = (int)readLittleEndian(file + 22, 4);
+		unsigned int bitCount = readLittleEndian(file + 28, 2);
+		unsigned int compression = readLittleEndian(file + 30, 4);
+		unsigned int headerSize = readLittleEndian(file + 14, 4);
+		// Positive height means the rows are stored from the bottom
+		bool bottomUp = imageHeight > 0;
+		if (imageHeight < 0) imageHeight = -imageHeight;
+
+		bool valid = imageWidth > 0 && imageHeight > 0 && imageWidth <= imageMaxSize && imageHeight <= imageMaxSize;
+		size_t rowBytes = bitCount == 32 ? (size_t)imageWidth * 4 : ((size_t)imageWidth * 3 + 3) & ~(size_t)3;
+		valid = valid && (bitCount == 32 || bitCount == 24) && offset <= size && (size - offset) / rowBytes >= (size_t)imageHeight;
+		bool alpha = false;
+		// BI_BITFIELDS and BI_ALPHABITFIELDS have the masks right after the BITMAPINFOHEADER, they have to be the ones of BGRA
+		if (valid && bitCount == 32 && (compression == 3 || compression == 6)) {
+			bool alphaMask = headerSize >= 56 || compression == 6;
+			valid = size >= (alphaMask ? 70u : 66u) && readLittleEndian(file + 54, 4) == 0xFF0000
+				&& readLittleEndian(file + 58, 4) == 0x00FF00 && readLittleEndian(file + 62, 4) == 0x0000FF;
+			alpha = valid && alphaMask && readLittleEndian(file + 66, 4) == 0xFF000000;
+		}
+		else
+			valid = valid && compression == 0;
+		if (!valid) {
+			unmapFile(file, size);
+			return false;
+		}
+
+		if (bitCount == 32) {
+			const unsigned char* top = file + offset + (bottomUp ? (size_t)(imageHeight - 1) * rowBytes : 0);
+			useView(file, size, top, bottomUp ? -(ptrdiff_t)rowBytes : (ptrdiff_t)rowBytes, imageWidth, imageHeight);
+			hasAlpha = alpha;
+			return true;
+		}
+		bool converted = convertBGR(file + offset, imageWidth, imageHeight, bottomUp);
+		hasAlpha = false;
+		unmapFile(file, size);
+		return converted;
+	}
+
+	// Loads a binary PPM (P6) file, converted to BGRA without alpha, returns false if it couldn't be loaded
+	bool loadPPM(_In_ const char* path) {
+		release();
+		size_t size;
+		const unsigned char* file = (const unsigned char*)mapFile(path, size);
+		if (!file) return false;
+		// Header is "P6", the width, the height and the maximum value, separated with whitespace and comments
+		size_t position = 2;
+		int values[3] = { 0, 0, 0 };
+		bool valid = size > 2 && file[0] == 'P' && file[1] == '6';
+		for (int i = 0; i < 3 && valid; i++) {
+			while (position < size && (isspace(file[position]) || file[position] == '#')) {
+				if (file[position] == '#')
+					while (position < size && file[position] != '\n') position++;
+				else
+					position++;
+			}
+			valid = position < size && isdigit(file[position]);
+			while (valid && position < size && isdigit(file[position]) && values[i] <= imageMaxSize)
+				values[i] = values[i] * 10 + (file[position++] - '0');
+		}
+		// Single whitespace character before the pixels
+		position++;
+		int imageWidth = values[0], imageHeight = values[1], maxValue = values[2];
+		valid = valid && imageWidth > 0 && imageHeight > 0 && maxValue > 0 && maxValue < 256 && position <= size
+			&& (size - position) / 3 / (size_t)imageWidth >= (size_t)imageHeight;
+		if (valid && create(imageWidth, imageHeight)) {
+			const unsigned char* source = file + position;
+			for (int y = 0; y < height; y++) {
+				UINT32* row = getRow(y);
+				for (int x = 0; x < width; x++, source += 3) {
+					UINT32 red = source[0] * 255u / maxValue;
+					UINT32 green = source[1] * 255u / maxValue;
+					UINT32 blue = source[2] * 255u / maxValue;
+					row[x] = 0xFF000000 | red << 16 | green << 8 | blue;
+				}
+			}
+			hasAlpha = false;
+		}
+		else
+			valid = false;
+		unmapFile(file, size);
+		return valid;
+	}
+
+	// Maps a file with nothing but the BGRA pixels (width * height * 4 bytes, top row first), returns false if it couldn't be loaded
+	bool loadRaw(_In_ const char* path, _In_ int imageWidth, _In_ int imageHeight, _In_opt_ bool alpha = true) {
+		release();
+		if (imageWidth <= 0 || imageHeight <= 0 || imageWidth > imageMaxSize || imageHeight > imageMaxSize) return false;
+		size_t size;
+		const unsigned char* file = (const unsigned char*)mapFile(path, size);
+		if (!file) return false;
+		if (size / ((size_t)imageWidth * 4) < (size_t)imageHeight) {
+			unmapFile(file, size);
+			return false;
+		}
+		useView(file, size, file, (ptrdiff_t)imageWidth * 4, imageWidth, imageHeight);
+		hasAlpha = alpha;
+		return true;
+	}
+
+	// Loads a BMP or PPM file, the format is recognized by its first bytes
+	bool load(_In_ const char* path) {
+		size_t size;
+		const unsigned char* file = (const unsigned char*)mapFile(path, size);
+		if (!file) return false;
+		bool bmp = size >= 2 && file[0] == 'B' && file[1] == 'M';
+		unmapFile(file, size);
+		return bmp ? loadBMP(path) : loadPPM(path);
+	}
+
+	// Unmaps or frees the pixels
+	void release() {
+		unmapFile(view, viewSize);
+		freePages(memory, memorySize);
+		view = nullptr;
+		viewSize = 0;
+		memory = nullptr;
+		memorySize = 0;
+		pixels = nullptr;
+		pitch = 0;
+		width = 0;
+		height = 0;
+		hasAlpha = false;
+	}
+
+	// If the pixels are read straight from a mapped file
+	bool isMapped() const {
+		return view != nullptr;
+	}
+
+	// BGRA bytes of the row y
+	const unsigned char* getRowBytes(_In_ int y) const {
+		return pixels + y * pitch;
+	}
+
+	// Writable row y of an image made with create, nullptr for the mapped ones
+	UINT32* getRow(_In_ int y) {
+		return memory ? (UINT32*)memory + (size_t)y * width : nullptr;
+	}
+
+	// Pixel (0xAARRGGBB) at the coordinates, 0 outside of the image
+	UINT32 getPixel(_In_ int x, _In_ int y) const {
+		if (x < 0 || y < 0 || x >= width || y >= height) return 0;
+		UINT32 value;
+		memcpy(&value, getRowBytes(y) + (size_t)x * 4, sizeof(value));
+		return value;
+	}
+
+	~Image() {
+		release();
+	}
+};
+
+#endif // !GRAPHICS_IMAGE
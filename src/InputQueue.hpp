@@ -0,0 +1,122 @@
+#ifndef GRAPHICS_INPUT_QUEUE
+#define GRAPHICS_INPUT_QUEUE
+
+#include "Platform.hpp"
+#include <atomic>
+#include <chrono>
+
+// Ring of items passed from one thread to another without any locks
+// Only one thread may push and only one (other) thread may pop, pushing to a full ring drops the item
+template<class T, unsigned int Capacity>
+class SpscRing {
+	static_assert(Capacity != 0 && (Capacity & (Capacity - 1)) == 0, "The capacity has to be a power of 2");
+
+	T items[Capacity];
+	// Items pushed and popped so far, the item i is at i % Capacity
+	// Each side has its own cache line with its count and the last count of the other side it saw,
+	// so the threads only touch the line of the other one when the ring looks full or empty
+	alignas(64) std::atomic<unsigned long long> pushed{ 0 };
+	unsigned long long poppedSeen = 0;
+	alignas(64) std::atomic<unsigned long long> popped{ 0 };
+	unsigned long long pushedSeen = 0;
+	alignas(64) std::atomic<unsigned long long> dropped{ 0 };
+
+public:
+	// Adds the item, returns false if the ring is full (the item is dropped then), only called by the producer
+	bool push(_In_ const T& item) {
+		unsigned long long index = pushed.load(std::memory_order_relaxed);
+		if (index - poppedSeen == Capacity) {
+			poppedSeen = popped.load(std::memory_order_acquire);
+			if (index - poppedSeen == Capacity) {
+				dropped.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+		}
+		items[index % Capacity] = item;
+		pushed.store(index + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Takes the oldest item, returns false if the ring is empty, only called by the consumer
+	bool pop(_Out_ T& item) {
+		unsigned long long index = popped.load(std::memory_order_relaxed);
+		if (index == pushedSeen) {
+			pushedSeen = pushed.load(std::memory_order_acquire);
+			if (index == pushedSeen) return false;
+		}
+		item = items[index % Capacity];
+		popped.store(index + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Number of the items in the ring, only exact when neither side is running
+	unsigned int size() const {
+		return (unsigned int)(pushed.load(std::memory_order_acquire) - popped.load(std::memory_order_acquire));
+	}
+
+	// Number of the items dropped because the ring was full
+	unsigned long long getDropped() const {
+		return dropped.load(std::memory_order_relaxed);
+	}
+
+	// Most items in the ring at once
+	static unsigned int capacity() {
+		return Capacity;
+	}
+};
+
+// Time of the input events (nanoseconds of the steady clock)
+inline long long inputClock() {
+	return (long long)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Kind of an input event
+enum class InputEventType {
+	KeyDown,
+	KeyUp,
+	MouseMove,
+	ButtonDown,
+	ButtonUp
+};
+
+// Mouse buttons of the button events
+enum class MouseButton {
+	Left,
+	Right
+};
+
+// Input event in the order the window got it
+struct InputEvent {
+	InputEventType type;
+	// Virtual key code of the key events, MouseButton of the button events
+	int code;
+	// Mouse position in the bitmap pixels when the event happened
+	int x;
+	int y;
+	// When the window got the event (inputClock)
+	long long timestamp;
+};
+
+// Input events passed from the message pump to the thread reading them
+typedef SpscRing<InputEvent, 1024> InputQueue;
+
+// Time from the first input event of a frame to the frame being on the screen
+struct InputLatencyStats {
+	// Frames presented with some input in them
+	unsigned long long frames = 0;
+	// Latency of the last one, the average and the longest (in milliseconds)
+	double lastMilliseconds = 0.0;
+	double averageMilliseconds = 0.0;
+	double maxMilliseconds = 0.0;
+
+	// Adds the frame with the first input event at the time inputTime presented at presentTime (inputClock)
+	void add(_In_ long long inputTime, _In_ long long presentTime) {
+		lastMilliseconds = (double)(presentTime - inputTime) / 1e6;
+		frames++;
+		averageMilliseconds += (lastMilliseconds - averageMilliseconds) / (double)frames;
+		if (lastMilliseconds > maxMilliseconds)
+			maxMilliseconds = lastMilliseconds;
+	}
+};
+
+#endif // !GRAPHICS_INPUT_QUEUE
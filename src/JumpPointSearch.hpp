@@ -0,0 +1,306 @@
+#ifndef GRAPHICS_JUMP_POINT_SEARCH
+#define GRAPHICS_JUMP_POINT_SEARCH
+
+#include "PathGrid.hpp"
+#include <algorithm>
+#include <cstdlib>
+
+// Jump Point Search on a PathBitGrid, finds the same cheapest paths as AStarPathfinder on grids where every step costs the same.
+// Instead of adding every neighbour to the open cells it jumps in a straight line (or diagonally) until a cell where the cheapest
+// path could turn (a jump point: the goal or a cell next to the end of an obstacle), only those are added and expanded.
+// The straight jumps test 64 cells at once with the bits of the line and the lines next to it, the diagonal ones jump straight
+// from every cell. Only the jump points have a state, in flat arrays found through a hash table by the cell, so the memory
+// doesn't grow with the grid
+class JumpPointSearch {
+public:
+	// Work done by the last search
+	struct Stats {
+		// Jump points taken from the heap and the ones added to it
+		unsigned long long expanded = 0;
+		unsigned long long pushed = 0;
+		// Cheaper ways found to the jump points already in the heap
+		unsigned long long decreased = 0;
+	};
+
+	PathConnectivity connectivity = PathConnectivity::Four;
+
+private:
+	// State of the jump points reached by the search, by the order they were reached in
+	std::vector<int> nodeCells;
+	std::vector<PathCost> nodeCosts;
+	std::vector<int> nodeParents;
+	// Direction the node was reached from (dx + 1 and dy + 1 in two bits each, both 0 for the start) and nodeExpanded
+	std::vector<unsigned char> nodeStates;
+	static const unsigned char nodeExpanded = 16;
+	// Nodes of the cells + 1 (0 for the empty slots), open addressing with a power of two slots
+	std::vector<int> table;
+	int tableShift = 32;
+	PathHeap open;
+	const PathBitGrid* grid = nullptr;
+	vec2<int> goal;
+	int goalNode = -1;
+	PathCost pathCost = pathNoCost;
+	Stats stats;
+
+	// First cell from the one at the index in the direction (1 or -1) that is blocked or has a forced neighbour, a cell of one
+	// of the lines on the sides open while the cell before it is blocked, so the cheapest path can turn into it only from this cell.
+	// The line and the lines on its sides are the bits of the rows or the columns, -1 if the line ends first
+	static int scan(_In_ const unsigned long long* line, _In_ const unsigned long long* before, _In_ const unsigned long long* after,
+		_In_ int words, _In_ int from, _In_ int direction) {
+		int word = from >> 6;
+		if (direction > 0) {
+			unsigned long long mask = ~0ull << (from & 63);
+			// The bits past the end of the line are set, so it stops there
+			for (; word < words; word++) {
+				unsigned long long beforeShifted = before[word] << 1 | (word > 0 ? before[word - 1] >> 63 : 1);
+				unsigned long long afterShifted = after[word] << 1 | (word > 0 ? after[word - 1] >> 63 : 1);
+				unsigned long long stops = (line[word] | (~before[word] & beforeShifted) | (~after[word] & afterShifted)) & mask;
+				if (stops) return word * 64 + countTrailingZeros64(stops);
+				mask = ~0ull;
+			}
+			return words * 64;
+		}
+		unsigned long long mask = ~0ull >> (63 - (from & 63));
+		for (; word >= 0; word--) {
+			unsigned long long beforeShifted = before[word] >> 1 | (word + 1 < words ? before[word + 1] << 63 : 1ull << 63);
+			unsigned long long afterShifted = after[word] >> 1 | (word + 1 < words ? after[word + 1] << 63 : 1ull << 63);
+			unsigned long long stops = (line[word] | (~before[word] & beforeShifted) | (~after[word] & afterShifted)) & mask;
+			if (stops) return word * 64 + highestSetBit64(stops);
+			mask = ~0ull;
+		}
+		return -1;
+	}
+
+	// If a diagonal step can be taken from the cell, it can't go past the corner of a blocked cell
+	bool canStepDiagonally(_In_ int x, _In_ int y, _In_ int dx, _In_ int dy) const {
+		return grid->isOpen(x + dx, y) && grid->isOpen(x, y + dy) && grid->isOpen(x + dx, y + dy);
+	}
+
+	// Jumps straight from the cell (included) in the direction, returns the jump point or -1 if there is none before an obstacle
+	int jumpStraight(_In_ int x, _In_ int y, _In_ int dx, _In_ int dy) const {
+		if (!grid->isOpen(x, y)) return -1;
+		if (dy == 0) {
+			int stop = scan(grid->row(y), grid->row(y - 1), grid->row(y + 1), grid->getRowWords(), x, dx);
+			if (goal.y == y && (goal.x - x) * dx >= 0 && (stop - goal.x) * dx >= 0)
+				return goal.y * grid->width + goal.x;
+			return grid->isOpen(stop, y) ? y * grid->width + stop : -1;
+		}
+		int stop = scan(grid->column(x), grid->column(x - 1), grid->column(x + 1), grid->getColumnWords(), y, dy);
+		if (goal.x == x && (goal.y - y) * dy >= 0 && (stop - goal.y) * dy >= 0)
+			return goal.y * grid->width + goal.x;
+		return grid->isOpen(x, stop) ? stop * grid->width + x : -1;
+	}
+
+	// Jumps up or down from the cell (included) with 4 neighbours, the horizontal moves are taken on the way
+	// so it also stops where a horizontal jump finds a jump point
+	int jumpVertically(_In_ int x, _In_ int y, _In_ int dy) const {
+		if (!grid->isOpen(x, y)) return -1;
+		int stop = scan(grid->column(x), grid->column(x - 1), grid->column(x + 1), grid->getColumnWords(), y, dy);
+		for (; y != stop; y += dy)
+			if ((x == goal.x && y == goal.y) || jumpStraight(x - 1, y, -1, 0) >= 0 || jumpStraight(x + 1, y, 1, 0) >= 0)
+				return y * grid->width + x;
+		return grid->isOpen(x, stop) ? stop * grid->width + x : -1;
+	}
+
+	// Jumps diagonally from the cell (included, the step to it has to be allowed), the straight moves are taken on the way
+	// so it also stops where one of the straight jumps finds a jump point
+	int jumpDiagonally(_In_ int x, _In_ int y, _In_ int dx, _In_ int dy) const {
+		for (;;) {
+			if ((x == goal.x && y == goal.y) || jumpStraight(x + dx, y, dx, 0) >= 0 || jumpStraight(x, y + dy, 0, dy) >= 0)
+				return y * grid->width + x;
+			if (!canStepDiagonally(x, y, dx, dy)) return -1;
+			x += dx;
+			y += dy;
+		}
+	}
+
+	// Node of the cell, -1 if it wasn't reached
+	int findNode(_In_ int cell) const {
+		unsigned int mask = (unsigned int)table.size() - 1;
+		for (unsigned int slot = (unsigned int)cell * 0x9E3779B1u >> tableShift;; slot = (slot + 1) & mask) {
+			if (table[slot] == 0) return -1;
+			if (nodeCells[table[slot] - 1] == cell) return table[slot] - 1;
+		}
+	}
+
+	void insertNode(_In_ int node) {
+		unsigned int mask = (unsigned int)table.size() - 1;
+		unsigned int slot = (unsigned int)nodeCells[node] * 0x9E3779B1u >> tableShift;
+		while (table[slot] != 0)
+			slot = (slot + 1) & mask;
+		table[slot] = node + 1;
+	}
+
+	// Adds the node of a cell, the table is kept at most half full
+	int addNode(_In_ int cell, _In_ PathCost cost, _In_ int parent, _In_ unsigned char state) {
+		int node = (int)nodeCells.size();
+		nodeCells.push_back(cell);
+		nodeCosts.push_back(cost);
+		nodeParents.push_back(parent);
+		nodeStates.push_back(state);
+		open.grow(node + 1);
+		if ((size_t)node * 2 >= table.size()) {
+			table.assign(table.size() * 2, 0);
+			tableShift--;
+			for (int other = 0; other < node; other++)
+				insertNode(other);
+		}
+		insertNode(node);
+		return node;
+	}
+
+	// Reaches the cell from the node in the direction
+	void reach(_In_ int cell, _In_ int parent, _In_ int dx, _In_ int dy, _In_ PathCost cost) {
+		unsigned char state = (unsigned char)((dx + 1) | (dy + 1) << 2);
+		int node = findNode(cell);
+		if (node < 0) {
+			node = addNode(cell, cost, parent, state);
+			open.push(node, pathKey(cost + pathHeuristic(vec2<int>(cell % grid->width, cell / grid->width), goal, connectivity), cost));
+			stats.pushed++;
+		}
+		// Expanded nodes already have their cheapest cost
+		else if (!(nodeStates[node] & nodeExpanded) && cost < nodeCosts[node]) {
+			nodeCosts[node] = cost;
+			nodeParents[node] = parent;
+			nodeStates[node] = state;
+			open.decrease(node, pathKey(cost + pathHeuristic(vec2<int>(cell % grid->width, cell / grid->width), goal, connectivity), cost));
+			stats.decreased++;
+		}
+	}
+
+	// Jumps from the node's cell (x, y) in the direction and reaches the jump point found
+	void jump(_In_ int node, _In_ int x, _In_ int y, _In_ int dx, _In_ int dy) {
+		int found;
+		if (dx != 0 && dy != 0)
+			found = canStepDiagonally(x, y, dx, dy) ? jumpDiagonally(x + dx, y + dy, dx, dy) : -1;
+		else if (dx == 0 && connectivity == PathConnectivity::Four)
+			found = jumpVertically(x, y + dy, dy);
+		else
+			found = jumpStraight(x + dx, y + dy, dx, dy);
+		if (found < 0) return;
+		int steps = std::max(abs(found % grid->width - x), abs(found / grid->width - y));
+		reach(found, node, dx, dy, nodeCosts[node] + steps * (dx != 0 && dy != 0 ? pathDiagonalCost : pathStraightCost));
+	}
+
+	// Jumps in the directions the cheapest paths through the node can continue in
+	void expand(_In_ int node) {
+		int x = nodeCells[node] % grid->width;
+		int y = nodeCells[node] / grid->width;
+		int dx = (nodeStates[node] & 3) - 1;
+		int dy = (nodeStates[node] >> 2 & 3) - 1;
+		bool diagonals = connectivity == PathConnectivity::Eight;
+		// The start in every direction
+		if (dx == 0 && dy == 0) {
+			jump(node, x, y, 1, 0);
+			jump(node, x, y, -1, 0);
+			jump(node, x, y, 0, 1);
+			jump(node, x, y, 0, -1);
+			if (!diagonals) return;
+			jump(node, x, y, 1, 1);
+			jump(node, x, y, -1, 1);
+			jump(node, x, y, 1, -1);
+			jump(node, x, y, -1, -1);
+		}
+		// With 4 neighbours the paths go both ways across the direction they came from
+		else if (!diagonals) {
+			jump(node, x, y, dx, dy);
+			jump(node, x, y, dy, dx);
+			jump(node, x, y, -dy, -dx);
+		}
+		// Diagonally the paths only go on in the same direction, straight or diagonally
+		else if (dx != 0 && dy != 0) {
+			jump(node, x, y, dx, 0);
+			jump(node, x, y, 0, dy);
+			jump(node, x, y, dx, dy);
+		}
+		// Straight they turn only to the sides where an obstacle ended (the forced neighbours)
+		else {
+			jump(node, x, y, dx, dy);
+			for (int side = -1; side <= 1; side += 2) {
+				int sideX = dx == 0 ? side : 0;
+				int sideY = dy == 0 ? side : 0;
+				if (grid->isOpen(x + sideX, y + sideY) && !grid->isOpen(x + sideX - dx, y + sideY - dy)) {
+					jump(node, x, y, sideX, sideY);
+					jump(node, x, y, dx + sideX, dy + sideY);
+				}
+			}
+		}
+	}
+
+public:
+	// Finds the cheapest path between the cells, returns false if there is none
+	bool findPath(_In_ const PathBitGrid& searchedGrid, _In_ vec2<int> start, _In_ vec2<int> target) {
+		grid = &searchedGrid;
+		goal = target;
+		goalNode = -1;
+		pathCost = pathNoCost;
+		stats = Stats();
+		nodeCells.clear();
+		nodeCosts.clear();
+		nodeParents.clear();
+		nodeStates.clear();
+		// The table only keeps the size of the last search
+		if (table.empty()) {
+			table.assign(1024, 0);
+			tableShift = 22;
+		}
+		else
+			std::fill(table.begin(), table.end(), 0);
+		open.reset(0);
+		if (!grid->isOpen(start.x, start.y) || !grid->isOpen(target.x, target.y)) return false;
+
+		int startNode = addNode(start.y * grid->width + start.x, 0, -1, 1 | 1 << 2);
+		open.push(startNode, pathKey(pathHeuristic(start, goal, connectivity), 0));
+		stats.pushed++;
+		int goalCell = target.y * grid->width + target.x;
+		while (!open.empty()) {
+			int node = open.pop();
+			nodeStates[node] |= nodeExpanded;
+			stats.expanded++;
+			if (nodeCells[node] == goalCell) {
+				goalNode = node;
+				pathCost = nodeCosts[node];
+				return true;
+			}
+			expand(node);
+		}
+		return false;
+	}
+
+	// Cost of the path found by the last search, pathNoCost if there was none
+	PathCost getCost() const {
+		return pathCost;
+	}
+
+	// Cells of the path found by the last search from the start to the goal, empty if there was none
+	// The cells between the jump points are filled in, they're in a straight or a diagonal line
+	void getPath(_Out_ std::vector<vec2<int>>& path) const {
+		path.clear();
+		if (goalNode < 0) return;
+		int width = grid->width;
+		for (int node = goalNode; node != -1; node = nodeParents[node]) {
+			vec2<int> cell(nodeCells[node] % width, nodeCells[node] / width);
+			path.push_back(cell);
+			if (nodeParents[node] < 0) break;
+			vec2<int> parent(nodeCells[nodeParents[node]] % width, nodeCells[nodeParents[node]] / width);
+			int dx = parent.x > cell.x ? 1 : parent.x < cell.x ? -1 : 0;
+			int dy = parent.y > cell.y ? 1 : parent.y < cell.y ? -1 : 0;
+			for (cell = vec2<int>(cell.x + dx, cell.y + dy); cell.x != parent.x || cell.y != parent.y; cell = vec2<int>(cell.x + dx, cell.y + dy))
+				path.push_back(cell);
+		}
+		std::reverse(path.begin(), path.end());
+	}
+
+	// Work done by the last search
+	Stats getStats() const {
+		return stats;
+	}
+
+	// Bytes used by the state of the jump points, the hash table and the heap
+	size_t memoryUsage() const {
+		return nodeCells.capacity() * sizeof(int) + nodeCosts.capacity() * sizeof(PathCost) + nodeParents.capacity() * sizeof(int)
+			+ nodeStates.capacity() + table.capacity() * sizeof(int) + open.memoryUsage();
+	}
+};
+
+#endif // !GRAPHICS_JUMP_POINT_SEARCH
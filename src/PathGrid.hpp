@@ -0,0 +1,335 @@
+#ifndef GRAPHICS_PATH_GRID
+#define GRAPHICS_PATH_GRID
+
+#include "Platform.hpp"
+#include "Geometry.hpp"
+#include <vector>
+
+// Cost of the paths, in hundredths of a straight step so that the costs add up exactly
+typedef unsigned int PathCost;
+const PathCost pathStraightCost = 100;
+const PathCost pathDiagonalCost = 141;
+// Cost of the cells that can't be reached
+const PathCost pathNoCost = 0xFFFFFFFF;
+// Most cells of a grid, the longest possible path (through all of them) still fits in a PathCost
+const int pathMaxCells = 1 << 24;
+
+// Moves allowed from a cell
+enum class PathConnectivity : unsigned char {
+	// Up, down, left and right
+	Four,
+	// Also diagonally, but not past the corner of a blocked cell
+	Eight,
+};
+
+// Grid of the cells the path finders search, the cells are stored row by row and their neighbours are found from the index
+class PathGrid {
+public:
+	int width = 0;
+	int height = 0;
+	// 1 for the blocked cells, the cell (x, y) is at y * width + x
+	std::vector<unsigned char> blocked;
+
+	PathGrid() {}
+	PathGrid(_In_ int gridWidth, _In_ int gridHeight) {
+		create(gridWidth, gridHeight);
+	}
+
+	// Makes an empty grid of the size, returns false if it's empty or too big
+	bool create(_In_ int gridWidth, _In_ int gridHeight) {
+		if (gridWidth <= 0 || gridHeight <= 0 || (long long)gridWidth * gridHeight > pathMaxCells) {
+			width = height = 0;
+			blocked.clear();
+			return false;
+		}
+		width = gridWidth;
+		height = gridHeight;
+		blocked.assign((size_t)width * height, 0);
+		return true;
+	}
+
+	// Number of the cells
+	int size() const {
+		return width * height;
+	}
+
+	// Index of the cell
+	int index(_In_ int x, _In_ int y) const {
+		return y * width + x;
+	}
+
+	// Coordinates of the cell at the index
+	vec2<int> coords(_In_ int cell) const {
+		return vec2<int>(cell % width, cell / width);
+	}
+
+	bool isInside(_In_ int x, _In_ int y) const {
+		return x >= 0 && y >= 0 && x < width && y < height;
+	}
+
+	// If the cell can be walked through, the cells outside of the grid can't
+	bool isOpen(_In_ int x, _In_ int y) const {
+		return isInside(x, y) && !blocked[(size_t)y * width + x];
+	}
+
+	void setBlocked(_In_ int x, _In_ int y, _In_ bool isBlocked) {
+		if (isInside(x, y))
+			blocked[(size_t)y * width + x] = isBlocked ? 1 : 0;
+	}
+};
+
+// Grid with one bit per cell (set for the blocked ones), for the maps too big for a byte per cell
+// The rows are stored twice, also transposed as columns, so the path finders can scan both for the next blocked cell
+// a word (64 cells) at a time. Every line has at least one bit more than the cells and there is a line more on both sides,
+// the bits outside of the grid are set, so a scan always stops at the edge
+class PathBitGrid {
+	// Words of a row and of a column
+	int rowWords = 0;
+	int columnWords = 0;
+	// Row y starts at (y + 1) * rowWords, column x at (x + 1) * columnWords
+	std::vector<unsigned long long> rows;
+	std::vector<unsigned long long> columns;
+
+public:
+	int width = 0;
+	int height = 0;
+
+	PathBitGrid() {}
+	PathBitGrid(_In_ int gridWidth, _In_ int gridHeight) {
+		create(gridWidth, gridHeight);
+	}
+
+	// Makes an empty grid of the size, returns false if it's empty or too big
+	bool create(_In_ int gridWidth, _In_ int gridHeight) {
+		rows.clear();
+		columns.clear();
+		if (gridWidth <= 0 || gridHeight <= 0 || (long long)gridWidth * gridHeight > pathMaxCells) {
+			width = height = rowWords = columnWords = 0;
+			return false;
+		}
+		width = gridWidth;
+		height = gridHeight;
+		rowWords = width / 64 + 1;
+		columnWords = height / 64 + 1;
+		rows.assign((size_t)(height + 2) * rowWords, ~0ull);
+		columns.assign((size_t)(width + 2) * columnWords, ~0ull);
+		// Clears the bits of the cells, the lines outside of the grid stay blocked
+		for (int y = 0; y < height; y++)
+			clearLine(&rows[(size_t)(y + 1) * rowWords], width);
+		for (int x = 0; x < width; x++)
+			clearLine(&columns[(size_t)(x + 1) * columnWords], height);
+		return true;
+	}
+
+	// Makes a copy of the byte grid
+	bool assign(_In_ const PathGrid& grid) {
+		if (!create(grid.width, grid.height)) return false;
+		for (int y = 0; y < height; y++)
+			for (int x = 0; x < width; x++)
+				if (grid.blocked[(size_t)y * width + x])
+					setBlocked(x, y, true);
+		return true;
+	}
+
+	bool isInside(_In_ int x, _In_ int y) const {
+		return x >= 0 && y >= 0 && x < width && y < height;
+	}
+
+	// If the cell can be walked through, the cells outside of the grid can't
+	bool isOpen(_In_ int x, _In_ int y) const {
+		return isInside(x, y) && !(row(y)[x >> 6] >> (x & 63) & 1);
+	}
+
+	void setBlocked(_In_ int x, _In_ int y, _In_ bool isBlocked) {
+		if (!isInside(x, y)) return;
+		setBit(rows[(size_t)(y + 1) * rowWords + (x >> 6)], x & 63, isBlocked);
+		setBit(columns[(size_t)(x + 1) * columnWords + (y >> 6)], y & 63, isBlocked);
+	}
+
+	// Bits of the row (from -1 to height), bit x % 64 of word x / 64 is the cell x
+	const unsigned long long* row(_In_ int y) const {
+		return &rows[(size_t)(y + 1) * rowWords];
+	}
+
+	// Bits of the column (from -1 to width), bit y % 64 of word y / 64 is the cell y
+	const unsigned long long* column(_In_ int x) const {
+		return &columns[(size_t)(x + 1) * columnWords];
+	}
+
+	int getRowWords() const {
+		return rowWords;
+	}
+
+	int getColumnWords() const {
+		return columnWords;
+	}
+
+	// Bytes used by the bits
+	size_t memoryUsage() const {
+		return (rows.capacity() + columns.capacity()) * sizeof(unsigned long long);
+	}
+
+private:
+	static void clearLine(_Inout_ unsigned long long* line, _In_ int length) {
+		for (int i = 0; i < length / 64; i++)
+			line[i] = 0;
+		// The bits past the end stay set
+		line[length / 64] = ~0ull << (length & 63);
+	}
+
+	static void setBit(_Inout_ unsigned long long& word, _In_ int bit, _In_ bool value) {
+		if (value) word |= 1ull << bit;
+		else word &= ~(1ull << bit);
+	}
+};
+
+// Cost of the cheapest path between the cells on a grid without obstacles, never more than the real cost
+// so the path finders using it find the shortest paths, and never dropping by more than the cost of a step
+inline PathCost pathHeuristic(_In_ vec2<int> from, _In_ vec2<int> to, _In_ PathConnectivity connectivity) {
+	PathCost dx = (PathCost)(from.x > to.x ? from.x - to.x : to.x - from.x);
+	PathCost dy = (PathCost)(from.y > to.y ? from.y - to.y : to.y - from.y);
+	if (connectivity == PathConnectivity::Four)
+		return (dx + dy) * pathStraightCost;
+	// Diagonal steps for the shorter axis, straight ones for the rest
+	PathCost diagonal = dx < dy ? dx : dy;
+	return diagonal * pathDiagonalCost + (dx + dy - 2 * diagonal) * pathStraightCost;
+}
+
+// Binary min heap of the open cells of a search, each cell knows its position in the heap so its key can be lowered in place
+// The keys are kept next to the cells so sifting only touches the heap array
+class PathHeap {
+	struct Entry {
+		unsigned long long key;
+		int cell;
+	};
+	std::vector<Entry> entries;
+	// Position of every cell in the heap, only valid for the cells in it
+	std::vector<int> positions;
+
+	void place(_In_ int position, _In_ const Entry& entry) {
+		entries[position] = entry;
+		positions[entry.cell] = position;
+	}
+
+	void siftUp(_In_ int position) {
+		Entry entry = entries[position];
+		while (position > 0) {
+			int parent = (position - 1) / 2;
+			if (entries[parent].key <= entry.key) break;
+			place(position, entries[parent]);
+			position = parent;
+		}
+		place(position, entry);
+	}
+
+	void siftDown(_In_ int position) {
+		Entry entry = entries[position];
+		int count = (int)entries.size();
+		for (;;) {
+			int child = position * 2 + 1;
+			if (child >= count) break;
+			if (child + 1 < count && entries[child + 1].key < entries[child].key)
+				child++;
+			if (entry.key <= entries[child].key) break;
+			place(position, entries[child]);
+			position = child;
+		}
+		place(position, entry);
+	}
+
+public:
+	// Makes room for the cells of a grid and empties the heap
+	void reset(_In_ int cellCount) {
+		entries.clear();
+		if ((int)positions.size() != cellCount)
+			positions.assign(cellCount, 0);
+	}
+
+	// Makes room for more cells without emptying the heap
+	void grow(_In_ int cellCount) {
+		if ((int)positions.size() < cellCount)
+			positions.resize(cellCount);
+	}
+
+	bool empty() const {
+		return entries.empty();
+	}
+
+	int size() const {
+		return (int)entries.size();
+	}
+
+	// Adds a cell that isn't in the heap
+	void push(_In_ int cell, _In_ unsigned long long key) {
+		entries.push_back(Entry{ key, cell });
+		siftUp((int)entries.size() - 1);
+	}
+
+	// Lowers the key of a cell in the heap
+	void decrease(_In_ int cell, _In_ unsigned long long key) {
+		int position = positions[cell];
+		entries[position].key = key;
+		siftUp(position);
+	}
+
+	// If the cell is in the heap, the positions of the other cells can be left from before
+	bool contains(_In_ int cell) const {
+		int position = positions[cell];
+		return position >= 0 && position < (int)entries.size() && entries[position].cell == cell;
+	}
+
+	// Cell with the lowest key and the key
+	int top() const {
+		return entries[0].cell;
+	}
+
+	unsigned long long topKey() const {
+		return entries[0].key;
+	}
+
+	// Changes the key of a cell in the heap either way
+	void update(_In_ int cell, _In_ unsigned long long key) {
+		int position = positions[cell];
+		unsigned long long oldKey = entries[position].key;
+		entries[position].key = key;
+		if (key < oldKey) siftUp(position);
+		else siftDown(position);
+	}
+
+	// Removes a cell from the heap
+	void remove(_In_ int cell) {
+		int position = positions[cell];
+		Entry last = entries.back();
+		entries.pop_back();
+		if (position == (int)entries.size()) return;
+		unsigned long long oldKey = entries[position].key;
+		place(position, last);
+		if (last.key < oldKey) siftUp(position);
+		else siftDown(position);
+	}
+
+	// Removes the cell with the lowest key and returns it
+	int pop() {
+		int cell = entries[0].cell;
+		Entry last = entries.back();
+		entries.pop_back();
+		if (!entries.empty()) {
+			entries[0] = last;
+			siftDown(0);
+		}
+		return cell;
+	}
+
+	// Bytes used by the heap
+	size_t memoryUsage() const {
+		return entries.capacity() * sizeof(Entry) + positions.capacity() * sizeof(int);
+	}
+};
+
+// Key of an open cell ordered by the estimated cost of the path through it (f), the ties go to the cell
+// closest to the goal (with the highest cost so far, g), which saves expanding most of the equally good cells
+inline unsigned long long pathKey(_In_ PathCost estimate, _In_ PathCost cost) {
+	return (unsigned long long)estimate << 32 | (PathCost)(pathNoCost - cost);
+}
+
+#endif // !GRAPHICS_PATH_GRID
@@ -0,0 +1,245 @@
+#ifndef GRAPHICS_PIXEL_FORMAT
+#define GRAPHICS_PIXEL_FORMAT
+
+#include "Platform.hpp"
+#include "SpanFill.hpp"
+#include "Blend.hpp"
+#include "Blit.hpp"
+#include "Triangle.hpp"
+#include <cstdint>
+#include <cstring>
+
+// Pixel formats of BasicRenderTarget, each one is a policy with the pixel type, the conversion from and to 0x00RRGGBB
+// and the inner loops written for it, so the primitives are compiled separately for every format without any branching on it
+// Colors are always passed as 0x00RRGGBB, the conversion is constexpr so constant colors are converted at compile time,
+// the pixels are only converted back (toBGRA) when they're presented
+
+// Loops of the formats that unpack the pixels to blend them, Format has the constexpr fromRGB and toRGB
+template<class Format, class PixelType>
+struct PackedPixelFormat {
+	typedef PixelType Pixel;
+
+	// Blends the color (0x00RRGGBB) over the pixel with the coverage (0 - 255), like blendColor
+	static Pixel blend(_In_ Pixel destination, _In_ UINT32 color, _In_ unsigned int coverage) {
+		return Format::fromRGB(blendColor(Format::toRGB(destination), color, coverage));
+	}
+
+	// Blends the color over count pixels, each one with its own coverage
+	static void blendSpan(_In_ Pixel* pixel, _In_ const unsigned char* coverage, _In_ size_t count, _In_ UINT32 color) {
+		Pixel value = Format::fromRGB(color);
+		for (size_t i = 0; i < count; i++) {
+			if (coverage[i] == 255)
+				pixel[i] = value;
+			else if (coverage[i] != 0)
+				pixel[i] = blend(pixel[i], color, coverage[i]);
+		}
+	}
+
+	// Blends the color over 2 pixels with their own coverage, like blendPair
+	static void blendPair(_Inout_ Pixel* first, _Inout_ Pixel* second, _In_ unsigned int firstCoverage, _In_ unsigned int secondCoverage, _In_ UINT32 color) {
+		*first = blend(*first, color, firstCoverage);
+		*second = blend(*second, color, secondCoverage);
+	}
+
+	// Combines a row of an image (BGRA bytes) with the pixels in the chosen mode, like blitSpan
+	static void blitSpan(_In_ Pixel* pixel, _In_ const unsigned char* source, _In_ size_t count, _In_ BlitMode mode, _In_ UINT32 colorKey) {
+		switch (mode) {
+		case BlitMode::Copy:
+			for (size_t i = 0; i < count; i++)
+				pixel[i] = Format::fromRGB(loadImagePixel(source + i * 4) & 0xFFFFFF);
+			break;
+		case BlitMode::ColorKey:
+			for (size_t i = 0; i < count; i++) {
+				UINT32 color = loadImagePixel(source + i * 4) & 0xFFFFFF;
+				if (color != colorKey)
+					pixel[i] = Format::fromRGB(color);
+			}
+			break;
+		case BlitMode::Alpha:
+			for (size_t i = 0; i < count; i++) {
+				UINT32 color = loadImagePixel(source + i * 4);
+				unsigned int alpha = color >> 24;
+				if (alpha == 255)
+					pixel[i] = Format::fromRGB(color & 0xFFFFFF);
+				else if (alpha != 0)
+					pixel[i] = blend(pixel[i], color & 0xFFFFFF, alpha);
+			}
+			break;
+		}
+	}
+
+	// Fills the covered pixels of a triangle block
+	static void coverBlock(_In_ const BasicTriangleBlock<Pixel>& block, _In_ Pixel color) {
+#ifdef GRAPHICS_SSE2
+		coverBlockMaskSSE2(block, color);
+#else
+		coverBlockScalar(block, color);
+#endif
+	}
+
+	// Fills the covered pixels of a whole small triangle, like a block
+	static void coverSmallTriangle(_In_ const BasicTriangleBlock<Pixel>& block, _In_ Pixel color) {
+		coverBlock(block, color);
+	}
+
+	// Converts count pixels to 0x00RRGGBB for presenting
+	static void toBGRA(_In_ const Pixel* pixel, _Out_ UINT32* bgra, _In_ size_t count) {
+		for (size_t i = 0; i < count; i++)
+			bgra[i] = Format::toRGB(pixel[i]);
+	}
+};
+
+// 32bpp 0x00RRGGBB (BGRA bytes, the top byte unused), the native format of the windows, with the SSE2 / AVX2 kernels
+struct BGRA32 {
+	typedef UINT32 Pixel;
+
+	static constexpr const char* name() {
+		return "BGRA32";
+	}
+
+	static constexpr Pixel fromRGB(_In_ UINT32 color) {
+		return color;
+	}
+
+	static constexpr UINT32 toRGB(_In_ Pixel pixel) {
+		return pixel & 0xFFFFFF;
+	}
+
+	static void fillSpan(_In_ Pixel* pixel, _In_ size_t count, _In_ Pixel color) {
+		::fillSpan(pixel, count, color);
+	}
+
+	static void fillFrame(_In_ Pixel* pixel, _In_ size_t count, _In_ Pixel color) {
+		::fillFrame(pixel, count, color);
+	}
+
+	static Pixel blend(_In_ Pixel destination, _In_ UINT32 color, _In_ unsigned int coverage) {
+		return blendColor(destination, color, coverage);
+	}
+
+	static void blendSpan(_In_ Pixel* pixel, _In_ const unsigned char* coverage, _In_ size_t count, _In_ UINT32 color) {
+		::blendSpan(pixel, coverage, count, color);
+	}
+
+	static void blendPair(_Inout_ Pixel* first, _Inout_ Pixel* second, _In_ unsigned int firstCoverage, _In_ unsigned int secondCoverage, _In_ UINT32 color) {
+		::blendPair(first, second, firstCoverage, secondCoverage, color);
+	}
+
+	static void blitSpan(_In_ Pixel* pixel, _In_ const unsigned char* source, _In_ size_t count, _In_ BlitMode mode, _In_ UINT32 colorKey) {
+		::blitSpan(pixel, source, count, mode, colorKey);
+	}
+
+	static void coverBlock(_In_ const TriangleBlock& block, _In_ Pixel color) {
+		coverBlockKernel()(block, color);
+	}
+
+	static void coverSmallTriangle(_In_ const TriangleBlock& block, _In_ Pixel color) {
+		coverSmallTriangleKernel()(block, color);
+	}
+
+	static void toBGRA(_In_ const Pixel* pixel, _Out_ UINT32* bgra, _In_ size_t count) {
+		memcpy(bgra, pixel, count * sizeof(Pixel));
+	}
+};
+
+// 16bpp 5-6-5 RGB, half of the memory traffic of BGRA32, long spans are filled 2 pixels at a time with the 32-bit kernels
+struct RGB565 : PackedPixelFormat<RGB565, uint16_t> {
+	static constexpr const char* name() {
+		return "RGB565";
+	}
+
+	// The low bits of the channels are dropped
+	static constexpr Pixel fromRGB(_In_ UINT32 color) {
+		return (Pixel)((color >> 8 & 0xF800) | (color >> 5 & 0x07E0) | (color >> 3 & 0x001F));
+	}
+
+	// The top bits of the channels are repeated in the low ones, so white stays white
+	static constexpr UINT32 toRGB(_In_ Pixel pixel) {
+		return ((UINT32)(pixel >> 11) << 3 | (UINT32)(pixel >> 13)) << 16
+			| ((UINT32)(pixel >> 5 & 0x3F) << 2 | (UINT32)(pixel >> 9 & 0x03)) << 8
+			| ((UINT32)(pixel & 0x1F) << 3 | (UINT32)(pixel >> 2 & 0x07));
+	}
+
+	static void fillSpan(_In_ Pixel* pixel, _In_ size_t count, _In_ Pixel color) {
+		if (count < shortSpanLength * 2) {
+			for (size_t i = 0; i < count; i++)
+				pixel[i] = color;
+			return;
+		}
+		// Pairs of pixels from a 4 byte boundary
+		if ((uintptr_t)pixel & 2) {
+			*pixel++ = color;
+			count--;
+		}
+		spanKernels().fill((UINT32*)pixel, count / 2, (UINT32)color * 0x10001);
+		if (count & 1)
+			pixel[count - 1] = color;
+	}
+
+	static void fillFrame(_In_ Pixel* pixel, _In_ size_t count, _In_ Pixel color) {
+		if (count * sizeof(Pixel) >= streamingFillThreshold) {
+			// Pairs of pixels from a 4 byte boundary, frames usually start at a page boundary but attached bitmaps don't have to
+			if ((uintptr_t)pixel & 2) {
+				*pixel++ = color;
+				count--;
+			}
+			spanKernels().fillStream((UINT32*)pixel, count / 2, (UINT32)color * 0x10001);
+			if (count & 1)
+				pixel[count - 1] = color;
+		}
+		else
+			fillSpan(pixel, count, color);
+	}
+};
+
+// 8bpp indexed with the fixed 3-3-2 palette (RRRGGGBB), a quarter of the memory traffic of BGRA32
+// The palette is fixed so that the colors can be converted at compile time
+struct Indexed8 : PackedPixelFormat<Indexed8, unsigned char> {
+	static constexpr const char* name() {
+		return "Indexed8";
+	}
+
+	// Index of the palette color with the top bits of the channels
+	static constexpr Pixel fromRGB(_In_ UINT32 color) {
+		return (Pixel)((color >> 16 & 0xE0) | (color >> 11 & 0x1C) | (color >> 6 & 0x03));
+	}
+
+	// Palette color of the index, the channels are scaled to 0 - 255
+	static constexpr UINT32 toRGB(_In_ Pixel pixel) {
+		return (UINT32)((pixel >> 5) * 255 / 7) << 16 | (UINT32)((pixel >> 2 & 0x07) * 255 / 7) << 8 | (UINT32)((pixel & 0x03) * 255 / 3);
+	}
+
+	// Colors of all of the indices
+	static const UINT32* palette() {
+		struct Palette {
+			UINT32 colors[256];
+			Palette() {
+				for (int i = 0; i < 256; i++)
+					colors[i] = toRGB((Pixel)i);
+			}
+		};
+		static const Palette table;
+		return table.colors;
+	}
+
+	static void fillSpan(_In_ Pixel* pixel, _In_ size_t count, _In_ Pixel color) {
+		memset(pixel, color, count);
+	}
+
+	static void fillFrame(_In_ Pixel* pixel, _In_ size_t count, _In_ Pixel color) {
+		memset(pixel, color, count);
+	}
+
+	// Presenting looks the colors up in the palette
+	static void toBGRA(_In_ const Pixel* pixel, _Out_ UINT32* bgra, _In_ size_t count) {
+		const UINT32* colors = palette();
+		for (size_t i = 0; i < count; i++)
+			bgra[i] = colors[pixel[i]];
+	}
+};
+
+// The conversions are constant expressions
+static_assert(RGB565::fromRGB(0xFF0000) == 0xF800 && RGB565::toRGB(0xFFFF) == 0xFFFFFF, "RGB565 conversion");
+static_assert(Indexed8::fromRGB(0xFFFFFF) == 0xFF && Indexed8::toRGB(0xFF) == 0xFFFFFF, "Indexed8 conversion");
+
+#endif // !GRAPHICS_PIXEL_FORMAT
@@ -0,0 +1,253 @@
+#ifndef GRAPHICS_PLATFORM
+#define GRAPHICS_PLATFORM
+
+#include <cstddef>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdint>
+#include <cerrno>
+#include <ctime>
+
+typedef std::uint32_t UINT32;
+
+// SAL annotations are only understood by MSVC
+#define _In_
+#define _In_opt_
+#define _Out_
+#define _Inout_
+#endif
+
+// SSE2 is always available on x64, AVX2 has to be detected at runtime
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GRAPHICS_SSE2
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+// MSVC allows using any instruction set intrinsics without compiler flags
+#define GRAPHICS_TARGET_AVX2
+#else
+#define GRAPHICS_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+// Checks if the CPU (and the OS) supports AVX2
+inline bool cpuHasAVX2() {
+#if !defined(GRAPHICS_SSE2)
+	return false;
+#elif defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7) return false;
+	__cpuid(info, 1);
+	// OSXSAVE and AVX, the OS also has to save the YMM registers
+	if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0 || (_xgetbv(0) & 0x6) != 0x6) return false;
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+
+// Index of the lowest set bit, the value can't be 0
+inline int countTrailingZeros(_In_ unsigned int value) {
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, value);
+	return (int)index;
+#else
+	return __builtin_ctz(value);
+#endif
+}
+
+// Index of the lowest set bit of a 64-bit value, the value can't be 0
+inline int countTrailingZeros64(_In_ unsigned long long value) {
+#if defined(_MSC_VER) && defined(_M_X64)
+	unsigned long index;
+	_BitScanForward64(&index, value);
+	return (int)index;
+#elif defined(_MSC_VER)
+	// 32-bit MSVC only scans 32 bits at once
+	unsigned int low = (unsigned int)value;
+	return low != 0 ? countTrailingZeros(low) : 32 + countTrailingZeros((unsigned int)(value >> 32));
+#else
+	return __builtin_ctzll(value);
+#endif
+}
+
+// Index of the highest set bit of a 64-bit value, the value can't be 0
+inline int highestSetBit64(_In_ unsigned long long value) {
+#if defined(_MSC_VER) && defined(_M_X64)
+	unsigned long index;
+	_BitScanReverse64(&index, value);
+	return (int)index;
+#elif defined(_MSC_VER)
+	unsigned long index;
+	unsigned int high = (unsigned int)(value >> 32);
+	if (high != 0) {
+		_BitScanReverse(&index, high);
+		return 32 + (int)index;
+	}
+	_BitScanReverse(&index, (unsigned int)value);
+	return (int)index;
+#else
+	return 63 - __builtin_clzll(value);
+#endif
+}
+
+// Allocates zeroed, page aligned memory for the pixel buffers
+inline void* allocatePages(_In_ size_t size) {
+#ifdef _WIN32
+	return VirtualAlloc(0,         // Starting address of the region to allocate
+		size,                      // Size of the region (in bytes)
+		MEM_RESERVE | MEM_COMMIT,  // Type of memory allocation
+		PAGE_READWRITE);           // Memory protection for the region
+#else
+	void* pages = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	return pages == MAP_FAILED ? nullptr : pages;
+#endif
+}
+
+// Frees memory allocated with allocatePages
+inline void freePages(_In_ void* pages, _In_ size_t size) {
+	if (!pages) return;
+#ifdef _WIN32
+	(void)size;
+	VirtualFree(pages, 0, MEM_RELEASE);
+#else
+	munmap(pages, size);
+#endif
+}
+
+// Size of the huge (large) pages, 0 if the OS doesn't support them
+inline size_t hugePageSize() {
+#ifdef _WIN32
+	return GetLargePageMinimum();
+#elif defined(MAP_HUGETLB)
+	// The default huge page size on x64 and ARM64
+	return (size_t)2 << 20;
+#else
+	return 0;
+#endif
+}
+
+#ifdef _WIN32
+// Large pages need the "Lock pages in memory" privilege, it's enabled once for the process if the user has it
+inline bool enableLargePages() {
+	static const bool enabled = [] {
+		HANDLE token;
+		if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token)) return false;
+		TOKEN_PRIVILEGES privileges = {};
+		privileges.PrivilegeCount = 1;
+		privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+		bool adjusted = LookupPrivilegeValue(nullptr, SE_LOCK_MEMORY_NAME, &privileges.Privileges[0].Luid)
+			&& AdjustTokenPrivileges(token, FALSE, &privileges, 0, nullptr, nullptr) && GetLastError() == ERROR_SUCCESS;
+		CloseHandle(token);
+		return adjusted;
+	}();
+	return enabled;
+}
+#endif
+
+// Allocates zeroed memory backed by huge pages (size has to be a multiple of hugePageSize), nullptr if there are none available
+// Without the reserved huge pages Linux gets the memory with the transparent huge pages hint instead
+inline void* allocateHugePages(_In_ size_t size) {
+	if (hugePageSize() == 0 || size % hugePageSize() != 0) return nullptr;
+#ifdef _WIN32
+	if (!enableLargePages()) return nullptr;
+	return VirtualAlloc(0, size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+#elif defined(MAP_HUGETLB)
+	void* pages = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	if (pages != MAP_FAILED) return pages;
+	// No reserved huge pages, ask for the transparent ones instead
+	pages = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (pages == MAP_FAILED) return nullptr;
+#ifdef MADV_HUGEPAGE
+	madvise(pages, size, MADV_HUGEPAGE);
+#endif
+	return pages;
+#else
+	return nullptr;
+#endif
+}
+
+// Sleeps for the time (in nanoseconds), on Windows with a high resolution timer where there is one (Windows 10 1803 and newer)
+// The OS can still wake the thread up a bit later, FrameScheduler measures by how much and wakes up earlier
+inline void preciseSleep(_In_ long long nanoseconds) {
+	if (nanoseconds <= 0) return;
+#ifdef _WIN32
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+	// Every thread has its own timer, Sleep only has the resolution of the system timer (usually 15.6 ms)
+	thread_local HANDLE timer = [] {
+		HANDLE highResolution = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+		return highResolution ? highResolution : CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+	}();
+	// Negative due time is relative, in 100 ns units
+	LARGE_INTEGER dueTime;
+	dueTime.QuadPart = -(nanoseconds + 99) / 100;
+	if (timer && SetWaitableTimer(timer, &dueTime, 0, nullptr, nullptr, FALSE))
+		WaitForSingleObject(timer, INFINITE);
+	else
+		Sleep((DWORD)(nanoseconds / 1000000));
+#else
+	timespec duration = { (time_t)(nanoseconds / 1000000000), (long)(nanoseconds % 1000000000) };
+	// Signals interrupt the sleep, the rest of it is in duration
+	while (nanosleep(&duration, &duration) != 0 && errno == EINTR) {}
+#endif
+}
+
+// Maps a whole file read-only into memory, returns nullptr (and size 0) if it couldn't be opened or is empty
+// The view stays valid after the file is closed, until unmapFile
+inline const void* mapFile(_In_ const char* path, _Out_ size_t& size) {
+	size = 0;
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) return nullptr;
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart <= 0 || (unsigned long long)fileSize.QuadPart > (size_t)-1) {
+		CloseHandle(file);
+		return nullptr;
+	}
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle(file);
+	if (!mapping) return nullptr;
+	// The view keeps the mapping alive
+	const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+	if (view) size = (size_t)fileSize.QuadPart;
+	return view;
+#else
+	int file = open(path, O_RDONLY);
+	if (file < 0) return nullptr;
+	struct stat info;
+	if (fstat(file, &info) != 0 || info.st_size <= 0) {
+		close(file);
+		return nullptr;
+	}
+	void* view = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+	close(file);
+	if (view == MAP_FAILED) return nullptr;
+	size = (size_t)info.st_size;
+	return view;
+#endif
+}
+
+// Unmaps a file mapped with mapFile
+inline void unmapFile(_In_ const void* view, _In_ size_t size) {
+	if (!view) return;
+#ifdef _WIN32
+	(void)size;
+	UnmapViewOfFile(view);
+#else
+	munmap(const_cast<void*>(view), size);
+#endif
+}
+
+#endif // !GRAPHICS_PLATFORM
@@ -0,0 +1,231 @@
+#ifndef GRAPHICS_PROFILER
+#define GRAPHICS_PROFILER
+
+// Frame profiler, compiled in only when GRAPHICS_PROFILE is defined (-DGRAPHICS_PROFILE or before including the engine)
+// Without it the macros below expand to nothing and none of the code below is compiled
+//
+// GRAPHICS_PROFILE_SCOPE("name") times the rest of the block, the name has to be a string literal
+// GRAPHICS_PROFILE_THREAD("name") names the calling thread in the trace
+// GRAPHICS_PROFILE_FRAME() ends a frame, its time is kept for the frame time graph
+
+#ifdef GRAPHICS_PROFILE
+
+#include "Platform.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Timed scope recorded by a thread
+struct ProfileEvent {
+	const char* name;
+	// Start and duration (in nanoseconds since the profiler was started)
+	long long start;
+	long long duration;
+};
+
+// Ring of the last events of one thread, written only by its thread without any locks
+// Older events are overwritten once it's full
+class ProfileThreadBuffer {
+public:
+	// Number of the events kept per thread
+	static const unsigned int capacity = 1 << 16;
+
+	ProfileEvent events[capacity];
+	// Events written so far, the event i is at i % capacity
+	std::atomic<unsigned long long> written{ 0 };
+	// Id of the thread in the trace (1 is the first thread that recorded anything)
+	int threadId = 0;
+	// Name of the thread in the trace, nullptr if it wasn't named
+	std::atomic<const char*> name{ nullptr };
+
+	// Adds an event, only called by the thread of the buffer
+	void add(_In_ const char* eventName, _In_ long long start, _In_ long long duration) {
+		unsigned long long index = written.load(std::memory_order_relaxed);
+		events[index % capacity] = ProfileEvent{ eventName, start, duration };
+		written.store(index + 1, std::memory_order_release);
+	}
+
+	// Copies the events that are still in the ring, events overwritten while copying are skipped
+	void snapshot(_Out_ std::vector<ProfileEvent>& copy) const {
+		unsigned long long end = written.load(std::memory_order_acquire);
+		unsigned long long begin = end > capacity ? end - capacity : 0;
+		copy.clear();
+		for (unsigned long long i = begin; i < end; i++)
+			copy.push_back(events[i % capacity]);
+		// The thread could have kept writing, events it may have overwritten are dropped
+		unsigned long long now = written.load(std::memory_order_acquire);
+		unsigned long long firstValid = now >= capacity ? now - capacity + 1 : 0;
+		size_t stale = firstValid > begin ? (size_t)(firstValid - begin) : 0;
+		copy.erase(copy.begin(), copy.begin() + (ptrdiff_t)std::min(stale, copy.size()));
+	}
+};
+
+// Collects the rings of all of the threads and the frame times
+class Profiler {
+public:
+	// Number of the frame times kept for the graph
+	static const int frameHistory = 240;
+
+private:
+	std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+	// Rings of the threads, never freed so the events of finished threads can still be exported
+	std::mutex threadsMutex;
+	std::vector<std::unique_ptr<ProfileThreadBuffer>> threads;
+
+	// Frame times (in milliseconds), written only by the thread calling frame()
+	float frameTimes[frameHistory] = {};
+	int frameCount = 0;
+	long long lastFrame = -1;
+
+	// Writes the string as JSON
+	static void writeJSONString(_In_ FILE* file, _In_ const char* text) {
+		fputc('"', file);
+		for (; *text; text++) {
+			if (*text == '"' || *text == '\\')
+				fputc('\\', file);
+			if ((unsigned char)*text >= 0x20)
+				fputc(*text, file);
+		}
+		fputc('"', file);
+	}
+
+public:
+	// Time since the profiler was started (in nanoseconds)
+	long long now() const {
+		return (long long)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+	}
+
+	// Ring of the calling thread, made when the thread records its first event
+	ProfileThreadBuffer& threadBuffer() {
+		thread_local ProfileThreadBuffer* buffer = nullptr;
+		if (!buffer) {
+			std::unique_ptr<ProfileThreadBuffer> created(new ProfileThreadBuffer());
+			std::lock_guard<std::mutex> lock(threadsMutex);
+			created->threadId = (int)threads.size() + 1;
+			buffer = created.get();
+			threads.push_back(std::move(created));
+		}
+		return *buffer;
+	}
+
+	// Ends a frame, records it as an event spanning from the end of the previous one
+	void frame() {
+		long long time = now();
+		if (lastFrame >= 0) {
+			threadBuffer().add("frame", lastFrame, time - lastFrame);
+			frameTimes[frameCount % frameHistory] = (float)((time - lastFrame) / 1e6);
+			frameCount++;
+		}
+		lastFrame = time;
+	}
+
+	// Number of the frames ended so far (without the first one)
+	int getFrameCount() const {
+		return frameCount;
+	}
+
+	// Time of the frame ago frames back (0 is the last one, in milliseconds), 0 if there's no such frame
+	float getFrameTime(_In_ int ago) const {
+		if (ago < 0 || ago >= frameHistory || ago >= frameCount) return 0.0f;
+		return frameTimes[(frameCount - 1 - ago) % frameHistory];
+	}
+
+	// Copies the events of all of the threads, with the thread ids
+	void collect(_Out_ std::vector<ProfileEvent>& events, _Out_ std::vector<int>& threadIds) {
+		events.clear();
+		threadIds.clear();
+		std::vector<ProfileEvent> copy;
+		std::lock_guard<std::mutex> lock(threadsMutex);
+		for (const std::unique_ptr<ProfileThreadBuffer>& buffer : threads) {
+			buffer->snapshot(copy);
+			events.insert(events.end(), copy.begin(), copy.end());
+			threadIds.insert(threadIds.end(), copy.size(), buffer->threadId);
+		}
+	}
+
+	// Writes the recorded events as a Chrome trace (chrome://tracing, ui.perfetto.dev), returns false if the file couldn't be written
+	bool writeChromeTrace(_In_ const char* path) {
+		FILE* file = fopen(path, "w");
+		if (!file) return false;
+		std::vector<ProfileEvent> events;
+		std::vector<int> threadIds;
+		collect(events, threadIds);
+
+		fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+		bool first = true;
+		{
+			std::lock_guard<std::mutex> lock(threadsMutex);
+			for (const std::unique_ptr<ProfileThreadBuffer>& buffer : threads) {
+				const char* name = buffer->name.load();
+				if (!name) continue;
+				fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":", first ? "" : ",\n", buffer->threadId);
+				writeJSONString(file, name);
+				fprintf(file, "}}");
+				first = false;
+			}
+		}
+		// Complete events with the times in microseconds
+		for (size_t i = 0; i < events.size(); i++) {
+			fprintf(file, "%s{\"name\":", first ? "" : ",\n");
+			writeJSONString(file, events[i].name);
+			fprintf(file, ",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}", threadIds[i], events[i].start / 1e3, events[i].duration / 1e3);
+			first = false;
+		}
+		fprintf(file, "\n]}\n");
+		return fclose(file) == 0;
+	}
+
+	// Forgets the recorded events and frame times, the threads can't be recording while it runs
+	void clear() {
+		{
+			std::lock_guard<std::mutex> lock(threadsMutex);
+			for (const std::unique_ptr<ProfileThreadBuffer>& buffer : threads)
+				buffer->written.store(0);
+		}
+		frameCount = 0;
+		lastFrame = -1;
+	}
+};
+
+// Profiler of the process
+inline Profiler& profiler() {
+	static Profiler instance;
+	return instance;
+}
+
+// Records the time from its construction to the end of the scope
+class ProfileScope {
+	const char* name;
+	long long start;
+
+public:
+	explicit ProfileScope(_In_ const char* scopeName) : name(scopeName), start(profiler().now()) {}
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope& operator=(const ProfileScope&) = delete;
+
+	~ProfileScope() {
+		Profiler& instance = profiler();
+		long long end = instance.now();
+		instance.threadBuffer().add(name, start, end - start);
+	}
+};
+
+#define GRAPHICS_PROFILE_CONCAT_(a, b) a##b
+#define GRAPHICS_PROFILE_CONCAT(a, b) GRAPHICS_PROFILE_CONCAT_(a, b)
+#define GRAPHICS_PROFILE_SCOPE(name) ProfileScope GRAPHICS_PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define GRAPHICS_PROFILE_THREAD(threadName) profiler().threadBuffer().name.store(threadName)
+#define GRAPHICS_PROFILE_FRAME() profiler().frame()
+
+#else
+
+#define GRAPHICS_PROFILE_SCOPE(name) ((void)0)
+#define GRAPHICS_PROFILE_THREAD(threadName) ((void)0)
+#define GRAPHICS_PROFILE_FRAME() ((void)0)
+
+#endif // GRAPHICS_PROFILE
+
+#endif // !GRAPHICS_PROFILER
@@ -0,0 +1,1755 @@
+#ifndef GRAPHICS_RENDER_TARGET
+#define GRAPHICS_RENDER_TARGET
+
+#include "Platform.hpp"
+#include "SpanFill.hpp"
+#include "Geometry.hpp"
+#include "DirtyRegion.hpp"
+#include "GlyphAtlas.hpp"
+#include "Blend.hpp"
+#include "Blit.hpp"
+#include "Bezier.hpp"
+#include "Triangle.hpp"
+#include "PixelFormat.hpp"
+#include "FramebufferPool.hpp"
+#include "DrawCommand.hpp"
+#include "Profiler.hpp"
+#include <cstdlib>
+#include <climits>
+#include <cstddef>
+#include <cstring>
+#include <cmath>
+#include <cwchar>
+
+enum COLOR {
+	RED = 0xFF0000,
+	GREEN = 0x00FF00,
+	BLUE = 0x0000FF,
+	YELLOW = 0xFFFF00,
+	PINK = 0xFFC0CB,
+	PURPLE = 0x800080,
+	ORANGE = 0xFFA500,
+	WHITE = 0xFFFFFF,
+	BLACK = 0x000000,
+	GREY = 0x808080,
+};
+
+// Offscreen pixel buffer in the pixel format (PixelFormat.hpp) with all of the drawing primitives
+// Doesn't depend on any window, so it can be rendered to headlessly on any platform
+// The colors of the draw calls are 0x00RRGGBB in every format, the pixels are converted only when presented
+template<class Format>
+class BasicRenderTarget {
+public:
+	// Pixel of the format
+	typedef typename Format::Pixel Pixel;
+
+protected:
+	// Memory allocated for the pixels
+	void* memory = nullptr;
+	// Size of the allocated memory (in bytes)
+	size_t memorySize = 0;
+	// If the memory was allocated by the target (and not attached)
+	bool ownsMemory = false;
+	// Region drawn to since the last present
+	DirtyRegion dirtyRegion;
+	// Buffers reused by the batched Bezier curves
+	BezierBatch bezierBatch;
+	// Points of the curves replayed with an offset
+	std::vector<vec2<int>> replayPoints;
+	// Coverage of the anti-aliased edges
+	std::vector<unsigned char> coverageRow;
+	// Row half widths of the round caps of the lines
+	std::vector<int> capExtents;
+	// Leftmost and rightmost pixel of every row of the thin line the thick lines are drawn around
+	std::vector<int> capsuleRuns;
+	// List the draw calls are recorded to instead of being drawn, nullptr draws them right away
+	DrawCommandList* recording = nullptr;
+	// List the draw calls are also copied to when they're drawn, nullptr if they aren't captured
+	DrawCommandList* capture = nullptr;
+	// Clip rectangle (max exclusive) of the draw calls, inside of the bitmap
+	Rect clipRect;
+	// Clip rectangles saved by pushClipRect
+	std::vector<Rect> clipStack;
+	// Rectangle (max exclusive) the plot functions are clipped to, the clip rectangle unless a part of it is drawn separately
+	int clipMinX = 0;
+	int clipMinY = 0;
+	int clipMaxX = 0;
+	int clipMaxY = 0;
+
+	template<class> friend class BasicTileRenderer;
+
+	// Sets the rectangle (max exclusive) the plot functions are clipped to, it has to be inside of the bitmap
+	void setClip(_In_ int minX, _In_ int minY, _In_ int maxX, _In_ int maxY) {
+		clipMinX = minX;
+		clipMinY = minY;
+		clipMaxX = maxX;
+		clipMaxY = maxY;
+	}
+
+	// Clips the plot functions to the clip rectangle
+	void resetClip() {
+		setClip(clipRect.minPoint.x, clipRect.minPoint.y, clipRect.maxPoint.x, clipRect.maxPoint.y);
+	}
+
+	// Clips the plot functions to a rectangle (max exclusive)
+	void setClip(_In_ const Rect& rect) {
+		setClip(rect.minPoint.x, rect.minPoint.y, rect.maxPoint.x, rect.maxPoint.y);
+	}
+
+	// If the clip rectangle is the entire bitmap
+	bool isClipFull() const {
+		return clipRect.minPoint.x == 0 && clipRect.minPoint.y == 0 && clipRect.maxPoint.x == bitmapWidth && clipRect.maxPoint.y == bitmapHeight;
+	}
+
+	// If the bounds are inside of the clip rectangle without touching its edges, so that nothing of the command was cut off
+	bool isInsideClip(_In_ const Rect& bounds) const {
+		return bounds.minPoint.x > clipRect.minPoint.x && bounds.minPoint.y > clipRect.minPoint.y
+			&& bounds.maxPoint.x < clipRect.maxPoint.x && bounds.maxPoint.y < clipRect.maxPoint.y;
+	}
+
+	// Rectangle (max exclusive) clipped to the bitmap, empty if it's entirely outside of it
+	Rect clipToBitmap(_In_ int minX, _In_ int minY, _In_ int maxX, _In_ int maxY) const {
+		if (minX < 0) minX = 0;
+		if (minY < 0) minY = 0;
+		if (maxX > bitmapWidth) maxX = bitmapWidth;
+		if (maxY > bitmapHeight) maxY = bitmapHeight;
+		if (minX >= maxX || minY >= maxY) return Rect();
+		return Rect(vec2<int>(minX, minY), vec2<int>(maxX, maxY));
+	}
+
+	// Bounding box of the points grown by the margin on every side, clipped to the bitmap
+	Rect pointBounds(_In_ const vec2<int>* points, _In_ int count, _In_ int margin) const {
+		vec2<int> min = points[0];
+		vec2<int> max = points[0];
+		for (int i = 1; i < count; i++) {
+			if (points[i].x < min.x) min.x = points[i].x;
+			if (points[i].y < min.y) min.y = points[i].y;
+			if (points[i].x > max.x) max.x = points[i].x;
+			if (points[i].y > max.y) max.y = points[i].y;
+		}
+		// The margin is added in 64 bits, the points can be anywhere in the int range
+		auto toInt = [](long long value) { return (int)(value < INT_MIN ? INT_MIN : value > INT_MAX ? INT_MAX : value); };
+		return clipToBitmap(toInt((long long)min.x - margin), toInt((long long)min.y - margin),
+			toInt((long long)max.x + margin + 1), toInt((long long)max.y + margin + 1));
+	}
+
+	// Marks the bounding box of the points, grown by the margin on every side
+	void markDirtyPoints(_In_ const vec2<int>* points, _In_ int count, _In_ int margin) {
+		Rect bounds = intersectRect(pointBounds(points, count, margin), clipRect);
+		if (bounds.width > 0)
+			dirtyRegion.add(bounds);
+	}
+
+	// Sets a pixel without marking it as changed, the clip rectangle is empty without the memory
+	void plotPixel(_In_ int x, _In_ int y, _In_ UINT32 color) {
+		if (x >= clipMinX && y >= clipMinY && x < clipMaxX && y < clipMaxY)
+			((Pixel*)memory)[(size_t)y * bitmapWidth + x] = Format::fromRGB(color);
+	}
+
+	// Fills a horizontal span of pixels (both ends inclusive) without marking it as changed, clipped to the clip rectangle
+	void plotSpan(_In_ int y, _In_ int minX, _In_ int maxX, _In_ UINT32 color) {
+		if (y < clipMinY || y >= clipMaxY) return;
+		if (minX < clipMinX) minX = clipMinX;
+		if (maxX >= clipMaxX) maxX = clipMaxX - 1;
+		if (minX <= maxX)
+			Format::fillSpan((Pixel*)memory + (size_t)y * bitmapWidth + minX, maxX - minX + 1, Format::fromRGB(color));
+	}
+
+	// Fills the clip rectangle
+	void plotClear(_In_ UINT32 color) {
+		if (!memory) return;
+		// The entire bitmap is one continuous span
+		if (clipMinX == 0 && clipMinY == 0 && clipMaxX == bitmapWidth && clipMaxY == bitmapHeight) {
+			Format::fillFrame((Pixel*)memory, (size_t)bitmapWidth * bitmapHeight, Format::fromRGB(color));
+			return;
+		}
+		for (int y = clipMinY; y < clipMaxY; y++)
+			Format::fillSpan((Pixel*)memory + (size_t)y * bitmapWidth + clipMinX, clipMaxX - clipMinX, Format::fromRGB(color));
+	}
+
+	// Fills a rectangle (max exclusive) without marking it as changed
+	void plotRectangle(_In_ vec2<int> minPoint, _In_ vec2<int> maxPoint, _In_ UINT32 color) {
+		if (!memory) return;
+		int minY = minPoint.y > clipMinY ? minPoint.y : clipMinY;
+		int maxY = maxPoint.y < clipMaxY ? maxPoint.y : clipMaxY;
+		for (int y = minY; y < maxY; y++)
+			plotSpan(y, minPoint.x, maxPoint.x - 1, color);
+	}
+
+	// Fills the pixels from minX to maxX away from the origin on both sides, in both of the rows y away from the origin
+	void plotMirroredSpans(_In_ vec2<int> origin, _In_ int y, _In_ int minX, _In_ int maxX, _In_ UINT32 color) {
+		if (minX > maxX) return;
+		int rows[2] = { origin.y + y, origin.y - y };
+		for (int i = 0; i < (y != 0 ? 2 : 1); i++) {
+			// Both sides meet in the middle
+			if (minX <= 0)
+				plotSpan(rows[i], origin.x - maxX, origin.x + maxX, color);
+			else {
+				plotSpan(rows[i], origin.x - maxX, origin.x - minX, color);
+				plotSpan(rows[i], origin.x + minX, origin.x + maxX, color);
+			}
+		}
+	}
+
+	// Draws a filled circle without marking it as changed
+	void plotCircle(_In_ vec2<int> origin, _In_ int radius, _In_  UINT32 color) {
+		if (!memory) return;
+		// Check for the trivial case of a 1 pixel radius circle
+		if (radius <= 1) {
+			plotPixel(origin.x, origin.y, color);
+			return;
+		}
+
+		// Radius squared
+		long long rSq = (long long)radius * radius;
+		// Half width of the current row, rows get narrower going away from the origin so it only decreases
+		int x = radius;
+		for (int y = 0; y <= radius; y++) {
+			while (!CEQ(x, y, rSq))
+				x--;
+			plotMirroredSpans(origin, y, 0, x, color);
+		}
+	}
+
+	// Draws a 1 pixel wide outline of a filled circle without marking it as changed
+	void plotCircleOutline(_In_ vec2<int> origin, _In_ int radius, _In_ UINT32 color) {
+		long long rSq = (long long)radius * radius;
+		int x = radius;
+		// Half width of the row y of the filled circle, -1 outside of the circle
+		auto rowExtent = [&](int y) {
+			if (y > radius) return -1;
+			while (!CEQ(x, y, rSq))
+				x--;
+			return x;
+		};
+
+		int current = rowExtent(0);
+		int below = rowExtent(1);
+		// The circle is symmetric so the row above the origin is the same as the one below
+		int above = below;
+		for (int y = 0; y <= radius; y++) {
+			// Row goes inwards until the first pixel with both of its vertical neighbours inside of the circle
+			int inner = current;
+			if (above < inner) inner = above;
+			if (below < inner) inner = below;
+			plotMirroredSpans(origin, y, inner < 0 ? 0 : inner, current, color);
+
+			above = current;
+			current = below;
+			below = rowExtent(y + 2);
+		}
+	}
+
+	// Draws a ring (pixels closer than thickness to the outline) without marking it as changed
+	void plotRing(_In_ vec2<int> origin, _In_ int radius, _In_ int thickness, _In_ UINT32 color) {
+		if (!memory) return;
+		if (thickness <= 1) {
+			plotCircleOutline(origin, radius, color);
+			return;
+		}
+
+		// The outline itself is up to 2 pixels thick on the inside
+		int outerRadius = radius + thickness;
+		int innerRadius = radius - thickness - 1;
+		if (innerRadius <= 0) {
+			plotCircle(origin, outerRadius, color);
+			return;
+		}
+
+		long long outerSq = (long long)outerRadius * outerRadius;
+		// Pixels strictly inside of the inner circle are not drawn
+		long long innerSq = (long long)innerRadius * innerRadius - 1;
+		int outerX = outerRadius;
+		int innerX = innerRadius;
+		for (int y = 0; y <= outerRadius; y++) {
+			while (!CEQ(outerX, y, outerSq))
+				outerX--;
+			while (innerX >= 0 && !CEQ(innerX, y, innerSq))
+				innerX--;
+			plotMirroredSpans(origin, y, innerX + 1, outerX, color);
+		}
+	}
+
+	// Fills a vertical span of pixels (both ends inclusive) without marking it as changed, clipped to the clip rectangle
+	void plotColumn(_In_ int x, _In_ int minY, _In_ int maxY, _In_ UINT32 color) {
+		if (x < clipMinX || x >= clipMaxX) return;
+		if (minY < clipMinY) minY = clipMinY;
+		if (maxY >= clipMaxY) maxY = clipMaxY - 1;
+		Pixel value = Format::fromRGB(color);
+		Pixel* pixel = (Pixel*)memory + (size_t)minY * bitmapWidth + x;
+		for (int y = minY; y <= maxY; y++, pixel += bitmapWidth)
+			*pixel = value;
+	}
+
+	// Clips the steps of a thin line (from first to last) to the clip range (max exclusive) of both axes
+	// Minor offset of the step k is (2 * minorLength * k + bias) / (2 * majorLength), it only grows with k,
+	// so the first and the last step inside of the minor range are solved for directly
+	static void clipLineSteps(_In_ int majorStart, _In_ long long majorLength, _In_ int majorMin, _In_ int majorMax,
+		_In_ int minorStart, _In_ long long minorLength, _In_ int minorStep, _In_ int minorMin, _In_ int minorMax, _In_ long long bias,
+		_Inout_ long long& first, _Inout_ long long& last) {
+		// Clip the steps along the major axis
+		first = majorStart < majorMin ? (long long)majorMin - majorStart : 0;
+		last = majorStart + majorLength >= majorMax ? (long long)majorMax - 1 - majorStart : majorLength;
+		// Minor offsets inside of the minor range
+		long long lowOffset = minorStep > 0 ? (long long)minorMin - minorStart : (long long)minorStart - minorMax + 1;
+		long long highOffset = minorStep > 0 ? (long long)minorMax - 1 - minorStart : (long long)minorStart - minorMin;
+		if (highOffset < 0 || lowOffset > minorLength) {
+			last = first - 1;
+			return;
+		}
+		// First step with the offset at least lowOffset
+		if (lowOffset > 0) {
+			long long step = (2 * majorLength * lowOffset - bias + 2 * minorLength - 1) / (2 * minorLength);
+			if (step > first) first = step;
+		}
+		// Last step with the offset at most highOffset
+		if (highOffset < minorLength) {
+			long long step = (2 * majorLength * (highOffset + 1) - bias - 1) / (2 * minorLength);
+			if (step < last) last = step;
+		}
+	}
+
+	// Biggest coordinate of the line ends the steps are exact for, 2 * length * length of the longer lines overflows 64 bits
+	static const int lineMaxCoordinate = (1 << 30) - 1;
+
+	// Moves the line ends further than lineMaxCoordinate from the origin along the line into that range, returns false if the line
+	// doesn't get there. The moved ends are rounded, so the pixels can be a step off from the whole line
+	static bool limitLineEnds(_Inout_ vec2<int>& p1, _Inout_ vec2<int>& p2) {
+		const double limit = lineMaxCoordinate;
+		double dx = (double)p2.x - p1.x;
+		double dy = (double)p2.y - p1.y;
+		// Part of the line inside of the range, between the parameters 0 (p1) and 1 (p2)
+		double minT = 0.0, maxT = 1.0;
+		const double directions[4] = { -dx, dx, -dy, dy };
+		const double distances[4] = { limit + p1.x, limit - p1.x, limit + p1.y, limit - p1.y };
+		for (int i = 0; i < 4; i++) {
+			if (directions[i] == 0.0) {
+				if (distances[i] < 0.0) return false;
+				continue;
+			}
+			double t = distances[i] / directions[i];
+			if (directions[i] < 0.0)
+				minT = t > minT ? t : minT;
+			else
+				maxT = t < maxT ? t : maxT;
+		}
+		if (minT > maxT) return false;
+		vec2<int> start = vec2<int>((int)floor(p1.x + dx * minT + 0.5), (int)floor(p1.y + dy * minT + 0.5));
+		p2 = vec2<int>((int)floor(p1.x + dx * maxT + 0.5), (int)floor(p1.y + dy * maxT + 0.5));
+		p1 = start;
+		return true;
+	}
+
+	// If an end of the line is further than lineMaxCoordinate from the origin
+	static bool isLineOutOfRange(_In_ vec2<int> p1, _In_ vec2<int> p2) {
+		return p1.x < -lineMaxCoordinate || p1.x > lineMaxCoordinate || p1.y < -lineMaxCoordinate || p1.y > lineMaxCoordinate
+			|| p2.x < -lineMaxCoordinate || p2.x > lineMaxCoordinate || p2.y < -lineMaxCoordinate || p2.y > lineMaxCoordinate;
+	}
+
+	// Draws a 1 pixel wide line without marking it as changed
+	// Gives the same pixels as the Bresenham's algorithm, but the line is clipped to the clip rectangle once
+	void plotThinLine(_In_ vec2<int> p1, _In_ vec2<int> p2, _In_ UINT32 color) {
+		if (isLineOutOfRange(p1, p2) && !limitLineEnds(p1, p2)) return;
+		long long dx = (long long)p2.x - p1.x;
+		long long dy = (long long)p2.y - p1.y;
+
+		// Horizontal and vertical lines are just spans
+		if (dy == 0) {
+			plotSpan(p1.y, p1.x < p2.x ? p1.x : p2.x, p1.x < p2.x ? p2.x : p1.x, color);
+			return;
+		}
+		if (dx == 0) {
+			plotColumn(p1.x, p1.y < p2.y ? p1.y : p2.y, p1.y < p2.y ? p2.y : p1.y, color);
+			return;
+		}
+
+		// The line steps by 1 pixel along the major axis and by 0 or 1 along the minor one
+		bool xMajor = llabs(dx) >= llabs(dy);
+		// Line is drawn from the end with the lower major coordinate
+		vec2<int> start = (xMajor ? dx : dy) >= 0 ? p1 : p2;
+		int majorStart = xMajor ? start.x : start.y;
+		int minorStart = xMajor ? start.y : start.x;
+		int minorStep = (dx > 0) == (dy > 0) ? 1 : -1;
+		long long majorLength = xMajor ? llabs(dx) : llabs(dy);
+		long long minorLength = xMajor ? llabs(dy) : llabs(dx);
+		// Minor offset of the step k is (2 * minorLength * k + bias) / (2 * majorLength),
+		// x major lines round the ties up and y major lines round them down
+		long long bias = xMajor ? majorLength : majorLength - 1;
+		auto minorAt = [&](long long step) {
+			return minorStart + minorStep * (int)((2 * minorLength * step + bias) / (2 * majorLength));
+		};
+
+		long long first = 0;
+		long long last = majorLength;
+		// Lines with both ends inside of the clip rectangle don't need clipping
+		if (p1.x < clipMinX || p1.y < clipMinY || p1.x >= clipMaxX || p1.y >= clipMaxY
+			|| p2.x < clipMinX || p2.y < clipMinY || p2.x >= clipMaxX || p2.y >= clipMaxY) {
+			if (xMajor)
+				clipLineSteps(majorStart, majorLength, clipMinX, clipMaxX, minorStart, minorLength, minorStep, clipMinY, clipMaxY, bias, first, last);
+			else
+				clipLineSteps(majorStart, majorLength, clipMinY, clipMaxY, minorStart, minorLength, minorStep, clipMinX, clipMaxX, bias, first, last);
+		}
+		if (first > last) return;
+
+		// Step thru the pixels without any more bounds checks, lines starting at their first pixel (like the short segments
+		// of the polylines) start with the bias and skip the divisions
+		long long remainder = first == 0 ? bias : (2 * minorLength * first + bias) % (2 * majorLength);
+		int minor = first == 0 ? minorStart : minorAt(first);
+		int major = majorStart + (int)first;
+		ptrdiff_t index = xMajor ? (ptrdiff_t)minor * bitmapWidth + major : (ptrdiff_t)major * bitmapWidth + minor;
+		ptrdiff_t majorStride = xMajor ? 1 : bitmapWidth;
+		ptrdiff_t minorStride = xMajor ? (ptrdiff_t)minorStep * bitmapWidth : minorStep;
+		Pixel* pixels = (Pixel*)memory;
+		Pixel value = Format::fromRGB(color);
+		// The minor steps come in no pattern a branch predictor could follow, so they're masked in (all bits set when the remainder overflows)
+		long long minorIncrement = 2 * minorLength;
+		long long majorIncrement = 2 * majorLength;
+		for (long long step = first; step <= last; step++) {
+			pixels[index] = value;
+			remainder += minorIncrement;
+			long long overflow = (majorIncrement - 1 - remainder) >> 63;
+			remainder -= majorIncrement & overflow;
+			index += majorStride + (minorStride & overflow);
+		}
+	}
+
+	// Draws a thick line as the filled circles (pixels up to the radius away) around every pixel of the thin line, without marking it as changed
+	// The thin line pixels of a row are a run, so every row of the circles is a single span and no pixel is written twice
+	void plotCapsule(_In_ vec2<int> p1, _In_ vec2<int> p2, _In_ int radius, _In_ UINT32 color) {
+		if (isLineOutOfRange(p1, p2) && !limitLineEnds(p1, p2)) return;
+		long long dx = (long long)p2.x - p1.x;
+		long long dy = (long long)p2.y - p1.y;
+		// Same steps as plotThinLine
+		bool xMajor = llabs(dx) >= llabs(dy);
+		vec2<int> start = (xMajor ? dx : dy) >= 0 ? p1 : p2;
+		int majorStart = xMajor ? start.x : start.y;
+		int minorStart = xMajor ? start.y : start.x;
+		int minorStep = (dx > 0) == (dy > 0) ? 1 : -1;
+		long long majorLength = xMajor ? llabs(dx) : llabs(dy);
+		long long minorLength = xMajor ? llabs(dy) : llabs(dx);
+		long long bias = xMajor ? majorLength : majorLength - 1;
+		// Minor offset of a step, a line of a single point has no steps to divide by
+		auto minorOffset = [&](long long step) { return majorLength > 0 ? (2 * minorLength * step + bias) / (2 * majorLength) : 0; };
+
+		// Only the centers at most radius away from the clip rectangle reach it
+		long long first, last;
+		if (xMajor)
+			clipLineSteps(majorStart, majorLength, clipMinX - radius, clipMaxX + radius, minorStart, minorLength, minorStep,
+				clipMinY - radius, clipMaxY + radius, bias, first, last);
+		else
+			clipLineSteps(majorStart, majorLength, clipMinY - radius, clipMaxY + radius, minorStart, minorLength, minorStep,
+				clipMinX - radius, clipMaxX + radius, bias, first, last);
+		if (first > last) return;
+
+		// Leftmost and rightmost center of every row the centers are in
+		long long firstOffset = minorOffset(first);
+		long long lastOffset = minorOffset(last);
+		int centerMinY = xMajor ? minorStart + minorStep * (int)(minorStep > 0 ? firstOffset : lastOffset) : majorStart + (int)first;
+		int centerMaxY = xMajor ? minorStart + minorStep * (int)(minorStep > 0 ? lastOffset : firstOffset) : majorStart + (int)last;
+		int rows = centerMaxY - centerMinY + 1;
+		capsuleRuns.resize((size_t)rows * 2);
+		int* runLefts = capsuleRuns.data();
+		int* runRights = capsuleRuns.data() + rows;
+		if (xMajor) {
+			// Every minor offset is a run of steps, it starts at the first step reaching the offset
+			long long runStart = first;
+			for (long long offset = firstOffset; offset <= lastOffset; offset++) {
+				long long runEnd = offset < lastOffset ? (2 * majorLength * (offset + 1) - bias + 2 * minorLength - 1) / (2 * minorLength) - 1 : last;
+				int row = minorStart + minorStep * (int)offset - centerMinY;
+				runLefts[row] = majorStart + (int)runStart;
+				runRights[row] = majorStart + (int)runEnd;
+				runStart = runEnd + 1;
+			}
+		}
+		else {
+			long long remainder = (2 * minorLength * first + bias) % (2 * majorLength);
+			int x = minorStart + minorStep * (int)firstOffset;
+			for (int row = 0; row < rows; row++) {
+				runLefts[row] = runRights[row] = x;
+				remainder += 2 * minorLength;
+				if (remainder >= 2 * majorLength) {
+					remainder -= 2 * majorLength;
+					x += minorStep;
+				}
+			}
+		}
+
+		// Half widths of the circle rows -radius to radius away
+		capExtents.resize((size_t)radius * 2 + 1);
+		int* extents = capExtents.data() + radius;
+		circleRowExtents(extents, radius);
+		for (int i = 1; i <= radius; i++)
+			extents[-i] = extents[i];
+
+		int minY = centerMinY - radius > clipMinY ? centerMinY - radius : clipMinY;
+		int maxY = centerMaxY + radius < clipMaxY - 1 ? centerMaxY + radius : clipMaxY - 1;
+		for (int y = minY; y <= maxY; y++) {
+			// The runs only move one way from row to row, so of the rows on the side an end of the span trails the closest one
+			// reaches the furthest, each end is found among that row and the rows on the side it leads
+			int fromRow = (y - radius > centerMinY ? y - radius : centerMinY) - centerMinY;
+			int toRow = (y + radius < centerMaxY ? y + radius : centerMaxY) - centerMinY;
+			int middleRow = (y < centerMinY ? centerMinY : y > centerMaxY ? centerMaxY : y) - centerMinY;
+			// Vertical lines have the same run in every row, the closest one reaches the furthest on both sides
+			if (dx == 0)
+				fromRow = toRow = middleRow;
+			int left = INT_MAX;
+			int right = INT_MIN;
+			const int* rowExtents = extents + centerMinY - y;
+			if (minorStep > 0) {
+				for (int row = fromRow; row <= middleRow; row++)
+					left = runLefts[row] - rowExtents[row] < left ? runLefts[row] - rowExtents[row] : left;
+				for (int row = middleRow; row <= toRow; row++)
+					right = runRights[row] + rowExtents[row] > right ? runRights[row] + rowExtents[row] : right;
+			}
+			else {
+				for (int row = middleRow; row <= toRow; row++)
+					left = runLefts[row] - rowExtents[row] < left ? runLefts[row] - rowExtents[row] : left;
+				for (int row = fromRow; row <= middleRow; row++)
+					right = runRights[row] + rowExtents[row] > right ? runRights[row] + rowExtents[row] : right;
+			}
+			plotSpan(y, left, right, color);
+		}
+	}
+
+	// Draws a line without marking it as changed
+	void plotLine(_In_ vec2<int> p1, _In_ vec2<int> p2, _In_ UINT32 color, _In_opt_ unsigned short thickness = 1) {
+		if (!memory) return;
+		if (thickness <= 1)
+			plotThinLine(p1, p2, color);
+		else
+			plotCapsule(p1, p2, thickness, color);
+	}
+
+	// Coverage (0 - 255) of a pixel distance away from an edge, positive inside, the edge goes thru the middle of the pixel at 0
+	static unsigned char edgeCoverage(_In_ double distance) {
+		if (distance >= 0.5) return 255;
+		if (distance <= -0.5) return 0;
+		return (unsigned char)((distance + 0.5) * 255.0 + 0.5);
+	}
+
+	// Draws an anti-aliased 1 pixel wide line with the Wu's algorithm without marking it as changed
+	// Every step along the major axis splits the coverage between the 2 pixels closest to the line
+	void plotWuLine(_In_ vec2<int> p1, _In_ vec2<int> p2, _In_ UINT32 color) {
+		// The deltas are 64-bit, the ends can be anywhere in the int range
+		long long dx = (long long)p2.x - p1.x;
+		long long dy = (long long)p2.y - p1.y;
+		bool xMajor = llabs(dx) >= llabs(dy);
+		// Walk along the major axis from the lower end
+		if ((xMajor && dx < 0) || (!xMajor && dy < 0)) {
+			vec2<int> swap = p1;
+			p1 = p2;
+			p2 = swap;
+			dx = -dx;
+			dy = -dy;
+		}
+		int majorStart = xMajor ? p1.x : p1.y;
+		int majorEnd = xMajor ? p2.x : p2.y;
+		int minorStart = xMajor ? p1.y : p1.x;
+		long long majorLength = xMajor ? dx : dy;
+		double slope = majorLength != 0 ? (double)(xMajor ? dy : dx) / majorLength : 0.0;
+		int majorMin = xMajor ? clipMinX : clipMinY;
+		int majorMax = xMajor ? clipMaxX : clipMaxY;
+		int minorMin = xMajor ? clipMinY : clipMinX;
+		int minorMax = xMajor ? clipMaxY : clipMaxX;
+
+		// Horizontal and vertical lines are just spans
+		if (slope == 0.0) {
+			if (xMajor)
+				plotSpan(minorStart, majorStart, majorEnd, color);
+			else
+				plotColumn(minorStart, majorStart, majorEnd, color);
+			return;
+		}
+
+		// Clip the steps to the major range, and to the steps with any of their 2 pixels in the minor range (plus a step for the rounding)
+		int first = majorStart > majorMin ? majorStart : majorMin;
+		int last = majorEnd < majorMax - 1 ? majorEnd : majorMax - 1;
+		double enter = majorStart + ((double)minorMin - 1 - minorStart) / slope;
+		double leave = majorStart + ((double)minorMax - minorStart) / slope;
+		if (enter > leave) {
+			double swap = enter;
+			enter = leave;
+			leave = swap;
+		}
+		if (floor(enter) - 1 > first) first = floor(enter) - 1 > last ? last + 1 : (int)floor(enter) - 1;
+		if (ceil(leave) + 1 < last) last = ceil(leave) + 1 < first ? first - 1 : (int)ceil(leave) + 1;
+
+		// Minor position of the step k is minorStart + k * gradient in the 16.16 fixed point, the top 8 bits of the fraction are the coverage
+		// The rounding of the gradient would add up along long lines, so every 256 steps (of the absolute major coordinates,
+		// not of the clipping) the position starts again from the exact one, the lines shorter than that only use the gradient
+		long long minorLength = xMajor ? dy : dx;
+		long long gradient = (long long)floor(slope * 65536.0 + 0.5);
+		auto syncPosition = [&](int major) {
+			long long sync = (major & ~255) > majorStart ? (major & ~255) : majorStart;
+			long long exact = (long long)floor((double)(sync - majorStart) * (double)minorLength * 65536.0 / (double)majorLength + 0.5);
+			return (long long)minorStart * 65536 + exact + gradient * (major - sync);
+		};
+		long long position = syncPosition(first);
+
+		Pixel* pixels = (Pixel*)memory;
+		Pixel value = Format::fromRGB(color);
+		ptrdiff_t majorStride = xMajor ? 1 : bitmapWidth;
+		ptrdiff_t minorStride = xMajor ? bitmapWidth : 1;
+		unsigned int minorRange = (unsigned int)(minorMax - minorMin);
+		unsigned int pairRange = minorRange > 0 ? minorRange - 1 : 0;
+		for (int major = first; major <= last; major++, position += gradient) {
+			if ((major & 255) == 0)
+				position = syncPosition(major);
+			int minor = (int)(position >> 16);
+			unsigned int fraction = (unsigned int)(position >> 8) & 0xFF;
+			Pixel* pixel = pixels + major * majorStride + minor * minorStride;
+			// Steps with both pixels in the minor range blend them together, checked with a single unsigned comparison
+			if ((unsigned int)(minor - minorMin) < pairRange) {
+				Format::blendPair(pixel, pixel + minorStride, 255 - fraction, fraction, color);
+				continue;
+			}
+			if ((unsigned int)(minor - minorMin) < minorRange)
+				*pixel = fraction == 0 ? value : Format::blend(*pixel, color, 255 - fraction);
+			if (fraction != 0 && (unsigned int)(minor + 1 - minorMin) < minorRange)
+				pixel[minorStride] = Format::blend(pixel[minorStride], color, fraction);
+		}
+	}
+
+	// Fills the table with the coverage of a round edge radius + 0.5 away from a point, for the pixels radius^2 + i away squared
+	// (i up to 2 * radius + 1, the pixels closer are covered entirely and the further ones not at all)
+	static void roundEdgeCoverage(_Out_ unsigned char* table, _In_ int radius) {
+		for (int i = 0; i <= 2 * radius + 1; i++)
+			table[i] = edgeCoverage(radius + 0.5 - sqrt((double)radius * radius + i));
+	}
+
+	// Fills the table with the half widths of the rows 0 to radius away from the center of a filled circle (the pixels at most radius away)
+	static void circleRowExtents(_Out_ int* extents, _In_ int radius) {
+		long long radiusSq = (long long)radius * radius;
+		int extent = radius;
+		for (int dy = 0; dy <= radius; dy++) {
+			while (extent * (long long)extent + (long long)dy * dy > radiusSq) extent--;
+			extents[dy] = extent;
+		}
+	}
+
+	// Draws an anti-aliased thick line as a capsule with the edge radius + 0.5 away from the segment, without marking it as changed
+	// The pixels closer than radius + 1 have some coverage and the ones up to radius all of it. The row ranges of both are stepped
+	// from row to row, the band along the segment moves by a constant and the round caps come from tables made once per line
+	// Pixels entirely inside are filled as spans, only the ones on the edge compute their coverage
+	void plotAntialiasedCapsule(_In_ vec2<int> p1, _In_ vec2<int> p2, _In_ int radius, _In_ UINT32 color) {
+		if (isLineOutOfRange(p1, p2) && !limitLineEnds(p1, p2)) return;
+		double edge = radius + 0.5;
+		double dx = (double)p2.x - p1.x;
+		double dy = (double)p2.y - p1.y;
+		double lengthSq = dx * dx + dy * dy;
+		double length = sqrt(lengthSq);
+		double inverseLength = lengthSq > 0 ? 1.0 / length : 0.0;
+		int minY = (p1.y < p2.y ? p1.y : p2.y) - radius - 1;
+		int maxY = (p1.y < p2.y ? p2.y : p1.y) + radius + 1;
+		if (minY < clipMinY) minY = clipMinY;
+		if (maxY >= clipMaxY) maxY = clipMaxY - 1;
+		if (minY > maxY) return;
+
+		// Coverage of the caps by the squared distance from the end, and the row half widths of the covered and entirely covered pixels
+		int capSize = 2 * radius + 2;
+		if (coverageRow.size() < (size_t)capSize)
+			coverageRow.resize(capSize);
+		roundEdgeCoverage(coverageRow.data(), radius);
+		capExtents.resize((size_t)(radius + 2) * 2);
+		int* outerExtents = capExtents.data();
+		int* innerExtents = outerExtents + radius + 2;
+		circleRowExtents(outerExtents, radius + 1);
+		circleRowExtents(innerExtents, radius);
+		innerExtents[radius + 1] = -1;
+		long long radiusSq = (long long)radius * radius;
+
+		// The band is the part of the strip along the line (|offset x * dy - offset y * dx| up to the reach * length) projecting onto
+		// the segment (offset x * dx + offset y * dy from 0 to length^2), offsets are relative to p1 and their bounds are linear in y
+		// The bounds of a row are computed from its offset and not added up row by row, so that they don't depend on the first row
+		// of the clip rectangle (the tiles draw the same pixels as the whole target) and the far ends don't add up their rounding
+		double offsetY = minY - p1.y;
+		bool band = lengthSq > 0;
+		double slabStep = dx != 0 ? -dy / dx : 0.0;
+		double slabLength = dx != 0 ? lengthSq / dx : 0.0;
+		double stripStep = dy != 0 ? dx / dy : 0.0;
+		double outerWidth = dy != 0 ? (edge + 0.5) * length / fabs(dy) : 0.0;
+		double innerWidth = dy != 0 ? (edge - 0.5) * length / fabs(dy) : 0.0;
+		float slope = (float)(dy * inverseLength * 255.0);
+		float scale = (float)((edge + 0.5) * 255.0);
+		// Columns of the band and the strips, the ones outside of the clip rectangle only matter as being outside of it
+		// and are kept a column away from it, the steep lines put them far beyond the int range
+		auto toColumn = [&](double column) { return column < clipMinX - 1 ? clipMinX - 1 : column > clipMaxX ? clipMaxX : (int)column; };
+
+		for (int y = minY; y <= maxY; y++, offsetY++) {
+			double slab1 = offsetY * slabStep;
+			double slab2 = slab1 + slabLength;
+			double strip = offsetY * stripStep;
+			int outerLeft = INT_MAX, outerRight = INT_MIN;
+			int innerLeft = INT_MAX, innerRight = INT_MIN;
+			// Round caps at both ends
+			vec2<int> ends[2] = { p1, p2 };
+			for (const vec2<int>& end : ends) {
+				int distY = abs(y - end.y);
+				if (distY > radius + 1) continue;
+				if (end.x - outerExtents[distY] < outerLeft) outerLeft = end.x - outerExtents[distY];
+				if (end.x + outerExtents[distY] > outerRight) outerRight = end.x + outerExtents[distY];
+				if (innerExtents[distY] < 0) continue;
+				if (end.x - innerExtents[distY] < innerLeft) innerLeft = end.x - innerExtents[distY];
+				if (end.x + innerExtents[distY] > innerRight) innerRight = end.x + innerExtents[distY];
+			}
+
+			// Pixels projecting onto the segment are |offset x * dy - offset y * dx| / length away from it, linear in x
+			double low = -HUGE_VAL, high = HUGE_VAL;
+			bool inBand = band;
+			if (dx != 0) {
+				low = slab1 < slab2 ? slab1 : slab2;
+				high = slab1 < slab2 ? slab2 : slab1;
+			}
+			else
+				inBand = inBand && offsetY * dy >= 0 && offsetY * dy <= lengthSq;
+			int bandLeft = inBand ? toColumn(p1.x + ceil(low)) : INT_MAX;
+			int bandRight = inBand ? toColumn(p1.x + floor(high)) : INT_MIN;
+			if (bandLeft <= bandRight) {
+				// Horizontal strips are the rows up to the reach away
+				auto addStrip = [&](double reach, double width, int& left, int& right) {
+					double stripLow = low, stripHigh = high;
+					if (dy != 0) {
+						if (strip - width > stripLow) stripLow = strip - width;
+						if (strip + width < stripHigh) stripHigh = strip + width;
+					}
+					else if (fabs(offsetY) > reach)
+						return;
+					if (stripLow > stripHigh) return;
+					int stripLeft = toColumn(p1.x + ceil(stripLow));
+					int stripRight = toColumn(p1.x + floor(stripHigh));
+					if (stripLeft < left) left = stripLeft;
+					if (stripRight > right) right = stripRight;
+				};
+				addStrip(edge + 0.5, outerWidth, outerLeft, outerRight);
+				addStrip(edge - 0.5, innerWidth, innerLeft, innerRight);
+			}
+			if (outerLeft > outerRight || outerRight < clipMinX || outerLeft >= clipMaxX) continue;
+
+			// The edges of the row a few below are blended next
+			if (y + prefetchRows < clipMaxY) {
+				Pixel* ahead = (Pixel*)memory + (size_t)(y + prefetchRows) * bitmapWidth;
+				prefetchPixel(ahead + (outerLeft > clipMinX ? outerLeft : clipMinX));
+				prefetchPixel(ahead + (outerRight < clipMaxX - 1 ? outerRight : clipMaxX - 1));
+			}
+			float offset = (float)(-offsetY * dx * inverseLength * 255.0);
+			// The caps are round, their coverage is looked up by the squared distance from the end
+			auto capCoverageAt = [&](int x) -> unsigned int {
+				vec2<int> end = x < bandLeft ? (dx > 0 ? p1 : p2) : (dx > 0 ? p2 : p1);
+				if (dx == 0) end = offsetY * dy < 0 ? p1 : p2;
+				long long distSq = (long long)(x - end.x) * (x - end.x) + (long long)(y - end.y) * (y - end.y) - radiusSq;
+				return distSq < 0 ? 255 : distSq >= capSize ? 0 : coverageRow[(size_t)distSq];
+			};
+			auto plotEdge = [&](int minX, int maxX) {
+				if (minX < clipMinX) minX = clipMinX;
+				if (maxX >= clipMaxX) maxX = clipMaxX - 1;
+				if (minX > maxX) return;
+				int count = maxX - minX + 1;
+				int linearMin = minX > bandLeft ? minX : bandLeft;
+				int linearMax = maxX < bandRight ? maxX : bandRight;
+				Pixel* pixel = (Pixel*)memory + (size_t)y * bitmapWidth;
+				// The edges of the steep rows are a pixel or 2 wide, their pixels are blended as they're computed
+				if (count <= shortEdgeLength) {
+					for (int x = minX; x <= maxX; x++) {
+						unsigned int value = x >= linearMin && x <= linearMax ? linearCoverageAt(x - p1.x, slope, offset, scale) : capCoverageAt(x);
+						if (value == 255)
+							pixel[x] = Format::fromRGB(color);
+						else if (value != 0)
+							pixel[x] = Format::blend(pixel[x], color, value);
+					}
+					return;
+				}
+				if (coverageRow.size() < (size_t)(capSize + count))
+					coverageRow.resize(capSize + count);
+				unsigned char* coverage = coverageRow.data() + capSize;
+				if (linearMin <= linearMax)
+					linearCoverage(coverage + (linearMin - minX), linearMin - p1.x, linearMax - linearMin + 1, slope, offset, scale);
+				for (int x = minX; x <= maxX; x++) {
+					if (x < linearMin || x > linearMax)
+						coverage[x - minX] = (unsigned char)capCoverageAt(x);
+				}
+				blendRowSpan(y, minX, count, coverage, color);
+			};
+			if (innerLeft <= innerRight) {
+				plotEdge(outerLeft, innerLeft - 1);
+				plotSpan(y, innerLeft, innerRight, color);
+				plotEdge(innerRight + 1, outerRight);
+			}
+			else
+				plotEdge(outerLeft, outerRight);
+		}
+	}
+
+	// Draws an anti-aliased line without marking it as changed
+	void plotAntialiasedLine(_In_ vec2<int> p1, _In_ vec2<int> p2, _In_ UINT32 color, _In_opt_ unsigned short thickness = 1) {
+		if (!memory) return;
+		if (thickness <= 1)
+			plotWuLine(p1, p2, color);
+		else
+			plotAntialiasedCapsule(p1, p2, thickness, color);
+	}
+
+	// Blends count pixels of the row y starting at x with their coverage, clipped to the clip rectangle
+	void blendRowSpan(_In_ int y, _In_ int x, _In_ int count, _In_ const unsigned char* coverage, _In_ UINT32 color) {
+		if (y < clipMinY || y >= clipMaxY) return;
+		if (x < clipMinX) {
+			coverage += clipMinX - x;
+			count -= clipMinX - x;
+			x = clipMinX;
+		}
+		if (x + count > clipMaxX) count = clipMaxX - x;
+		if (count > 0)
+			Format::blendSpan((Pixel*)memory + (size_t)y * bitmapWidth + x, coverage, count, color);
+	}
+
+	// Draws the pixels from innerRadius to outerRadius away from the origin (both inclusive, innerRadius <= 0 fills the circle)
+	// with anti-aliased edges half a pixel further out, without marking them as changed
+	// Entirely covered spans are filled, only the pixels on the edges compute their coverage, once for the 4 mirrored quarters
+	void plotAntialiasedRing(_In_ vec2<int> origin, _In_ int innerRadius, _In_ int outerRadius, _In_ UINT32 color) {
+		if (!memory || outerRadius < 0) return;
+		// Pixels closer than outerRadius + 1 have some coverage, up to outerRadius all of it
+		long long reachSq = (long long)(outerRadius + 1) * (outerRadius + 1);
+		long long outerSq = (long long)outerRadius * outerRadius;
+		// Pixels up to innerRadius - 1 away have no coverage, from innerRadius all of it
+		long long holeSq = innerRadius > 0 ? (long long)(innerRadius - 1) * (innerRadius - 1) : -1;
+		long long innerSq = innerRadius > 0 ? (long long)innerRadius * innerRadius : 0;
+		double innerEdge = innerRadius - 0.5;
+		double outerEdge = outerRadius + 0.5;
+		// |dx| extents of the row, they only shrink going away from the origin
+		int reach = outerRadius + 1;
+		int full = outerRadius;
+		int hole = innerRadius > 0 ? innerRadius : 0;
+		int fullMin = hole;
+
+		for (int dy = 0; dy <= outerRadius; dy++) {
+			long long dySq = (long long)dy * dy;
+			while (reach >= 0 && reach * (long long)reach + dySq >= reachSq) reach--;
+			while (full >= 0 && full * (long long)full + dySq > outerSq) full--;
+			while (hole > 0 && (hole - 1) * (long long)(hole - 1) + dySq > holeSq) hole--;
+			while (fullMin > 0 && (fullMin - 1) * (long long)(fullMin - 1) + dySq >= innerSq) fullMin--;
+			if (reach < hole) continue;
+			// Both of the mirrored rows have to be inside of the clip rectangle
+			bool above = origin.y - dy >= clipMinY && origin.y - dy < clipMaxY;
+			bool below = dy > 0 && origin.y + dy >= clipMinY && origin.y + dy < clipMaxY;
+			if (!above && !below) continue;
+
+			// The outer edges of both of the rows a few further out are blended next
+			for (int side = -1; side <= 1; side += 2) {
+				int aheadY = origin.y + side * (dy + prefetchRows);
+				if (aheadY < clipMinY || aheadY >= clipMaxY) continue;
+				Pixel* ahead = (Pixel*)memory + (size_t)aheadY * bitmapWidth;
+				int left = origin.x - reach;
+				int right = origin.x + reach;
+				prefetchPixel(ahead + (left < clipMinX ? clipMinX : left >= clipMaxX ? clipMaxX - 1 : left));
+				prefetchPixel(ahead + (right < clipMinX ? clipMinX : right >= clipMaxX ? clipMaxX - 1 : right));
+			}
+
+			// Pieces of |dx| (both inclusive), the entirely covered one is between the edges
+			int fullLow = fullMin > hole ? fullMin : hole;
+			int fullHigh = full < reach ? full : reach;
+			int pieces[2][2];
+			int pieceCount = 0;
+			if (fullLow <= fullHigh) {
+				if (hole < fullLow) {
+					pieces[pieceCount][0] = hole;
+					pieces[pieceCount++][1] = fullLow - 1;
+				}
+				if (fullHigh < reach) {
+					pieces[pieceCount][0] = fullHigh + 1;
+					pieces[pieceCount++][1] = reach;
+				}
+			}
+			else {
+				pieces[pieceCount][0] = hole;
+				pieces[pieceCount++][1] = reach;
+			}
+
+			for (int i = 0; i < pieceCount; i++) {
+				int first = pieces[i][0];
+				int count = pieces[i][1] - first + 1;
+				// The pieces around the middle rows are a pixel or 2 wide, their pixels are blended in all of the mirrored rows as they're computed
+				if (count <= shortEdgeLength) {
+					for (int distX = first; distX < first + count; distX++) {
+						double distance = sqrt((double)distX * distX + (double)dySq);
+						double inside = outerEdge - distance;
+						if (innerRadius > 0 && distance - innerEdge < inside) inside = distance - innerEdge;
+						unsigned int value = edgeCoverage(inside);
+						if (value == 0) continue;
+						int left = origin.x - distX;
+						int right = origin.x + distX;
+						for (int row = 0; row < 2; row++) {
+							if (!(row == 0 ? above : below)) continue;
+							Pixel* pixel = (Pixel*)memory + (size_t)(row == 0 ? origin.y - dy : origin.y + dy) * bitmapWidth;
+							if (left >= clipMinX && left < clipMaxX)
+								pixel[left] = value == 255 ? Format::fromRGB(color) : Format::blend(pixel[left], color, value);
+							if (distX != 0 && right >= clipMinX && right < clipMaxX)
+								pixel[right] = value == 255 ? Format::fromRGB(color) : Format::blend(pixel[right], color, value);
+						}
+					}
+					continue;
+				}
+				// Coverage of the right side, the left side is mirrored
+				if (coverageRow.size() < (size_t)count * 2)
+					coverageRow.resize((size_t)count * 2);
+				unsigned char* right = coverageRow.data();
+				unsigned char* left = right + count;
+				for (int k = 0; k < count; k++) {
+					double distance = sqrt((double)(first + k) * (first + k) + (double)dySq);
+					double inside = outerEdge - distance;
+					if (innerRadius > 0 && distance - innerEdge < inside) inside = distance - innerEdge;
+					right[k] = edgeCoverage(inside);
+					left[count - 1 - k] = right[k];
+				}
+				for (int row = 0; row < 2; row++) {
+					if (!(row == 0 ? above : below)) continue;
+					int y = row == 0 ? origin.y - dy : origin.y + dy;
+					// Pieces starting in the middle are drawn once
+					if (first == 0) {
+						blendRowSpan(y, origin.x - count + 1, count - 1, left, color);
+						blendRowSpan(y, origin.x, count, right, color);
+					}
+					else {
+						blendRowSpan(y, origin.x - first - count + 1, count, left, color);
+						blendRowSpan(y, origin.x + first, count, right, color);
+					}
+				}
+			}
+			if (fullLow <= fullHigh) {
+				if (above) plotMirroredRow(origin, origin.y - dy, fullLow, fullHigh, color);
+				if (below) plotMirroredRow(origin, origin.y + dy, fullLow, fullHigh, color);
+			}
+		}
+	}
+
+	// Fills the pixels from minX to maxX away from the origin on both sides of the row y
+	void plotMirroredRow(_In_ vec2<int> origin, _In_ int y, _In_ int minX, _In_ int maxX, _In_ UINT32 color) {
+		if (minX == 0)
+			plotSpan(y, origin.x - maxX, origin.x + maxX, color);
+		else {
+			plotSpan(y, origin.x - maxX, origin.x - minX, color);
+			plotSpan(y, origin.x + minX, origin.x + maxX, color);
+		}
+	}
+
+	// Draws an anti-aliased 1 pixel wide outline (thickness up to 1) or a ring as wide as the plotRing one, without marking it as changed
+	void plotAntialiasedEmptyCircle(_In_ vec2<int> origin, _In_ int radius, _In_ int thickness, _In_ UINT32 color) {
+		int halfWidth = thickness > 1 ? thickness : 0;
+		plotAntialiasedRing(origin, radius - halfWidth, radius + halfWidth, color);
+	}
+
+	// Draws connected segments without marking them as changed
+	// Like lines, thickness up to 1 is a thin polyline and a bigger one is the radius of the pen
+	// Only the segments from firstSegment to lastSegment are drawn
+	void plotPolyline(_In_ const vec2<int>* points, _In_ int count, _In_ UINT32 color, _In_ unsigned short thickness,
+		_In_opt_ int firstSegment = 0, _In_opt_ int lastSegment = INT_MAX) {
+		if (!memory) return;
+		if (count == 1) {
+			if (thickness <= 1)
+				plotPixel(points[0].x, points[0].y, color);
+			else
+				plotCircle(points[0], thickness, color);
+			return;
+		}
+		for (int i = firstSegment; i + 1 < count && i <= lastSegment; i++) {
+			// Rounding can collapse neighbouring points into one pixel
+			if (i > 0 && points[i].x == points[i + 1].x && points[i].y == points[i + 1].y)
+				continue;
+			// Skip the segments entirely outside of the clip rectangle
+			int minX = points[i].x < points[i + 1].x ? points[i].x : points[i + 1].x;
+			int minY = points[i].y < points[i + 1].y ? points[i].y : points[i + 1].y;
+			int maxX = points[i].x < points[i + 1].x ? points[i + 1].x : points[i].x;
+			int maxY = points[i].y < points[i + 1].y ? points[i + 1].y : points[i].y;
+			if (maxX + thickness < clipMinX || maxY + thickness < clipMinY || minX - thickness >= clipMaxX || minY - thickness >= clipMaxY)
+				continue;
+			if (thickness <= 1)
+				plotThinLine(points[i], points[i + 1], color);
+			else
+				plotCapsule(points[i], points[i + 1], thickness, color);
+		}
+	}
+
+	// Blends a glyph coverage bitmap with its top left corner at the specified coordinates, clipped to the clip rectangle
+	void blitGlyph(_In_ const GlyphAtlas& atlas, _In_ const Glyph& glyph, _In_ int x, _In_ int y, _In_ UINT32 color) {
+		// Clip the glyph once instead of checking every pixel
+		int minX = x < clipMinX ? clipMinX - x : 0;
+		int minY = y < clipMinY ? clipMinY - y : 0;
+		int maxX = x + glyph.width > clipMaxX ? clipMaxX - x : glyph.width;
+		int maxY = y + glyph.height > clipMaxY ? clipMaxY - y : glyph.height;
+		if (minX >= maxX || minY >= maxY) return;
+
+		for (int row = minY; row < maxY; row++) {
+			const unsigned char* coverage = &atlas.coverage[glyph.offset + (size_t)row * glyph.width];
+			Pixel* pixel = (Pixel*)memory + (size_t)(y + row) * bitmapWidth + x;
+			Format::blendSpan(pixel + minX, coverage + minX, maxX - minX, color);
+		}
+	}
+
+	// Fills a triangle with fixed point (subpixelBits) vertices without marking it as changed
+	void plotTriangle(_In_ vec2<int> v1, _In_ vec2<int> v2, _In_ vec2<int> v3, _In_ UINT32 color) {
+		if (!memory) return;
+		rasterizeTriangle<Format>((Pixel*)memory, bitmapWidth, clipMinX, clipMinY, clipMaxX, clipMaxY, v1, v2, v3, Format::fromRGB(color));
+	}
+
+	// Draws a quadratic (degree 2) or cubic (degree 3) Bezier curve without marking it as changed
+	void plotBezierCurve(_In_ const vec2<int>* controlPoints, _In_ int degree, _In_ UINT32 color, _In_ unsigned short thickness) {
+		float x[4], y[4];
+		for (int i = 0; i <= degree; i++) {
+			x[i] = (float)controlPoints[i].x;
+			y[i] = (float)controlPoints[i].y;
+		}
+		vec2<int> points[bezierMaxSegments + 1];
+		int segments = bezierSegmentCount(x, y, degree);
+		flattenBezier(x, y, degree, segments, points);
+		plotPolyline(points, segments + 1, color, thickness);
+	}
+
+	// Bounds of a text (max exclusive) clipped to the bitmap, rasterizes the glyphs used for the first time
+	Rect textBounds(_In_ int x, _In_ int y, _In_ const wchar_t* text, _In_ int size) const {
+		GlyphAtlas& atlas = glyphCache().getAtlas(size);
+		int minX = x, maxX = x;
+		int minY = y, maxY = y;
+		int penX = x;
+		for (const wchar_t* character = text; *character; character++) {
+			const Glyph& glyph = atlas.getGlyph(*character);
+			if (glyph.width > 0) {
+				int glyphX = penX + glyph.left;
+				int glyphY = y + glyph.top;
+				if (glyphX < minX) minX = glyphX;
+				if (glyphY < minY) minY = glyphY;
+				if (glyphX + glyph.width > maxX) maxX = glyphX + glyph.width;
+				if (glyphY + glyph.height > maxY) maxY = glyphY + glyph.height;
+			}
+			penX += glyph.advance;
+		}
+		return clipToBitmap(minX, minY, maxX, maxY);
+	}
+
+	// Draws a text without marking it as changed, all of its glyphs have to be already rasterized (by textBounds)
+	// Only reads the glyph cache, so many threads can draw at once
+	void plotText(_In_ int x, _In_ int y, _In_ const wchar_t* text, _In_ int size, _In_ UINT32 color) {
+		const GlyphAtlas* atlas = glyphCache().findAtlas(size);
+		if (!memory || !atlas) return;
+		int penX = x;
+		for (const wchar_t* character = text; *character; character++) {
+			const Glyph* glyph = atlas->findGlyph(*character);
+			if (!glyph) continue;
+			if (glyph->width > 0)
+				blitGlyph(*atlas, *glyph, penX + glyph->left, y + glyph->top, color);
+			penX += glyph->advance;
+		}
+	}
+
+	// Draws the part of the image (size pixels from the source corner) with its top left corner at the position without marking it as changed
+	// Clipped to the clip rectangle, each row is combined with the pixels under it in one call
+	void plotImage(_In_ const Image& image, _In_ vec2<int> position, _In_ vec2<int> source, _In_ vec2<int> size, _In_ BlitMode mode, _In_ UINT32 colorKey) {
+		if (!memory) return;
+		int minX = position.x > clipMinX ? position.x : clipMinX;
+		int minY = position.y > clipMinY ? position.y : clipMinY;
+		int maxX = position.x + size.x < clipMaxX ? position.x + size.x : clipMaxX;
+		int maxY = position.y + size.y < clipMaxY ? position.y + size.y : clipMaxY;
+		if (minX >= maxX || minY >= maxY) return;
+		for (int y = minY; y < maxY; y++) {
+			const unsigned char* row = image.getRowBytes(source.y + y - position.y) + (size_t)(source.x + minX - position.x) * 4;
+			Format::blitSpan((Pixel*)memory + (size_t)y * bitmapWidth + minX, row, maxX - minX, mode, colorKey);
+		}
+	}
+
+	// Pixels the command can change (max exclusive) clipped to the bitmap, text is the text of Text commands
+	Rect commandBounds(_In_ const DrawCommand& command, _In_opt_ const wchar_t* text = nullptr) const {
+		switch (command.type) {
+		case DrawCommandType::Clear:
+			return clipToBitmap(0, 0, bitmapWidth, bitmapHeight);
+		case DrawCommandType::Pixel:
+			return clipToBitmap(command.points[0].x, command.points[0].y, command.points[0].x + 1, command.points[0].y + 1);
+		case DrawCommandType::Rectangle:
+			return clipToBitmap(command.points[0].x, command.points[0].y, command.points[1].x, command.points[1].y);
+		case DrawCommandType::Circle:
+			// Circles with radius up to 1 are a single pixel
+			return pointBounds(command.points, 1, command.size > 0 ? command.size : 0);
+		case DrawCommandType::EmptyCircle:
+			return pointBounds(command.points, 1, command.size + command.thickness);
+		case DrawCommandType::Line:
+			return pointBounds(command.points, 2, command.thickness);
+		case DrawCommandType::QuadraticBezier:
+			// The curve never leaves the convex hull of its control points
+			return pointBounds(command.points, 3, command.thickness);
+		case DrawCommandType::CubicBezier:
+			return pointBounds(command.points, 4, command.thickness);
+		case DrawCommandType::Triangle: {
+			vec2<int> vertices[3];
+			for (int i = 0; i < 3; i++)
+				vertices[i] = vec2<int>(command.points[i].x >> subpixelBits, command.points[i].y >> subpixelBits);
+			return pointBounds(vertices, 3, 1);
+		}
+		case DrawCommandType::Text:
+			return textBounds(command.points[0].x, command.points[0].y, text, command.size);
+		// Anti-aliased edges reach a pixel further
+		case DrawCommandType::AntialiasedLine:
+			return pointBounds(command.points, 2, command.thickness + 1);
+		case DrawCommandType::AntialiasedCircle:
+			return pointBounds(command.points, 1, command.size > 0 ? command.size + 1 : 1);
+		case DrawCommandType::AntialiasedEmptyCircle:
+			return pointBounds(command.points, 1, command.size + command.thickness + 1);
+		case DrawCommandType::Image:
+			return clipToBitmap(command.points[0].x, command.points[0].y, command.points[0].x + command.points[2].x, command.points[0].y + command.points[2].y);
+		}
+		return Rect();
+	}
+
+	// Moves the command by the offset, returns false if it can't be drawn there
+	static bool moveCommand(_Inout_ DrawCommand& command, _In_ vec2<int> offset) {
+		if (command.type == DrawCommandType::Triangle) {
+			// Vertices are fixed point and have to stay in the range of the rasterizer
+			const int maxFixed = triangleMaxCoordinate << subpixelBits;
+			for (int i = 0; i < 3; i++) {
+				long long x = (long long)command.points[i].x + ((long long)offset.x << subpixelBits);
+				long long y = (long long)command.points[i].y + ((long long)offset.y << subpixelBits);
+				if (x < -maxFixed || x > maxFixed || y < -maxFixed || y > maxFixed)
+					return false;
+				command.points[i] = vec2<int>((int)x, (int)y);
+			}
+			return true;
+		}
+		// Only the position of the images moves, the rest is their source rectangle
+		if (command.type == DrawCommandType::Image) {
+			command.points[0] = vec2<int>(command.points[0].x + offset.x, command.points[0].y + offset.y);
+			return true;
+		}
+		for (vec2<int>& point : command.points)
+			point = vec2<int>(point.x + offset.x, point.y + offset.y);
+		return true;
+	}
+
+	// Draws a recorded command without marking it as changed, the list holds its text or flattened curve
+	void execute(_In_ const DrawCommand& command, _In_ const DrawCommandList& list) {
+		switch (command.type) {
+		case DrawCommandType::Clear:
+			plotClear(command.color);
+			break;
+		case DrawCommandType::Pixel:
+			plotPixel(command.points[0].x, command.points[0].y, command.color);
+			break;
+		case DrawCommandType::Rectangle:
+			plotRectangle(command.points[0], command.points[1], command.color);
+			break;
+		case DrawCommandType::Circle:
+			plotCircle(command.points[0], command.size, command.color);
+			break;
+		case DrawCommandType::EmptyCircle:
+			plotRing(command.points[0], command.size, command.thickness, command.color);
+			break;
+		case DrawCommandType::Line:
+			plotLine(command.points[0], command.points[1], command.color, command.thickness);
+			break;
+		case DrawCommandType::QuadraticBezier:
+		case DrawCommandType::CubicBezier:
+			plotPolyline(list.getPoints(command), command.size, command.color, command.thickness);
+			break;
+		case DrawCommandType::Triangle:
+			plotTriangle(command.points[0], command.points[1], command.points[2], command.color);
+			break;
+		case DrawCommandType::Text:
+			plotText(command.points[0].x, command.points[0].y, list.getText(command), command.size, command.color);
+			break;
+		case DrawCommandType::AntialiasedLine:
+			plotAntialiasedLine(command.points[0], command.points[1], command.color, command.thickness);
+			break;
+		case DrawCommandType::AntialiasedCircle:
+			plotAntialiasedRing(command.points[0], 0, command.size, command.color);
+			break;
+		case DrawCommandType::AntialiasedEmptyCircle:
+			plotAntialiasedEmptyCircle(command.points[0], command.size, command.thickness, command.color);
+			break;
+		case DrawCommandType::Image:
+			plotImage(*list.getImage(command), command.points[0], command.points[1], command.points[2], (BlitMode)command.thickness, command.color);
+			break;
+		}
+	}
+
+	// Adds the command to the list with its text, flattened curve or image
+	static void addCommand(_Inout_ DrawCommandList& list, _Inout_ DrawCommand& command, _In_opt_ const wchar_t* text, _In_opt_ const Image* image) {
+		if (command.type == DrawCommandType::Text)
+			command.data = list.addText(text);
+		else if (command.type == DrawCommandType::QuadraticBezier || command.type == DrawCommandType::CubicBezier)
+			list.addCurve(command, command.type == DrawCommandType::QuadraticBezier ? 2 : 3);
+		else if (command.type == DrawCommandType::Image)
+			command.data = list.addImage(image);
+		list.add(command);
+	}
+
+	// Clips the command to the clip rectangle, marks it as changed and records it if recording, returns true if it has to be drawn right away
+	// text is the text of Text commands and image the image of Image commands
+	// The recorded bounds keep the clip rectangle, recorded commands are drawn clipped to them
+	bool submit(_Inout_ DrawCommand& command, _In_opt_ const wchar_t* text = nullptr, _In_opt_ const Image* image = nullptr) {
+		command.bounds = intersectRect(command.bounds, clipRect);
+		// Commands entirely outside of the clip rectangle don't change anything
+		if (command.bounds.width <= 0 || command.bounds.height <= 0) return false;
+		dirtyRegion.add(command.bounds);
+		command.clipped = !isInsideClip(command.bounds);
+		if (!recording) {
+			if (capture) {
+				DrawCommand captured = command;
+				addCommand(*capture, captured, text, image);
+			}
+			return true;
+		}
+		addCommand(*recording, command, text, image);
+		return false;
+	}
+
+public:
+	// Size of the bitmap
+	int bitmapWidth = 0;
+	int bitmapHeight = 0;
+
+	// Statistics of the presented frames
+	struct PresentStats {
+		// Rectangles presented in the last frame
+		int rects = 0;
+		// Bytes presented in the last frame
+		size_t bytes = 0;
+		// Bytes presented in all of the frames
+		unsigned long long totalBytes = 0;
+		// Number of the presented frames
+		unsigned long long frames = 0;
+	} presentStats;
+
+	BasicRenderTarget() {}
+	BasicRenderTarget(_In_ int targetWidth, _In_ int targetHeight) {
+		create(targetWidth, targetHeight);
+	}
+
+	BasicRenderTarget(const BasicRenderTarget&) = delete;
+	BasicRenderTarget& operator=(const BasicRenderTarget&) = delete;
+
+	// Pixel of the color (0x00RRGGBB), a constant expression for the constant colors
+	static constexpr Pixel toPixel(_In_ UINT32 color) {
+		return Format::fromRGB(color);
+	}
+
+	// Allocates the pixel memory, returns false if the allocation failed
+	bool create(_In_ int targetWidth, _In_ int targetHeight) {
+		release();
+		bitmapWidth = targetWidth;
+		bitmapHeight = targetHeight;
+		memorySize = (size_t)targetWidth * (size_t)targetHeight * sizeof(Pixel);
+		memory = framebufferPool().acquire(memorySize);
+		ownsMemory = true;
+		resetClipRect();
+		markAllDirty();
+		return memory != nullptr;
+	}
+
+	// Draws to pixels owned by someone else (rows are targetWidth pixels long), release() doesn't free them
+	void attach(_In_ Pixel* pixels, _In_ int targetWidth, _In_ int targetHeight) {
+		release();
+		bitmapWidth = targetWidth;
+		bitmapHeight = targetHeight;
+		memory = pixels;
+		ownsMemory = false;
+		resetClipRect();
+		markAllDirty();
+	}
+
+	// Switches to other pixels of the same size owned by someone else (for example the next buffer of a swap chain)
+	// Unlike attach, the dirty region and the clip rectangles are kept
+	void swapPixels(_In_ Pixel* pixels) {
+		if (ownsMemory)
+			framebufferPool().release(memory);
+		memory = pixels;
+		ownsMemory = false;
+	}
+
+	// Frees the pixel memory
+	void release() {
+		if (ownsMemory)
+			framebufferPool().release(memory);
+		memory = nullptr;
+		memorySize = 0;
+		ownsMemory = false;
+		// Nothing can be drawn without the memory
+		resetClipRect();
+	}
+
+	// Pointer to the first (top left) pixel, rows are bitmapWidth pixels long
+	Pixel* getPixels() const {
+		return (Pixel*)memory;
+	}
+
+	// Marks a rectangle (max exclusive) as changed so that it gets presented, it's clipped to the bitmap
+	void markDirty(_In_ int minX, _In_ int minY, _In_ int maxX, _In_ int maxY) {
+		Rect rect = clipToBitmap(minX, minY, maxX, maxY);
+		if (rect.width > 0)
+			dirtyRegion.add(rect);
+	}
+
+	// Marks the entire bitmap as changed
+	void markAllDirty() {
+		dirtyRegion.clear();
+		markDirty(0, 0, bitmapWidth, bitmapHeight);
+	}
+
+	// Region changed since the last present
+	const DirtyRegion& getDirtyRegion() const {
+		return dirtyRegion;
+	}
+
+	// Has to be called by the presenters after presenting the dirty region
+	void finishPresent() {
+		presentStats.rects = dirtyRegion.count;
+		presentStats.bytes = (size_t)dirtyRegion.area() * sizeof(Pixel);
+		presentStats.totalBytes += presentStats.bytes;
+		presentStats.frames++;
+		dirtyRegion.clear();
+	}
+
+	// Bytes presented in the last frame
+	size_t getPresentedBytes() const {
+		return presentStats.bytes;
+	}
+
+	// Clip rectangle (max exclusive) all of the draw calls are clipped to, the entire bitmap by default
+	Rect getClipRect() const {
+		return clipRect;
+	}
+
+	// Sets the clip rectangle (max exclusive), it's clipped to the bitmap
+	void setClipRect(_In_ const Rect& rect) {
+		clipRect = clipToBitmap(rect.minPoint.x, rect.minPoint.y, rect.maxPoint.x, rect.maxPoint.y);
+		if (!memory) clipRect = Rect();
+		resetClip();
+	}
+
+	// Saves the clip rectangle and restricts it to the part inside of the rectangle, for example to the UI panel drawn next
+	void pushClipRect(_In_ const Rect& rect) {
+		clipStack.push_back(clipRect);
+		setClipRect(intersectRect(clipRect, rect));
+	}
+
+	// Restores the clip rectangle saved by the last pushClipRect
+	void popClipRect() {
+		if (clipStack.empty()) return;
+		setClipRect(clipStack.back());
+		clipStack.pop_back();
+	}
+
+	// Clips the draw calls to the entire bitmap again, the saved clip rectangles are dropped
+	void resetClipRect() {
+		clipStack.clear();
+		setClipRect(Rect(vec2<int>(0, 0), vec2<int>(bitmapWidth, bitmapHeight)));
+	}
+
+	// Records the following draw calls to the list (after the commands already in it) instead of drawing them
+	// They're still marked as changed, the list has to be drawn before presenting (for example by a TileRenderer)
+	void beginRecording(_Inout_ DrawCommandList& list) {
+		recording = &list;
+	}
+
+	// Goes back to drawing the draw calls right away
+	void endRecording() {
+		recording = nullptr;
+	}
+
+	// List the draw calls are recorded to, nullptr if they're drawn right away
+	DrawCommandList* getRecording() const {
+		return recording;
+	}
+
+	// Copies the following draw calls to the list when they're drawn (validated and clipped), replaying the list on a target
+	// of the same size after the lists of the earlier frames gives the same pixels. Recorded draw calls are copied when their list
+	// is replayed, lists drawn another way (by a TileRenderer) have to be appended by whoever draws them
+	void beginCapture(_Inout_ DrawCommandList& list) {
+		capture = &list;
+	}
+
+	// Stops copying the draw calls
+	void endCapture() {
+		capture = nullptr;
+	}
+
+	// List the draw calls are copied to, nullptr if they aren't captured
+	DrawCommandList* getCapture() const {
+		return capture;
+	}
+
+	// Draws a recorded list again, moved by the offset, so that static content is recorded once and replayed every frame
+	// The commands were already validated, clipped and flattened when recorded, the ones entirely outside of the target then are left out
+	// They're clipped to the clip rectangle, and to the one they were recorded with unless they're moved
+	// The list is marked as changed with a single rectangle, the union of the bounds of its commands
+	// While recording, the commands are copied to the recorded list
+	void replay(_In_ const DrawCommandList& list, _In_opt_ vec2<int> offset = vec2<int>(0, 0)) {
+		GRAPHICS_PROFILE_SCOPE("replay");
+		if (!memory || &list == recording || list.empty()) return;
+		bool moved = offset.x != 0 || offset.y != 0;
+		// The recorded bounds move with the list, except the ones cut off when recorded which are computed again
+		bool boundsKnown = !moved || !list.clipped;
+		Rect listBounds = offsetRect(list.bounds, offset);
+		if (boundsKnown && intersectRect(listBounds, clipRect).width <= 0) return;
+		// Lists inside of the clip rectangle don't need their commands clipped one by one
+		bool inside = boundsKnown && containsRect(clipRect, listBounds);
+		Rect dirty = boundsKnown ? intersectRect(listBounds, clipRect) : Rect();
+		bool clipSet = false;
+		for (const DrawCommand& recorded : list.commands) {
+			DrawCommand command = recorded;
+			bool curve = command.type == DrawCommandType::QuadraticBezier || command.type == DrawCommandType::CubicBezier;
+			if (moved) {
+				if (!moveCommand(command, offset)) continue;
+				command.bounds = recorded.clipped ? commandBounds(command, command.type == DrawCommandType::Text ? list.getText(recorded) : nullptr)
+					: offsetRect(recorded.bounds, offset);
+			}
+			if (!inside) {
+				command.bounds = intersectRect(command.bounds, clipRect);
+				if (command.bounds.width <= 0 || command.bounds.height <= 0) continue;
+				if (!boundsKnown)
+					dirty = dirty.width > 0 ? unionRect(dirty, command.bounds) : command.bounds;
+			}
+
+			if (command.type == DrawCommandType::Clear && rectArea(command.bounds) == (long long)bitmapWidth * bitmapHeight)
+				dirtyRegion.clear();
+			if (recording || capture)
+				command.clipped = command.clipped || !isInsideClip(command.bounds);
+			if (recording) {
+				recording->append(command, list, offset);
+				continue;
+			}
+			if (capture)
+				capture->append(command, list, offset);
+			// The bounds of the rest hold all of their pixels, the clip rectangle clips them like when they were drawn
+			if (recorded.clipped && !moved) {
+				setClip(command.bounds);
+				clipSet = true;
+			}
+			else if (clipSet) {
+				resetClip();
+				clipSet = false;
+			}
+			if (curve && moved) {
+				const vec2<int>* points = list.getPoints(recorded);
+				replayPoints.resize(command.size);
+				for (int i = 0; i < command.size; i++)
+					replayPoints[i] = vec2<int>(points[i].x + offset.x, points[i].y + offset.y);
+				plotPolyline(replayPoints.data(), command.size, command.color, command.thickness);
+			}
+			else
+				execute(command, list);
+		}
+		if (clipSet)
+			resetClip();
+		if (dirty.width > 0)
+			dirtyRegion.add(dirty);
+	}
+
+	// Clears the screen (the clip rectangle) with a chosen color
+	void clearScreen(_In_ UINT32 color = BLACK) {
+		GRAPHICS_PROFILE_SCOPE("clearScreen");
+		// Everything drawn before is overwritten
+		if (isClipFull())
+			dirtyRegion.clear();
+		DrawCommand command(DrawCommandType::Clear, color);
+		command.bounds = commandBounds(command);
+		if (submit(command))
+			plotClear(color);
+	}
+
+	// Draws a pixel with custom color at specified coordinates
+	// Isn't profiled, timing it would take longer than drawing the pixel
+	void drawPixel(_In_ int x, _In_ int y, _In_ UINT32 color) {
+		DrawCommand command(DrawCommandType::Pixel, color);
+		command.points[0] = vec2<int>(x, y);
+		command.bounds = commandBounds(command);
+		// The pixel is inside of the clip rectangle if its bounds aren't empty
+		if (submit(command))
+			((Pixel*)memory)[(size_t)y * bitmapWidth + x] = Format::fromRGB(color);
+	}
+
+	// Draws text on the screen, glyphs are rasterized once per size and cached
+	// The size is 1 - glyphMaxSize (512) pixels, like in the draw streams, text of the other sizes isn't drawn
+	void drawText(_In_ int x, _In_ int y, _In_ const wchar_t* text, _In_ int size = 16, _In_ UINT32 color = WHITE) {
+		GRAPHICS_PROFILE_SCOPE("drawText");
+		if (!memory || !text || size < 1 || size > glyphMaxSize) return;
+		DrawCommand command(DrawCommandType::Text, color);
+		command.points[0] = vec2<int>(x, y);
+		command.size = size;
+		command.bounds = commandBounds(command, text);
+		if (submit(command, text))
+			plotText(x, y, text, size, color);
+	}
+
+	// Draws a rectangle
+	// The far corner is computed in 64 bits and clamped to the target, so a rectangle recorded sticking out of the target
+	// stays cut off at its edge when the list is replayed moved
+	void drawRectangle(_In_ vec2<int> coords, _In_ int recWidth, _In_ int recHeight, _In_ UINT32 color) {
+		GRAPHICS_PROFILE_SCOPE("drawRectangle");
+		if (!memory || recWidth <= 0 || recHeight <= 0) return;
+		long long maxX = (long long)coords.x + recWidth;
+		long long maxY = (long long)coords.y + recHeight;
+		DrawCommand command(DrawCommandType::Rectangle, color);
+		command.points[0] = coords;
+		command.points[1] = vec2<int>(maxX < bitmapWidth ? (int)maxX : bitmapWidth, maxY < bitmapHeight ? (int)maxY : bitmapHeight);
+		command.bounds = commandBounds(command);
+		if (submit(command))
+			plotRectangle(command.points[0], command.points[1], color);
+	}
+
+	// Draws a rectangle from Rect
+	void drawRectangle(_In_ Rect rect, _In_ UINT32 color) {
+		drawRectangle(rect.minPoint, rect.width, rect.height, color);
+	}
+
+	// Draws a filled circle
+	void drawCircle(_In_ vec2<int> origin, _In_ int radius, _In_  UINT32 color) {
+		GRAPHICS_PROFILE_SCOPE("drawCircle");
+		DrawCommand command(DrawCommandType::Circle, color);
+		command.points[0] = origin;
+		command.size = radius;
+		command.bounds = commandBounds(command);
+		if (submit(command))
+			plotCircle(origin, radius, color);
+	}
+
+	// Draws and empty circle
+	void drawEmptyCircle(_In_ vec2<int> origin, _In_ int radius, _In_  UINT32 color, _In_opt_ unsigned short thickness = 1) {
+		GRAPHICS_PROFILE_SCOPE("drawEmptyCircle");
+		DrawCommand command(DrawCommandType::EmptyCircle, color);
+		command.points[0] = origin;
+		command.size = radius;
+		command.thickness = thickness;
+		command.bounds = commandBounds(command);
+		if (submit(command))
+			plotRing(origin, radius, thickness, color);
+	}
+
+	// Draws a line
+	void drawLine(_In_ vec2<int> p1, _In_ vec2<int> p2, _In_ UINT32 color, _In_opt_ unsigned short thickness = 1) {
+		GRAPHICS_PROFILE_SCOPE("drawLine");
+		DrawCommand command(DrawCommandType::Line, color);
+		command.points[0] = p1;
+		command.points[1] = p2;
+		command.thickness = thickness;
+		command.bounds = commandBounds(command);
+		if (submit(command))
+			plotLine(p1, p2, color, thickness);
+	}
+
+	// Draws an anti-aliased line, coverage is computed and blended in the same pass
+	// Lines with thickness up to 1 use the Wu's algorithm, thicker ones are capsules with smooth edges
+	void drawAntialiasedLine(_In_ vec2<int> p1, _In_ vec2<int> p2, _In_ UINT32 color, _In_opt_ unsigned short thickness = 1) {
+		GRAPHICS_PROFILE_SCOPE("drawAntialiasedLine");
+		DrawCommand command(DrawCommandType::AntialiasedLine, color);
+		command.points[0] = p1;
+		command.points[1] = p2;
+		command.thickness = thickness;
+		command.bounds = commandBounds(command);
+		if (submit(command))
+			plotAntialiasedLine(p1, p2, color, thickness);
+	}
+
+	// Draws an anti-aliased filled circle, its edge is radius + 0.5 away from the origin so it's as big as the drawCircle one
+	void drawAntialiasedCircle(_In_ vec2<int> origin, _In_ int radius, _In_ UINT32 color) {
+		GRAPHICS_PROFILE_SCOPE("drawAntialiasedCircle");
+		DrawCommand command(DrawCommandType::AntialiasedCircle, color);
+		command.points[0] = origin;
+		command.size = radius;
+		command.bounds = commandBounds(command);
+		if (submit(command))
+			plotAntialiasedRing(origin, 0, radius, color);
+	}
+
+	// Draws an anti-aliased empty circle
+	void drawAntialiasedEmptyCircle(_In_ vec2<int> origin, _In_ int radius, _In_ UINT32 color, _In_opt_ unsigned short thickness = 1) {
+		GRAPHICS_PROFILE_SCOPE("drawAntialiasedEmptyCircle");
+		DrawCommand command(DrawCommandType::AntialiasedEmptyCircle, color);
+		command.points[0] = origin;
+		command.size = radius;
+		command.thickness = thickness;
+		command.bounds = commandBounds(command);
+		if (submit(command))
+			plotAntialiasedEmptyCircle(origin, radius, thickness, color);
+	}
+
+	// Get point for Bezier curve
+	int getPt(int n1, int n2, float perc) {
+		int diff = n2 - n1;
+
+		return n1 + (int)(diff * perc);
+	}
+
+	// Draws a quadratic Bezier curve
+	void drawBezierCurve(_In_ vec2<int> p1, _In_ vec2<int> p2, _In_ vec2<int> p3, _In_ UINT32 color, _In_opt_ unsigned short thickness = 1) {
+		GRAPHICS_PROFILE_SCOPE("drawBezierCurve");
+		DrawCommand command(DrawCommandType::QuadraticBezier, color);
+		command.points[0] = p1;
+		command.points[1] = p2;
+		command.points[2] = p3;
+		command.thickness = thickness;
+		command.bounds = commandBounds(command);
+		if (submit(command))
+			plotBezierCurve(command.points, 2, color, thickness);
+	}
+
+	// Draws a cubic Bezier curve
+	void drawBezierCurve(_In_ vec2<int> p1, _In_ vec2<int> p2, _In_ vec2<int> p3, _In_ vec2<int> p4, _In_ UINT32 color, _In_opt_ unsigned short thickness = 1) {
+		GRAPHICS_PROFILE_SCOPE("drawBezierCurve");
+		DrawCommand command(DrawCommandType::CubicBezier, color);
+		command.points[0] = p1;
+		command.points[1] = p2;
+		command.points[2] = p3;
+		command.points[3] = p4;
+		command.thickness = thickness;
+		command.bounds = commandBounds(command);
+		if (submit(command))
+			plotBezierCurve(command.points, 3, color, thickness);
+	}
+
+	// Draws many quadratic (degree 2) or cubic (degree 3) Bezier curves in one call
+	// controlPoints holds degree + 1 points per curve, the curves are flattened together with SIMD
+	void drawBezierCurves(_In_ const vec2<int>* controlPoints, _In_ int curveCount, _In_ int degree, _In_ UINT32 color, _In_opt_ unsigned short thickness = 1) {
+		GRAPHICS_PROFILE_SCOPE("drawBezierCurves");
+		if (curveCount <= 0 || (degree != 2 && degree != 3)) return;
+		// Recorded curves are flattened one by one
+		if (recording) {
+			for (int curve = 0; curve < curveCount; curve++) {
+				DrawCommand command(degree == 2 ? DrawCommandType::QuadraticBezier : DrawCommandType::CubicBezier, color);
+				for (int i = 0; i <= degree; i++)
+					command.points[i] = controlPoints[curve * (degree + 1) + i];
+				command.thickness = thickness;
+				command.bounds = commandBounds(command);
+				submit(command);
+			}
+			return;
+		}
+		bezierBatch.flatten(controlPoints, curveCount, degree);
+		for (int curve = 0; curve < curveCount; curve++) {
+			markDirtyPoints(controlPoints + curve * (degree + 1), degree + 1, thickness);
+			int first = bezierBatch.offsets[curve];
+			int count = bezierBatch.offsets[curve + 1] - first;
+			// Captured curves keep the points they were flattened to here
+			if (capture) {
+				DrawCommand command(degree == 2 ? DrawCommandType::QuadraticBezier : DrawCommandType::CubicBezier, color);
+				command.thickness = thickness;
+				command.bounds = intersectRect(pointBounds(controlPoints + curve * (degree + 1), degree + 1, thickness), clipRect);
+				if (command.bounds.width > 0 && command.bounds.height > 0) {
+					command.data = (int)capture->pointPool.size();
+					command.size = count;
+					capture->pointPool.insert(capture->pointPool.end(), &bezierBatch.points[first], &bezierBatch.points[first] + count);
+					capture->add(command);
+				}
+			}
+			plotPolyline(&bezierBatch.points[first], count, color, thickness);
+		}
+	}
+
+	// Draws a filled triangle, pixels on the edges shared with other triangles are drawn exactly once
+	void drawTriangle(_In_ vec2<int> v1, _In_ vec2<int> v2, _In_ vec2<int> v3, _In_ UINT32 color) {
+		GRAPHICS_PROFILE_SCOPE("drawTriangle");
+		const int limit = triangleMaxCoordinate;
+		if (v1.x < -limit || v1.x > limit || v1.y < -limit || v1.y > limit || v2.x < -limit || v2.x > limit || v2.y < -limit || v2.y > limit
+			|| v3.x < -limit || v3.x > limit || v3.y < -limit || v3.y > limit)
+			return;
+		DrawCommand command(DrawCommandType::Triangle, color);
+		vec2<int> p1(v1.x * subpixelScale, v1.y * subpixelScale);
+		vec2<int> p2(v2.x * subpixelScale, v2.y * subpixelScale);
+		vec2<int> p3(v3.x * subpixelScale, v3.y * subpixelScale);
+		command.points[0] = p1;
+		command.points[1] = p2;
+		command.points[2] = p3;
+		// The bounds commandBounds() gives to the triangles, from the vertices as they are, the small triangles of the meshes
+		// take about as long as the switch over the command types and the vertices loaded back from the command
+		int minX = v1.x < v2.x ? (v1.x < v3.x ? v1.x : v3.x) : (v2.x < v3.x ? v2.x : v3.x);
+		int minY = v1.y < v2.y ? (v1.y < v3.y ? v1.y : v3.y) : (v2.y < v3.y ? v2.y : v3.y);
+		int maxX = v1.x > v2.x ? (v1.x > v3.x ? v1.x : v3.x) : (v2.x > v3.x ? v2.x : v3.x);
+		int maxY = v1.y > v2.y ? (v1.y > v3.y ? v1.y : v3.y) : (v2.y > v3.y ? v2.y : v3.y);
+		command.bounds = clipToBitmap(minX - 1, minY - 1, maxX + 2, maxY + 2);
+		if (submit(command))
+			plotTriangle(p1, p2, p3, color);
+	}
+
+	// Draws a filled triangle with sub-pixel precise vertices (snapped to 1/16 of a pixel), pixel (x, y) is covered if the point (x, y) is
+	void drawTriangle(_In_ vec2<float> v1, _In_ vec2<float> v2, _In_ vec2<float> v3, _In_ UINT32 color) {
+		GRAPHICS_PROFILE_SCOPE("drawTriangle");
+		DrawCommand command(DrawCommandType::Triangle, color);
+		if (!toSubpixel(v1, command.points[0]) || !toSubpixel(v2, command.points[1]) || !toSubpixel(v3, command.points[2]))
+			return;
+		command.bounds = commandBounds(command);
+		if (submit(command))
+			plotTriangle(command.points[0], command.points[1], command.points[2], color);
+	}
+
+	// Draws the image with its top left corner at the coordinates
+	// ColorKey mode skips the pixels with the color key (0x00RRGGBB), Alpha mode copies the images without alpha
+	void drawImage(_In_ const Image& image, _In_ int x, _In_ int y, _In_opt_ BlitMode mode = BlitMode::Copy, _In_opt_ UINT32 colorKey = 0) {
+		drawImage(image, x, y, Rect(vec2<int>(0, 0), image.width, image.height), mode, colorKey);
+	}
+
+	// Draws a part of the image (for example a sprite of a sprite sheet) with its top left corner at the coordinates
+	void drawImage(_In_ const Image& image, _In_ int x, _In_ int y, _In_ Rect source, _In_opt_ BlitMode mode = BlitMode::Copy, _In_opt_ UINT32 colorKey = 0) {
+		GRAPHICS_PROFILE_SCOPE("drawImage");
+		if (!memory || image.width <= 0) return;
+		// Parts of the source rectangle outside of the image aren't drawn
+		if (source.minPoint.x < 0) {
+			x -= source.minPoint.x;
+			source.minPoint.x = 0;
+		}
+		if (source.minPoint.y < 0) {
+			y -= source.minPoint.y;
+			source.minPoint.y = 0;
+		}
+		if (source.maxPoint.x > image.width) source.maxPoint.x = image.width;
+		if (source.maxPoint.y > image.height) source.maxPoint.y = image.height;
+		if (source.minPoint.x >= source.maxPoint.x || source.minPoint.y >= source.maxPoint.y) return;
+		if (mode == BlitMode::Alpha && !image.hasAlpha) mode = BlitMode::Copy;
+
+		DrawCommand command(DrawCommandType::Image, colorKey & 0xFFFFFF);
+		command.points[0] = vec2<int>(x, y);
+		command.points[1] = source.minPoint;
+		command.points[2] = vec2<int>(source.maxPoint.x - source.minPoint.x, source.maxPoint.y - source.minPoint.y);
+		command.thickness = (unsigned short)mode;
+		command.bounds = commandBounds(command);
+		if (submit(command, nullptr, &image))
+			plotImage(image, command.points[0], command.points[1], command.points[2], mode, command.color);
+	}
+
+#ifdef GRAPHICS_PROFILE
+	// Draws the times of the last frames of the profiler as bars (newest on the right) with lines at 16.7 ms and 33.3 ms
+	// and the average frame time, graphHeight pixels are 50 ms
+	void drawFrameGraph(_In_ vec2<int> position, _In_opt_ int graphHeight = 100) {
+		GRAPHICS_PROFILE_SCOPE("drawFrameGraph");
+		const Profiler& frames = profiler();
+		const int barWidth = 2;
+		const float scale = (float)graphHeight / 50.0f;
+		const float budgets[2] = { 1000.0f / 60.0f, 1000.0f / 30.0f };
+		int count = frames.getFrameCount() < Profiler::frameHistory ? frames.getFrameCount() : Profiler::frameHistory;
+		drawRectangle(position, Profiler::frameHistory * barWidth, graphHeight, 0x101010);
+		float total = 0.0f;
+		for (int i = 0; i < count; i++) {
+			float time = frames.getFrameTime(i);
+			total += time;
+			int barHeight = (int)(time * scale) + 1;
+			if (barHeight > graphHeight) barHeight = graphHeight;
+			// Green within 60 FPS, yellow within 30 FPS, red over that
+			UINT32 color = time <= budgets[0] ? GREEN : time <= budgets[1] ? YELLOW : RED;
+			drawRectangle(vec2<int>(position.x + (Profiler::frameHistory - 1 - i) * barWidth, position.y + graphHeight - barHeight), barWidth, barHeight, color);
+		}
+		for (float budget : budgets) {
+			int y = position.y + graphHeight - (int)(budget * scale);
+			drawLine(vec2<int>(position.x, y), vec2<int>(position.x + Profiler::frameHistory * barWidth - 1, y), GREY);
+		}
+		if (count > 0) {
+			wchar_t label[32];
+			swprintf(label, 32, L"%.2f ms", total / count);
+			drawText(position.x + 4, position.y + 2, label, 16, WHITE);
+		}
+	}
+#endif
+
+	~BasicRenderTarget() {
+		release();
+	}
+};
+
+// Render target of the windows
+typedef BasicRenderTarget<BGRA32> RenderTarget;
+// Render targets with a half and a quarter of the memory traffic
+typedef BasicRenderTarget<RGB565> RenderTarget16;
+typedef BasicRenderTarget<Indexed8> RenderTarget8;
+
+#endif // !GRAPHICS_RENDER_TARGET
@@ -0,0 +1,272 @@
+#ifndef GRAPHICS_SCALE
+#define GRAPHICS_SCALE
+
+#include "Platform.hpp"
+#include "Geometry.hpp"
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Filters of the upscaler
+enum class ScaleFilter : unsigned char {
+	// Copies the closest source pixel
+	Nearest,
+	// Interpolates the 4 closest source pixels
+	Bilinear,
+};
+
+// Scales a row with the nearest filter, sourceX has the source column of every destination pixel
+typedef void (*NearestRowFunction)(const UINT32* row, const int32_t* sourceX, UINT32* destination, size_t count);
+// Scales a row horizontally with the bilinear filter, sourceX has the left column of every destination pixel
+// and weightX the weight of the right one (0 - 256) 4 times, once for every channel
+typedef void (*BilinearRowFunction)(const UINT32* row, const int32_t* sourceX, const uint16_t* weightX, UINT32* destination, size_t count);
+// Interpolates two rows, weight is the weight of the bottom one (0 - 256)
+typedef void (*BlendRowsFunction)(const UINT32* top, const UINT32* bottom, unsigned int weight, UINT32* destination, size_t count);
+
+// Interpolates the channels of 2 colors with 8 fractional bits, weight is the weight of the second one (0 - 256)
+inline UINT32 interpolateColor(_In_ UINT32 first, _In_ UINT32 second, _In_ unsigned int weight) {
+	UINT32 color = 0;
+	for (int shift = 0; shift < 32; shift += 8)
+		color |= (UINT32)(((first >> shift & 0xFF) * (256 - weight) + (second >> shift & 0xFF) * weight) >> 8) << shift;
+	return color;
+}
+
+// Scalar fallback
+inline void scaleRowNearestScalar(_In_ const UINT32* row, _In_ const int32_t* sourceX, _Out_ UINT32* destination, _In_ size_t count) {
+	for (size_t i = 0; i < count; i++)
+		destination[i] = row[sourceX[i]];
+}
+
+// Scalar fallback
+inline void scaleRowBilinearScalar(_In_ const UINT32* row, _In_ const int32_t* sourceX, _In_ const uint16_t* weightX, _Out_ UINT32* destination, _In_ size_t count) {
+	for (size_t i = 0; i < count; i++)
+		destination[i] = interpolateColor(row[sourceX[i]], row[sourceX[i] + 1], weightX[i * 4]);
+}
+
+// Scalar fallback
+inline void blendRowsScalar(_In_ const UINT32* top, _In_ const UINT32* bottom, _In_ unsigned int weight, _Out_ UINT32* destination, _In_ size_t count) {
+	for (size_t i = 0; i < count; i++)
+		destination[i] = interpolateColor(top[i], bottom[i], weight);
+}
+
+#ifdef GRAPHICS_SSE2
+// Interpolates the 16-bit channels, the products are at most 255 * 256 so they fit in the unsigned 16 bits
+inline __m128i interpolateChannelsSSE2(_In_ __m128i first, _In_ __m128i second, _In_ __m128i weight) {
+	__m128i firstWeight = _mm_sub_epi16(_mm_set1_epi16(256), weight);
+	return _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(first, firstWeight), _mm_mullo_epi16(second, weight)), 8);
+}
+
+// 2 pixels per step, the left and the right columns of both are interpolated at once
+inline void scaleRowBilinearSSE2(_In_ const UINT32* row, _In_ const int32_t* sourceX, _In_ const uint16_t* weightX, _Out_ UINT32* destination, _In_ size_t count) {
+	__m128i zero = _mm_setzero_si128();
+	size_t i = 0;
+	for (; i + 2 <= count; i += 2) {
+		__m128i first = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(row + sourceX[i])), zero);
+		__m128i second = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(row + sourceX[i + 1])), zero);
+		__m128i left = _mm_unpacklo_epi64(first, second);
+		__m128i right = _mm_unpackhi_epi64(first, second);
+		__m128i weight = _mm_loadu_si128((const __m128i*)(weightX + i * 4));
+		_mm_storel_epi64((__m128i*)(destination + i), _mm_packus_epi16(interpolateChannelsSSE2(left, right, weight), zero));
+	}
+	scaleRowBilinearScalar(row, sourceX + i, weightX + i * 4, destination + i, count - i);
+}
+
+// 4 pixels per step
+inline void blendRowsSSE2(_In_ const UINT32* top, _In_ const UINT32* bottom, _In_ unsigned int weight, _Out_ UINT32* destination, _In_ size_t count) {
+	__m128i zero = _mm_setzero_si128();
+	__m128i bottomWeight = _mm_set1_epi16((short)weight);
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m128i upper = _mm_loadu_si128((const __m128i*)(top + i));
+		__m128i lower = _mm_loadu_si128((const __m128i*)(bottom + i));
+		__m128i low = interpolateChannelsSSE2(_mm_unpacklo_epi8(upper, zero), _mm_unpacklo_epi8(lower, zero), bottomWeight);
+		__m128i high = interpolateChannelsSSE2(_mm_unpackhi_epi8(upper, zero), _mm_unpackhi_epi8(lower, zero), bottomWeight);
+		_mm_storeu_si128((__m128i*)(destination + i), _mm_packus_epi16(low, high));
+	}
+	blendRowsScalar(top + i, bottom + i, weight, destination + i, count - i);
+}
+
+// 8 pixels per gather
+GRAPHICS_TARGET_AVX2 inline void scaleRowNearestAVX2(_In_ const UINT32* row, _In_ const int32_t* sourceX, _Out_ UINT32* destination, _In_ size_t count) {
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256i index = _mm256_loadu_si256((const __m256i*)(sourceX + i));
+		_mm256_storeu_si256((__m256i*)(destination + i), _mm256_i32gather_epi32((const int*)row, index, 4));
+	}
+	scaleRowNearestScalar(row, sourceX + i, destination + i, count - i);
+}
+
+// 8 pixels per step
+GRAPHICS_TARGET_AVX2 inline void blendRowsAVX2(_In_ const UINT32* top, _In_ const UINT32* bottom, _In_ unsigned int weight, _Out_ UINT32* destination, _In_ size_t count) {
+	__m256i zero = _mm256_setzero_si256();
+	__m256i bottomWeight = _mm256_set1_epi16((short)weight);
+	__m256i topWeight = _mm256_set1_epi16((short)(256 - weight));
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256i upper = _mm256_loadu_si256((const __m256i*)(top + i));
+		__m256i lower = _mm256_loadu_si256((const __m256i*)(bottom + i));
+		// The unpacks stay in their 128-bit lanes and the pack puts them back in the same order
+		__m256i low = _mm256_srli_epi16(_mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(upper, zero), topWeight),
+			_mm256_mullo_epi16(_mm256_unpacklo_epi8(lower, zero), bottomWeight)), 8);
+		__m256i high = _mm256_srli_epi16(_mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(upper, zero), topWeight),
+			_mm256_mullo_epi16(_mm256_unpackhi_epi8(lower, zero), bottomWeight)), 8);
+		_mm256_storeu_si256((__m256i*)(destination + i), _mm256_packus_epi16(low, high));
+	}
+	blendRowsSSE2(top + i, bottom + i, weight, destination + i, count - i);
+}
+#endif
+
+// Row kernels selected for the CPU
+struct ScaleKernels {
+	NearestRowFunction nearest;
+	BilinearRowFunction bilinear;
+	BlendRowsFunction blendRows;
+	// Name of the instruction set
+	const char* name;
+};
+
+// Picks the fastest kernels supported by the CPU
+inline ScaleKernels selectScaleKernels() {
+#ifdef GRAPHICS_SSE2
+	if (cpuHasAVX2())
+		return { scaleRowNearestAVX2, scaleRowBilinearSSE2, blendRowsAVX2, "AVX2" };
+	return { scaleRowNearestScalar, scaleRowBilinearSSE2, blendRowsSSE2, "SSE2" };
+#else
+	return { scaleRowNearestScalar, scaleRowBilinearScalar, blendRowsScalar, "scalar" };
+#endif
+}
+
+// Kernels of the CPU, selected once on the first use
+inline const ScaleKernels& scaleKernels() {
+	static const ScaleKernels kernels = selectScaleKernels();
+	return kernels;
+}
+
+// Scales 32bpp frames to another size, the pixel centers of both frames are aligned
+// Keeps the source positions of the columns, so scaling the frames of the same sizes doesn't compute them again
+// The bilinear filter scales every source row horizontally once and interpolates the pairs of the scaled rows
+class Upscaler {
+	// Sizes the columns were computed for
+	int columnsSource = 0;
+	int columnsDestination = 0;
+	ScaleFilter columnFilter = ScaleFilter::Nearest;
+	// Source column of every destination column (the left one of the bilinear filter) and the weight of the right one 4 times
+	std::vector<int32_t> columns;
+	std::vector<uint16_t> weights;
+	// Source rows scaled horizontally, the source row of each one (-1 if none)
+	std::vector<UINT32> scaledRows[2];
+	int32_t scaledRowIndex[2] = { -1, -1 };
+
+	// Scaled source row, made if neither of the 2 kept ones is it, other is the slot that has to be kept
+	const UINT32* scaledRow(_In_ const UINT32* source, _In_ int sourceWidth, _In_ int32_t row, _In_ int other, _In_ const Rect& rect, _Out_ int& slot) {
+		for (slot = 0; slot < 2; slot++)
+			if (scaledRowIndex[slot] == row) return scaledRows[slot].data();
+		slot = other == 0 ? 1 : 0;
+		scaledRowIndex[slot] = row;
+		scaledRows[slot].resize((size_t)rect.width);
+		scaleKernels().bilinear(source + (size_t)row * sourceWidth, columns.data() + rect.minPoint.x, weights.data() + (size_t)rect.minPoint.x * 4,
+			scaledRows[slot].data(), (size_t)rect.width);
+		return scaledRows[slot].data();
+	}
+
+	// Position of the center of the destination pixel in the source (16.16 fixed point), clamped to the source
+	static int64_t sourcePosition(_In_ int destination, _In_ int sourceSize, _In_ int destinationSize) {
+		int64_t position = (((int64_t)destination * 2 + 1) * sourceSize - destinationSize) * 65536 / ((int64_t)destinationSize * 2);
+		if (position < 0) return 0;
+		if (position > ((int64_t)sourceSize - 1) << 16) return ((int64_t)sourceSize - 1) << 16;
+		return position;
+	}
+
+	// Source pixel (the first one of the bilinear pair) and the weight of the next one, the pair always fits in the source
+	static void bilinearSample(_In_ int destination, _In_ int sourceSize, _In_ int destinationSize, _Out_ int32_t& index, _Out_ uint16_t& weight) {
+		int64_t position = sourcePosition(destination, sourceSize, destinationSize);
+		index = (int32_t)(position >> 16);
+		weight = (uint16_t)(position >> 8 & 0xFF);
+		if (index >= sourceSize - 1) {
+			index = sourceSize - 2;
+			weight = 256;
+		}
+	}
+
+	// Source pixel closest to the destination pixel
+	static int32_t nearestSample(_In_ int destination, _In_ int sourceSize, _In_ int destinationSize) {
+		int32_t index = (int32_t)(((int64_t)destination * 2 + 1) * sourceSize / ((int64_t)destinationSize * 2));
+		return index < sourceSize ? index : sourceSize - 1;
+	}
+
+	// Computes the source columns for the sizes if they changed
+	void prepareColumns(_In_ int sourceSize, _In_ int destinationSize, _In_ ScaleFilter filter) {
+		if (sourceSize == columnsSource && destinationSize == columnsDestination && filter == columnFilter) return;
+		columnsSource = sourceSize;
+		columnsDestination = destinationSize;
+		columnFilter = filter;
+		columns.resize(destinationSize);
+		weights.resize((size_t)destinationSize * 4);
+		for (int x = 0; x < destinationSize; x++) {
+			uint16_t weight = 0;
+			if (filter == ScaleFilter::Bilinear)
+				bilinearSample(x, sourceSize, destinationSize, columns[x], weight);
+			else
+				columns[x] = nearestSample(x, sourceSize, destinationSize);
+			for (int channel = 0; channel < 4; channel++)
+				weights[(size_t)x * 4 + channel] = weight;
+		}
+	}
+
+public:
+	// Part of the destination that has to be scaled again when the source rectangle (max exclusive) changes
+	static Rect destinationRect(_In_ const Rect& source, _In_ int sourceWidth, _In_ int sourceHeight, _In_ int destinationWidth, _In_ int destinationHeight) {
+		// The bilinear filter reaches a source pixel further, which is up to half of the scale and one more destination pixels away
+		int marginX = (destinationWidth + sourceWidth - 1) / sourceWidth / 2 + 1;
+		int marginY = (destinationHeight + sourceHeight - 1) / sourceHeight / 2 + 1;
+		int minX = (int)((int64_t)source.minPoint.x * destinationWidth / sourceWidth) - marginX;
+		int minY = (int)((int64_t)source.minPoint.y * destinationHeight / sourceHeight) - marginY;
+		int maxX = (int)(((int64_t)source.maxPoint.x * destinationWidth + sourceWidth - 1) / sourceWidth) + marginX;
+		int maxY = (int)(((int64_t)source.maxPoint.y * destinationHeight + sourceHeight - 1) / sourceHeight) + marginY;
+		return Rect(vec2<int>(minX > 0 ? minX : 0, minY > 0 ? minY : 0),
+			vec2<int>(maxX < destinationWidth ? maxX : destinationWidth, maxY < destinationHeight ? maxY : destinationHeight));
+	}
+
+	// Scales the source frame to the rectangle (max exclusive) of the destination frame, rows of both are as long as their width
+	void scale(_In_ const UINT32* source, _In_ int sourceWidth, _In_ int sourceHeight, _Out_ UINT32* destination, _In_ int destinationWidth, _In_ int destinationHeight,
+		_In_ const Rect& rect, _In_ ScaleFilter filter) {
+		if (sourceWidth <= 0 || sourceHeight <= 0 || rect.width <= 0 || rect.height <= 0) return;
+		// The bilinear filter needs pairs of pixels
+		if (sourceWidth < 2 || sourceHeight < 2)
+			filter = ScaleFilter::Nearest;
+		prepareColumns(sourceWidth, destinationWidth, filter);
+		const ScaleKernels& kernels = scaleKernels();
+
+		// The rows scaled in the earlier calls may have had other columns
+		scaledRowIndex[0] = -1;
+		scaledRowIndex[1] = -1;
+		UINT32* previous = nullptr;
+		int32_t previousRow = -1;
+		uint16_t previousWeight = 0;
+		for (int y = rect.minPoint.y; y < rect.maxPoint.y; y++) {
+			UINT32* row = destination + (size_t)y * destinationWidth + rect.minPoint.x;
+			int32_t sourceRow;
+			uint16_t weight = 0;
+			if (filter == ScaleFilter::Bilinear)
+				bilinearSample(y, sourceHeight, destinationHeight, sourceRow, weight);
+			else
+				sourceRow = nearestSample(y, sourceHeight, destinationHeight);
+			// Upscaled rows sampling the same source rows are the same
+			if (previous && sourceRow == previousRow && weight == previousWeight)
+				memcpy(row, previous, (size_t)rect.width * sizeof(UINT32));
+			else if (filter == ScaleFilter::Bilinear) {
+				int topSlot, bottomSlot;
+				const UINT32* top = scaledRow(source, sourceWidth, sourceRow, -1, rect, topSlot);
+				const UINT32* bottom = scaledRow(source, sourceWidth, sourceRow + 1, topSlot, rect, bottomSlot);
+				kernels.blendRows(top, bottom, weight, row, (size_t)rect.width);
+			}
+			else
+				kernels.nearest(source + (size_t)sourceRow * sourceWidth, columns.data() + rect.minPoint.x, row, (size_t)rect.width);
+			previous = row;
+			previousRow = sourceRow;
+			previousWeight = weight;
+		}
+	}
+};
+
+#endif // !GRAPHICS_SCALE
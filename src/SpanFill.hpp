@@ -0,0 +1,144 @@
+#ifndef GRAPHICS_SPAN_FILL
+#define GRAPHICS_SPAN_FILL
+
+#include "Platform.hpp"
+#include <cstdint>
+
+// Fills count pixels starting at pixel with the color
+typedef void (*FillSpanFunction)(UINT32* pixel, size_t count, UINT32 color);
+
+// Spans shorter than this are filled inline, without going thru the dispatched kernel
+const size_t shortSpanLength = 8;
+// Full-frame fills bigger than this (in bytes) use non-temporal stores,
+// smaller frames are left in the cache since they're going to be drawn over right away
+const size_t streamingFillThreshold = 4 * 1024 * 1024;
+
+// Scalar fallback
+inline void fillSpanScalar(_In_ UINT32* pixel, _In_ size_t count, _In_ UINT32 color) {
+	for (size_t i = 0; i < count; i++)
+		pixel[i] = color;
+}
+
+#ifdef GRAPHICS_SSE2
+// Fills pixels one by one until the pointer is aligned to the alignment (in bytes)
+inline UINT32* fillUntilAligned(UINT32* pixel, size_t& count, UINT32 color, uintptr_t alignment) {
+	while (count > 0 && ((uintptr_t)pixel & (alignment - 1)) != 0) {
+		*pixel++ = color;
+		count--;
+	}
+	return pixel;
+}
+
+// 4 pixels per store
+inline void fillSpanSSE2(_In_ UINT32* pixel, _In_ size_t count, _In_ UINT32 color) {
+	__m128i value = _mm_set1_epi32((int)color);
+	// Unrolled 16 pixels per iteration
+	for (; count >= 16; count -= 16, pixel += 16) {
+		_mm_storeu_si128((__m128i*)pixel, value);
+		_mm_storeu_si128((__m128i*)(pixel + 4), value);
+		_mm_storeu_si128((__m128i*)(pixel + 8), value);
+		_mm_storeu_si128((__m128i*)(pixel + 12), value);
+	}
+	for (; count >= 4; count -= 4, pixel += 4)
+		_mm_storeu_si128((__m128i*)pixel, value);
+	fillSpanScalar(pixel, count, color);
+}
+
+// 4 pixels per non-temporal store, bypasses the cache
+inline void fillSpanStreamSSE2(_In_ UINT32* pixel, _In_ size_t count, _In_ UINT32 color) {
+	__m128i value = _mm_set1_epi32((int)color);
+	pixel = fillUntilAligned(pixel, count, color, 16);
+	for (; count >= 16; count -= 16, pixel += 16) {
+		_mm_stream_si128((__m128i*)pixel, value);
+		_mm_stream_si128((__m128i*)(pixel + 4), value);
+		_mm_stream_si128((__m128i*)(pixel + 8), value);
+		_mm_stream_si128((__m128i*)(pixel + 12), value);
+	}
+	for (; count >= 4; count -= 4, pixel += 4)
+		_mm_stream_si128((__m128i*)pixel, value);
+	// Make the streamed stores visible before the next regular ones
+	_mm_sfence();
+	fillSpanScalar(pixel, count, color);
+}
+
+// 8 pixels per store
+GRAPHICS_TARGET_AVX2 inline void fillSpanAVX2(_In_ UINT32* pixel, _In_ size_t count, _In_ UINT32 color) {
+	__m256i value = _mm256_set1_epi32((int)color);
+	// Unrolled 32 pixels per iteration
+	for (; count >= 32; count -= 32, pixel += 32) {
+		_mm256_storeu_si256((__m256i*)pixel, value);
+		_mm256_storeu_si256((__m256i*)(pixel + 8), value);
+		_mm256_storeu_si256((__m256i*)(pixel + 16), value);
+		_mm256_storeu_si256((__m256i*)(pixel + 24), value);
+	}
+	for (; count >= 8; count -= 8, pixel += 8)
+		_mm256_storeu_si256((__m256i*)pixel, value);
+	if (count >= 4) {
+		_mm_storeu_si128((__m128i*)pixel, _mm256_castsi256_si128(value));
+		pixel += 4;
+		count -= 4;
+	}
+	fillSpanScalar(pixel, count, color);
+}
+
+// 8 pixels per non-temporal store, bypasses the cache
+GRAPHICS_TARGET_AVX2 inline void fillSpanStreamAVX2(_In_ UINT32* pixel, _In_ size_t count, _In_ UINT32 color) {
+	__m256i value = _mm256_set1_epi32((int)color);
+	pixel = fillUntilAligned(pixel, count, color, 32);
+	for (; count >= 32; count -= 32, pixel += 32) {
+		_mm256_stream_si256((__m256i*)pixel, value);
+		_mm256_stream_si256((__m256i*)(pixel + 8), value);
+		_mm256_stream_si256((__m256i*)(pixel + 16), value);
+		_mm256_stream_si256((__m256i*)(pixel + 24), value);
+	}
+	for (; count >= 8; count -= 8, pixel += 8)
+		_mm256_stream_si256((__m256i*)pixel, value);
+	_mm_sfence();
+	fillSpanScalar(pixel, count, color);
+}
+#endif
+
+// Fill kernels picked for the current CPU
+struct SpanKernels {
+	// Regular (cached) fill
+	FillSpanFunction fill;
+	// Non-temporal fill for the full-frame clears
+	FillSpanFunction fillStream;
+	// Name of the instruction set
+	const char* name;
+};
+
+// Picks the fastest kernels supported by the CPU
+inline SpanKernels selectSpanKernels() {
+#ifdef GRAPHICS_SSE2
+	if (cpuHasAVX2())
+		return { fillSpanAVX2, fillSpanStreamAVX2, "AVX2" };
+	return { fillSpanSSE2, fillSpanStreamSSE2, "SSE2" };
+#else
+	return { fillSpanScalar, fillSpanScalar, "scalar" };
+#endif
+}
+
+// Kernels are selected once, on the first use
+inline const SpanKernels& spanKernels() {
+	static const SpanKernels kernels = selectSpanKernels();
+	return kernels;
+}
+
+// Fills a horizontal span of pixels
+inline void fillSpan(_In_ UINT32* pixel, _In_ size_t count, _In_ UINT32 color) {
+	if (count < shortSpanLength)
+		fillSpanScalar(pixel, count, color);
+	else
+		spanKernels().fill(pixel, count, color);
+}
+
+// Fills an entire frame, big frames bypass the cache
+inline void fillFrame(_In_ UINT32* pixel, _In_ size_t count, _In_ UINT32 color) {
+	if (count * sizeof(UINT32) >= streamingFillThreshold)
+		spanKernels().fillStream(pixel, count, color);
+	else
+		fillSpan(pixel, count, color);
+}
+
+#endif // !GRAPHICS_SPAN_FILL
@@ -0,0 +1,269 @@
+#ifndef GRAPHICS_SWAP_CHAIN
+#define GRAPHICS_SWAP_CHAIN
+
+#include "RenderTarget.hpp"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstring>
+
+// Destination of the frames presented by a SwapChain (a window, a file, nothing at all...)
+template<class Format>
+class BasicPresentSink {
+public:
+	virtual ~BasicPresentSink() {}
+
+	// Pushes the region of the frame that changed since the previous one, called on the present thread
+	// The pixels (in the format of the swap chain, rows are width pixels long) stay untouched until it returns
+	virtual void presentFrame(_In_ const typename Format::Pixel* pixels, _In_ int width, _In_ int height, _In_ const DirtyRegion& region) = 0;
+};
+
+// Ring of 2 - 3 framebuffers with a present thread, the frame N is presented while the frame N + 1 is drawn
+// A buffer is only drawn to again after the present thread is done with it (its fence is signaled)
+// The next buffer is brought up to date by copying the regions that changed since it was drawn, so drawing only
+// what changed every frame still works, apps redrawing the entire frame can turn it off with preserveContents
+template<class Format>
+class BasicSwapChain {
+public:
+	typedef typename Format::Pixel Pixel;
+
+	// Most buffers of a swap chain
+	static const int maxBuffers = 3;
+
+	// Statistics of the presented frames
+	struct Stats {
+		// Frames queued by present()
+		unsigned long long frames = 0;
+		// Frames pushed to the sink by the present thread
+		unsigned long long presented = 0;
+		// Time present() waited for a free buffer (in nanoseconds)
+		unsigned long long fenceWaitNanoseconds = 0;
+		// Bytes copied to bring the next buffers up to date
+		unsigned long long copiedBytes = 0;
+	};
+
+	// If the next buffer gets the changes of the frames drawn since it was drawn to, off if the entire frame is drawn every time
+	bool preserveContents = true;
+
+private:
+	struct Buffer {
+		Pixel* pixels = nullptr;
+		// Region of the frame the buffer holds that has to be presented
+		DirtyRegion region;
+		// Fence of the buffer, set while the frame in it is queued or being presented
+		bool presenting = false;
+	};
+
+	Buffer buffers[maxBuffers];
+	int bufferCount = 0;
+	// Buffer the target draws to
+	int current = 0;
+	int width = 0;
+	int height = 0;
+	size_t bufferSize = 0;
+	BasicPresentSink<Format>* sink = nullptr;
+
+	// Regions that changed in the last bufferCount - 1 frames, the next buffer is missing them
+	DirtyRegion history[maxBuffers - 1];
+	int historyIndex = 0;
+
+	std::thread presentThread;
+	std::mutex mutex;
+	// Wakes the present thread up when a frame is queued
+	std::condition_variable queued;
+	// Signals the fences, wakes present() and waitIdle() up when a frame was presented
+	std::condition_variable presented;
+	// Queued buffers, presented in this order
+	int queue[maxBuffers];
+	int queueStart = 0;
+	int queueLength = 0;
+	bool stopping = false;
+	Stats stats;
+
+	// Presents the queued frames until the swap chain is released
+	void presentLoop() {
+		GRAPHICS_PROFILE_THREAD("present");
+		for (;;) {
+			int index;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				queued.wait(lock, [&] { return stopping || queueLength > 0; });
+				if (queueLength == 0) return;
+				index = queue[queueStart];
+			}
+			// The buffer can't change until its fence is signaled, so it's read without the lock
+			{
+				GRAPHICS_PROFILE_SCOPE("presentFrame");
+				sink->presentFrame(buffers[index].pixels, width, height, buffers[index].region);
+			}
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				buffers[index].presenting = false;
+				queueStart = (queueStart + 1) % maxBuffers;
+				queueLength--;
+				stats.presented++;
+			}
+			presented.notify_all();
+		}
+	}
+
+	// Copies the rectangle of the pixels of a buffer to another one
+	void copyRect(_In_ const Pixel* source, _Out_ Pixel* destination, _In_ const Rect& rect) {
+		for (int y = rect.minPoint.y; y < rect.maxPoint.y; y++) {
+			size_t offset = (size_t)y * width + rect.minPoint.x;
+			memcpy(destination + offset, source + offset, (size_t)rect.width * sizeof(Pixel));
+		}
+	}
+
+public:
+	BasicSwapChain() {}
+	BasicSwapChain(const BasicSwapChain&) = delete;
+	BasicSwapChain& operator=(const BasicSwapChain&) = delete;
+
+	// Makes count (2 - 3) buffers of the size of the target and starts the present thread, returns false if the memory couldn't be allocated
+	// The target is switched to the first buffer with its pixels, the sink has to outlive the swap chain
+	bool create(_Inout_ BasicRenderTarget<Format>& target, _In_ int count, _In_ BasicPresentSink<Format>& presentSink) {
+		release();
+		if (count < 2 || count > maxBuffers || !target.getPixels()) return false;
+		width = target.bitmapWidth;
+		height = target.bitmapHeight;
+		bufferSize = (size_t)width * height * sizeof(Pixel);
+		for (int i = 0; i < count; i++) {
+			// The first buffer gets the pixels of the target right away
+			buffers[i].pixels = (Pixel*)framebufferPool().acquire(bufferSize, i != 0);
+			buffers[i].presenting = false;
+			if (!buffers[i].pixels) {
+				bufferCount = i;
+				release();
+				return false;
+			}
+		}
+		bufferCount = count;
+		current = 0;
+		sink = &presentSink;
+		stats = Stats();
+		// The other buffers start empty, so they're missing everything
+		for (DirtyRegion& region : history) {
+			region.clear();
+			region.add(Rect(vec2<int>(0, 0), vec2<int>(width, height)));
+		}
+		historyIndex = 0;
+		memcpy(buffers[0].pixels, target.getPixels(), bufferSize);
+		target.swapPixels(buffers[0].pixels);
+
+		stopping = false;
+		queueStart = 0;
+		queueLength = 0;
+		presentThread = std::thread(&BasicSwapChain::presentLoop, this);
+		return true;
+	}
+
+	// If the swap chain was created
+	bool isActive() const {
+		return bufferCount > 0;
+	}
+
+	// Number of the buffers
+	int getBufferCount() const {
+		return bufferCount;
+	}
+
+	// Queues the frame drawn to the target for presenting and switches the target to the next buffer
+	// Waits if the next buffer is still being presented, that's at most bufferCount - 1 frames ahead of the present thread
+	void present(_Inout_ BasicRenderTarget<Format>& target) {
+		if (!isActive()) return;
+		Buffer& frame = buffers[current];
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			frame.region = target.getDirtyRegion();
+			frame.presenting = true;
+			queue[(queueStart + queueLength) % maxBuffers] = current;
+			queueLength++;
+			stats.frames++;
+		}
+		queued.notify_one();
+		history[historyIndex] = frame.region;
+		historyIndex = (historyIndex + 1) % (bufferCount - 1);
+		target.finishPresent();
+
+		// Wait for the fence of the next buffer
+		int next = (current + 1) % bufferCount;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			if (buffers[next].presenting) {
+				GRAPHICS_PROFILE_SCOPE("waitForBuffer");
+				auto start = std::chrono::steady_clock::now();
+				presented.wait(lock, [&] { return !buffers[next].presenting; });
+				stats.fenceWaitNanoseconds += (unsigned long long)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+			}
+		}
+
+		// The next buffer holds the frame from bufferCount - 1 frames ago, the frame just queued has everything since then
+		// (it's only read here while the present thread reads it too)
+		if (preserveContents) {
+			DirtyRegion missing;
+			for (int i = 0; i < bufferCount - 1; i++)
+				for (int j = 0; j < history[i].count; j++)
+					missing.add(history[i].rects[j]);
+			for (int i = 0; i < missing.count; i++)
+				copyRect(frame.pixels, buffers[next].pixels, missing.rects[i]);
+			std::lock_guard<std::mutex> lock(mutex);
+			stats.copiedBytes += (unsigned long long)missing.area() * sizeof(Pixel);
+		}
+		current = next;
+		target.swapPixels(buffers[current].pixels);
+	}
+
+	// Waits until all of the queued frames are presented
+	void waitIdle() {
+		if (!isActive()) return;
+		std::unique_lock<std::mutex> lock(mutex);
+		presented.wait(lock, [&] { return queueLength == 0; });
+	}
+
+	// Statistics of the presented frames
+	Stats getStats() {
+		std::lock_guard<std::mutex> lock(mutex);
+		return stats;
+	}
+
+	// Gives the target its own memory with the current pixels again and releases the swap chain
+	void detach(_Inout_ BasicRenderTarget<Format>& target) {
+		if (!isActive()) return;
+		waitIdle();
+		// The new memory is all marked as changed
+		if (target.create(width, height))
+			memcpy(target.getPixels(), buffers[current].pixels, bufferSize);
+		release();
+	}
+
+	// Presents the queued frames, stops the present thread and frees the buffers
+	// A target still drawing to them has to be detached first
+	void release() {
+		if (presentThread.joinable()) {
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				stopping = true;
+			}
+			queued.notify_one();
+			presentThread.join();
+		}
+		for (int i = 0; i < bufferCount; i++) {
+			framebufferPool().release(buffers[i].pixels);
+			buffers[i].pixels = nullptr;
+		}
+		bufferCount = 0;
+		sink = nullptr;
+	}
+
+	~BasicSwapChain() {
+		release();
+	}
+};
+
+// Swap chain and present sink of the windows
+typedef BasicPresentSink<BGRA32> PresentSink;
+typedef BasicSwapChain<BGRA32> SwapChain;
+
+#endif // !GRAPHICS_SWAP_CHAIN
@@ -0,0 +1,302 @@
+#ifndef GRAPHICS_TILE_RENDERER
+#define GRAPHICS_TILE_RENDERER
+
+#include "RenderTarget.hpp"
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+// Command drawn in a tile, curves only draw their segments from firstSegment to lastSegment there
+struct TileCommand {
+	unsigned int command;
+	int firstSegment;
+	int lastSegment;
+};
+
+// Draws recorded command lists with a pool of worker threads
+// The commands are binned by the screen tiles they touch, then every tile draws its commands in the recorded order
+// clipped to the tile, so the pixels are exactly the same as if the commands were drawn right away
+template<class Format>
+class BasicTileRenderer {
+private:
+	// Worker threads, the thread calling render() draws tiles too
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	// Wakes the workers up when there are tiles to draw
+	std::condition_variable wake;
+	// Wakes render() up when all of the workers are done
+	std::condition_variable done;
+	// Incremented for every rendered list
+	unsigned long long generation = 0;
+	// Number of the workers still drawing the current list
+	int busyWorkers = 0;
+	bool stopping = false;
+
+	// Target and list of the current render() call
+	BasicRenderTarget<Format>* target = nullptr;
+	const DrawCommandList* list = nullptr;
+	// Commands touching each tile, in the recorded order
+	std::vector<std::vector<TileCommand>> bins;
+	// Tiles with at least one command
+	std::vector<int> activeTiles;
+	// Index of the next active tile to draw
+	std::atomic<int> nextTile{ 0 };
+	// Size of the tile grid
+	int tilesX = 0;
+	int tilesY = 0;
+	int binTileSize = 0;
+
+	// Adds the command (or a segment of a curve) to the bin of the tile, curves already there are extended up to the segment
+	void addToBin(_In_ int tileX, _In_ int tileY, _In_ unsigned int command, _In_opt_ int segment = 0) {
+		std::vector<TileCommand>& bin = bins[(size_t)tileY * tilesX + tileX];
+		if (!bin.empty() && bin.back().command == command)
+			bin.back().lastSegment = segment;
+		else
+			bin.push_back(TileCommand{ command, segment, segment });
+	}
+
+	// Adds the command to the bins of all of the tiles the rectangle (max exclusive) touches
+	void binRect(_In_ const Rect& rect, _In_ unsigned int command) {
+		for (int tileY = rect.minPoint.y / binTileSize; tileY <= (rect.maxPoint.y - 1) / binTileSize; tileY++)
+			for (int tileX = rect.minPoint.x / binTileSize; tileX <= (rect.maxPoint.x - 1) / binTileSize; tileX++)
+				addToBin(tileX, tileY, command);
+	}
+
+	// Adds the command to the bins of the tiles the segment (widened by the margin) crosses, inside of the bounds
+	// Long lines cross a lot fewer tiles than their bounding box does
+	void binSegment(_In_ vec2<int> p1, _In_ vec2<int> p2, _In_ int margin, _In_ const Rect& bounds, _In_ unsigned int command, _In_opt_ int segment = 0) {
+		if (p1.y > p2.y) {
+			vec2<int> swap = p1;
+			p1 = p2;
+			p2 = swap;
+		}
+		int boundsMinTileX = bounds.minPoint.x / binTileSize;
+		int boundsMaxTileX = (bounds.maxPoint.x - 1) / binTileSize;
+		// The ends can be anywhere in the int range, the margins are added in 64 bits and the slope is computed in doubles
+		int minTileY = ((long long)p1.y - margin > bounds.minPoint.y ? p1.y - margin : bounds.minPoint.y) / binTileSize;
+		int maxTileY = ((long long)p2.y + margin < bounds.maxPoint.y - 1 ? p2.y + margin : bounds.maxPoint.y - 1) / binTileSize;
+		double slope = p1.y != p2.y ? ((double)p2.x - p1.x) / ((double)p2.y - p1.y) : 0.0;
+		for (int tileY = minTileY; tileY <= maxTileY; tileY++) {
+			// Part of the segment close enough to the rows of the tile, the pixels of a row of the thin line are up to half a row
+			// away from the segment (the thick lines are drawn around them)
+			int minY = tileY * binTileSize - margin;
+			int maxY = (tileY + 1) * binTileSize - 1 + margin;
+			double x1 = p1.x, x2 = p2.x;
+			if (p1.y != p2.y) {
+				x1 = p1.x + slope * (minY - 0.5 > p1.y ? minY - 0.5 - p1.y : 0.0);
+				x2 = p1.x + slope * (maxY + 0.5 < p2.y ? maxY + 0.5 - p1.y : (double)p2.y - p1.y);
+			}
+			// Columns are converted to int only inside of the bounds
+			double minX = floor(x1 < x2 ? x1 : x2) - margin - 1;
+			double maxX = ceil(x1 < x2 ? x2 : x1) + margin + 1;
+			if (maxX < bounds.minPoint.x || minX >= bounds.maxPoint.x) continue;
+			int minTileX = minX > bounds.minPoint.x ? (int)minX / binTileSize : boundsMinTileX;
+			int maxTileX = maxX < bounds.maxPoint.x - 1 ? (int)maxX / binTileSize : boundsMaxTileX;
+			for (int tileX = minTileX; tileX <= maxTileX; tileX++)
+				addToBin(tileX, tileY, command, segment);
+		}
+	}
+
+	// Adds the command to the bins of the tiles with pixels between the inner and the outer radius
+	// (inner exclusive, at most 0 for a filled circle)
+	void binRing(_In_ vec2<int> origin, _In_ int innerRadius, _In_ int outerRadius, _In_ const Rect& bounds, _In_ unsigned int command) {
+		long long innerSq = (long long)innerRadius * innerRadius;
+		long long outerSq = (long long)outerRadius * outerRadius;
+		for (int tileY = bounds.minPoint.y / binTileSize; tileY <= (bounds.maxPoint.y - 1) / binTileSize; tileY++)
+			for (int tileX = bounds.minPoint.x / binTileSize; tileX <= (bounds.maxPoint.x - 1) / binTileSize; tileX++) {
+				int minX = tileX * binTileSize - origin.x;
+				int minY = tileY * binTileSize - origin.y;
+				int maxX = minX + binTileSize - 1;
+				int maxY = minY + binTileSize - 1;
+				// Closest and farthest pixel of the tile
+				long long nearX = minX > 0 ? minX : maxX < 0 ? maxX : 0;
+				long long nearY = minY > 0 ? minY : maxY < 0 ? maxY : 0;
+				long long farX = -minX > maxX ? minX : maxX;
+				long long farY = -minY > maxY ? minY : maxY;
+				if (nearX * nearX + nearY * nearY > outerSq) continue;
+				if (innerRadius > 0 && farX * farX + farY * farY < innerSq) continue;
+				addToBin(tileX, tileY, command);
+			}
+	}
+
+	// Bins the commands of the list by the tiles they touch
+	void binCommands() {
+		tilesX = (target->bitmapWidth + tileSize - 1) / tileSize;
+		tilesY = (target->bitmapHeight + tileSize - 1) / tileSize;
+		binTileSize = tileSize;
+		if (bins.size() < (size_t)tilesX * tilesY)
+			bins.resize((size_t)tilesX * tilesY);
+		for (std::vector<TileCommand>& bin : bins)
+			bin.clear();
+
+		for (size_t i = 0; i < list->commands.size(); i++) {
+			const DrawCommand& command = list->commands[i];
+			const Rect& bounds = command.bounds;
+			unsigned int index = (unsigned int)i;
+			if (bounds.width <= 0 || bounds.height <= 0) continue;
+			switch (command.type) {
+			case DrawCommandType::Clear:
+				// Clearing overwrites the tiles entirely inside of the clip rectangle, so nothing drawn before it there is visible
+				for (int tileY = bounds.minPoint.y / binTileSize; tileY <= (bounds.maxPoint.y - 1) / binTileSize; tileY++)
+					for (int tileX = bounds.minPoint.x / binTileSize; tileX <= (bounds.maxPoint.x - 1) / binTileSize; tileX++) {
+						Rect tileRect = target->clipToBitmap(tileX * binTileSize, tileY * binTileSize, (tileX + 1) * binTileSize, (tileY + 1) * binTileSize);
+						if (containsRect(bounds, tileRect))
+							bins[(size_t)tileY * tilesX + tileX].clear();
+						addToBin(tileX, tileY, index);
+					}
+				break;
+			case DrawCommandType::Line:
+				// Thin lines are at most half a row away from the segment, thick ones are the circles around their pixels
+				binSegment(command.points[0], command.points[1], command.thickness > 1 ? command.thickness : 1, bounds, index);
+				break;
+			case DrawCommandType::QuadraticBezier:
+			case DrawCommandType::CubicBezier: {
+				const vec2<int>* points = list->getPoints(command);
+				if (command.size == 1)
+					binRect(bounds, index);
+				for (int point = 0; point + 1 < command.size; point++)
+					binSegment(points[point], points[point + 1], command.thickness > 1 ? command.thickness : 1, bounds, index, point);
+				break;
+			}
+			case DrawCommandType::Circle:
+				binRing(command.points[0], 0, command.size, bounds, index);
+				break;
+			case DrawCommandType::EmptyCircle:
+				// Outlines (thickness up to 1) go at most 3 pixels inside of the radius
+				if (command.thickness <= 1)
+					binRing(command.points[0], command.size - 3, command.size, bounds, index);
+				else
+					binRing(command.points[0], command.size - command.thickness - 1, command.size + command.thickness, bounds, index);
+				break;
+			case DrawCommandType::AntialiasedLine:
+				binSegment(command.points[0], command.points[1], command.thickness + 2, bounds, index);
+				break;
+			case DrawCommandType::AntialiasedCircle:
+				binRing(command.points[0], 0, command.size + 2, bounds, index);
+				break;
+			case DrawCommandType::AntialiasedEmptyCircle:
+				binRing(command.points[0], command.size - command.thickness - 2, command.size + command.thickness + 2, bounds, index);
+				break;
+			default:
+				binRect(bounds, index);
+				break;
+			}
+		}
+
+		activeTiles.clear();
+		for (int tile = 0; tile < tilesX * tilesY; tile++)
+			if (!bins[tile].empty())
+				activeTiles.push_back(tile);
+	}
+
+	// Draws the active tiles until there are none left, view is attached to the target pixels
+	void drawTiles(_Inout_ BasicRenderTarget<Format>& view) {
+		GRAPHICS_PROFILE_SCOPE("drawTiles");
+		for (;;) {
+			int index = nextTile.fetch_add(1);
+			if (index >= (int)activeTiles.size()) return;
+			int tile = activeTiles[index];
+			int minX = (tile % tilesX) * binTileSize;
+			int minY = (tile / tilesX) * binTileSize;
+			Rect tileRect = view.clipToBitmap(minX, minY, minX + binTileSize, minY + binTileSize);
+			for (const TileCommand& entry : bins[tile]) {
+				const DrawCommand& command = list->commands[entry.command];
+				// The bounds keep the clip rectangle the command was recorded with
+				view.setClip(intersectRect(tileRect, command.bounds));
+				if (command.type == DrawCommandType::QuadraticBezier || command.type == DrawCommandType::CubicBezier)
+					view.plotPolyline(list->getPoints(command), command.size, command.color, command.thickness, entry.firstSegment, entry.lastSegment);
+				else
+					view.execute(command, *list);
+			}
+		}
+	}
+
+	// Waits for the lists to draw until the renderer is destroyed
+	void workerLoop() {
+		GRAPHICS_PROFILE_THREAD("tile worker");
+		BasicRenderTarget<Format> view;
+		unsigned long long seenGeneration = 0;
+		for (;;) {
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				wake.wait(lock, [&] { return stopping || generation != seenGeneration; });
+				if (stopping) return;
+				seenGeneration = generation;
+			}
+			view.attach(target->getPixels(), target->bitmapWidth, target->bitmapHeight);
+			drawTiles(view);
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				if (--busyWorkers == 0)
+					done.notify_one();
+			}
+		}
+	}
+
+public:
+	// Size of the square tiles (in pixels)
+	int tileSize = 128;
+
+	// Starts the worker threads, threadCount includes the thread calling render(), 0 uses all of the hardware threads
+	explicit BasicTileRenderer(_In_opt_ int threadCount = 0) {
+		if (threadCount <= 0)
+			threadCount = (int)std::thread::hardware_concurrency();
+		for (int i = 1; i < threadCount; i++)
+			workers.push_back(std::thread([this] { workerLoop(); }));
+	}
+
+	BasicTileRenderer(const BasicTileRenderer&) = delete;
+	BasicTileRenderer& operator=(const BasicTileRenderer&) = delete;
+
+	// Number of the threads drawing the tiles (including the one calling render())
+	int getThreadCount() const {
+		return (int)workers.size() + 1;
+	}
+
+	// Draws the list to the target, returns after all of the tiles are drawn
+	// The commands have to be recorded by a target of the same size, they're already marked as changed by then
+	void render(_Inout_ BasicRenderTarget<Format>& renderTarget, _In_ const DrawCommandList& commandList) {
+		if (commandList.empty() || !renderTarget.getPixels()) return;
+		GRAPHICS_PROFILE_SCOPE("TileRenderer::render");
+		target = &renderTarget;
+		list = &commandList;
+		{
+			GRAPHICS_PROFILE_SCOPE("binCommands");
+			binCommands();
+		}
+		nextTile = 0;
+
+		if (!workers.empty() && activeTiles.size() > 1) {
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				busyWorkers = (int)workers.size();
+				generation++;
+			}
+			wake.notify_all();
+		}
+
+		BasicRenderTarget<Format> view;
+		view.attach(target->getPixels(), target->bitmapWidth, target->bitmapHeight);
+		drawTiles(view);
+
+		std::unique_lock<std::mutex> lock(mutex);
+		done.wait(lock, [&] { return busyWorkers == 0; });
+	}
+
+	~BasicTileRenderer() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		wake.notify_all();
+		for (std::thread& worker : workers)
+			worker.join();
+	}
+};
+
+// Tile renderer of the windows
+typedef BasicTileRenderer<BGRA32> TileRenderer;
+
+#endif // !GRAPHICS_TILE_RENDERER
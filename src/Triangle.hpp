@@ -0,0 +1,435 @@
+#ifndef GRAPHICS_TRIANGLE
+#define GRAPHICS_TRIANGLE
+
+#include "Platform.hpp"
+#include "Geometry.hpp"
+#include "SpanFill.hpp"
+#include <cstdint>
+#include <cmath>
+
+// Vertices are in fixed point with this many fractional bits (1/16 of a pixel)
+const int subpixelBits = 4;
+const int subpixelScale = 1 << subpixelBits;
+// Triangles are rasterized in blocks of triangleBlockSize x triangleBlockSize pixels
+const int triangleBlockSize = 8;
+// Triangles with the bounding box up to this size (in pixels) skip the block classification and are evaluated directly
+const int smallTriangleSize = 64;
+// Small triangles up to this many pixels wide are a single step of the AVX2 kernel per row
+const int tinyTriangleSize = 8;
+// Vertices further than this from the origin (in pixels) aren't drawn, it keeps the per block edge values in 32 bits
+const int triangleMaxCoordinate = 1 << 17;
+
+// Converts a vertex to the fixed point, returns false if it's too far from the origin to be drawn
+inline bool toSubpixel(_In_ vec2<float> vertex, _Out_ vec2<int>& fixed) {
+	const float limit = (float)triangleMaxCoordinate;
+	if (!(vertex.x >= -limit && vertex.x <= limit && vertex.y >= -limit && vertex.y <= limit))
+		return false;
+	fixed = vec2<int>((int)lrintf(vertex.x * subpixelScale), (int)lrintf(vertex.y * subpixelScale));
+	return true;
+}
+
+// Edge functions of the evaluated area (a partially covered block or a whole small triangle)
+// The pixel is covered if all 3 values are >= 0
+template<class Pixel>
+struct BasicTriangleBlock {
+	// Value of each edge function at the top left pixel of the area
+	int32_t edge[3];
+	// Change of each edge function per pixel to the right and per row down
+	int32_t stepX[3];
+	int32_t stepY[3];
+	// First pixel of the area in the bitmap
+	Pixel* row;
+	// Distance between the bitmap rows (in pixels)
+	int pitch;
+	// Covered part of the area after clipping, relative to its top left pixel
+	int minX, minY, maxX, maxY;
+	// Pixels before this one are in the clip rectangle, so they can be read and written back unchanged
+	int clipX;
+};
+
+// Block of the 32bpp targets, the SIMD kernels below are written for it
+typedef BasicTriangleBlock<UINT32> TriangleBlock;
+
+// Fills the covered pixels of the area
+typedef void (*CoverBlockFunction)(const TriangleBlock& block, UINT32 color);
+
+// Scalar fallback, steps the edge functions pixel by pixel, also used by the pixel formats without SIMD kernels
+// The steps are copied first, the pixel writes could alias the block and reload them every pixel
+template<class Pixel>
+inline void coverBlockScalar(_In_ const BasicTriangleBlock<Pixel>& block, _In_ Pixel color) {
+	const int32_t stepX0 = block.stepX[0], stepX1 = block.stepX[1], stepX2 = block.stepX[2];
+	const int32_t stepY0 = block.stepY[0], stepY1 = block.stepY[1], stepY2 = block.stepY[2];
+	const int minX = block.minX, maxX = block.maxX, pitch = block.pitch;
+	int32_t row0 = block.edge[0] + minX * stepX0 + block.minY * stepY0;
+	int32_t row1 = block.edge[1] + minX * stepX1 + block.minY * stepY1;
+	int32_t row2 = block.edge[2] + minX * stepX2 + block.minY * stepY2;
+	Pixel* row = block.row + block.minY * pitch;
+	for (int y = block.minY; y < block.maxY; y++, row += pitch) {
+		int32_t e0 = row0, e1 = row1, e2 = row2;
+		for (int x = minX; x < maxX; x++) {
+			if ((e0 | e1 | e2) >= 0)
+				row[x] = color;
+			e0 += stepX0;
+			e1 += stepX1;
+			e2 += stepX2;
+		}
+		row0 += stepY0;
+		row1 += stepY1;
+		row2 += stepY2;
+	}
+}
+
+#ifdef GRAPHICS_SSE2
+// 4 pixels per step
+inline void coverBlockSSE2(_In_ const TriangleBlock& block, _In_ UINT32 color) {
+	__m128i value = _mm_set1_epi32((int)color);
+	__m128i lanes = _mm_setr_epi32(0, 1, 2, 3);
+	__m128i edge[3];
+	__m128i stepX4[3];
+	__m128i stepY[3];
+	for (int i = 0; i < 3; i++) {
+		int first = block.edge[i] + block.minX * block.stepX[i] + block.minY * block.stepY[i];
+		int step = block.stepX[i];
+		// x * stepX without the SSE4.1 multiplication
+		edge[i] = _mm_setr_epi32(first, first + step, first + 2 * step, first + 3 * step);
+		stepX4[i] = _mm_set1_epi32(4 * step);
+		stepY[i] = _mm_set1_epi32(block.stepY[i]);
+	}
+
+	UINT32* row = block.row + block.minY * block.pitch + block.minX;
+	int width = block.maxX - block.minX;
+	for (int y = block.minY; y < block.maxY; y++, row += block.pitch) {
+		__m128i e0 = edge[0], e1 = edge[1], e2 = edge[2];
+		for (int x = 0; x < width; x += 4) {
+			// Sign bit of any edge set means outside, lanes after the width belong to the next block
+			__m128i outside = _mm_or_si128(_mm_or_si128(e0, e1), e2);
+			__m128i covered = _mm_andnot_si128(_mm_srai_epi32(outside, 31), _mm_cmplt_epi32(lanes, _mm_set1_epi32(width - x)));
+			UINT32* pixel = row + x;
+			if (block.minX + x + 4 <= block.clipX) {
+				// Pixels outside of the triangle are written back unchanged, it's faster than branching on the mask
+				__m128i old = _mm_loadu_si128((const __m128i*)pixel);
+				_mm_storeu_si128((__m128i*)pixel, _mm_or_si128(_mm_andnot_si128(covered, old), _mm_and_si128(covered, value)));
+			}
+			else
+				// The last pixels of the row, the ones after the clip rectangle may not even be in the bitmap
+				for (int mask = _mm_movemask_ps(_mm_castsi128_ps(covered)); mask != 0; mask &= mask - 1)
+					pixel[countTrailingZeros((unsigned int)mask)] = color;
+			e0 = _mm_add_epi32(e0, stepX4[0]);
+			e1 = _mm_add_epi32(e1, stepX4[1]);
+			e2 = _mm_add_epi32(e2, stepX4[2]);
+		}
+		for (int i = 0; i < 3; i++)
+			edge[i] = _mm_add_epi32(edge[i], stepY[i]);
+	}
+}
+
+// 4 pixels per step for the pixels narrower than 32 bits, the edges are evaluated with SSE2 and only the covered pixels are written
+template<class Pixel>
+inline void coverBlockMaskSSE2(_In_ const BasicTriangleBlock<Pixel>& block, _In_ Pixel color) {
+	__m128i lanes = _mm_setr_epi32(0, 1, 2, 3);
+	__m128i edge[3];
+	__m128i stepX4[3];
+	__m128i stepY[3];
+	for (int i = 0; i < 3; i++) {
+		int first = block.edge[i] + block.minX * block.stepX[i] + block.minY * block.stepY[i];
+		int step = block.stepX[i];
+		edge[i] = _mm_setr_epi32(first, first + step, first + 2 * step, first + 3 * step);
+		stepX4[i] = _mm_set1_epi32(4 * step);
+		stepY[i] = _mm_set1_epi32(block.stepY[i]);
+	}
+
+	Pixel* row = block.row + block.minY * block.pitch + block.minX;
+	int width = block.maxX - block.minX;
+	for (int y = block.minY; y < block.maxY; y++, row += block.pitch) {
+		__m128i e0 = edge[0], e1 = edge[1], e2 = edge[2];
+		for (int x = 0; x < width; x += 4) {
+			__m128i outside = _mm_or_si128(_mm_or_si128(e0, e1), e2);
+			__m128i covered = _mm_andnot_si128(_mm_srai_epi32(outside, 31), _mm_cmplt_epi32(lanes, _mm_set1_epi32(width - x)));
+			Pixel* pixel = row + x;
+			int mask = _mm_movemask_ps(_mm_castsi128_ps(covered));
+			if (mask == 0xF) {
+				pixel[0] = color;
+				pixel[1] = color;
+				pixel[2] = color;
+				pixel[3] = color;
+			}
+			else
+				for (; mask != 0; mask &= mask - 1)
+					pixel[countTrailingZeros((unsigned int)mask)] = color;
+			e0 = _mm_add_epi32(e0, stepX4[0]);
+			e1 = _mm_add_epi32(e1, stepX4[1]);
+			e2 = _mm_add_epi32(e2, stepX4[2]);
+		}
+		for (int i = 0; i < 3; i++)
+			edge[i] = _mm_add_epi32(edge[i], stepY[i]);
+	}
+}
+
+// 8 pixels per step
+GRAPHICS_TARGET_AVX2 inline void coverBlockAVX2(_In_ const TriangleBlock& block, _In_ UINT32 color) {
+	__m256i value = _mm256_set1_epi32((int)color);
+	__m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	__m256i edge[3];
+	__m256i stepX8[3];
+	__m256i stepY[3];
+	for (int i = 0; i < 3; i++) {
+		int first = block.edge[i] + block.minX * block.stepX[i] + block.minY * block.stepY[i];
+		edge[i] = _mm256_add_epi32(_mm256_set1_epi32(first), _mm256_mullo_epi32(lanes, _mm256_set1_epi32(block.stepX[i])));
+		stepX8[i] = _mm256_set1_epi32(8 * block.stepX[i]);
+		stepY[i] = _mm256_set1_epi32(block.stepY[i]);
+	}
+
+	UINT32* row = block.row + block.minY * block.pitch + block.minX;
+	int width = block.maxX - block.minX;
+	for (int y = block.minY; y < block.maxY; y++, row += block.pitch) {
+		__m256i e0 = edge[0], e1 = edge[1], e2 = edge[2];
+		for (int x = 0; x < width; x += 8) {
+			// Sign bit of any edge set means outside, lanes after the width belong to the next block
+			__m256i outside = _mm256_or_si256(_mm256_or_si256(e0, e1), e2);
+			__m256i covered = _mm256_andnot_si256(_mm256_srai_epi32(outside, 31), _mm256_cmpgt_epi32(_mm256_set1_epi32(width - x), lanes));
+			UINT32* pixel = row + x;
+			if (block.minX + x + 8 <= block.clipX)
+				// Pixels outside of the triangle are written back unchanged, it's faster than branching on the mask
+				// (and much faster than the masked stores)
+				_mm256_storeu_si256((__m256i*)pixel, _mm256_blendv_epi8(_mm256_loadu_si256((const __m256i*)pixel), value, covered));
+			else
+				// The last pixels of the row, the ones after the clip rectangle may not even be in the bitmap
+				for (int mask = _mm256_movemask_ps(_mm256_castsi256_ps(covered)); mask != 0; mask &= mask - 1)
+					pixel[countTrailingZeros((unsigned int)mask)] = color;
+			e0 = _mm256_add_epi32(e0, stepX8[0]);
+			e1 = _mm256_add_epi32(e1, stepX8[1]);
+			e2 = _mm256_add_epi32(e2, stepX8[2]);
+		}
+		edge[0] = _mm256_add_epi32(edge[0], stepY[0]);
+		edge[1] = _mm256_add_epi32(edge[1], stepY[1]);
+		edge[2] = _mm256_add_epi32(edge[2], stepY[2]);
+	}
+}
+
+// Whole small triangle (the bounding box up to smallTriangleSize pixels) with the masked stores, 8 pixels per step
+// Unlike the blocks of the big triangles the small ones are usually next to each other in a mesh, the neighbours write the same rows
+// and reading them back for coverBlockAVX2 waits for those stores. The masked stores never read the pixels and don't touch the pixels
+// after the clip rectangle. The tiny ones (up to tinyTriangleSize pixels wide) walk their rows without the loop over the steps
+GRAPHICS_TARGET_AVX2 inline void coverSmallTriangleAVX2(_In_ const TriangleBlock& block, _In_ UINT32 color) {
+	__m256i value = _mm256_set1_epi32((int)color);
+	__m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	__m256i e0 = _mm256_add_epi32(_mm256_set1_epi32(block.edge[0]), _mm256_mullo_epi32(lanes, _mm256_set1_epi32(block.stepX[0])));
+	__m256i e1 = _mm256_add_epi32(_mm256_set1_epi32(block.edge[1]), _mm256_mullo_epi32(lanes, _mm256_set1_epi32(block.stepX[1])));
+	__m256i e2 = _mm256_add_epi32(_mm256_set1_epi32(block.edge[2]), _mm256_mullo_epi32(lanes, _mm256_set1_epi32(block.stepX[2])));
+	__m256i stepY0 = _mm256_set1_epi32(block.stepY[0]);
+	__m256i stepY1 = _mm256_set1_epi32(block.stepY[1]);
+	__m256i stepY2 = _mm256_set1_epi32(block.stepY[2]);
+	// The stores could alias the block, so its fields are copied first
+	const int width = block.maxX;
+	const int height = block.maxY;
+	const int pitch = block.pitch;
+	UINT32* row = block.row;
+
+	if (width <= tinyTriangleSize) {
+		__m256i inside = _mm256_cmpgt_epi32(_mm256_set1_epi32(width), lanes);
+		for (int y = 0; y < height; y++, row += pitch) {
+			__m256i outside = _mm256_or_si256(_mm256_or_si256(e0, e1), e2);
+			_mm256_maskstore_epi32((int*)row, _mm256_andnot_si256(_mm256_srai_epi32(outside, 31), inside), value);
+			e0 = _mm256_add_epi32(e0, stepY0);
+			e1 = _mm256_add_epi32(e1, stepY1);
+			e2 = _mm256_add_epi32(e2, stepY2);
+		}
+		return;
+	}
+
+	__m256i stepX0 = _mm256_set1_epi32(8 * block.stepX[0]);
+	__m256i stepX1 = _mm256_set1_epi32(8 * block.stepX[1]);
+	__m256i stepX2 = _mm256_set1_epi32(8 * block.stepX[2]);
+	for (int y = 0; y < height; y++, row += pitch) {
+		__m256i r0 = e0, r1 = e1, r2 = e2;
+		for (int x = 0; x < width; x += 8) {
+			__m256i outside = _mm256_or_si256(_mm256_or_si256(r0, r1), r2);
+			__m256i covered = _mm256_andnot_si256(_mm256_srai_epi32(outside, 31), _mm256_cmpgt_epi32(_mm256_set1_epi32(width - x), lanes));
+			_mm256_maskstore_epi32((int*)(row + x), covered, value);
+			r0 = _mm256_add_epi32(r0, stepX0);
+			r1 = _mm256_add_epi32(r1, stepX1);
+			r2 = _mm256_add_epi32(r2, stepX2);
+		}
+		e0 = _mm256_add_epi32(e0, stepY0);
+		e1 = _mm256_add_epi32(e1, stepY1);
+		e2 = _mm256_add_epi32(e2, stepY2);
+	}
+}
+#endif
+
+// Picks the fastest kernel supported by the CPU, selected once on the first use
+inline CoverBlockFunction coverBlockKernel() {
+#ifdef GRAPHICS_SSE2
+	static const CoverBlockFunction kernel = cpuHasAVX2() ? coverBlockAVX2 : coverBlockSSE2;
+	return kernel;
+#else
+	return coverBlockScalar<UINT32>;
+#endif
+}
+
+// Picks the kernel of the whole small triangles, without AVX2 they're filled like a block
+inline CoverBlockFunction coverSmallTriangleKernel() {
+#ifdef GRAPHICS_SSE2
+	static const CoverBlockFunction kernel = cpuHasAVX2() ? coverSmallTriangleAVX2 : coverBlockSSE2;
+	return kernel;
+#else
+	return coverBlockScalar<UINT32>;
+#endif
+}
+
+// Rasterizes a triangle with the top left fill rule, vertices are in the fixed point (subpixelBits)
+// Pixel (x, y) is sampled at (x, y), so pixels on the edges shared by 2 triangles are drawn exactly once
+// Only pixels inside of [clipMinX, clipMaxX) x [clipMinY, clipMaxY) are written, the blocks are filled with the kernels of the pixel format
+template<class Format>
+inline void rasterizeTriangle(_In_ typename Format::Pixel* pixels, _In_ int pitch, _In_ int clipMinX, _In_ int clipMinY, _In_ int clipMaxX, _In_ int clipMaxY,
+	_In_ vec2<int> v0, _In_ vec2<int> v1, _In_ vec2<int> v2, _In_ typename Format::Pixel color) {
+	typedef typename Format::Pixel Pixel;
+	// Bounding box of the vertices
+	int minX = (v0.x < v1.x ? (v0.x < v2.x ? v0.x : v2.x) : (v1.x < v2.x ? v1.x : v2.x));
+	int minY = (v0.y < v1.y ? (v0.y < v2.y ? v0.y : v2.y) : (v1.y < v2.y ? v1.y : v2.y));
+	int maxX = (v0.x > v1.x ? (v0.x > v2.x ? v0.x : v2.x) : (v1.x > v2.x ? v1.x : v2.x));
+	int maxY = (v0.y > v1.y ? (v0.y > v2.y ? v0.y : v2.y) : (v1.y > v2.y ? v1.y : v2.y));
+	const int maxFixed = triangleMaxCoordinate << subpixelBits;
+	if (minX < -maxFixed || minY < -maxFixed || maxX > maxFixed || maxY > maxFixed)
+		return;
+
+	// Order the vertices so the inside is where all of the edge functions are positive
+	long long area = (long long)(v1.x - v0.x) * (v2.y - v0.y) - (long long)(v1.y - v0.y) * (v2.x - v0.x);
+	if (area == 0) return;
+	if (area < 0) {
+		vec2<int> temp = v1;
+		v1 = v2;
+		v2 = temp;
+	}
+
+	// Covered pixel centers
+	minX = (minX + subpixelScale - 1) >> subpixelBits;
+	minY = (minY + subpixelScale - 1) >> subpixelBits;
+	maxX = (maxX >> subpixelBits) + 1;
+	maxY = (maxY >> subpixelBits) + 1;
+	// Edge values of small triangles always fit in 32 bits
+	bool small = maxX - minX <= smallTriangleSize && maxY - minY <= smallTriangleSize;
+	if (minX < clipMinX) minX = clipMinX;
+	if (minY < clipMinY) minY = clipMinY;
+	if (maxX > clipMaxX) maxX = clipMaxX;
+	if (maxY > clipMaxY) maxY = clipMaxY;
+	if (minX >= maxX || minY >= maxY) return;
+
+	// Edge function of the edge a -> b at the pixel p: (b - a) x (p - a), the pixels exactly on the edge
+	// are only covered if it's a top edge (horizontal with the inside below it) or a left edge
+	const vec2<int> ends[3][2] = { { v0, v1 }, { v1, v2 }, { v2, v0 } };
+	BasicTriangleBlock<Pixel> block;
+	block.pitch = pitch;
+
+	if (small) {
+		// The whole bounding box at once, relative to its top left pixel
+		int originX = minX << subpixelBits;
+		int originY = minY << subpixelBits;
+		for (int i = 0; i < 3; i++) {
+			int ex = ends[i][1].x - ends[i][0].x;
+			int ey = ends[i][1].y - ends[i][0].y;
+			bool topLeft = ey < 0 || (ey == 0 && ex > 0);
+			block.edge[i] = ey * (ends[i][0].x - originX) - ex * (ends[i][0].y - originY) - (topLeft ? 0 : 1);
+			block.stepX[i] = -ey * subpixelScale;
+			block.stepY[i] = ex * subpixelScale;
+		}
+		block.row = pixels + (size_t)minY * pitch + minX;
+		block.minX = 0;
+		block.minY = 0;
+		block.maxX = maxX - minX;
+		block.maxY = maxY - minY;
+		block.clipX = clipMaxX - minX;
+		Format::coverSmallTriangle(block, color);
+		return;
+	}
+
+	int startX = minX & ~(triangleBlockSize - 1);
+	int startY = minY & ~(triangleBlockSize - 1);
+	long long edgeStart[3];
+	long long stepX[3];
+	long long stepY[3];
+	for (int i = 0; i < 3; i++) {
+		const vec2<int>& a = ends[i][0];
+		const vec2<int>& b = ends[i][1];
+		long long ex = b.x - a.x;
+		long long ey = b.y - a.y;
+		bool topLeft = ey < 0 || (ey == 0 && ex > 0);
+		stepX[i] = -ey * subpixelScale;
+		stepY[i] = ex * subpixelScale;
+		edgeStart[i] = ex * ((long long)startY * subpixelScale - a.y) - ey * ((long long)startX * subpixelScale - a.x) - (topLeft ? 0 : 1);
+	}
+
+	// Range of each edge function over a block relative to its top left pixel
+	const int last = triangleBlockSize - 1;
+	long long lowOffset[3];
+	long long highOffset[3];
+	for (int i = 0; i < 3; i++) {
+		lowOffset[i] = (stepX[i] < 0 ? last * stepX[i] : 0) + (stepY[i] < 0 ? last * stepY[i] : 0);
+		highOffset[i] = (stepX[i] > 0 ? last * stepX[i] : 0) + (stepY[i] > 0 ? last * stepY[i] : 0);
+	}
+
+	for (int blockY = startY; blockY < maxY; blockY += triangleBlockSize) {
+		block.minY = minY > blockY ? minY - blockY : 0;
+		block.maxY = maxY < blockY + triangleBlockSize ? maxY - blockY : triangleBlockSize;
+		Pixel* blockRow = pixels + (size_t)blockY * pitch;
+		long long corner[3];
+		for (int i = 0; i < 3; i++)
+			corner[i] = edgeStart[i] + (blockY - startY) / triangleBlockSize * (triangleBlockSize * stepY[i]);
+
+		// Neighbouring fully covered blocks are filled together as longer spans
+		int acceptedFrom = -1;
+		int acceptedTo = -1;
+		for (int blockX = startX; blockX < maxX; blockX += triangleBlockSize) {
+			block.minX = minX > blockX ? minX - blockX : 0;
+			block.maxX = maxX < blockX + triangleBlockSize ? maxX - blockX : triangleBlockSize;
+
+			// Trivial reject if any edge is negative in the whole block, trivial accept if all of them are positive
+			bool accept = true;
+			bool reject = false;
+			for (int i = 0; i < 3 && !reject; i++) {
+				if (corner[i] + highOffset[i] < 0)
+					reject = true;
+				else if (corner[i] + lowOffset[i] >= 0) {
+					// Always covered, doesn't have to be evaluated (and could overflow 32 bits)
+					block.edge[i] = 0;
+					block.stepX[i] = 0;
+					block.stepY[i] = 0;
+				}
+				else {
+					// The edge crosses the block, so the values in the block are small
+					accept = false;
+					block.edge[i] = (int32_t)corner[i];
+					block.stepX[i] = (int32_t)stepX[i];
+					block.stepY[i] = (int32_t)stepY[i];
+				}
+			}
+			for (int i = 0; i < 3; i++)
+				corner[i] += triangleBlockSize * stepX[i];
+
+			if (!reject && accept) {
+				if (acceptedFrom < 0)
+					acceptedFrom = blockX + block.minX;
+				acceptedTo = blockX + block.maxX;
+				continue;
+			}
+			if (!reject) {
+				block.row = blockRow + blockX;
+				block.clipX = clipMaxX - blockX;
+				Format::coverBlock(block, color);
+			}
+			if (acceptedFrom >= 0) {
+				Pixel* row = blockRow + (size_t)block.minY * pitch + acceptedFrom;
+				for (int y = block.minY; y < block.maxY; y++, row += pitch)
+					Format::fillSpan(row, (size_t)(acceptedTo - acceptedFrom), color);
+				acceptedFrom = -1;
+			}
+		}
+		if (acceptedFrom >= 0) {
+			Pixel* row = blockRow + (size_t)block.minY * pitch + acceptedFrom;
+			for (int y = block.minY; y < block.maxY; y++, row += pitch)
+				Format::fillSpan(row, (size_t)(acceptedTo - acceptedFrom), color);
+		}
+	}
+}
+
+#endif // !GRAPHICS_TRIANGLE
@@ -0,0 +1,111 @@
+//
+// Anti-aliasing benchmark
+//
+// Compares the anti-aliased lines and circles with the aliased ones, and with anti-aliasing the aliased ones
+// by supersampling the whole frame (drawn at 2x2 the size and averaged down)
+//
+// Usage: antialias [width] [height]
+//
+
+#include "../RenderTarget.hpp"
+#include "bench.hpp"
+#include <cstdlib>
+
+// Scene drawn with the aliased or the anti-aliased primitives, scaled for supersampling
+struct Scene {
+	std::vector<vec2<int>> points;
+	std::vector<int> sizes;
+	std::vector<UINT32> colors;
+
+	explicit Scene(int width, int height) {
+		srand(11);
+		for (int i = 0; i < 2000; i++) {
+			points.push_back(vec2<int>(rand() % width, rand() % height));
+			sizes.push_back(rand() % 60 + 2);
+			colors.push_back((UINT32)((rand() & 0xFF) << 16 | (rand() & 0xFF) << 8 | (rand() & 0xFF)));
+		}
+	}
+
+	void drawLines(RenderTarget& target, bool antialiased, int scale, unsigned short thickness) const {
+		for (size_t i = 0; i + 1 < points.size(); i += 2) {
+			vec2<int> p1 = vec2<int>(points[i].x * scale, points[i].y * scale);
+			vec2<int> p2 = vec2<int>(points[i + 1].x * scale, points[i + 1].y * scale);
+			if (antialiased)
+				target.drawAntialiasedLine(p1, p2, colors[i], thickness);
+			else
+				target.drawLine(p1, p2, colors[i], (unsigned short)(thickness * scale));
+		}
+	}
+
+	void drawCircles(RenderTarget& target, bool antialiased, int scale, bool empty) const {
+		for (size_t i = 0; i < points.size(); i += 4) {
+			vec2<int> origin = vec2<int>(points[i].x * scale, points[i].y * scale);
+			int radius = sizes[i] * scale;
+			if (empty && antialiased)
+				target.drawAntialiasedEmptyCircle(origin, radius, colors[i], 3);
+			else if (empty)
+				target.drawEmptyCircle(origin, radius, colors[i], (unsigned short)(3 * scale));
+			else if (antialiased)
+				target.drawAntialiasedCircle(origin, radius, colors[i]);
+			else
+				target.drawCircle(origin, radius, colors[i]);
+		}
+	}
+};
+
+// Averages every 2x2 block of the source into a pixel of the target
+void downsample(const RenderTarget& source, RenderTarget& target) {
+	const UINT32* pixels = const_cast<RenderTarget&>(source).getPixels();
+	UINT32* output = target.getPixels();
+	for (int y = 0; y < target.bitmapHeight; y++) {
+		const UINT32* row1 = pixels + (size_t)(2 * y) * source.bitmapWidth;
+		const UINT32* row2 = row1 + source.bitmapWidth;
+		for (int x = 0; x < target.bitmapWidth; x++) {
+			UINT32 a = row1[2 * x], b = row1[2 * x + 1], c = row2[2 * x], d = row2[2 * x + 1];
+			UINT32 redBlue = (((a & 0xFF00FF) + (b & 0xFF00FF) + (c & 0xFF00FF) + (d & 0xFF00FF)) >> 2) & 0xFF00FF;
+			UINT32 green = (((a & 0x00FF00) + (b & 0x00FF00) + (c & 0x00FF00) + (d & 0x00FF00)) >> 2) & 0x00FF00;
+			output[(size_t)y * target.bitmapWidth + x] = redBlue | green;
+		}
+	}
+}
+
+int main(int argc, char** argv) {
+	int width = argc > 1 ? atoi(argv[1]) : 1920;
+	int height = argc > 2 ? atoi(argv[2]) : 1080;
+
+	RenderTarget target;
+	RenderTarget supersampled;
+	if (width <= 0 || height <= 0 || !target.create(width, height) || !supersampled.create(width * 2, height * 2)) {
+		fprintf(stderr, "Couldn't create a %dx%d render target\n", width, height);
+		return 1;
+	}
+	printf("Render target: %dx%d, blend kernel: %s\n", width, height, cpuHasAVX2() ? "AVX2" : "SSE2 or scalar");
+	Scene scene(width, height);
+
+	struct Case {
+		const char* name;
+		void (*draw)(const Scene&, RenderTarget&, bool, int);
+	};
+	const Case cases[] = {
+		{ "1000 thin lines", [](const Scene& s, RenderTarget& t, bool aa, int scale) { s.drawLines(t, aa, scale, 1); } },
+		{ "1000 lines 4 thick", [](const Scene& s, RenderTarget& t, bool aa, int scale) { s.drawLines(t, aa, scale, 4); } },
+		{ "500 circles", [](const Scene& s, RenderTarget& t, bool aa, int scale) { s.drawCircles(t, aa, scale, false); } },
+		{ "500 rings 3 thick", [](const Scene& s, RenderTarget& t, bool aa, int scale) { s.drawCircles(t, aa, scale, true); } },
+	};
+
+	char name[64];
+	for (const Case& test : cases) {
+		printf("\n%s\n", test.name);
+		// The ways are compared by their fastest samples, the averages drift more than the difference between them
+		BenchResult aliased = runBenchmarkSamples("aliased", [&] { test.draw(scene, target, false, 1); });
+		BenchResult antialiased = runBenchmarkSamples("anti-aliased", [&] { test.draw(scene, target, true, 1); });
+		snprintf(name, sizeof(name), "supersampled 2x2 (with the downsample)");
+		BenchResult ssaa = runBenchmarkSamples(name, [&] {
+			test.draw(scene, supersampled, false, 2);
+			downsample(supersampled, target);
+		});
+		printf("%-40s %14.2fx\n", "anti-aliased / aliased", antialiased.minNsPerCall / aliased.minNsPerCall);
+		printf("%-40s %14.2fx\n", "supersampled / aliased", ssaa.minNsPerCall / aliased.minNsPerCall);
+	}
+	return 0;
+}
@@ -0,0 +1,83 @@
+#ifndef GRAPHICS_BENCH
+#define GRAPHICS_BENCH
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+// Result of a single benchmark
+struct BenchResult {
+	const char* name;
+	// Average time of one call (in nanoseconds)
+	double nsPerCall;
+	// Number of the measured calls
+	long long calls;
+	// Standard deviation of the average call time between the samples and the average of the fastest sample (in nanoseconds)
+	// Only measured by runBenchmarkSamples
+	double stddev = 0.0;
+	double minNsPerCall = 0.0;
+	int samples = 0;
+};
+
+// Calls the function until at least minSeconds have passed and measures the average call time
+template<class F>
+BenchResult runBenchmark(const char* name, F&& function, double minSeconds = 0.25) {
+	// Warm up caches and branch predictors
+	function();
+
+	long long calls = 0;
+	long long batch = 1;
+	std::chrono::duration<double> elapsed{};
+	auto start = std::chrono::steady_clock::now();
+	do {
+		for (long long i = 0; i < batch; i++)
+			function();
+		calls += batch;
+		batch *= 2;
+		elapsed = std::chrono::steady_clock::now() - start;
+	} while (elapsed.count() < minSeconds);
+
+	BenchResult result = { name, elapsed.count() * 1e9 / (double)calls, calls };
+	printf("%-40s %14.1f ns/call %12lld calls\n", result.name, result.nsPerCall, result.calls);
+	return result;
+}
+
+// Times the function in samples of at least sampleSeconds each (the calls per sample are picked first), the spread
+// of the samples shows how noisy the average is and the fastest one is the least disturbed by the rest of the system
+template<class F>
+BenchResult runBenchmarkSamples(const char* name, F&& function, int samples = 15, double sampleSeconds = 0.02) {
+	// Warm up and find the number of the calls that take sampleSeconds
+	long long batch = 1;
+	for (;;) {
+		auto start = std::chrono::steady_clock::now();
+		for (long long i = 0; i < batch; i++)
+			function();
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		if (elapsed.count() >= sampleSeconds) break;
+		batch = elapsed.count() > sampleSeconds / 16 ? (long long)(batch * sampleSeconds / elapsed.count()) + 1 : batch * 16;
+	}
+
+	double sum = 0.0;
+	double squares = 0.0;
+	double fastest = 0.0;
+	for (int sample = 0; sample < samples; sample++) {
+		auto start = std::chrono::steady_clock::now();
+		for (long long i = 0; i < batch; i++)
+			function();
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		double ns = elapsed.count() * 1e9 / (double)batch;
+		sum += ns;
+		squares += ns * ns;
+		if (sample == 0 || ns < fastest)
+			fastest = ns;
+	}
+
+	BenchResult result = { name, sum / samples, batch * samples };
+	result.stddev = sqrt(fmax(squares / samples - result.nsPerCall * result.nsPerCall, 0.0));
+	result.minNsPerCall = fastest;
+	result.samples = samples;
+	printf("%-40s %14.1f ns/call +- %5.1f%% %12lld calls\n", result.name, result.nsPerCall, result.stddev * 100.0 / result.nsPerCall, result.calls);
+	return result;
+}
+
+#endif // !GRAPHICS_BENCH
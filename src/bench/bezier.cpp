@@ -0,0 +1,171 @@
+//
+// Bezier curve benchmark
+//
+// Compares the adaptively flattened drawBezierCurve with the old 10000 step version,
+// and one drawBezierCurves batch with separate drawBezierCurve calls (by their fastest samples)
+// Checks that straight curves of thickness 0, 1 and 2 are as wide as the old version
+//
+// Usage: bezier
+//
+
+#include "../RenderTarget.hpp"
+#include "bench.hpp"
+#include <vector>
+
+// Bezier curves before the flattening, a circle stamped every 0.0001 of t
+struct OldBeziers {
+	RenderTarget& target;
+
+	void drawPixel(int x, int y, UINT32 color) {
+		if (x < target.bitmapWidth && y < target.bitmapHeight && x > 0 && y > 0)
+			target.getPixels()[y * target.bitmapWidth + x] = color;
+	}
+
+	void drawCircle(vec2<int> origin, int radius, UINT32 color) {
+		if (radius > 1) {
+			int rSq = radius * radius;
+			for (int y = -radius; y <= radius; y++)
+				for (int x = -radius; x <= radius; x++)
+					if (CEQ(x, y, rSq))
+						drawPixel(origin.x + x, origin.y + y, color);
+		}
+		else
+			drawPixel(origin.x, origin.y, color);
+	}
+
+	int getPt(int n1, int n2, float perc) {
+		return n1 + (int)((n2 - n1) * perc);
+	}
+
+	void drawBezierCurve(vec2<int> p1, vec2<int> p2, vec2<int> p3, vec2<int> p4, UINT32 color, unsigned short thickness) {
+		vec2<int> pA, pB, pC, pM, pN;
+		for (float i = 0; i < 1; i += 0.0001f) {
+			pA.x = getPt(p1.x, p2.x, i);
+			pA.y = getPt(p1.y, p2.y, i);
+			pB.x = getPt(p2.x, p3.x, i);
+			pB.y = getPt(p2.y, p3.y, i);
+			pC.x = getPt(p3.x, p4.x, i);
+			pC.y = getPt(p3.y, p4.y, i);
+			pN.x = getPt(pA.x, pB.x, i);
+			pN.y = getPt(pA.y, pB.y, i);
+			pM.x = getPt(pB.x, pC.x, i);
+			pM.y = getPt(pB.y, pC.y, i);
+			drawCircle(vec2<int>(getPt(pN.x, pM.x, i), getPt(pN.y, pM.y, i)), thickness, color);
+		}
+	}
+};
+
+// Widths of a straight curve across it, away from its ends (the old one stops short of t = 1)
+// The old one rounds every step of t down, so it leaves gaps and its widest place is compared
+// Returns false if the widths differ or the new curve isn't as wide everywhere
+bool matchesOld(RenderTarget& target, OldBeziers& old, vec2<int> from, vec2<int> to, unsigned short thickness) {
+	vec2<int> step((to.x - from.x) / 3, (to.y - from.y) / 3);
+	vec2<int> p2(from.x + step.x, from.y + step.y);
+	vec2<int> p3(from.x + 2 * step.x, from.y + 2 * step.y);
+	bool horizontal = from.y == to.y;
+	int length = horizontal ? target.bitmapHeight : target.bitmapWidth;
+	// Widest and narrowest place of the curve
+	auto widths = [&](int& widest, int& narrowest) {
+		widest = 0;
+		narrowest = INT_MAX;
+		const int margin = 10;
+		for (int along = (horizontal ? from.x : from.y) + margin; along <= (horizontal ? to.x : to.y) - margin; along++) {
+			int width = 0;
+			for (int across = 0; across < length; across++)
+				width += (horizontal ? target.getPixels()[(size_t)across * target.bitmapWidth + along] : target.getPixels()[(size_t)along * target.bitmapWidth + across]) != BLACK;
+			if (width > widest) widest = width;
+			if (width < narrowest) narrowest = width;
+		}
+	};
+
+	int oldWidth, oldNarrowest, newWidth, newNarrowest;
+	target.clearScreen(BLACK);
+	old.drawBezierCurve(from, p2, p3, to, WHITE, thickness);
+	widths(oldWidth, oldNarrowest);
+	target.clearScreen(BLACK);
+	target.drawBezierCurve(from, p2, p3, to, WHITE, thickness);
+	widths(newWidth, newNarrowest);
+	printf("%-11s thickness %d: old %d - %d px wide, new %d - %d px wide\n", horizontal ? "horizontal" : "vertical",
+		thickness, oldNarrowest, oldWidth, newNarrowest, newWidth);
+	return newWidth == oldWidth && newNarrowest == newWidth;
+}
+
+int main() {
+	// Same size as the bezier demo window
+	RenderTarget target(900, 900);
+	OldBeziers old = { target };
+	const double minSeconds = 0.1;
+	char name[64];
+
+	// Random cubic curves inside the target
+	const int maxCurves = 10000;
+	std::vector<vec2<int>> points(maxCurves * 4);
+	srand(1);
+	for (vec2<int>& point : points)
+		point = vec2<int>(rand() % 900, rand() % 900);
+
+	printf("Flattening: %s\n\n", cpuHasAVX2() ? "AVX2" : "SSE2 or scalar");
+
+	bool matches = true;
+	for (unsigned short thickness = 0; thickness <= 2; thickness++) {
+		matches = matchesOld(target, old, vec2<int>(100, 450), vec2<int>(700, 450), thickness) && matches;
+		matches = matchesOld(target, old, vec2<int>(450, 100), vec2<int>(450, 700), thickness) && matches;
+	}
+	printf("%s\n", matches ? "Straight curves are as wide as the old version" : "Straight curve widths DIFFER from the old version");
+
+	const unsigned short thicknesses[] = { 0, 1, 4 };
+	for (unsigned short thickness : thicknesses) {
+		printf("\nSingle cubic curve, thickness %d\n", thickness);
+		snprintf(name, sizeof(name), "old t=%d", thickness);
+		BenchResult oldResult = runBenchmark(name, [&] { old.drawBezierCurve(points[0], points[1], points[2], points[3], RED, thickness); }, minSeconds);
+		snprintf(name, sizeof(name), "new t=%d", thickness);
+		BenchResult newResult = runBenchmark(name, [&] { target.drawBezierCurve(points[0], points[1], points[2], points[3], RED, thickness); }, minSeconds);
+		printf("%-40s %14.1fx\n", "speedup", oldResult.nsPerCall / newResult.nsPerCall);
+	}
+
+	// Flattening alone, one curve at a time and batched
+	printf("\nFlattening %d cubic curves\n", maxCurves);
+	BezierBatch batch;
+	std::vector<vec2<int>> polyline(bezierMaxSegments + 1);
+	BenchResult scalarFlatten = runBenchmark("flattenBezier", [&] {
+		for (int i = 0; i < maxCurves; i++) {
+			float x[4], y[4];
+			for (int j = 0; j < 4; j++) {
+				x[j] = (float)points[i * 4 + j].x;
+				y[j] = (float)points[i * 4 + j].y;
+			}
+			flattenBezier(x, y, 3, bezierSegmentCount(x, y, 3), polyline.data());
+		}
+	}, minSeconds);
+	BenchResult batchFlatten = runBenchmark("BezierBatch::flatten", [&] { batch.flatten(points.data(), maxCurves, 3); }, minSeconds);
+	printf("%-40s %14.1fx\n", "speedup", scalarFlatten.nsPerCall / batchFlatten.nsPerCall);
+	printf("%-40s %14.1f\n", "average segments per curve", (double)(batch.points.size() - maxCurves) / maxCurves);
+
+	const int curveCounts[] = { 3, 100, 1000, maxCurves };
+	for (int curves : curveCounts) {
+		printf("\n%d cubic curves, thickness 0\n", curves);
+		BenchResult oldResult = { nullptr, 0.0, 0 };
+		// The old version takes seconds for the biggest batches
+		if (curves <= 100) {
+			snprintf(name, sizeof(name), "old x%d", curves);
+			oldResult = runBenchmark(name, [&] {
+				for (int i = 0; i < curves; i++)
+					old.drawBezierCurve(points[i * 4], points[i * 4 + 1], points[i * 4 + 2], points[i * 4 + 3], GREEN, 0);
+			}, minSeconds);
+		}
+		// Single calls and the batch are compared by their fastest samples, the averages drift more than the difference between them
+		snprintf(name, sizeof(name), "drawBezierCurve x%d", curves);
+		BenchResult singleResult = runBenchmarkSamples(name, [&] {
+			for (int i = 0; i < curves; i++)
+				target.drawBezierCurve(points[i * 4], points[i * 4 + 1], points[i * 4 + 2], points[i * 4 + 3], GREEN, 0);
+		});
+		snprintf(name, sizeof(name), "drawBezierCurves x%d", curves);
+		BenchResult batchResult = runBenchmarkSamples(name, [&] { target.drawBezierCurves(points.data(), curves, 3, GREEN, 0); });
+		if (oldResult.calls)
+			printf("%-40s %14.1fx\n", "speedup over old", oldResult.nsPerCall / batchResult.minNsPerCall);
+		printf("%-40s %14.1fx\n", "speedup over single calls", singleResult.minNsPerCall / batchResult.minNsPerCall);
+		printf("%-40s %14.1f frames/s\n", "batch", 1e9 / batchResult.minNsPerCall);
+	}
+
+	return matches ? 0 : 1;
+}
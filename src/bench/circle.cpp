@@ -0,0 +1,83 @@
+//
+// Circle rasterization benchmark
+//
+// Compares the span based drawCircle and drawEmptyCircle with the old per pixel versions
+//
+// Usage: circle
+//
+
+#include "../RenderTarget.hpp"
+#include "bench.hpp"
+
+// Circle rasterizers before the span based ones
+struct OldCircles {
+	RenderTarget& target;
+
+	void drawPixel(int x, int y, UINT32 color) {
+		if (x < target.bitmapWidth && y < target.bitmapHeight && x > 0 && y > 0)
+			target.getPixels()[y * target.bitmapWidth + x] = color;
+	}
+
+	void drawCircle(vec2<int> origin, int radius, UINT32 color) {
+		if (radius > 1) {
+			int rSq = radius * radius;
+			for (int y = -radius; y <= radius; y++)
+				for (int x = -radius; x <= radius; x++)
+					if (CEQ(x, y, rSq))
+						drawPixel(origin.x + x, origin.y + y, color);
+		}
+		else
+			drawPixel(origin.x, origin.y, color);
+	}
+
+	void drawEmptyCircle(vec2<int> origin, int radius, UINT32 color, unsigned short thickness) {
+		int rSq = radius * radius;
+		for (int y = -radius; y <= radius; y++) {
+			for (int x = -radius; x <= radius; x++)
+				if (CEQ(x, y, rSq)) {
+					drawCircle(vec2<int>(origin.x + x, origin.y + y), thickness, color);
+					if (CEQ(x, y + 1, rSq) && CEQ(x, y - 1, rSq))
+						break;
+				}
+			for (int x = radius; x >= -radius; x--)
+				if (CEQ(x, y, rSq)) {
+					drawCircle(vec2<int>(origin.x + x, origin.y + y), thickness, color);
+					if (CEQ(x, y + 1, rSq) && CEQ(x, y - 1, rSq))
+						break;
+				}
+		}
+	}
+};
+
+int main() {
+	// Big enough for the biggest ring
+	RenderTarget target(2200, 2200);
+	OldCircles old = { target };
+	vec2<int> center = vec2<int>(1100, 1100);
+	const double minSeconds = 0.1;
+	char name[64];
+
+	const int radii[] = { 1, 4, 16, 64, 256, 1000 };
+	const int thicknesses[] = { 1, 2, 4, 8, 16, 32 };
+
+	printf("drawCircle\n");
+	for (int radius : radii) {
+		snprintf(name, sizeof(name), "old r=%d", radius);
+		BenchResult oldResult = runBenchmark(name, [&] { old.drawCircle(center, radius, RED); }, minSeconds);
+		snprintf(name, sizeof(name), "new r=%d", radius);
+		BenchResult newResult = runBenchmark(name, [&] { target.drawCircle(center, radius, RED); }, minSeconds);
+		printf("%-40s %14.1fx\n", "speedup", oldResult.nsPerCall / newResult.nsPerCall);
+	}
+
+	printf("\ndrawEmptyCircle\n");
+	for (int radius : radii)
+		for (int thickness : thicknesses) {
+			snprintf(name, sizeof(name), "old r=%d t=%d", radius, thickness);
+			BenchResult oldResult = runBenchmark(name, [&] { old.drawEmptyCircle(center, radius, WHITE, (unsigned short)thickness); }, minSeconds);
+			snprintf(name, sizeof(name), "new r=%d t=%d", radius, thickness);
+			BenchResult newResult = runBenchmark(name, [&] { target.drawEmptyCircle(center, radius, WHITE, (unsigned short)thickness); }, minSeconds);
+			printf("%-40s %14.1fx\n", "speedup", oldResult.nsPerCall / newResult.nsPerCall);
+		}
+
+	return 0;
+}
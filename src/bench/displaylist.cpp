@@ -0,0 +1,137 @@
+//
+// Display list benchmark
+//
+// Compares drawing static content (the grid of the pathfinding demo and the axes of a graph) with the draw calls
+// every frame against replaying it from a list recorded once, checks that the pixels are the same
+//
+// Usage: displaylist [width] [height]
+//
+
+#include "../RenderTarget.hpp"
+#include "bench.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+const int tilesWidth = 16;
+const int tilesHeight = 16;
+const int tileSize = 56;
+const int gap = 3;
+
+// Tiles connected with their neighbours like in the pathfinding demo, top left corner at the origin
+void drawGrid(RenderTarget& target, vec2<int> origin) {
+	for (int y = 0; y < tilesHeight; y++)
+		for (int x = 0; x < tilesWidth; x++) {
+			vec2<int> center = vec2<int>(origin.x + x * tileSize + tileSize / 2, origin.y + y * tileSize + tileSize / 2);
+			const int neighbours[4][2] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+			for (const int* neighbour : neighbours) {
+				int nx = x + neighbour[0], ny = y + neighbour[1];
+				if (nx >= 0 && nx < tilesWidth && ny >= 0 && ny < tilesHeight)
+					target.drawLine(center, vec2<int>(center.x + neighbour[0] * tileSize, center.y + neighbour[1] * tileSize), 0x333333);
+			}
+			target.drawRectangle(vec2<int>(origin.x + gap + x * tileSize, origin.y + gap + y * tileSize), tileSize - 2 * gap, tileSize - 2 * gap, 0x333333);
+		}
+}
+
+// Axes, gridlines and labels like in the graph demo, top left corner at the origin
+void drawAxes(RenderTarget& target, vec2<int> origin) {
+	const int width = 800, height = 500;
+	for (int i = 0; i <= 10; i++) {
+		int y = origin.y + 20 + i * (height - 40) / 10;
+		target.drawText(origin.x, y, std::to_wstring((10 - i) * 100).c_str(), 20, WHITE);
+		target.drawLine(vec2<int>(origin.x + 50, y + 10), vec2<int>(origin.x + width - 5, y + 10), GREY, 1);
+	}
+	for (int i = 0; i <= 20; i++) {
+		int x = origin.x + 50 + i * (width - 60) / 20;
+		target.drawLine(vec2<int>(x, origin.y + height - 10), vec2<int>(x, origin.y + 20), GREY);
+		target.drawText(x - 4, origin.y + height - 5, std::to_wstring(i * 5).c_str(), 16, WHITE);
+	}
+	target.drawLine(vec2<int>(origin.x + 40, origin.y + height - 20), vec2<int>(origin.x + width, origin.y + height - 20), WHITE, 2);
+	target.drawLine(vec2<int>(origin.x + 50, origin.y + height - 10), vec2<int>(origin.x + 50, origin.y + 20), WHITE, 2);
+	target.drawBezierCurve(vec2<int>(origin.x + 50, origin.y + height - 20), vec2<int>(origin.x + width / 2, origin.y - 200),
+		vec2<int>(origin.x + width - 10, origin.y + height - 30), RED, 1);
+}
+
+// Checks that the dirty region of the target holds every pixel that isn't black and stays inside of the clip rectangle
+bool dirtyCoversDrawn(const RenderTarget& target) {
+	const DirtyRegion& region = target.getDirtyRegion();
+	for (int i = 0; i < region.count; i++)
+		if (!containsRect(target.getClipRect(), region.rects[i]))
+			return false;
+	for (int y = 0; y < target.bitmapHeight; y++)
+		for (int x = 0; x < target.bitmapWidth; x++) {
+			if (target.getPixels()[(size_t)y * target.bitmapWidth + x] == BLACK) continue;
+			bool covered = false;
+			for (int i = 0; i < region.count && !covered; i++)
+				covered = x >= region.rects[i].minPoint.x && y >= region.rects[i].minPoint.y && x < region.rects[i].maxPoint.x && y < region.rects[i].maxPoint.y;
+			if (!covered) return false;
+		}
+	return true;
+}
+
+void drawScene(RenderTarget& target, vec2<int> origin) {
+	drawGrid(target, origin);
+	drawAxes(target, vec2<int>(origin.x + 50, origin.y + 100));
+	// Cut off by the left edge where it's recorded, moving the list shows the rest of it
+	target.drawCircle(vec2<int>(origin.x + 20, origin.y + 700), 40, RED);
+}
+
+int main(int argc, char** argv) {
+	int width = argc > 1 ? atoi(argv[1]) : 1920;
+	int height = argc > 2 ? atoi(argv[2]) : 1080;
+	const vec2<int> origin = vec2<int>(0, 0);
+	const vec2<int> offset = vec2<int>(width / 2 - 100, 37);
+
+	RenderTarget immediate;
+	RenderTarget replayed;
+	if (width <= 0 || height <= 0 || !immediate.create(width, height) || !replayed.create(width, height)) {
+		fprintf(stderr, "Couldn't create a %dx%d render target\n", width, height);
+		return 1;
+	}
+	size_t frameBytes = (size_t)width * height * sizeof(UINT32);
+
+	DrawCommandList list;
+	replayed.beginRecording(list);
+	drawScene(replayed, origin);
+	replayed.endRecording();
+	printf("Render target: %dx%d, %zu recorded commands\n", width, height, list.size());
+
+	// Replays where they were recorded, moved, moved partly off the target and cut by a clip rectangle
+	struct ReplayCase {
+		vec2<int> moveBy;
+		Rect clip;
+	};
+	const Rect full = Rect(vec2<int>(0, 0), vec2<int>(width, height));
+	const ReplayCase cases[4] = { { vec2<int>(0, 0), full }, { offset, full }, { vec2<int>(-width / 4, -height / 4), full },
+		{ offset, Rect(vec2<int>(width / 3, height / 4), vec2<int>(width * 2 / 3, height * 3 / 4)) } };
+	bool identical = true;
+	for (const ReplayCase& replayCase : cases) {
+		vec2<int> moveBy = replayCase.moveBy;
+		immediate.clearScreen(BLACK);
+		immediate.setClipRect(replayCase.clip);
+		drawScene(immediate, vec2<int>(origin.x + moveBy.x, origin.y + moveBy.y));
+		immediate.resetClipRect();
+		replayed.clearScreen(BLACK);
+		replayed.finishPresent();
+		replayed.setClipRect(replayCase.clip);
+		replayed.replay(list, moveBy);
+		if (!dirtyCoversDrawn(replayed)) {
+			printf("Replay moved by (%d, %d) isn't covered by its dirty rectangles!\n", moveBy.x, moveBy.y);
+			identical = false;
+		}
+		replayed.resetClipRect();
+		if (memcmp(immediate.getPixels(), replayed.getPixels(), frameBytes) != 0) {
+			printf("Replay moved by (%d, %d) differs from the draw calls!\n", moveBy.x, moveBy.y);
+			identical = false;
+		}
+	}
+
+	BenchResult drawn = runBenchmark("draw calls", [&] { drawScene(immediate, origin); });
+	BenchResult replay = runBenchmark("replay", [&] { replayed.replay(list); });
+	BenchResult moved = runBenchmark("replay with an offset", [&] { replayed.replay(list, offset); });
+	printf("%-40s %14.1fx\n", "replay speedup", drawn.nsPerCall / replay.nsPerCall);
+	printf("%-40s %14.1fx\n", "replay with an offset speedup", drawn.nsPerCall / moved.nsPerCall);
+
+	printf("\n%s\n", identical ? "Replayed frames are identical to the drawn ones and marked as changed" : "Replayed frames DIFFER from the drawn ones or aren't marked as changed");
+	return identical ? 0 : 1;
+}
@@ -0,0 +1,77 @@
+//
+// Span fill benchmark
+//
+// Compares the fill kernels used by clearScreen and drawRectangle with the old one pixel at a time loops
+//
+// Usage: fill
+//
+
+#include "../RenderTarget.hpp"
+#include "bench.hpp"
+
+// clearScreen loop before the span kernels
+void clearLoop(UINT32* memory, int pixels, UINT32 color) {
+	UINT32* pixel = memory;
+	for (int index = 0; index < pixels; ++index) {
+		*pixel++ = color;
+	}
+}
+
+// drawRectangle loop before the span kernels
+void rectangleLoop(UINT32* memory, int bitmapWidth, vec2<int> coords, int recWidth, int recHeight, UINT32 color) {
+	UINT32* pixel = memory;
+	pixel += coords.y * bitmapWidth + coords.x;
+	for (int y = 0; y < recHeight; ++y) {
+		for (int x = 0; x < recWidth; ++x)
+			*pixel++ = color;
+		pixel += bitmapWidth - recWidth;
+	}
+}
+
+// Prints throughput of the benchmark
+void printBandwidth(const BenchResult& result, size_t bytes) {
+	printf("%-40s %14.2f GB/s\n", "", (double)bytes / result.nsPerCall);
+}
+
+// Benchmarks one kernel filling the whole frame
+void benchFrameKernel(const char* name, FillSpanFunction kernel, UINT32* pixels, size_t count) {
+	printBandwidth(runBenchmark(name, [&] { kernel(pixels, count, 0x333333); }), count * sizeof(UINT32));
+}
+
+int main() {
+	printf("Dispatched kernels: %s\n", spanKernels().name);
+
+	const int sizes[][2] = { { 800, 600 }, { 1920, 1080 }, { 3840, 2160 } };
+	for (const auto& size : sizes) {
+		RenderTarget target(size[0], size[1]);
+		UINT32* pixels = target.getPixels();
+		size_t count = (size_t)size[0] * size[1];
+		size_t bytes = count * sizeof(UINT32);
+		printf("\n%dx%d (%.1f MB)\n", size[0], size[1], (double)bytes / (1024.0 * 1024.0));
+
+		printBandwidth(runBenchmark("old clearScreen loop", [&] { clearLoop(pixels, (int)count, 0x333333); }), bytes);
+		printBandwidth(runBenchmark("clearScreen", [&] { target.clearScreen(0x333333); }), bytes);
+		benchFrameKernel("fillSpanScalar", fillSpanScalar, pixels, count);
+#ifdef GRAPHICS_SSE2
+		benchFrameKernel("fillSpanSSE2", fillSpanSSE2, pixels, count);
+		benchFrameKernel("fillSpanStreamSSE2", fillSpanStreamSSE2, pixels, count);
+		if (cpuHasAVX2()) {
+			benchFrameKernel("fillSpanAVX2", fillSpanAVX2, pixels, count);
+			benchFrameKernel("fillSpanStreamAVX2", fillSpanStreamAVX2, pixels, count);
+		}
+#endif
+
+		// Rectangles of different widths, the narrow ones are dominated by the per row overhead
+		const int rectSizes[] = { 5, 37, 200, 500 };
+		for (int rectSize : rectSizes) {
+			char oldName[64], newName[64];
+			snprintf(oldName, sizeof(oldName), "old drawRectangle loop %dx%d", rectSize, rectSize);
+			snprintf(newName, sizeof(newName), "drawRectangle %dx%d", rectSize, rectSize);
+			size_t rectBytes = (size_t)rectSize * rectSize * sizeof(UINT32);
+			printBandwidth(runBenchmark(oldName, [&] { rectangleLoop(pixels, size[0], vec2<int>(3, 3), rectSize, rectSize, BLUE); }), rectBytes);
+			printBandwidth(runBenchmark(newName, [&] { target.drawRectangle(vec2<int>(3, 3), rectSize, rectSize, BLUE); }), rectBytes);
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,115 @@
+//
+// Pixel format benchmark
+//
+// Draws the same frames into BGRA32, RGB565 and Indexed8 render targets and compares the times and the bytes written,
+// checks that the deferred frames of every format are identical to the immediate ones and that the opaque primitives
+// of the smaller formats are exactly the BGRA32 ones converted to the format
+//
+// Usage: formats [width] [height]
+// (g++ -O2 -std=c++17 -pthread src/bench/formats.cpp -o formats)
+//
+
+#include "../TileRenderer.hpp"
+#include "bench.hpp"
+#include <cstdlib>
+#include <cstring>
+
+// Draws a frame with only opaque primitives, so every pixel is one of the colors drawn
+template<class Format>
+void drawOpaqueScene(BasicRenderTarget<Format>& target) {
+	srand(5);
+	target.clearScreen(0x202020);
+	for (int i = 0; i < 200; i++)
+		target.drawRectangle(vec2<int>(rand() % target.bitmapWidth, rand() % target.bitmapHeight), rand() % 200, rand() % 200, (UINT32)(rand() & 0xFFFFFF));
+	for (int i = 0; i < 1000; i++) {
+		vec2<int> v1 = vec2<int>(rand() % target.bitmapWidth, rand() % target.bitmapHeight);
+		target.drawTriangle(v1, vec2<int>(v1.x + rand() % 81 - 40, v1.y + rand() % 81 - 40), vec2<int>(v1.x + rand() % 81 - 40, v1.y + rand() % 81 - 40), (UINT32)(rand() & 0xFFFFFF));
+	}
+	for (int i = 0; i < 100; i++)
+		target.drawCircle(vec2<int>(rand() % target.bitmapWidth, rand() % target.bitmapHeight), rand() % 60, (UINT32)(rand() & 0xFFFFFF));
+	for (int i = 0; i < 300; i++)
+		target.drawLine(vec2<int>(rand() % target.bitmapWidth, rand() % target.bitmapHeight),
+			vec2<int>(rand() % target.bitmapWidth, rand() % target.bitmapHeight), (UINT32)(rand() & 0xFFFFFF), (unsigned short)(i % 3 + 1));
+}
+
+// Draws a frame with the blended primitives too
+template<class Format>
+void drawScene(BasicRenderTarget<Format>& target) {
+	drawOpaqueScene(target);
+	for (int i = 0; i < 100; i++)
+		target.drawAntialiasedLine(vec2<int>(rand() % target.bitmapWidth, rand() % target.bitmapHeight),
+			vec2<int>(rand() % target.bitmapWidth, rand() % target.bitmapHeight), (UINT32)(rand() & 0xFFFFFF), 2);
+	for (int i = 0; i < 50; i++)
+		target.drawAntialiasedCircle(vec2<int>(rand() % target.bitmapWidth, rand() % target.bitmapHeight), rand() % 40, (UINT32)(rand() & 0xFFFFFF));
+	for (int i = 0; i < 20; i++)
+		target.drawText(rand() % target.bitmapWidth, rand() % target.bitmapHeight, L"The quick brown fox jumps over the lazy dog", 16, WHITE);
+}
+
+// Times the primitives and the frames of the format, returns false if the deferred frames differ from the immediate ones
+template<class Format>
+bool benchmarkFormat(_In_ int width, _In_ int height) {
+	typedef typename Format::Pixel Pixel;
+	BasicRenderTarget<Format> target;
+	BasicRenderTarget<Format> deferred;
+	if (!target.create(width, height) || !deferred.create(width, height)) {
+		fprintf(stderr, "Couldn't create a %dx%d %s render target\n", width, height, Format::name());
+		exit(1);
+	}
+	printf("\n%s (%zu bytes per pixel, %.2f MB per frame)\n", Format::name(), sizeof(Pixel), (double)width * height * sizeof(Pixel) / (1024.0 * 1024.0));
+
+	double frameBytes = (double)width * height * sizeof(Pixel);
+	BenchResult clear = runBenchmark("clearScreen", [&] { target.clearScreen(GREY); });
+	printf("%-40s %14.2f GB/s\n", "", frameBytes / clear.nsPerCall);
+	runBenchmark("drawRectangle 200x200", [&] { target.drawRectangle(vec2<int>(10, 10), 200, 200, BLUE); });
+	runBenchmark("drawCircle r=100", [&] { target.drawCircle(vec2<int>(width / 2, height / 2), 100, GREEN); });
+	runBenchmark("drawTriangle", [&] { target.drawTriangle(vec2<int>(100, 500), vec2<int>(200, 100), vec2<int>(400, 450), YELLOW); });
+	runBenchmark("drawAntialiasedLine 400px t=2", [&] { target.drawAntialiasedLine(vec2<int>(10, 10), vec2<int>(410, 210), PINK, 2); });
+	runBenchmark("drawText 16 chars", [&] { target.drawText(100, 100, L"Quick brown fox!", 16, WHITE); });
+	BenchResult frame = runBenchmark("scene frame", [&] { drawScene(target); target.finishPresent(); }, 1.0);
+	printf("%-40s %14.1f frames/s\n", "", 1e9 / frame.nsPerCall);
+
+	// The tiles of the deferred frame are drawn with the same loops
+	BasicTileRenderer<Format> renderer;
+	DrawCommandList list;
+	drawScene(target);
+	deferred.beginRecording(list);
+	drawScene(deferred);
+	deferred.endRecording();
+	renderer.render(deferred, list);
+	return memcmp(target.getPixels(), deferred.getPixels(), (size_t)width * height * sizeof(Pixel)) == 0;
+}
+
+// Checks that the opaque frame of the format is the BGRA32 frame converted pixel by pixel
+template<class Format>
+bool matchesConverted(_In_ const RenderTarget& reference) {
+	BasicRenderTarget<Format> target(reference.bitmapWidth, reference.bitmapHeight);
+	drawOpaqueScene(target);
+	const UINT32* expected = reference.getPixels();
+	const typename Format::Pixel* pixel = target.getPixels();
+	for (size_t i = 0; i < (size_t)reference.bitmapWidth * reference.bitmapHeight; i++)
+		if (pixel[i] != Format::fromRGB(expected[i]))
+			return false;
+	return true;
+}
+
+int main(int argc, char** argv) {
+	int width = argc > 1 ? atoi(argv[1]) : 1920;
+	int height = argc > 2 ? atoi(argv[2]) : 1080;
+	if (width <= 600 || height <= 600) {
+		fprintf(stderr, "The render target has to be bigger than 600x600\n");
+		return 1;
+	}
+	printf("Render target: %dx%d\n", width, height);
+
+	bool identical = benchmarkFormat<BGRA32>(width, height);
+	identical = benchmarkFormat<RGB565>(width, height) && identical;
+	identical = benchmarkFormat<Indexed8>(width, height) && identical;
+
+	RenderTarget reference(width, height);
+	drawOpaqueScene(reference);
+	bool converted = matchesConverted<RGB565>(reference) && matchesConverted<Indexed8>(reference);
+
+	printf("\n%s\n", identical ? "Deferred frames are identical to the immediate ones" : "Deferred frames DIFFER from the immediate ones");
+	printf("%s\n", converted ? "Opaque frames are identical to the converted BGRA32 ones" : "Opaque frames DIFFER from the converted BGRA32 ones");
+	return identical && converted ? 0 : 1;
+}
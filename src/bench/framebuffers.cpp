@@ -0,0 +1,91 @@
+//
+// Framebuffer pool benchmark
+//
+// Recreates render targets like resizing and switching to the fullscreen mode do, with the pool and with every buffer
+// given back to the OS right away, then times full frame passes over buffers with the normal and the huge pages
+// Checks that no buffers are left behind once all of the targets are released
+//
+// Usage: framebuffers [width] [height]
+// (g++ -O2 -std=c++17 -pthread src/bench/framebuffers.cpp -o framebuffers)
+//
+
+#include "../RenderTarget.hpp"
+#include "bench.hpp"
+#include <cstdlib>
+
+// Prints the allocation statistics of the pool
+void printStats(const char* name) {
+	FramebufferPool::Stats stats = framebufferPool().getStats();
+	printf("%-40s %8llu allocated %8llu reused %8llu freed %4llu huge, %d live (%.1f MB), %d cached (%.1f MB), peak %.1f MB\n", name,
+		stats.allocations, stats.reuses, stats.frees, stats.hugePageAllocations, stats.liveBuffers, stats.liveBytes / 1048576.0,
+		stats.cachedBuffers, stats.cachedBytes / 1048576.0, stats.peakBytes / 1048576.0);
+}
+
+// Times the passes over the whole frame, the vertical lines touch a different page on every row with the normal pages
+void benchmarkPasses(RenderTarget& target, const char* clearName, const char* columnsName) {
+	runBenchmark(clearName, [&] { target.clearScreen(GREY); });
+	runBenchmark(columnsName, [&] {
+		for (int x = 0; x < target.bitmapWidth; x += 61)
+			target.drawLine(vec2<int>(x, 0), vec2<int>(x, target.bitmapHeight - 1), RED);
+	});
+}
+
+int main(int argc, char** argv) {
+	int width = argc > 1 ? atoi(argv[1]) : 3840;
+	int height = argc > 2 ? atoi(argv[2]) : 2160;
+	if (width <= 800 || height <= 600) {
+		fprintf(stderr, "The fullscreen size has to be bigger than 800x600\n");
+		return 1;
+	}
+	printf("Fullscreen: %dx%d, huge pages of %zu KB\n", width, height, hugePageSize() / 1024);
+
+	// Toggling between the windowed and the fullscreen size, the new buffer is drawn to right away
+	{
+		RenderTarget target;
+		bool fullscreen = false;
+		auto toggle = [&] {
+			fullscreen = !fullscreen;
+			target.create(fullscreen ? width : 800, fullscreen ? height : 600);
+			target.clearScreen(BLACK);
+		};
+		framebufferPool().setMaxCachedBytes(0);
+		runBenchmark("toggle without the pool", toggle);
+		framebufferPool().setMaxCachedBytes((size_t)128 << 20);
+		runBenchmark("toggle with the pool", toggle);
+	}
+	printStats("after toggling");
+
+	// Switching between 1 and 3 buffers like SwapChain does
+	{
+		RenderTarget target(width, height);
+		size_t size = (size_t)width * height * sizeof(UINT32);
+		runBenchmark("3 buffers acquired and released", [&] {
+			void* buffers[3];
+			for (void*& buffer : buffers)
+				buffer = framebufferPool().acquire(size, false);
+			for (void* buffer : buffers)
+				framebufferPool().release(buffer);
+		});
+	}
+	printStats("after the buffers");
+
+	{
+		RenderTarget target(width, height);
+		benchmarkPasses(target, "clearScreen, normal pages", "vertical lines, normal pages");
+	}
+	framebufferPool().setHugePages(true);
+	{
+		RenderTarget target(width, height);
+		benchmarkPasses(target, "clearScreen, huge pages", "vertical lines, huge pages");
+	}
+	framebufferPool().setHugePages(false);
+	printStats("after the passes");
+
+	// Every target is released by now, only the cached buffers can be left
+	framebufferPool().trim();
+	FramebufferPool::Stats stats = framebufferPool().getStats();
+	bool leaked = stats.liveBuffers != 0 || stats.cachedBuffers != 0 || stats.allocations != stats.frees;
+	printStats("after trim");
+	printf("\n%s\n", leaked ? "Buffers were LEAKED" : "No buffers were leaked");
+	return leaked ? 1 : 0;
+}
@@ -0,0 +1,93 @@
+//
+// Headless rendering benchmark
+//
+// Renders the engine primitives into an offscreen RenderTarget without any window,
+// so it can be run on any platform (for example: g++ -O2 -std=c++17 src/bench/headless.cpp)
+//
+// Usage: headless [width] [height] [frame dump pattern, for example "frame_%05d.ppm"]
+//
+
+#include "../RenderTarget.hpp"
+#include "../HeadlessPresenter.hpp"
+#include "bench.hpp"
+#include <cstdlib>
+
+// Draws a scene similar to the pathfinding and bezier demos
+void drawScene(RenderTarget& target, int frame) {
+	const int tiles = 16;
+	int tileW = target.bitmapWidth / tiles;
+	int tileH = target.bitmapHeight / tiles;
+
+	target.clearScreen(BLACK);
+
+	for (int y = 0; y < tiles; y++)
+		for (int x = 0; x < tiles; x++) {
+			vec2<int> center = vec2<int>(x * tileW + tileW / 2, y * tileH + tileH / 2);
+			if (x < tiles - 1)
+				target.drawLine(center, vec2<int>(center.x + tileW, center.y), 0x333333);
+			if (y < tiles - 1)
+				target.drawLine(center, vec2<int>(center.x, center.y + tileH), 0x333333);
+			target.drawRectangle(vec2<int>(x * tileW + 3, y * tileH + 3), tileW - 6, tileH - 6, (x + y + frame) % 5 ? 0x333333 : 0xA97700);
+		}
+
+	int w = target.bitmapWidth;
+	int h = target.bitmapHeight;
+	target.drawCircle(vec2<int>(w / 2, h / 2), h / 8, RED);
+	target.drawEmptyCircle(vec2<int>(w / 2, h / 2), h / 4, WHITE, 2);
+	target.drawTriangle(vec2<int>(w / 10, h - h / 10), vec2<int>(w / 5, h / 2), vec2<int>(w / 3, h - h / 8), GREEN);
+	target.drawBezierCurve(vec2<int>(w / 9, h / 9), vec2<int>(w / 6, h / 3), vec2<int>(w / 2, h / 6), RED);
+	target.drawBezierCurve(vec2<int>(w / 2, h / 3), vec2<int>(w / 2, h / 4), vec2<int>(2 * w / 3, 2 * h / 3), vec2<int>(8 * w / 9, h / 6), BLUE);
+	target.drawText(10, 10, L"Headless frame", 20, WHITE);
+	target.drawText(10, h - 30, L"0123456789 The quick brown fox jumps over the lazy dog!", 16, YELLOW);
+}
+
+int main(int argc, char** argv) {
+	int width = argc > 1 ? atoi(argv[1]) : 800;
+	int height = argc > 2 ? atoi(argv[2]) : 600;
+	const char* dumpPattern = argc > 3 ? argv[3] : nullptr;
+
+	RenderTarget target;
+	if (width <= 0 || height <= 0 || !target.create(width, height)) {
+		fprintf(stderr, "Couldn't create a %dx%d render target\n", width, height);
+		return 1;
+	}
+
+	printf("Render target: %dx%d\n", width, height);
+
+	vec2<int> center = vec2<int>(width / 2, height / 2);
+	runBenchmark("clearScreen", [&] { target.clearScreen(GREY); });
+	runBenchmark("drawPixel", [&] { target.drawPixel(center.x, center.y, RED); });
+	runBenchmark("drawRectangle 100x100", [&] { target.drawRectangle(vec2<int>(10, 10), 100, 100, BLUE); });
+	runBenchmark("drawCircle r=50", [&] { target.drawCircle(center, 50, GREEN); });
+	runBenchmark("drawEmptyCircle r=100 t=2", [&] { target.drawEmptyCircle(center, 100, WHITE, 2); });
+	runBenchmark("drawLine 400px t=1", [&] { target.drawLine(vec2<int>(10, 10), vec2<int>(410, 210), PINK); });
+	runBenchmark("drawLine 400px t=5", [&] { target.drawLine(vec2<int>(10, 10), vec2<int>(410, 210), PINK, 5); });
+	runBenchmark("drawBezierCurve quadratic", [&] { target.drawBezierCurve(vec2<int>(100, 100), vec2<int>(150, 300), vec2<int>(500, 150), RED); });
+	runBenchmark("drawBezierCurve cubic", [&] { target.drawBezierCurve(vec2<int>(400, 300), vec2<int>(450, 200), vec2<int>(600, 550), vec2<int>(750, 150), BLUE); });
+	runBenchmark("drawText 16 chars", [&] { target.drawText(100, 100, L"Quick brown fox!", 16, WHITE); });
+	runBenchmark("drawTriangle", [&] { target.drawTriangle(vec2<int>(100, 500), vec2<int>(200, 300), vec2<int>(300, 550), YELLOW); });
+
+	HeadlessPresenter presenter(dumpPattern);
+	int frame = 0;
+	BenchResult scene = runBenchmark("full scene frame", [&] {
+		drawScene(target, frame++);
+		presenter.present(target);
+	}, dumpPattern ? 0.0 : 1.0);
+	printf("%.1f frames/s\n", 1e9 / scene.nsPerCall);
+
+	// Damage tracking: only the repainted tiles should be presented after the first frame
+	drawScene(target, 0);
+	presenter.present(target);
+	printf("\nFirst frame presented %zu bytes in %d rects\n", target.getPresentedBytes(), target.presentStats.rects);
+	int tileW = width / 16;
+	int tileH = height / 16;
+	for (int i = 0; i < 3; i++)
+		target.drawRectangle(vec2<int>((i * 5) * tileW + 3, (i * 3) * tileH + 3), tileW - 6, tileH - 6, 0x111111);
+	presenter.present(target);
+	printf("3 repainted tiles presented %zu bytes in %d rects (%.2f%% of the frame)\n", target.getPresentedBytes(), target.presentStats.rects,
+		100.0 * (double)target.getPresentedBytes() / ((double)width * height * sizeof(UINT32)));
+	presenter.present(target);
+	printf("Unchanged frame presented %zu bytes\n", target.getPresentedBytes());
+
+	return 0;
+}
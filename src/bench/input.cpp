@@ -0,0 +1,111 @@
+//
+// Input queue benchmark
+//
+// Times pushing and popping the input events on one thread, then passes them from a producer thread (like the message pump)
+// to a consumer thread (like the game logic) through the lock-free ring and through a mutex guarded deque
+// Checks that every event arrives once and in order, and that a full ring drops the new events instead of the old ones
+//
+// Usage: input [events]
+// (g++ -O2 -std=c++17 -pthread src/bench/input.cpp -o input)
+//
+
+#include "../InputQueue.hpp"
+#include "bench.hpp"
+#include <cstdlib>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+// Queue of the same events with a lock, like most message queues
+class LockedInputQueue {
+	std::mutex mutex;
+	std::deque<InputEvent> events;
+
+public:
+	bool push(const InputEvent& event) {
+		std::lock_guard<std::mutex> lock(mutex);
+		events.push_back(event);
+		return true;
+	}
+
+	bool pop(InputEvent& event) {
+		std::lock_guard<std::mutex> lock(mutex);
+		if (events.empty()) return false;
+		event = events.front();
+		events.pop_front();
+		return true;
+	}
+};
+
+// Passes the events from another thread, returns false if any was lost or out of order
+// Also prints the average time from pushing an event to popping it
+template<class Queue>
+bool passEvents(const char* name, Queue& queue, long long count) {
+	std::thread producer([&] {
+		for (long long i = 0; i < count; i++) {
+			InputEvent event = InputEvent{ InputEventType::MouseMove, 0, (int)(i & 0xFFFF), (int)(i >> 16), inputClock() };
+			// The message pump would drop them, the benchmark waits so that every event can be checked
+			while (!queue.push(event))
+				std::this_thread::yield();
+		}
+	});
+
+	bool ordered = true;
+	long long received = 0;
+	double latency = 0.0;
+	auto start = std::chrono::steady_clock::now();
+	while (received < count) {
+		InputEvent event;
+		if (!queue.pop(event)) {
+			std::this_thread::yield();
+			continue;
+		}
+		latency += (double)(inputClock() - event.timestamp);
+		ordered = ordered && event.x == (int)(received & 0xFFFF) && event.y == (int)(received >> 16);
+		received++;
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	producer.join();
+	printf("%-40s %14.1f ns/event %10.1f us from push to pop\n", name, seconds * 1e9 / (double)count, latency / (double)count / 1000.0);
+	return ordered;
+}
+
+int main(int argc, char** argv) {
+	long long count = argc > 1 ? atoll(argv[1]) : 2000000;
+	if (count <= 0) {
+		fprintf(stderr, "The number of the events has to be positive\n");
+		return 1;
+	}
+	printf("%u hardware threads, %lld events\n\n", std::thread::hardware_concurrency(), count);
+
+	// Single thread
+	static InputQueue queue;
+	LockedInputQueue locked;
+	InputEvent event = InputEvent{ InputEventType::KeyDown, 'A', 0, 0, 0 };
+	runBenchmark("ring push + pop", [&] {
+		queue.push(event);
+		queue.pop(event);
+	});
+	runBenchmark("locked deque push + pop", [&] {
+		locked.push(event);
+		locked.pop(event);
+	});
+	printf("\n");
+
+	// Message pump and logic threads
+	bool ordered = passEvents("ring across threads", queue, count);
+	ordered = passEvents("locked deque across threads", locked, count) && ordered;
+
+	// A full ring keeps the oldest events
+	static InputQueue full;
+	unsigned int extra = 10;
+	for (unsigned int i = 0; i < InputQueue::capacity() + extra; i++)
+		full.push(InputEvent{ InputEventType::KeyDown, (int)i, 0, 0, 0 });
+	bool drops = full.getDropped() == extra && full.size() == InputQueue::capacity();
+	for (unsigned int i = 0; drops && full.pop(event); i++)
+		drops = event.code == (int)i;
+
+	printf("\n%s\n", ordered ? "Every event arrived in order" : "Events were LOST or reordered");
+	printf("%s\n", drops ? "A full ring drops the new events" : "A full ring LOSES the old events");
+	return ordered && drops ? 0 : 1;
+}
@@ -0,0 +1,121 @@
+//
+// Jump Point Search benchmark
+//
+// Finds paths on maps of a few kinds and sizes with AStarPathfinder (a byte per cell) and JumpPointSearch (a bit per cell),
+// prints the time, the expanded cells (jump points), the memory of the grid and the search state of both, and checks that
+// they find paths of the same cost, with 4 and 8 neighbours
+// The paths go between random open cells far from each other, the same ones for both path finders
+//
+// Usage: jumppoints [max size] [searches]
+// (g++ -O2 -std=c++17 src/bench/jumppoints.cpp -o jumppoints)
+//
+
+#include "../AStar.hpp"
+#include "../JumpPointSearch.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+// Map with the obstacles in random cells
+void randomMap(PathGrid& grid, int percent) {
+	for (unsigned char& cell : grid.blocked)
+		cell = rand() % 100 < percent ? 1 : 0;
+}
+
+// Map of rooms (the walls every 32 cells with 4 doors in each room), with some random obstacles in them
+void roomsMap(PathGrid& grid) {
+	randomMap(grid, 3);
+	const int room = 32;
+	for (int y = 0; y < grid.height; y++)
+		for (int x = 0; x < grid.width; x++)
+			if (x % room == 0 || y % room == 0)
+				grid.setBlocked(x, y, true);
+	for (int y = 0; y < grid.height; y += room)
+		for (int x = 0; x < grid.width; x += room) {
+			grid.setBlocked(x + 1 + rand() % (room - 1), y, false);
+			grid.setBlocked(x, y + 1 + rand() % (room - 1), false);
+		}
+}
+
+// Map of long walls across every 16 rows with a gap somewhere in each, and a few random obstacles between them
+void wallsMap(PathGrid& grid) {
+	randomMap(grid, 1);
+	for (int y = 16; y < grid.height; y += 16) {
+		int gap = rand() % grid.width;
+		for (int x = 0; x < grid.width; x++)
+			grid.setBlocked(x, y, x < gap - 2 || x > gap + 2);
+	}
+}
+
+// Random open cell in the rectangle
+vec2<int> randomOpenCell(const PathGrid& grid, int minX, int minY, int maxX, int maxY) {
+	for (;;) {
+		vec2<int> cell(minX + rand() % (maxX - minX), minY + rand() % (maxY - minY));
+		if (grid.isOpen(cell.x, cell.y)) return cell;
+	}
+}
+
+double millisecondsSince(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+	int maxSize = argc > 1 ? atoi(argv[1]) : 4096;
+	int searches = argc > 2 ? atoi(argv[2]) : 5;
+	const char* mapNames[] = { "random 10%", "random 30%", "rooms", "walls" };
+	bool correct = true;
+	int found = 0, total = 0;
+
+	printf("%d searches on every map, times and expanded cells are the totals, MB is the grid and the search state\n\n", searches);
+	printf("%-6s %-11s %-10s %12s %12s %8s %12s %12s %8s %9s\n", "size", "map", "neighbours", "A* ms", "expanded", "MB", "JPS ms", "expanded", "MB", "speedup");
+	for (int size = 256; size <= maxSize; size *= 2)
+		for (int map = 0; map < 4; map++) {
+			PathGrid grid(size, size);
+			srand(size * 4 + map);
+			if (map == 0) randomMap(grid, 10);
+			else if (map == 1) randomMap(grid, 30);
+			else if (map == 2) roomsMap(grid);
+			else wallsMap(grid);
+			PathBitGrid bitGrid;
+			bitGrid.assign(grid);
+			std::vector<vec2<int>> starts, goals;
+			for (int i = 0; i < searches; i++) {
+				starts.push_back(randomOpenCell(grid, 0, 0, size / 4, size / 4));
+				goals.push_back(randomOpenCell(grid, size * 3 / 4, size * 3 / 4, size, size));
+			}
+
+			for (int neighbours = 4; neighbours <= 8; neighbours += 4) {
+				AStarPathfinder pathfinder;
+				JumpPointSearch jumpPoints;
+				pathfinder.connectivity = jumpPoints.connectivity = neighbours == 4 ? PathConnectivity::Four : PathConnectivity::Eight;
+				double aStarTime = 0.0, jumpTime = 0.0;
+				unsigned long long aStarExpanded = 0, jumpExpanded = 0;
+				size_t jumpMemory = 0;
+				for (int i = 0; i < searches; i++) {
+					auto begin = std::chrono::steady_clock::now();
+					pathfinder.findPath(grid, starts[i], goals[i]);
+					aStarTime += millisecondsSince(begin);
+					begin = std::chrono::steady_clock::now();
+					jumpPoints.findPath(bitGrid, starts[i], goals[i]);
+					jumpTime += millisecondsSince(begin);
+					aStarExpanded += pathfinder.getStats().expanded;
+					jumpExpanded += jumpPoints.getStats().expanded;
+					jumpMemory = std::max(jumpMemory, jumpPoints.memoryUsage());
+					found += pathfinder.getCost() != pathNoCost;
+					total++;
+					if (pathfinder.getCost() != jumpPoints.getCost()) {
+						printf("Search %d from (%d, %d) to (%d, %d): A* cost %u, JPS cost %u\n", i, starts[i].x, starts[i].y, goals[i].x, goals[i].y,
+							pathfinder.getCost(), jumpPoints.getCost());
+						correct = false;
+					}
+				}
+				printf("%-6d %-11s %-10d %12.2f %12llu %8.1f %12.2f %12llu %8.1f %8.1fx\n", size, mapNames[map], neighbours,
+					aStarTime, aStarExpanded, (grid.blocked.size() + pathfinder.memoryUsage()) / 1e6,
+					jumpTime, jumpExpanded, (bitGrid.memoryUsage() + jumpMemory) / 1e6, aStarTime / jumpTime);
+			}
+		}
+
+	printf("\n%d of %d searches found a path\n", found, total);
+	printf("%s\n", correct ? "Jump Point Search found paths of the same cost as A*" : "The costs DON'T match");
+	return correct ? 0 : 1;
+}
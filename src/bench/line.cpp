@@ -0,0 +1,123 @@
+//
+// Line rasterization benchmark
+//
+// Compares drawLine with the old version stamping a circle at every Bresenham step,
+// and checks that both of them draw the same pixels
+//
+// Usage: line
+//
+
+#include "../RenderTarget.hpp"
+#include "bench.hpp"
+#include <cstring>
+#include <vector>
+
+// Line rasterizer before the dedicated line engine
+struct OldLines {
+	RenderTarget& target;
+
+	void drawPixel(int x, int y, UINT32 color) {
+		if (x < target.bitmapWidth && y < target.bitmapHeight && x > 0 && y > 0)
+			target.getPixels()[y * target.bitmapWidth + x] = color;
+	}
+
+	void drawCircle(vec2<int> origin, int radius, UINT32 color) {
+		if (radius > 1) {
+			int rSq = radius * radius;
+			for (int y = -radius; y <= radius; y++)
+				for (int x = -radius; x <= radius; x++)
+					if (CEQ(x, y, rSq))
+						drawPixel(origin.x + x, origin.y + y, color);
+		}
+		else
+			drawPixel(origin.x, origin.y, color);
+	}
+
+	void drawLine(vec2<int> p1, vec2<int> p2, UINT32 color, unsigned short thickness) {
+		int x, y, e, pk;
+		int dx = p2.x - p1.x;
+		int dy = p2.y - p1.y;
+		int dxAbs = abs(dx);
+		int dyAbs = abs(dy);
+		if (dxAbs >= dyAbs) {
+			pk = 2 * dyAbs - dxAbs;
+			if (dx >= 0) { x = p1.x; y = p1.y; e = p2.x; }
+			else { x = p2.x; y = p2.y; e = p1.x; }
+			drawCircle(vec2<int>(x, y), thickness, color);
+			while (x < e) {
+				x++;
+				if (pk < 0)
+					pk += 2 * dyAbs;
+				else {
+					if ((dx < 0 && dy < 0) || (dx > 0 && dy > 0)) y++;
+					else y--;
+					pk += 2 * (dyAbs - dxAbs);
+				}
+				drawCircle(vec2<int>(x, y), thickness, color);
+			}
+		}
+		else {
+			pk = 2 * dxAbs - dyAbs;
+			if (dy >= 0) { x = p1.x; y = p1.y; e = p2.y; }
+			else { x = p2.x; y = p2.y; e = p1.y; }
+			drawCircle(vec2<int>(x, y), thickness, color);
+			while (y < e) {
+				y++;
+				if (pk <= 0)
+					pk += 2 * dxAbs;
+				else {
+					if ((dx < 0 && dy < 0) || (dx > 0 && dy > 0)) x++;
+					else x--;
+					pk += 2 * (dxAbs - dyAbs);
+				}
+				drawCircle(vec2<int>(x, y), thickness, color);
+			}
+		}
+	}
+};
+
+// Returns false if drawLine doesn't draw the same pixels as the old version (lines inside of the bitmap, the old one skips its first row and column)
+bool matchesOld(RenderTarget& target, OldLines& old, vec2<int> p1, vec2<int> p2, int thickness) {
+	std::vector<UINT32> oldPixels((size_t)target.bitmapWidth * target.bitmapHeight);
+	target.clearScreen(BLACK);
+	old.drawLine(p1, p2, WHITE, (unsigned short)thickness);
+	memcpy(oldPixels.data(), target.getPixels(), oldPixels.size() * sizeof(UINT32));
+	target.clearScreen(BLACK);
+	target.drawLine(p1, p2, WHITE, (unsigned short)thickness);
+	if (memcmp(oldPixels.data(), target.getPixels(), oldPixels.size() * sizeof(UINT32)) == 0) return true;
+	printf("Line (%d, %d) - (%d, %d) thickness %d DIFFERS from the old version\n", p1.x, p1.y, p2.x, p2.y, thickness);
+	return false;
+}
+
+int main() {
+	RenderTarget target(1200, 1200);
+	OldLines old = { target };
+	const double minSeconds = 0.1;
+	char name[64];
+
+	const int lengths[] = { 10, 100, 1000 };
+	const int thicknesses[] = { 1, 2, 5, 10, 20 };
+	// Direction of the line, the last one goes partially outside of the bitmap
+	const struct { const char* name; int dx, dy, startX; } shapes[] = {
+		{ "horizontal", 1, 0, 100 }, { "vertical", 0, 1, 100 }, { "diagonal", 3, 2, 100 }, { "clipped", 3, 2, -500 },
+	};
+
+	bool matches = true;
+	for (const auto& shape : shapes)
+		for (int length : lengths)
+			for (int thickness : thicknesses) {
+				double scale = (double)length / sqrt((double)(shape.dx * shape.dx + shape.dy * shape.dy));
+				vec2<int> p1 = vec2<int>(shape.startX, 100);
+				vec2<int> p2 = vec2<int>(shape.startX + (int)(shape.dx * scale), 100 + (int)(shape.dy * scale));
+				if (shape.startX > thickness)
+					matches = matchesOld(target, old, p1, p2, thickness) && matches;
+				snprintf(name, sizeof(name), "old %s l=%d t=%d", shape.name, length, thickness);
+				BenchResult oldResult = runBenchmark(name, [&] { old.drawLine(p1, p2, PINK, (unsigned short)thickness); }, minSeconds);
+				snprintf(name, sizeof(name), "new %s l=%d t=%d", shape.name, length, thickness);
+				BenchResult newResult = runBenchmark(name, [&] { target.drawLine(p1, p2, PINK, (unsigned short)thickness); }, minSeconds);
+				printf("%-40s %14.1fx\n", "speedup", oldResult.nsPerCall / newResult.nsPerCall);
+			}
+
+	printf("%s\n", matches ? "Lines draw the same pixels as the old version" : "Lines DIFFER from the old version");
+	return matches ? 0 : 1;
+}
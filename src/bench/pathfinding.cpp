@@ -0,0 +1,219 @@
+//
+// Path finding benchmark
+//
+// Finds a path between the opposite corners of grids with random obstacles with AStarPathfinder and with the solver the
+// pathfinding demo used before it (a std::list of the open tiles sorted on every step, a vector of neighbour pointers per tile),
+// and prints the time, the expanded cells and the memory of both
+// Checks the costs against a breadth-first search (4 neighbours) and Dijkstra's algorithm (8 neighbours)
+// The list solver is only run on the grids it finishes in a reasonable time, the obstacles are regenerated until the corners are connected
+//
+// Usage: pathfinding [max size] [obstacle percent]
+// (g++ -O2 -std=c++17 src/bench/pathfinding.cpp -o pathfinding)
+//
+
+#include "../AStar.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <list>
+#include <queue>
+
+// Tile of the list solver, like the pathfinding demo had it
+struct ListTile {
+	Rect rect;
+	bool isObstacle = false;
+	bool isVisited = false;
+	float globalGoal = INFINITY;
+	float localGoal = INFINITY;
+	vec2<int> coords = vec2<int>();
+	std::vector<ListTile*> neighbours = {};
+	ListTile* parent = nullptr;
+};
+
+// Solver of the pathfinding demo before AStarPathfinder, returns the number of the expanded tiles
+long long listSolve(std::vector<std::vector<ListTile>>& tiles, ListTile* tileStart, ListTile* tileEnd) {
+	auto dist = [](ListTile* a, ListTile* b) {
+		return sqrtf((float)((a->coords.x - b->coords.x) * (a->coords.x - b->coords.x) + (a->coords.y - b->coords.y) * (a->coords.y - b->coords.y)));
+	};
+	for (std::vector<ListTile>& row : tiles)
+		for (ListTile& tile : row) {
+			tile.isVisited = false;
+			tile.globalGoal = INFINITY;
+			tile.localGoal = INFINITY;
+			tile.parent = nullptr;
+		}
+	long long expanded = 0;
+	ListTile* tileCurrent = tileStart;
+	tileStart->localGoal = 0.0f;
+	tileStart->globalGoal = dist(tileStart, tileEnd);
+	std::list<ListTile*> notTestedTiles;
+	notTestedTiles.push_back(tileStart);
+	while (!notTestedTiles.empty()) {
+		notTestedTiles.sort([](ListTile* a, ListTile* b) { return a->globalGoal < b->globalGoal; });
+		while (!notTestedTiles.empty() && notTestedTiles.front()->isVisited)
+			notTestedTiles.pop_front();
+		// The demo stopped at the goal in its faster mode
+		if (notTestedTiles.empty() || tileCurrent == tileEnd)
+			break;
+		tileCurrent = notTestedTiles.front();
+		tileCurrent->isVisited = true;
+		expanded++;
+		for (ListTile* neighbour : tileCurrent->neighbours) {
+			if (!neighbour->isVisited && !neighbour->isObstacle)
+				notTestedTiles.push_back(neighbour);
+			float possibleLowerGoal = tileCurrent->localGoal + dist(tileCurrent, neighbour);
+			if (possibleLowerGoal < neighbour->localGoal) {
+				neighbour->parent = tileCurrent;
+				neighbour->localGoal = possibleLowerGoal;
+				neighbour->globalGoal = neighbour->localGoal + dist(neighbour, tileEnd);
+			}
+		}
+	}
+	return expanded;
+}
+
+// Number of the steps of the shortest 4-connected path, -1 if there is none
+long long breadthFirstSteps(const PathGrid& grid, vec2<int> start, vec2<int> goal) {
+	std::vector<int> steps(grid.size(), -1);
+	std::vector<int> queue;
+	queue.reserve(grid.size());
+	queue.push_back(grid.index(start.x, start.y));
+	steps[queue[0]] = 0;
+	const int dx[4] = { 1, -1, 0, 0 };
+	const int dy[4] = { 0, 0, 1, -1 };
+	for (size_t i = 0; i < queue.size(); i++) {
+		vec2<int> cell = grid.coords(queue[i]);
+		for (int d = 0; d < 4; d++) {
+			if (!grid.isOpen(cell.x + dx[d], cell.y + dy[d])) continue;
+			int next = grid.index(cell.x + dx[d], cell.y + dy[d]);
+			if (steps[next] >= 0) continue;
+			steps[next] = steps[queue[i]] + 1;
+			queue.push_back(next);
+		}
+	}
+	return steps[grid.index(goal.x, goal.y)];
+}
+
+// Cost of the cheapest 8-connected path (without cutting corners), pathNoCost if there is none
+PathCost dijkstraCost(const PathGrid& grid, vec2<int> start, vec2<int> goal) {
+	typedef std::pair<PathCost, int> Item;
+	std::vector<PathCost> costs(grid.size(), pathNoCost);
+	std::priority_queue<Item, std::vector<Item>, std::greater<Item>> queue;
+	costs[grid.index(start.x, start.y)] = 0;
+	queue.push(Item(0, grid.index(start.x, start.y)));
+	while (!queue.empty()) {
+		Item item = queue.top();
+		queue.pop();
+		if (item.first != costs[item.second]) continue;
+		vec2<int> cell = grid.coords(item.second);
+		for (int dy = -1; dy <= 1; dy++)
+			for (int dx = -1; dx <= 1; dx++) {
+				if ((dx == 0 && dy == 0) || !grid.isOpen(cell.x + dx, cell.y + dy)) continue;
+				if (dx != 0 && dy != 0 && (!grid.isOpen(cell.x + dx, cell.y) || !grid.isOpen(cell.x, cell.y + dy))) continue;
+				PathCost cost = item.first + (dx != 0 && dy != 0 ? pathDiagonalCost : pathStraightCost);
+				int next = grid.index(cell.x + dx, cell.y + dy);
+				if (cost < costs[next]) {
+					costs[next] = cost;
+					queue.push(Item(cost, next));
+				}
+			}
+	}
+	return costs[grid.index(goal.x, goal.y)];
+}
+
+// Milliseconds since the time
+double millisecondsSince(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Fastest of a few searches (the first one allocates the arrays), returns the milliseconds
+double timeSearches(AStarPathfinder& pathfinder, const PathGrid& grid, vec2<int> start, vec2<int> goal) {
+	double best = 1e300;
+	for (int run = 0; run < 3; run++) {
+		auto begin = std::chrono::steady_clock::now();
+		pathfinder.findPath(grid, start, goal);
+		best = std::min(best, millisecondsSince(begin));
+	}
+	return best;
+}
+
+int main(int argc, char** argv) {
+	int maxSize = argc > 1 ? atoi(argv[1]) : 4096;
+	int obstaclePercent = argc > 2 ? atoi(argv[2]) : 30;
+	// The list solver isn't run on the grids it would take longer than this on (in milliseconds), its time grows
+	// at least 16 times with each size: 4 times more cells expanded, each sorting a 4 times longer list
+	const double listLimit = 30000.0;
+	double listTime = 0.0;
+	bool correct = true;
+
+	printf("Random grids with %d%% of the cells blocked, from the top left corner to the bottom right one\n\n", obstaclePercent);
+	printf("%-6s %-18s %12s %12s %10s %12s\n", "size", "solver", "ms", "expanded", "MB", "cost");
+	for (int size = 256; size <= maxSize; size *= 2) {
+		PathGrid grid;
+		if (!grid.create(size, size)) {
+			fprintf(stderr, "A %dx%d grid is too big\n", size, size);
+			return 1;
+		}
+		vec2<int> start(0, 0);
+		vec2<int> goal(size - 1, size - 1);
+		// Other obstacles are tried until the corners are connected (a corner walled in by a few cells is quick to search)
+		long long steps = -1;
+		for (unsigned int seed = size; steps < 0 && seed < (unsigned int)size + 100; seed++) {
+			srand(seed);
+			for (unsigned char& cell : grid.blocked)
+				cell = rand() % 100 < obstaclePercent ? 1 : 0;
+			grid.setBlocked(start.x, start.y, false);
+			grid.setBlocked(goal.x, goal.y, false);
+			steps = breadthFirstSteps(grid, start, goal);
+		}
+		double gridMegabytes = grid.blocked.size() / 1e6;
+
+		PathCost expected4 = steps < 0 ? pathNoCost : (PathCost)steps * pathStraightCost;
+		PathCost expected8 = dijkstraCost(grid, start, goal);
+
+		AStarPathfinder pathfinder;
+		double time = timeSearches(pathfinder, grid, start, goal);
+		printf("%-6d %-18s %12.2f %12llu %10.1f %12u\n", size, "A* 4 neighbours", time, pathfinder.getStats().expanded,
+			gridMegabytes + pathfinder.memoryUsage() / 1e6, pathfinder.getCost());
+		correct = correct && pathfinder.getCost() == expected4;
+
+		pathfinder.connectivity = PathConnectivity::Eight;
+		time = timeSearches(pathfinder, grid, start, goal);
+		printf("%-6s %-18s %12.2f %12llu %10.1f %12u\n", "", "A* 8 neighbours", time, pathfinder.getStats().expanded,
+			gridMegabytes + pathfinder.memoryUsage() / 1e6, pathfinder.getCost());
+		correct = correct && pathfinder.getCost() == expected8;
+
+		if (listTime * 16.0 > listLimit) {
+			printf("%-6s %-18s %12s (would take over %.0f s)\n", "", "list solver", "skipped", listTime * 16.0 / 1000.0);
+			continue;
+		}
+		// Each tile with its own vector of neighbours, like the demo built them
+		auto begin = std::chrono::steady_clock::now();
+		std::vector<std::vector<ListTile>> tiles(size, std::vector<ListTile>(size));
+		size_t neighbourBytes = 0;
+		for (int y = 0; y < size; y++)
+			for (int x = 0; x < size; x++) {
+				ListTile& tile = tiles[y][x];
+				tile.coords = vec2<int>(x, y);
+				tile.isObstacle = grid.blocked[grid.index(x, y)] != 0;
+				if (x < size - 1) tile.neighbours.push_back(&tiles[y][x + 1]);
+				if (x > 0) tile.neighbours.push_back(&tiles[y][x - 1]);
+				if (y < size - 1) tile.neighbours.push_back(&tiles[y + 1][x]);
+				if (y > 0) tile.neighbours.push_back(&tiles[y - 1][x]);
+				neighbourBytes += tile.neighbours.capacity() * sizeof(ListTile*);
+			}
+		double buildTime = millisecondsSince(begin);
+		begin = std::chrono::steady_clock::now();
+		long long expanded = listSolve(tiles, &tiles[0][0], &tiles[size - 1][size - 1]);
+		listTime = millisecondsSince(begin);
+		float listCost = tiles[size - 1][size - 1].localGoal;
+		printf("%-6s %-18s %12.2f %12lld %10.1f %12.0f (+ %.2f ms building the tiles)\n", "", "list solver", listTime, expanded,
+			((double)size * size * sizeof(ListTile) + neighbourBytes) / 1e6, std::isinf(listCost) ? -1.0f : listCost * pathStraightCost, buildTime);
+		correct = correct && (std::isinf(listCost) ? expected4 == pathNoCost : (PathCost)lroundf(listCost * pathStraightCost) == expected4);
+	}
+
+	printf("\n%s\n", correct ? "The costs match the breadth-first search and Dijkstra's algorithm" : "The costs DON'T match");
+	return correct ? 0 : 1;
+}
@@ -0,0 +1,131 @@
+//
+// Profiler benchmark
+//
+// Measures the cost of a GRAPHICS_PROFILE_SCOPE, then draws frames right away and deferred on 4 threads
+// with the profiler on, prints where the frame time went and writes the deferred frames as a Chrome trace
+// (open it in chrome://tracing or ui.perfetto.dev), the frames have to fit in the rings of the threads
+//
+// Usage: profiler [width] [height] [frames] [trace path]
+// (g++ -O2 -std=c++17 -pthread src/bench/profiler.cpp -o profiler)
+//
+
+#define GRAPHICS_PROFILE
+#include "../TileRenderer.hpp"
+#include "bench.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+// Random point in the target
+vec2<int> randomPoint(const RenderTarget& target) {
+	return vec2<int>(rand() % target.bitmapWidth, rand() % target.bitmapHeight);
+}
+
+// Draws a frame where the clears, triangles, lines and text all take a noticeable share of the time
+void drawScene(RenderTarget& target) {
+	srand(11);
+	target.clearScreen(0x202020);
+	for (int i = 0; i < 2000; i++) {
+		vec2<int> v1 = randomPoint(target);
+		target.drawTriangle(v1, vec2<int>(v1.x + rand() % 61 - 30, v1.y + rand() % 61 - 30), vec2<int>(v1.x + rand() % 61 - 30, v1.y + rand() % 61 - 30), (UINT32)(rand() & 0xFFFFFF));
+	}
+	for (int i = 0; i < 500; i++)
+		target.drawLine(randomPoint(target), randomPoint(target), (UINT32)(rand() & 0xFFFFFF), (unsigned short)(i % 4 == 0 ? 3 : 1));
+	for (int i = 0; i < 100; i++)
+		target.drawCircle(randomPoint(target), rand() % 60, (UINT32)(rand() & 0xFFFFFF));
+	for (int i = 0; i < 100; i++)
+		target.drawAntialiasedLine(randomPoint(target), randomPoint(target), (UINT32)(rand() & 0xFFFFFF), 2);
+	for (int i = 0; i < 50; i++) {
+		vec2<int> point = randomPoint(target);
+		target.drawText(point.x, point.y, L"The quick brown fox jumps over the lazy dog", 16, WHITE);
+	}
+	target.drawFrameGraph(vec2<int>(10, target.bitmapHeight - 110));
+}
+
+// Total time and calls of the scopes with the same name
+struct ScopeTotal {
+	const char* name;
+	long long nanoseconds;
+	long long calls;
+};
+
+// Prints the scopes that took the most time, as a share of the frames
+void printTotals() {
+	std::vector<ProfileEvent> events;
+	std::vector<int> threadIds;
+	profiler().collect(events, threadIds);
+	std::vector<ScopeTotal> totals;
+	long long frameTime = 0;
+	for (const ProfileEvent& event : events) {
+		if (strcmp(event.name, "frame") == 0) {
+			frameTime += event.duration;
+			continue;
+		}
+		auto found = std::find_if(totals.begin(), totals.end(), [&](const ScopeTotal& total) { return strcmp(total.name, event.name) == 0; });
+		if (found == totals.end())
+			totals.push_back(ScopeTotal{ event.name, event.duration, 1 });
+		else {
+			found->nanoseconds += event.duration;
+			found->calls++;
+		}
+	}
+	std::sort(totals.begin(), totals.end(), [](const ScopeTotal& a, const ScopeTotal& b) { return a.nanoseconds > b.nanoseconds; });
+	for (const ScopeTotal& total : totals)
+		printf("%-40s %14.1f ns/call %12lld calls %8.1f%% of frames\n", total.name, (double)total.nanoseconds / total.calls, total.calls,
+			frameTime > 0 ? total.nanoseconds * 100.0 / frameTime : 0.0);
+}
+
+int main(int argc, char** argv) {
+	int width = argc > 1 ? atoi(argv[1]) : 1920;
+	int height = argc > 2 ? atoi(argv[2]) : 1080;
+	int frames = argc > 3 ? atoi(argv[3]) : 10;
+	const char* path = argc > 4 ? argv[4] : "trace.json";
+
+	RenderTarget target;
+	if (width <= 200 || height <= 200 || frames <= 0 || !target.create(width, height)) {
+		fprintf(stderr, "Couldn't create a %dx%d render target\n", width, height);
+		return 1;
+	}
+	printf("Render target: %dx%d, %d frames, ring of %u events per thread\n", width, height, frames, ProfileThreadBuffer::capacity);
+
+	// Cost of recording one scope (two clock reads and a write to the ring), the ring is cleared afterwards
+	runBenchmark("GRAPHICS_PROFILE_SCOPE", [] { GRAPHICS_PROFILE_SCOPE("scope"); });
+	profiler().clear();
+
+	printf("\nImmediate\n");
+	GRAPHICS_PROFILE_THREAD("main");
+	GRAPHICS_PROFILE_FRAME();
+	for (int frame = 0; frame < frames; frame++) {
+		drawScene(target);
+		target.finishPresent();
+		GRAPHICS_PROFILE_FRAME();
+	}
+	printTotals();
+	printf("%-40s %14.2f ms\n", "last frame", profiler().getFrameTime(0));
+	profiler().clear();
+
+	// Only the deferred frames are written to the trace
+	printf("\nDeferred on 4 threads (the shares are summed over the threads)\n");
+	TileRenderer renderer(4);
+	GRAPHICS_PROFILE_FRAME();
+	DrawCommandList list;
+	for (int frame = 0; frame < frames; frame++) {
+		target.beginRecording(list);
+		list.clear();
+		drawScene(target);
+		target.endRecording();
+		renderer.render(target, list);
+		target.finishPresent();
+		GRAPHICS_PROFILE_FRAME();
+	}
+	printTotals();
+	printf("%-40s %14.2f ms\n", "last frame", profiler().getFrameTime(0));
+
+	if (!profiler().writeChromeTrace(path)) {
+		fprintf(stderr, "Couldn't write %s\n", path);
+		return 1;
+	}
+	printf("\nTrace written to %s\n", path);
+	return 0;
+}
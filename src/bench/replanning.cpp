@@ -0,0 +1,139 @@
+//
+// Incremental replanning benchmark
+//
+// Changes random grids one cell at a time like an editor does (blocking cells of the current path and opening the ones blocked
+// before) and moves the start along the path like a unit walking it and seeing the obstacles it didn't know about once they're
+// close (5% more of the cells), then finds the path again after every change with DStarLite (repairing the last search)
+// and with AStarPathfinder (solving again)
+// Prints the time and the cells expanded by both and checks that the costs match after every change
+//
+// Usage: replanning [max size] [changes]
+// (g++ -O2 -std=c++17 src/bench/replanning.cpp -o replanning)
+//
+
+#include "../AStar.hpp"
+#include "../DStarLite.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+double millisecondsSince(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Totals of one path finder over the changes
+struct Totals {
+	double time = 0.0;
+	unsigned long long expanded = 0;
+};
+
+// Finds the path after a change with both path finders, returns false if the costs differ
+bool compare(DStarLite& incremental, AStarPathfinder& pathfinder, vec2<int> start, vec2<int> goal, Totals& incrementalTotals, Totals& fullTotals) {
+	auto begin = std::chrono::steady_clock::now();
+	incremental.findPath();
+	incrementalTotals.time += millisecondsSince(begin);
+	incrementalTotals.expanded += incremental.getStats().expanded;
+	begin = std::chrono::steady_clock::now();
+	pathfinder.findPath(incremental.getGrid(), start, goal);
+	fullTotals.time += millisecondsSince(begin);
+	fullTotals.expanded += pathfinder.getStats().expanded;
+	if (incremental.getCost() == pathfinder.getCost()) return true;
+	printf("From (%d, %d) to (%d, %d): D* Lite cost %u, A* cost %u\n", start.x, start.y, goal.x, goal.y, incremental.getCost(), pathfinder.getCost());
+	return false;
+}
+
+void printTotals(int size, const char* scenario, int changes, const Totals& incrementalTotals, const Totals& fullTotals) {
+	printf("%-6d %-10s %8d %12.2f %14llu %12.2f %14llu %10.1fx %10.1fx\n", size, scenario, changes, incrementalTotals.time, incrementalTotals.expanded,
+		fullTotals.time, fullTotals.expanded, fullTotals.time / incrementalTotals.time, (double)fullTotals.expanded / incrementalTotals.expanded);
+}
+
+int main(int argc, char** argv) {
+	int maxSize = argc > 1 ? atoi(argv[1]) : 1024;
+	int changes = argc > 2 ? atoi(argv[2]) : 200;
+	// How far the unit sees the obstacles
+	const int sight = 3;
+	bool correct = true;
+	std::vector<vec2<int>> path;
+
+	printf("Random grids with 25%% of the cells blocked, times and expanded cells are the totals over the changes\n\n");
+	printf("%-6s %-10s %8s %12s %14s %12s %14s %11s %11s\n", "size", "scenario", "changes", "D* Lite ms", "expanded", "A* ms", "expanded", "time", "expanded");
+	for (int size = 256; size <= maxSize; size *= 2)
+		for (int neighbours = 4; neighbours <= 8; neighbours += 4) {
+			PathConnectivity connectivity = neighbours == 4 ? PathConnectivity::Four : PathConnectivity::Eight;
+			PathGrid grid(size, size);
+			// The grid with the obstacles the unit only sees close
+			PathGrid hidden(size, size);
+			vec2<int> start(0, 0);
+			vec2<int> goal(size - 1, size - 1);
+			AStarPathfinder pathfinder;
+			pathfinder.connectivity = connectivity;
+			// Other obstacles are tried until the corners are connected
+			for (unsigned int seed = size * 2 + neighbours; ; seed += 16) {
+				srand(seed);
+				for (size_t i = 0; i < grid.blocked.size(); i++) {
+					int random = rand() % 100;
+					grid.blocked[i] = random < 25 ? 1 : 0;
+					hidden.blocked[i] = random < 30 ? 1 : 0;
+				}
+				grid.setBlocked(start.x, start.y, false);
+				grid.setBlocked(goal.x, goal.y, false);
+				hidden.setBlocked(start.x, start.y, false);
+				hidden.setBlocked(goal.x, goal.y, false);
+				if (pathfinder.findPath(hidden, start, goal) && pathfinder.findPath(grid, start, goal)) break;
+			}
+
+			// An editor blocking the cells of the path and opening them again
+			DStarLite incremental;
+			incremental.create(grid, connectivity);
+			incremental.setStart(start);
+			incremental.setGoal(goal);
+			incremental.findPath();
+			printf("%-6d %-10s %8s %12s %14llu %12s %14llu  (the first search, %d neighbours)\n", size, "", "", "", incremental.getStats().expanded,
+				"", pathfinder.getStats().expanded, neighbours);
+			Totals incrementalTotals, fullTotals;
+			std::vector<vec2<int>> blocked;
+			for (int change = 0; change < changes; change++) {
+				incremental.getPath(path);
+				if (!blocked.empty() && (rand() % 2 == 0 || path.size() < 3)) {
+					int i = rand() % (int)blocked.size();
+					incremental.setBlocked(blocked[i].x, blocked[i].y, false);
+					blocked[i] = blocked.back();
+					blocked.pop_back();
+				}
+				else if (path.size() >= 3) {
+					vec2<int> cell = path[1 + rand() % ((int)path.size() - 2)];
+					incremental.setBlocked(cell.x, cell.y, true);
+					blocked.push_back(cell);
+				}
+				correct = compare(incremental, pathfinder, start, goal, incrementalTotals, fullTotals) && correct;
+			}
+			printTotals(size, "editor", changes, incrementalTotals, fullTotals);
+
+			// A unit walking the path and seeing the hidden obstacles around it, a step and the obstacles seen are one change
+			incremental.create(grid, connectivity);
+			incremental.setStart(start);
+			incremental.setGoal(goal);
+			incremental.findPath();
+			incrementalTotals = fullTotals = Totals();
+			vec2<int> unit = start;
+			int steps = 0;
+			for (; steps < changes; steps++) {
+				for (int y = unit.y - sight; y <= unit.y + sight; y++)
+					for (int x = unit.x - sight; x <= unit.x + sight; x++)
+						if (hidden.isInside(x, y) && !hidden.isOpen(x, y))
+							incremental.setBlocked(x, y, true);
+				incremental.setStart(unit);
+				if (!compare(incremental, pathfinder, unit, goal, incrementalTotals, fullTotals)) {
+					correct = false;
+					break;
+				}
+				incremental.getPath(path);
+				if (path.size() < 2) break;
+				unit = path[1];
+			}
+			printTotals(size, "walking", steps, incrementalTotals, fullTotals);
+		}
+
+	printf("\n%s\n", correct ? "The costs match A* after every change" : "The costs DON'T match");
+	return correct ? 0 : 1;
+}
@@ -0,0 +1,337 @@
+//
+// Draw stream replay
+//
+// Replays a stream captured with GraphicsEngine::startCapture on an offscreen target as fast as possible, without the window
+// or the app, and prints how long every frame took to draw, the slowest frames and the draw calls and input events in them
+// The stream is replayed a few times and the frames are hashed, so any frame that comes out different is reported
+// Without a stream it captures a test scene (immediate and deferred frames, display lists, clipping, images, text and curves)
+// and checks that the replayed frames are exactly the ones that were drawn
+//
+// Usage: replay [stream.gds] [repeats] [frame_%05d.ppm]
+// (g++ -O2 -std=c++17 -pthread src/bench/replay.cpp -o replay)
+//
+
+#include "../DrawStream.hpp"
+#include "../HeadlessPresenter.hpp"
+#include "../TileRenderer.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+
+// Timings and hash of a replayed frame
+struct ReplayedFrame {
+	double minMilliseconds = 1e300;
+	double totalMilliseconds = 0.0;
+	unsigned long long hash = 0;
+	size_t commands = 0;
+	size_t events = 0;
+};
+
+// FNV-1a hash of the pixels of the target
+unsigned long long hashPixels(const RenderTarget& target) {
+	unsigned long long hash = 14695981039346656037ull;
+	const unsigned char* bytes = (const unsigned char*)target.getPixels();
+	for (size_t i = 0; i < (size_t)target.bitmapWidth * target.bitmapHeight * sizeof(UINT32); i++)
+		hash = (hash ^ bytes[i]) * 1099511628211ull;
+	return hash;
+}
+
+// Replays all of the frames of the stream repeats times, returns false if the stream couldn't be read
+// The first pass writes the frames as PPM files if there is a pattern, the hashes of the later passes are compared with it
+bool replayStream(const char* path, int repeats, const char* ppmPattern, std::vector<ReplayedFrame>& frames, bool& deterministic) {
+	DrawStreamReader reader;
+	if (!reader.open(path)) {
+		fprintf(stderr, "%s isn't a draw stream\n", path);
+		return false;
+	}
+	RenderTarget target;
+	DrawStreamFrame frame;
+	deterministic = true;
+	double readMilliseconds = 0.0;
+	for (int pass = 0; pass < repeats; pass++) {
+		reader.rewind();
+		// Every pass starts from a cleared target like the capture did
+		target.release();
+		size_t index = 0;
+		for (;;) {
+			auto readStart = std::chrono::steady_clock::now();
+			if (!reader.nextFrame(frame)) break;
+			readMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - readStart).count();
+			// The frames of another size start from a cleared bitmap, like after resizing the window
+			if (frame.width != target.bitmapWidth || frame.height != target.bitmapHeight)
+				target.create(frame.width, frame.height);
+
+			auto start = std::chrono::steady_clock::now();
+			target.replay(frame.commands);
+			double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			target.finishPresent();
+
+			if (pass == 0) {
+				frames.push_back(ReplayedFrame());
+				frames[index].commands = frame.commands.size();
+				frames[index].events = frame.events.size();
+				frames[index].hash = hashPixels(target);
+				if (ppmPattern) {
+					char name[512];
+					snprintf(name, sizeof(name), ppmPattern, (int)index);
+					writePPM(target, name);
+				}
+			}
+			else if (index >= frames.size() || hashPixels(target) != frames[index].hash)
+				deterministic = false;
+			if (index < frames.size()) {
+				frames[index].minMilliseconds = std::min(frames[index].minMilliseconds, milliseconds);
+				frames[index].totalMilliseconds += milliseconds;
+			}
+			index++;
+		}
+		if (reader.isDamaged()) {
+			fprintf(stderr, "%s is damaged after frame %zu\n", path, index);
+			return false;
+		}
+		if (index != frames.size())
+			deterministic = false;
+	}
+	printf("%zu frames, %zu images, %.3f ms per frame to read\n", frames.size(), reader.getImageCount(),
+		frames.empty() ? 0.0 : readMilliseconds / repeats / (double)frames.size());
+	return true;
+}
+
+// Prints the frame times and the slowest frames
+void printFrames(const std::vector<ReplayedFrame>& frames, int repeats) {
+	if (frames.empty()) return;
+	double minTotal = 0.0;
+	double averageTotal = 0.0;
+	size_t commands = 0;
+	size_t events = 0;
+	for (const ReplayedFrame& frame : frames) {
+		minTotal += frame.minMilliseconds;
+		averageTotal += frame.totalMilliseconds / repeats;
+		commands += frame.commands;
+		events += frame.events;
+	}
+	printf("%zu draw calls and %zu input events, %.1f draw calls per frame\n", commands, events, (double)commands / frames.size());
+	printf("%.3f ms per frame (fastest pass %.3f ms), %.0f frames per second\n\n", averageTotal / frames.size(), minTotal / frames.size(),
+		frames.size() / (averageTotal / 1000.0));
+
+	std::vector<size_t> order(frames.size());
+	for (size_t i = 0; i < order.size(); i++)
+		order[i] = i;
+	std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return frames[a].minMilliseconds > frames[b].minMilliseconds; });
+	printf("Slowest frames:\n");
+	for (size_t i = 0; i < order.size() && i < 5; i++) {
+		const ReplayedFrame& frame = frames[order[i]];
+		printf("  frame %6zu %10.3f ms %8zu draw calls %4zu input events\n", order[i], frame.minMilliseconds, frame.commands, frame.events);
+	}
+}
+
+// Random point in the target, a bit outside of it so that the clipping is tested too
+vec2<int> randomPoint(const RenderTarget& target) {
+	return vec2<int>(rand() % (target.bitmapWidth + 100) - 50, rand() % (target.bitmapHeight + 100) - 50);
+}
+
+// Random color
+UINT32 randomColor() {
+	return (UINT32)((rand() & 0xFF) << 16 | (rand() & 0xFF) << 8 | (rand() & 0xFF));
+}
+
+// Draws a frame of the test scene with every kind of draw call, the frames don't clear everything so they build on each other
+void drawTestFrame(RenderTarget& target, int frame, const Image& sprite, const DrawCommandList& grid) {
+	srand(frame + 1);
+	target.drawRectangle(vec2<int>(0, 0), target.bitmapWidth, target.bitmapHeight / 2, 0x101830);
+	target.replay(grid, vec2<int>(frame * 3 % 40, frame % 20));
+	target.pushClipRect(Rect(vec2<int>(40, 30), target.bitmapWidth - 80, target.bitmapHeight - 60));
+	for (int i = 0; i < 40; i++) {
+		target.drawTriangle(randomPoint(target), randomPoint(target), randomPoint(target), randomColor());
+		target.drawLine(randomPoint(target), randomPoint(target), randomColor(), (unsigned short)(rand() % 4));
+		target.drawAntialiasedLine(randomPoint(target), randomPoint(target), randomColor(), (unsigned short)(rand() % 4));
+	}
+	target.drawTriangle(vec2<float>(10.25f, 20.5f), vec2<float>(300.75f, 40.125f), vec2<float>(120.5f, 260.0f), randomColor());
+	for (int i = 0; i < 10; i++) {
+		target.drawCircle(randomPoint(target), rand() % 40, randomColor());
+		target.drawEmptyCircle(randomPoint(target), rand() % 60, randomColor(), (unsigned short)(rand() % 5));
+		target.drawAntialiasedCircle(randomPoint(target), rand() % 40, randomColor());
+		target.drawAntialiasedEmptyCircle(randomPoint(target), rand() % 60, randomColor(), (unsigned short)(rand() % 5));
+		target.drawBezierCurve(randomPoint(target), randomPoint(target), randomPoint(target), randomColor(), (unsigned short)(rand() % 3));
+		target.drawBezierCurve(randomPoint(target), randomPoint(target), randomPoint(target), randomPoint(target), randomColor(), 1);
+	}
+	std::vector<vec2<int>> curves(200 * 4);
+	for (vec2<int>& point : curves)
+		point = randomPoint(target);
+	target.drawBezierCurves(curves.data(), 200, 3, randomColor(), 0);
+	target.drawBezierCurves(curves.data(), 266, 2, randomColor(), 1);
+	target.popClipRect();
+	for (int i = 0; i < 30; i++) {
+		vec2<int> point = randomPoint(target);
+		target.drawImage(sprite, point.x, point.y, Rect(vec2<int>(i % 4 * 8, 0), 32, 40), (BlitMode)(i % 3), 0);
+		target.drawPixel(rand() % target.bitmapWidth, rand() % target.bitmapHeight, randomColor());
+	}
+	wchar_t text[64];
+	swprintf(text, 64, L"Frame %d éß", frame);
+	target.drawText(20 + frame % 50, target.bitmapHeight - 40, text, 16 + frame % 3 * 8, WHITE);
+}
+
+// Captures frames of the test scene to the path like the engine does, the hashes of the drawn frames go to expected
+// The second half of the frames is deferred and drawn by a TileRenderer, a frame in the middle changes the size
+// and a later one changes the pixels of the sprite in place, the stream has to write it again
+bool captureTestScene(const char* path, int frameCount, std::vector<unsigned long long>& expected) {
+	RenderTarget target(640, 480);
+	Image sprite;
+	sprite.create(64, 48);
+	for (int y = 0; y < sprite.height; y++)
+		for (int x = 0; x < sprite.width; x++)
+			sprite.getRow(y)[x] = (UINT32)(x * y * 7 % 256) << 24 | (UINT32)(x * 4) << 16 | (UINT32)(y * 5) << 8 | 0x40;
+	DrawCommandList grid;
+	target.beginRecording(grid);
+	for (int x = 0; x < target.bitmapWidth; x += 32)
+		target.drawLine(vec2<int>(x, 0), vec2<int>(x, target.bitmapHeight), 0x303030, 1);
+	target.drawBezierCurve(vec2<int>(0, 0), vec2<int>(200, 300), vec2<int>(400, 0), 0x505050, 2);
+	target.drawText(100, 100, L"grid", 24, 0x808080);
+	target.endRecording();
+
+	// Something drawn before the capture, the first captured frame starts from it
+	target.clearScreen(0x332211);
+	target.drawCircle(vec2<int>(320, 240), 100, GREEN);
+
+	DrawStreamWriter writer;
+	if (!writer.open(path)) {
+		fprintf(stderr, "Couldn't create %s\n", path);
+		return false;
+	}
+	DrawCommandList captured;
+	DrawCommandList deferred;
+	TileRenderer renderer(4);
+	Image start;
+	start.create(target.bitmapWidth, target.bitmapHeight);
+	for (int y = 0; y < target.bitmapHeight; y++)
+		memcpy(start.getRow(y), target.getPixels() + (size_t)y * target.bitmapWidth, (size_t)target.bitmapWidth * sizeof(UINT32));
+	target.beginCapture(captured);
+	target.drawImage(start, 0, 0);
+
+	for (int frame = 0; frame < frameCount; frame++) {
+		if (frame == frameCount / 3)
+			target.create(800, 500);
+		if (frame == frameCount * 2 / 3)
+			for (int y = 0; y < sprite.height; y++)
+				for (int x = 0; x < sprite.width; x++)
+					sprite.getRow(y)[x] ^= 0x00FFFFFF;
+		bool deferFrame = frame >= frameCount / 2;
+		if (deferFrame)
+			target.beginRecording(deferred);
+		drawTestFrame(target, frame, sprite, grid);
+		if (deferFrame) {
+			target.endRecording();
+			renderer.render(target, deferred);
+			for (const DrawCommand& command : deferred.commands)
+				captured.append(command, deferred, vec2<int>(0, 0));
+			deferred.clear();
+		}
+		InputEvent events[3] = {
+			{ InputEventType::MouseMove, 0, frame * 5, -frame, inputClock() },
+			{ InputEventType::KeyDown, 'A' + frame % 26, 0, 0, inputClock() },
+			{ InputEventType::ButtonUp, (int)MouseButton::Right, 1 << 20, 3, inputClock() },
+		};
+		if (!writer.writeFrame(captured, target.bitmapWidth, target.bitmapHeight, events, frame % 4)) {
+			fprintf(stderr, "Couldn't write %s\n", path);
+			return false;
+		}
+		captured.clear();
+		expected.push_back(hashPixels(target));
+		target.finishPresent();
+	}
+	target.endCapture();
+	DrawStreamWriter::Stats stats = writer.getStats();
+	printf("Captured %llu frames, %llu draw calls, %llu input events and %llu images in %.1f KB (%.1f bytes per draw call)\n",
+		stats.frames, stats.commands, stats.inputEvents, stats.images, stats.bytes / 1024.0, (double)stats.bytes / (double)stats.commands);
+	return writer.close();
+}
+
+// Checks that the input events come back as they were written
+bool checkEvents(const char* path) {
+	DrawStreamReader reader;
+	DrawStreamFrame frame;
+	if (!reader.open(path)) return false;
+	for (int index = 0; reader.nextFrame(frame); index++) {
+		if (frame.events.size() != (size_t)(index % 4)) return false;
+		for (size_t i = 0; i < frame.events.size(); i++) {
+			const InputEvent& event = frame.events[i];
+			bool same = i == 0 ? event.type == InputEventType::MouseMove && event.x == index * 5 && event.y == -index
+				: i == 1 ? event.type == InputEventType::KeyDown && event.code == 'A' + index % 26
+				: event.type == InputEventType::ButtonUp && event.code == (int)MouseButton::Right && event.x == 1 << 20;
+			if (!same || event.timestamp < 0 || event.timestamp > frame.time) return false;
+		}
+	}
+	return !reader.isDamaged();
+}
+
+// Damaged copies of the stream have to be refused or replayed without crashing
+bool checkDamaged(const char* path) {
+	FILE* file = fopen(path, "rb");
+	if (!file) return false;
+	std::vector<unsigned char> bytes;
+	unsigned char buffer[65536];
+	for (size_t read; (read = fread(buffer, 1, sizeof(buffer), file)) > 0;)
+		bytes.insert(bytes.end(), buffer, buffer + read);
+	fclose(file);
+
+	const char* damagedPath = "replay_damaged.gds";
+	int refused = 0;
+	srand(3);
+	for (int attempt = 0; attempt < 20; attempt++) {
+		std::vector<unsigned char> damaged = bytes;
+		if (attempt % 2 == 0)
+			damaged.resize(8 + rand() % (damaged.size() - 8));
+		for (int i = 0; i < 1 + attempt % 8; i++)
+			damaged[8 + rand() % (damaged.size() - 8)] = (unsigned char)rand();
+		file = fopen(damagedPath, "wb");
+		if (!file) return false;
+		fwrite(damaged.data(), 1, damaged.size(), file);
+		fclose(file);
+
+		DrawStreamReader reader;
+		DrawStreamFrame frame;
+		RenderTarget target;
+		reader.open(damagedPath);
+		while (reader.nextFrame(frame)) {
+			if (frame.width != target.bitmapWidth || frame.height != target.bitmapHeight)
+				target.create(frame.width, frame.height);
+			target.replay(frame.commands);
+		}
+		refused += reader.isDamaged();
+	}
+	remove(damagedPath);
+	printf("%d of 20 damaged streams were refused, the rest replayed what they could\n", refused);
+	return true;
+}
+
+int main(int argc, char** argv) {
+	int repeats = argc > 2 ? atoi(argv[2]) : 5;
+	const char* ppmPattern = argc > 3 ? argv[3] : nullptr;
+	if (repeats < 1) repeats = 1;
+
+	std::vector<ReplayedFrame> frames;
+	bool deterministic = true;
+	if (argc > 1) {
+		if (!replayStream(argv[1], repeats, ppmPattern, frames, deterministic)) return 1;
+		printFrames(frames, repeats);
+		printf("\n%s\n", deterministic ? "Every pass drew the same frames" : "The passes drew DIFFERENT frames");
+		return deterministic ? 0 : 1;
+	}
+
+	const char* path = "replay_test.gds";
+	std::vector<unsigned long long> expected;
+	if (!captureTestScene(path, 60, expected) || !replayStream(path, repeats, ppmPattern, frames, deterministic)) return 1;
+	printFrames(frames, repeats);
+
+	bool same = frames.size() == expected.size();
+	for (size_t i = 0; same && i < frames.size(); i++)
+		same = frames[i].hash == expected[i];
+	bool events = checkEvents(path);
+	bool damaged = checkDamaged(path);
+	remove(path);
+	printf("\n%s\n", same ? "The replayed frames are identical to the drawn ones" : "The replayed frames DIFFER from the drawn ones");
+	printf("%s\n", deterministic ? "Every pass drew the same frames" : "The passes drew DIFFERENT frames");
+	printf("%s\n", events ? "The input events are read back as they were written" : "The input events DON'T match");
+	return same && deterministic && events && damaged ? 0 : 1;
+}
@@ -0,0 +1,104 @@
+//
+// Frame scheduler benchmark
+//
+// Runs a main loop drawing a frame with a fixed update step at the target frame rate, paced by FrameScheduler
+// and by busy-waiting for the deadline like an unpaced loop spinning on the clock would, and prints the frame times,
+// the jitter and the CPU time used
+// Checks that the paced loop keeps the frame rate, hands out the right number of fixed steps and sleeps instead of spinning
+//
+// Usage: scheduler [frame rate] [seconds]
+// (g++ -O2 -std=c++17 src/bench/scheduler.cpp -o scheduler)
+//
+
+#include "../RenderTarget.hpp"
+#include "../FrameScheduler.hpp"
+#include <cstdlib>
+#include <ctime>
+
+// Result of a paced run
+struct LoopResult {
+	FrameScheduler::Stats stats;
+	// Share of the wall time the process spent on the CPU
+	double cpuFraction;
+	// Fixed steps taken and the ones the elapsed time should have had
+	long long steps;
+	long long expectedSteps;
+};
+
+// Draws a few hundred triangles moved by the fixed steps, a few milliseconds of work
+void drawFrame(RenderTarget& target, int position) {
+	srand(5);
+	target.clearScreen(0x202020);
+	for (int i = 0; i < 400; i++) {
+		int x = (rand() + position) % target.bitmapWidth;
+		int y = rand() % target.bitmapHeight;
+		target.drawTriangle(vec2<int>(x, y), vec2<int>(x + 40, y + 10), vec2<int>(x + 10, y + 40), (UINT32)(rand() & 0xFFFFFF));
+	}
+}
+
+// Runs the loop for the time, busyWait spins on the clock until the deadline instead of using the scheduler to wait
+LoopResult runLoop(RenderTarget& target, double frameRate, double seconds, bool busyWait) {
+	FrameScheduler scheduler;
+	scheduler.fixedTimestep = 1.0 / 120.0;
+	scheduler.setTargetFrameRate(busyWait ? 0.0 : frameRate);
+	long long period = (long long)(1e9 / frameRate);
+	long long start = FrameScheduler::now();
+	long long deadline = start;
+	std::clock_t cpuStart = std::clock();
+	long long steps = 0;
+	int position = 0;
+	while (FrameScheduler::now() - start < (long long)(seconds * 1e9)) {
+		scheduler.beginFrame();
+		while (scheduler.stepFixedUpdate()) {
+			position++;
+			steps++;
+		}
+		drawFrame(target, position);
+		if (busyWait) {
+			deadline += period;
+			while (FrameScheduler::now() < deadline) {}
+		}
+		scheduler.endFrame();
+	}
+	long long elapsed = FrameScheduler::now() - start;
+	LoopResult result;
+	result.stats = scheduler.getStats();
+	result.cpuFraction = (double)(std::clock() - cpuStart) / CLOCKS_PER_SEC / (elapsed / 1e9);
+	result.steps = steps;
+	result.expectedSteps = (long long)((double)elapsed / 1e9 / scheduler.fixedTimestep);
+	return result;
+}
+
+// Prints a result
+void printResult(const char* name, const LoopResult& result) {
+	printf("%-28s %8.3f ms/frame, %7.3f ms jitter, %7.3f ms worst deviation, %llu missed, %5.1f%% CPU, %5.1f%% asleep\n", name,
+		result.stats.averageFrameTime, result.stats.jitter, result.stats.maxDeviation, result.stats.missedFrames,
+		result.cpuFraction * 100.0, result.stats.sleepFraction * 100.0);
+}
+
+int main(int argc, char** argv) {
+	double frameRate = argc > 1 ? atof(argv[1]) : 60.0;
+	double seconds = argc > 2 ? atof(argv[2]) : 2.0;
+	if (frameRate <= 0.0 || seconds <= 0.0) {
+		fprintf(stderr, "The frame rate and the time have to be positive\n");
+		return 1;
+	}
+	printf("Target: %.1f FPS (%.3f ms) for %.1f s\n\n", frameRate, 1000.0 / frameRate, seconds);
+
+	RenderTarget target(800, 600);
+	LoopResult busy = runLoop(target, frameRate, seconds, true);
+	printResult("busy-waiting", busy);
+	LoopResult paced = runLoop(target, frameRate, seconds, false);
+	printResult("FrameScheduler", paced);
+
+	bool rate = paced.stats.averageFrameTime < 1000.0 / frameRate * 1.02 && paced.stats.averageFrameTime > 1000.0 / frameRate * 0.98;
+	long long missing = paced.expectedSteps - paced.steps - (long long)paced.stats.droppedSteps;
+	// The time of the last frame isn't handed out yet, that's up to a frame of steps
+	bool steps = missing >= 0 && missing <= (long long)(1.0 / frameRate / (1.0 / 120.0)) + 1;
+	bool sleeps = paced.cpuFraction < busy.cpuFraction * 0.9;
+	printf("\n%lld fixed steps for %lld expected, %llu dropped\n", paced.steps, paced.expectedSteps, paced.stats.droppedSteps);
+	printf("\n%s\n", rate ? "The frame rate is kept" : "The frame rate is MISSED");
+	printf("%s\n", steps ? "The fixed steps match the elapsed time" : "The fixed steps DON'T match the elapsed time");
+	printf("%s\n", sleeps ? "Pacing sleeps instead of spinning" : "Pacing uses as much CPU as spinning");
+	return rate && steps && sleeps ? 0 : 1;
+}
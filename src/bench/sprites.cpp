@@ -0,0 +1,134 @@
+//
+// Sprite benchmark
+//
+// Blits thousands of sprites of a sprite sheet per frame in every BlitMode, compared with drawing them pixel by pixel
+// The sheet is saved as a 32-bit BMP and drawn from the memory mapped file, checking that it looks the same
+//
+// Usage: sprites [width] [height] [sprites per frame] [BMP path]
+//
+
+#include "../RenderTarget.hpp"
+#include "bench.hpp"
+#include <cstdlib>
+#include <cstring>
+
+const int spriteSize = 32;
+const int spriteCount = 8;
+const UINT32 colorKey = 0xFF00FF;
+
+// Sheet of round sprites with soft edges, alpha 0 and the color key outside of them
+void makeSheet(Image& sheet) {
+	sheet.create(spriteSize * spriteCount, spriteSize);
+	for (int y = 0; y < spriteSize; y++) {
+		UINT32* row = sheet.getRow(y);
+		for (int x = 0; x < spriteSize * spriteCount; x++) {
+			int sprite = x / spriteSize;
+			double dx = x % spriteSize - spriteSize / 2 + 0.5, dy = y - spriteSize / 2 + 0.5;
+			double inside = (spriteSize / 2 - 1 - sqrt(dx * dx + dy * dy)) * 64.0;
+			unsigned int alpha = inside <= 0 ? 0 : inside >= 255 ? 255 : (unsigned int)inside;
+			UINT32 color = (UINT32)((sprite * 37 & 0xFF) << 16 | (y * 8 & 0xFF) << 8 | (x * 4 & 0xFF));
+			row[x] = alpha == 0 ? colorKey : alpha << 24 | color;
+		}
+	}
+}
+
+// Writes the image as a top-down 32-bit BMP with the BGRA masks (BI_ALPHABITFIELDS)
+bool writeBMP(const Image& image, const char* path) {
+	FILE* file = fopen(path, "wb");
+	if (!file) return false;
+	const unsigned int offset = 14 + 40 + 16;
+	const unsigned int pixelBytes = (unsigned int)image.width * image.height * 4;
+	const unsigned int header[] = {
+		offset + pixelBytes, 0, offset,                                   // File size, reserved, pixel offset
+		40, (unsigned int)image.width, (unsigned int)-image.height,       // Header size, width, height (negative for top-down)
+		1 | 32 << 16, 6, pixelBytes, 2835, 2835, 0, 0,                   // Planes and bits, compression, size, resolution, colors
+		0xFF0000, 0x00FF00, 0x0000FF, 0xFF000000,                         // Masks
+	};
+	bool written = fwrite("BM", 1, 2, file) == 2 && fwrite(header, sizeof(header), 1, file) == 1;
+	for (int y = 0; y < image.height && written; y++)
+		written = fwrite(image.getRowBytes(y), 4, image.width, file) == (size_t)image.width;
+	fclose(file);
+	return written;
+}
+
+int main(int argc, char** argv) {
+	int width = argc > 1 ? atoi(argv[1]) : 1920;
+	int height = argc > 2 ? atoi(argv[2]) : 1080;
+	int count = argc > 3 ? atoi(argv[3]) : 5000;
+	const char* path = argc > 4 ? argv[4] : "sprites.bmp";
+
+	RenderTarget target;
+	if (width <= 0 || height <= 0 || count <= 0 || !target.create(width, height)) {
+		fprintf(stderr, "Couldn't create a %dx%d render target\n", width, height);
+		return 1;
+	}
+
+	Image generated;
+	makeSheet(generated);
+	Image sheet;
+	if (!writeBMP(generated, path) || !sheet.loadBMP(path)) {
+		fprintf(stderr, "Couldn't write and load %s\n", path);
+		return 1;
+	}
+	bool identical = sheet.isMapped() && sheet.hasAlpha && sheet.width == generated.width && sheet.height == generated.height;
+	for (int y = 0; y < sheet.height && identical; y++)
+		identical = memcmp(sheet.getRowBytes(y), generated.getRowBytes(y), (size_t)sheet.width * 4) == 0;
+	printf("Render target: %dx%d, %d sprites %dx%d, blit kernels: %s\n", width, height, count, spriteSize, spriteSize, blitKernels().name);
+	printf("%s %s\n", path, identical ? "is mapped without copying" : "DIFFERS from the generated sheet");
+
+	srand(5);
+	std::vector<vec2<int>> positions(count);
+	for (vec2<int>& position : positions)
+		position = vec2<int>(rand() % (width + spriteSize) - spriteSize, rand() % (height + spriteSize) - spriteSize);
+	const double pixels = (double)count * spriteSize * spriteSize;
+
+	auto drawSprites = [&](BlitMode mode) {
+		for (int i = 0; i < count; i++) {
+			Rect source(vec2<int>(i % spriteCount * spriteSize, 0), spriteSize, spriteSize);
+			target.drawImage(sheet, positions[i].x, positions[i].y, source, mode, colorKey);
+		}
+	};
+	// Color keyed sprites pixel by pixel, the way they were drawn without images
+	BenchResult perPixel = runBenchmark("drawPixel per pixel", [&] {
+		for (int i = 0; i < count; i++)
+			for (int y = 0; y < spriteSize; y++)
+				for (int x = 0; x < spriteSize; x++) {
+					UINT32 color = sheet.getPixel(i % spriteCount * spriteSize + x, y) & 0xFFFFFF;
+					if (color != colorKey)
+						target.drawPixel(positions[i].x + x, positions[i].y + y, color);
+				}
+	});
+	printf("%-40s %14.1f Mpx/s\n", "", pixels / perPixel.nsPerCall * 1e3);
+
+	const struct {
+		const char* name;
+		const char* kernelName;
+		BlitMode mode;
+	} modes[] = {
+		{ "drawImage copy", "copy speedup", BlitMode::Copy },
+		{ "drawImage color key", "color key speedup", BlitMode::ColorKey },
+		{ "drawImage alpha", "alpha speedup", BlitMode::Alpha },
+	};
+	for (const auto& test : modes) {
+		BenchResult result = runBenchmark(test.name, [&] { drawSprites(test.mode); });
+		printf("%-40s %14.1f Mpx/s %10.1fx\n", "", pixels / result.nsPerCall * 1e3, perPixel.nsPerCall / result.nsPerCall);
+	}
+
+	// The row kernels on their own, against the scalar ones
+	printf("\nRow kernels, %d rows of %d pixels\n", spriteSize, spriteSize * spriteCount);
+	const BlitSpanFunction scalar[3] = { blitCopyScalar, blitColorKeyScalar, blitAlphaScalar };
+	UINT32* row = target.getPixels();
+	for (const auto& test : modes) {
+		BlitSpanFunction kernel = blitKernels().spans[(int)test.mode];
+		BenchResult simd = runBenchmark(blitKernels().name, [&] {
+			for (int y = 0; y < spriteSize; y++)
+				kernel(row, sheet.getRowBytes(y), (size_t)sheet.width, colorKey);
+		});
+		BenchResult reference = runBenchmark("scalar", [&] {
+			for (int y = 0; y < spriteSize; y++)
+				scalar[(int)test.mode](row, sheet.getRowBytes(y), (size_t)sheet.width, colorKey);
+		});
+		printf("%-40s %14.1fx\n", test.kernelName, reference.nsPerCall / simd.nsPerCall);
+	}
+	return identical ? 0 : 1;
+}
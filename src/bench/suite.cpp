@@ -0,0 +1,236 @@
+//
+// Primitive benchmark suite
+//
+// Times every primitive at a few sizes on an offscreen target, with the spread of the samples, and how many pixels
+// a call covers (counted on the target), so the results of different primitives and engine versions can be compared
+// Writes the results as JSON and compares them with the results of an older version if there are any
+// A primitive is reported as a regression if its fastest sample got slower by more than the threshold
+//
+// Usage: suite [output.json] [baseline.json] [threshold in percent]
+// (g++ -O2 -std=c++17 src/bench/suite.cpp -o suite)
+//
+
+#include "../RenderTarget.hpp"
+#include "bench.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Number of the positions every case cycles through
+const int positionCount = 64;
+const UINT32 background = BLACK;
+
+// Primitive at one size, draws the call number i
+struct BenchCase {
+	std::string name;
+	std::function<void(RenderTarget&, int)> draw;
+	// Average number of the pixels one call covers
+	double pixelsPerCall = 0.0;
+	BenchResult result = {};
+};
+
+// Random point at least margin pixels away from the edges of the target
+vec2<int> randomPoint(const RenderTarget& target, int margin) {
+	return vec2<int>(margin + rand() % (target.bitmapWidth - 2 * margin), margin + rand() % (target.bitmapHeight - 2 * margin));
+}
+
+// Random point at most distance pixels away from the point along each axis
+vec2<int> randomNear(vec2<int> point, int distance) {
+	return vec2<int>(point.x + rand() % (2 * distance + 1) - distance, point.y + rand() % (2 * distance + 1) - distance);
+}
+
+// Random pen position with all of the glyphs of the text inside of the target, measured like RenderTarget::textBounds
+// Texts wider or taller than the target start at its edge
+vec2<int> randomTextPoint(const RenderTarget& target, const wchar_t* text, int size) {
+	GlyphAtlas& atlas = glyphCache().getAtlas(size);
+	int minX = 0, maxX = 0;
+	int minY = 0, maxY = 0;
+	int penX = 0;
+	for (const wchar_t* character = text; *character; character++) {
+		const Glyph& glyph = atlas.getGlyph(*character);
+		if (glyph.width > 0) {
+			if (penX + glyph.left < minX) minX = penX + glyph.left;
+			if (glyph.top < minY) minY = glyph.top;
+			if (penX + glyph.left + glyph.width > maxX) maxX = penX + glyph.left + glyph.width;
+			if (glyph.top + glyph.height > maxY) maxY = glyph.top + glyph.height;
+		}
+		penX += glyph.advance;
+	}
+	int rangeX = target.bitmapWidth - (maxX - minX);
+	int rangeY = target.bitmapHeight - (maxY - minY);
+	return vec2<int>(-minX + (rangeX > 0 ? rand() % rangeX : 0), -minY + (rangeY > 0 ? rand() % rangeY : 0));
+}
+
+// Counts the pixels a call covers by drawing it on a cleared target, averaged over the positions
+double countPixels(RenderTarget& target, const BenchCase& benchCase) {
+	size_t total = 0;
+	for (int i = 0; i < positionCount; i++) {
+		target.clearScreen(background);
+		benchCase.draw(target, i);
+		const UINT32* pixels = target.getPixels();
+		for (size_t p = 0; p < (size_t)target.bitmapWidth * target.bitmapHeight; p++)
+			total += pixels[p] != background;
+	}
+	return (double)total / positionCount;
+}
+
+// Builds the cases, every size gets its own random positions
+std::vector<BenchCase> makeCases(const RenderTarget& target) {
+	std::vector<BenchCase> cases;
+	srand(42);
+	cases.push_back({ "clearScreen", [](RenderTarget& t, int) { t.clearScreen(GREY); } });
+	{
+		std::vector<vec2<int>> points(positionCount);
+		for (vec2<int>& point : points)
+			point = randomPoint(target, 0);
+		cases.push_back({ "drawPixel", [points](RenderTarget& t, int i) { t.drawPixel(points[i].x, points[i].y, WHITE); } });
+	}
+	for (int size : { 8, 64, 512 }) {
+		std::vector<vec2<int>> points(positionCount);
+		for (vec2<int>& point : points)
+			point = randomPoint(target, size);
+		cases.push_back({ "drawRectangle " + std::to_string(size) + "x" + std::to_string(size),
+			[points, size](RenderTarget& t, int i) { t.drawRectangle(points[i], size, size, WHITE); } });
+	}
+	for (int radius : { 4, 32, 256 }) {
+		std::vector<vec2<int>> points(positionCount);
+		for (vec2<int>& point : points)
+			point = randomPoint(target, radius + 1);
+		cases.push_back({ "drawCircle r" + std::to_string(radius), [points, radius](RenderTarget& t, int i) { t.drawCircle(points[i], radius, WHITE); } });
+	}
+	for (int radius : { 8, 64, 256 })
+		for (int thickness : { 1, 8 }) {
+			std::vector<vec2<int>> points(positionCount);
+			for (vec2<int>& point : points)
+				point = randomPoint(target, radius + thickness + 1);
+			cases.push_back({ "drawEmptyCircle r" + std::to_string(radius) + " t" + std::to_string(thickness),
+				[points, radius, thickness](RenderTarget& t, int i) { t.drawEmptyCircle(points[i], radius, WHITE, (unsigned short)thickness); } });
+		}
+	for (int length : { 16, 128, 512 })
+		for (int thickness : { 1, 4, 16 }) {
+			std::vector<vec2<int>> points(positionCount * 2);
+			for (int i = 0; i < positionCount; i++) {
+				points[i * 2] = randomPoint(target, length + thickness);
+				double angle = (rand() % 3600) * 3.14159265358979 / 1800.0;
+				points[i * 2 + 1] = vec2<int>(points[i * 2].x + (int)(cos(angle) * length), points[i * 2].y + (int)(sin(angle) * length));
+			}
+			cases.push_back({ "drawLine " + std::to_string(length) + " t" + std::to_string(thickness),
+				[points, thickness](RenderTarget& t, int i) { t.drawLine(points[i * 2], points[i * 2 + 1], WHITE, (unsigned short)thickness); } });
+		}
+	for (int span : { 64, 512 })
+		for (int thickness : { 1, 4 }) {
+			std::vector<vec2<int>> points(positionCount * 4);
+			for (int i = 0; i < positionCount; i++) {
+				points[i * 4] = randomPoint(target, span / 2 + thickness);
+				for (int j = 1; j < 4; j++)
+					points[i * 4 + j] = randomNear(points[i * 4], span / 2);
+			}
+			cases.push_back({ "drawBezierCurve quadratic " + std::to_string(span) + " t" + std::to_string(thickness),
+				[points, thickness](RenderTarget& t, int i) { t.drawBezierCurve(points[i * 4], points[i * 4 + 1], points[i * 4 + 2], WHITE, (unsigned short)thickness); } });
+			cases.push_back({ "drawBezierCurve cubic " + std::to_string(span) + " t" + std::to_string(thickness),
+				[points, thickness](RenderTarget& t, int i) {
+					t.drawBezierCurve(points[i * 4], points[i * 4 + 1], points[i * 4 + 2], points[i * 4 + 3], WHITE, (unsigned short)thickness);
+				} });
+		}
+	for (int size : { 16, 128, 512 }) {
+		std::vector<vec2<int>> points(positionCount * 3);
+		for (int i = 0; i < positionCount; i++) {
+			points[i * 3] = randomPoint(target, size);
+			points[i * 3 + 1] = randomNear(points[i * 3], size);
+			points[i * 3 + 2] = randomNear(points[i * 3], size);
+		}
+		cases.push_back({ "drawTriangle " + std::to_string(size),
+			[points](RenderTarget& t, int i) { t.drawTriangle(points[i * 3], points[i * 3 + 1], points[i * 3 + 2], WHITE); } });
+	}
+	const wchar_t* text = L"The quick brown fox 0123456789";
+	for (int size : { 12, 24, 48 }) {
+		std::vector<vec2<int>> points(positionCount);
+		for (vec2<int>& point : points)
+			point = randomTextPoint(target, text, size);
+		cases.push_back({ "drawText " + std::to_string(size),
+			[points, size, text](RenderTarget& t, int i) { t.drawText(points[i].x, points[i].y, text, size, WHITE); } });
+	}
+	return cases;
+}
+
+// Writes the results, one per line so that they can be read back without a JSON parser
+bool writeJson(const char* path, const std::vector<BenchCase>& cases, const RenderTarget& target) {
+	FILE* file = fopen(path, "w");
+	if (!file) return false;
+	fprintf(file, "{\n\t\"width\": %d,\n\t\"height\": %d,\n\t\"avx2\": %s,\n\t\"results\": [\n", target.bitmapWidth, target.bitmapHeight, cpuHasAVX2() ? "true" : "false");
+	for (size_t i = 0; i < cases.size(); i++) {
+		const BenchResult& result = cases[i].result;
+		fprintf(file, "\t\t{ \"name\": \"%s\", \"nsPerCall\": %.2f, \"stddev\": %.2f, \"minNsPerCall\": %.2f, \"calls\": %lld, \"samples\": %d, "
+			"\"pixelsPerCall\": %.1f, \"pixelsPerSecond\": %.0f }%s\n", cases[i].name.c_str(), result.nsPerCall, result.stddev, result.minNsPerCall,
+			result.calls, result.samples, cases[i].pixelsPerCall, cases[i].pixelsPerCall * 1e9 / result.nsPerCall, i + 1 < cases.size() ? "," : "");
+	}
+	fprintf(file, "\t]\n}\n");
+	return fclose(file) == 0;
+}
+
+// Fastest sample of the case in the results written by writeJson, 0 if it isn't there
+double findBaseline(const std::vector<std::string>& lines, const std::string& name) {
+	std::string key = "\"name\": \"" + name + "\"";
+	for (const std::string& line : lines) {
+		if (line.find(key) == std::string::npos) continue;
+		size_t value = line.find("\"minNsPerCall\": ");
+		if (value == std::string::npos) return 0.0;
+		return atof(line.c_str() + value + strlen("\"minNsPerCall\": "));
+	}
+	return 0.0;
+}
+
+int main(int argc, char** argv) {
+	const char* output = argc > 1 ? argv[1] : "bench_results.json";
+	const char* baselinePath = argc > 2 ? argv[2] : nullptr;
+	double threshold = argc > 3 ? atof(argv[3]) : 10.0;
+
+	RenderTarget target(1920, 1080);
+	std::vector<BenchCase> cases = makeCases(target);
+	for (BenchCase& benchCase : cases)
+		benchCase.pixelsPerCall = countPixels(target, benchCase);
+
+	for (BenchCase& benchCase : cases) {
+		int call = 0;
+		target.clearScreen(background);
+		benchCase.result = runBenchmarkSamples(benchCase.name.c_str(), [&] { benchCase.draw(target, call++ % positionCount); });
+		printf("%-40s %14.0f pixels/call %10.1f Mpixels/s\n", "", benchCase.pixelsPerCall, benchCase.pixelsPerCall * 1e3 / benchCase.result.nsPerCall);
+	}
+
+	if (!writeJson(output, cases, target)) {
+		fprintf(stderr, "Couldn't write %s\n", output);
+		return 1;
+	}
+	printf("\nResults written to %s\n", output);
+	if (!baselinePath) return 0;
+
+	// Compare with the older results
+	FILE* file = fopen(baselinePath, "r");
+	if (!file) {
+		fprintf(stderr, "Couldn't read %s\n", baselinePath);
+		return 1;
+	}
+	std::vector<std::string> lines;
+	char line[1024];
+	while (fgets(line, sizeof(line), file))
+		lines.push_back(line);
+	fclose(file);
+
+	int regressions = 0;
+	printf("\nCompared with %s (fastest samples, regressions over %.1f%%):\n", baselinePath, threshold);
+	for (const BenchCase& benchCase : cases) {
+		double baseline = findBaseline(lines, benchCase.name);
+		if (baseline <= 0.0) {
+			printf("%-40s %14s\n", benchCase.name.c_str(), "new");
+			continue;
+		}
+		double change = (benchCase.result.minNsPerCall / baseline - 1.0) * 100.0;
+		bool regressed = change > threshold;
+		regressions += regressed;
+		printf("%-40s %+13.1f%% %s\n", benchCase.name.c_str(), change, regressed ? "REGRESSION" : "");
+	}
+	printf("\n%d regressions\n", regressions);
+	return regressions == 0 ? 0 : 1;
+}
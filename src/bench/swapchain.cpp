@@ -0,0 +1,120 @@
+//
+// Swap chain benchmark
+//
+// Draws and presents frames to a HeadlessSink with a single buffer (presented on the drawing thread) and with
+// 2 and 3 buffers presented by the present thread, with and without extra time spent presenting (like a slow driver)
+// Checks that the presented frames are the same as the drawn ones, also when only the changes are drawn every frame
+//
+// Usage: swapchain [width] [height] [frames] [present delay in microseconds]
+// (g++ -O2 -std=c++17 -pthread src/bench/swapchain.cpp -o swapchain)
+//
+
+#include "../HeadlessPresenter.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+// Redraws the entire frame, like the bezier demo
+void drawFullFrame(RenderTarget& target, int frame) {
+	srand(3);
+	target.clearScreen(0x202020);
+	for (int i = 0; i < 2000; i++) {
+		vec2<int> v1 = vec2<int>(rand() % target.bitmapWidth + frame % 50, rand() % target.bitmapHeight);
+		vec2<int> v2 = vec2<int>(v1.x + rand() % 61 - 30, v1.y + rand() % 61 - 30);
+		vec2<int> v3 = vec2<int>(v1.x + rand() % 61 - 30, v1.y + rand() % 61 - 30);
+		target.drawTriangle(v1, v2, v3, (UINT32)(rand() & 0xFFFFFF));
+	}
+	for (int i = 0; i < 200; i++)
+		target.drawLine(vec2<int>(rand() % target.bitmapWidth, rand() % target.bitmapHeight),
+			vec2<int>(rand() % target.bitmapWidth, rand() % target.bitmapHeight), (UINT32)(rand() & 0xFFFFFF), 2);
+	target.drawText(20, 40, L"Swap chain", 32, WHITE);
+}
+
+// Only draws what changed, like the pathfinding demo, the earlier frames have to stay in the buffers
+void drawChanges(RenderTarget& target, int frame) {
+	if (frame == 0)
+		target.clearScreen(0x202020);
+	int x = frame * 37 % (target.bitmapWidth - 40);
+	int y = frame * 53 % (target.bitmapHeight - 40);
+	target.drawRectangle(vec2<int>(x, y), 40, 40, (UINT32)(frame * 2654435761u & 0xFFFFFF));
+}
+
+// Draws the frames and presents them with the buffers (1 presents right away on this thread), returns the frames per second
+// Full frames don't need the buffers to keep the earlier frames
+double run(RenderTarget& target, HeadlessSink& sink, int buffers, int frames, void (*draw)(RenderTarget&, int), SwapChain::Stats& stats) {
+	SwapChain chain;
+	chain.preserveContents = draw != drawFullFrame;
+	target.clearScreen(BLACK);
+	if (buffers > 1 && !chain.create(target, buffers, sink)) {
+		fprintf(stderr, "Couldn't create a swap chain with %d buffers\n", buffers);
+		exit(1);
+	}
+	auto start = std::chrono::steady_clock::now();
+	for (int frame = 0; frame < frames; frame++) {
+		draw(target, frame);
+		if (buffers > 1)
+			chain.present(target);
+		else {
+			sink.presentFrame(target.getPixels(), target.bitmapWidth, target.bitmapHeight, target.getDirtyRegion());
+			target.finishPresent();
+		}
+	}
+	chain.waitIdle();
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	stats = chain.getStats();
+	chain.detach(target);
+	return frames / seconds;
+}
+
+int main(int argc, char** argv) {
+	int width = argc > 1 ? atoi(argv[1]) : 1920;
+	int height = argc > 2 ? atoi(argv[2]) : 1080;
+	int frames = argc > 3 ? atoi(argv[3]) : 120;
+	int delay = argc > 4 ? atoi(argv[4]) : 8000;
+
+	RenderTarget target;
+	if (width <= 40 || height <= 40 || frames <= 0 || !target.create(width, height)) {
+		fprintf(stderr, "Couldn't create a %dx%d render target\n", width, height);
+		return 1;
+	}
+	printf("Render target: %dx%d, %d frames, %u hardware threads\n", width, height, frames, std::thread::hardware_concurrency());
+
+	// Frames presented by the present thread have to match the ones presented right away
+	bool identical = true;
+	std::vector<UINT32> expected((size_t)width * height);
+	const struct {
+		const char* name;
+		void (*draw)(RenderTarget&, int);
+	} scenes[] = { { "full frames", drawFullFrame }, { "changes only", drawChanges } };
+	for (const auto& scene : scenes)
+		for (int buffers = 1; buffers <= SwapChain::maxBuffers; buffers++) {
+			HeadlessSink sink;
+			SwapChain::Stats stats;
+			run(target, sink, buffers, 30, scene.draw, stats);
+			if (buffers == 1)
+				memcpy(expected.data(), sink.surface.getPixels(), expected.size() * sizeof(UINT32));
+			else if (memcmp(sink.surface.getPixels(), expected.data(), expected.size() * sizeof(UINT32)) != 0) {
+				printf("%s presented with %d buffers differ from the drawn ones!\n", scene.name, buffers);
+				identical = false;
+			}
+		}
+
+	const int delays[] = { 0, delay };
+	for (int presentDelay : delays) {
+		printf("\nPresent delay %d us\n", presentDelay);
+		double single = 0.0;
+		for (int buffers = 1; buffers <= SwapChain::maxBuffers; buffers++) {
+			HeadlessSink sink(nullptr, presentDelay);
+			SwapChain::Stats stats;
+			double fps = run(target, sink, buffers, frames, drawFullFrame, stats);
+			if (buffers == 1) single = fps;
+			printf("%d buffer%-33s %14.1f fps %10.2fx\n", buffers, buffers > 1 ? "s" : "", fps, fps / single);
+			if (buffers > 1)
+				printf("%-40s %14.2f ms/frame waiting for a free buffer\n", "", stats.fenceWaitNanoseconds / 1e6 / frames);
+		}
+	}
+
+	printf("\n%s\n", identical ? "Presented frames are identical to the drawn ones" : "Presented frames DIFFER from the drawn ones");
+	return identical ? 0 : 1;
+}
@@ -0,0 +1,141 @@
+//
+// Tile renderer benchmark
+//
+// Draws the same scene right away and deferred with TileRenderer on 1 to 16 threads,
+// checks that the pixels are exactly the same and measures how the drawing scales with the threads
+//
+// Usage: tiles [width] [height] [max threads]
+// (g++ -O2 -std=c++17 -pthread src/bench/tiles.cpp -o tiles)
+//
+
+#include "../TileRenderer.hpp"
+#include "bench.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+// Random point in the target, a bit outside of it so that the clipping is tested too
+vec2<int> randomPoint(const RenderTarget& target) {
+	return vec2<int>(rand() % (target.bitmapWidth + 200) - 100, rand() % (target.bitmapHeight + 200) - 100);
+}
+
+// Random color
+UINT32 randomColor() {
+	return (UINT32)((rand() & 0xFF) << 16 | (rand() & 0xFF) << 8 | (rand() & 0xFF));
+}
+
+// Sprite with soft edges for the images of the scene
+Image sprite;
+
+// Draws a scene with every primitive, overlapping a lot so that the draw order matters
+void drawScene(RenderTarget& target) {
+	srand(7);
+	target.clearScreen(0x202020);
+	for (int i = 0; i < 300; i++) {
+		vec2<int> corner = randomPoint(target);
+		target.drawRectangle(corner, rand() % 200 + 1, rand() % 200 + 1, randomColor());
+	}
+	for (int i = 0; i < 3000; i++) {
+		vec2<int> v1 = randomPoint(target);
+		vec2<int> v2 = vec2<int>(v1.x + rand() % 121 - 60, v1.y + rand() % 121 - 60);
+		vec2<int> v3 = vec2<int>(v1.x + rand() % 121 - 60, v1.y + rand() % 121 - 60);
+		target.drawTriangle(v1, v2, v3, randomColor());
+	}
+	for (int i = 0; i < 20; i++)
+		target.drawTriangle(randomPoint(target), randomPoint(target), randomPoint(target), randomColor());
+	for (int i = 0; i < 200; i++)
+		target.drawCircle(randomPoint(target), rand() % 80, randomColor());
+	for (int i = 0; i < 100; i++)
+		target.drawEmptyCircle(randomPoint(target), rand() % 150, randomColor(), (unsigned short)(rand() % 4));
+	for (int i = 0; i < 1000; i++)
+		target.drawLine(randomPoint(target), randomPoint(target), randomColor(), (unsigned short)(i % 4 == 0 ? rand() % 6 : 1));
+	for (int i = 0; i < 200; i++)
+		target.drawBezierCurve(randomPoint(target), randomPoint(target), randomPoint(target), randomPoint(target), randomColor(), (unsigned short)(rand() % 3));
+	for (int i = 0; i < 100; i++)
+		target.drawBezierCurve(randomPoint(target), randomPoint(target), randomPoint(target), randomColor(), (unsigned short)(rand() % 3));
+	for (int i = 0; i < 2000; i++) {
+		vec2<int> point = randomPoint(target);
+		target.drawPixel(point.x, point.y, randomColor());
+	}
+	for (int i = 0; i < 300; i++) {
+		vec2<int> point = randomPoint(target);
+		target.drawImage(sprite, point.x, point.y, (BlitMode)(i % 3), 0);
+	}
+	for (int i = 0; i < 100; i++) {
+		vec2<int> point = randomPoint(target);
+		target.drawText(point.x, point.y, L"The quick brown fox jumps over the lazy dog", 16 + rand() % 3 * 8, randomColor());
+	}
+}
+
+int main(int argc, char** argv) {
+	int width = argc > 1 ? atoi(argv[1]) : 1920;
+	int height = argc > 2 ? atoi(argv[2]) : 1080;
+	int maxThreads = argc > 3 ? atoi(argv[3]) : 16;
+	const double minSeconds = 0.5;
+	char name[64];
+
+	RenderTarget immediate;
+	RenderTarget deferred;
+	if (width <= 0 || height <= 0 || !immediate.create(width, height) || !deferred.create(width, height)) {
+		fprintf(stderr, "Couldn't create a %dx%d render target\n", width, height);
+		return 1;
+	}
+	size_t frameBytes = (size_t)width * height * sizeof(UINT32);
+	sprite.create(48, 48);
+	for (int y = 0; y < sprite.height; y++)
+		for (int x = 0; x < sprite.width; x++)
+			sprite.getRow(y)[x] = (UINT32)(x * y % 256) << 24 | randomColor();
+	printf("Render target: %dx%d, %u hardware threads\n", width, height, std::thread::hardware_concurrency());
+
+	BenchResult immediateResult = runBenchmark("immediate", [&] { drawScene(immediate); }, minSeconds);
+
+	DrawCommandList list;
+	deferred.beginRecording(list);
+	BenchResult recordResult = runBenchmark("recording only", [&] {
+		list.clear();
+		drawScene(deferred);
+	}, minSeconds);
+	deferred.endRecording();
+	printf("%-40s %14zu commands\n", "recorded", list.size());
+
+	bool identical = true;
+	double oneThread = 0.0;
+	for (int threads = 1; threads <= maxThreads; threads *= 2) {
+		TileRenderer renderer(threads);
+		printf("\n%d threads\n", threads);
+
+		// The pixels have to match for every tile size
+		int defaultTileSize = renderer.tileSize;
+		const int tileSizes[] = { 16, 64, 128, 256 };
+		for (int tileSize : tileSizes) {
+			renderer.tileSize = tileSize;
+			memset(deferred.getPixels(), 0, frameBytes);
+			renderer.render(deferred, list);
+			if (memcmp(deferred.getPixels(), immediate.getPixels(), frameBytes) != 0) {
+				printf("%d px tiles differ from the immediate mode!\n", tileSize);
+				identical = false;
+			}
+		}
+
+		renderer.tileSize = defaultTileSize;
+		snprintf(name, sizeof(name), "deferred x%d", threads);
+		BenchResult result = runBenchmark(name, [&] {
+			deferred.beginRecording(list);
+			list.clear();
+			drawScene(deferred);
+			deferred.endRecording();
+			renderer.render(deferred, list);
+		}, minSeconds);
+		if (threads == 1) oneThread = result.nsPerCall;
+		printf("%-40s %14.1fx\n", "speedup over immediate", immediateResult.nsPerCall / result.nsPerCall);
+		// More threads than the hardware has only take turns, that isn't a speedup measurement
+		if (threads > (int)std::thread::hardware_concurrency())
+			printf("%-40s %14.1fx (more threads than hardware threads)\n", "speedup over 1 thread", oneThread / result.nsPerCall);
+		else
+			printf("%-40s %14.1fx\n", "speedup over 1 thread", oneThread / result.nsPerCall);
+		printf("%-40s %14.1f%%\n", "recording share", recordResult.nsPerCall / result.nsPerCall * 100.0);
+	}
+
+	printf("\n%s\n", identical ? "Deferred frames are identical to the immediate ones" : "Deferred frames DIFFER from the immediate ones");
+	return identical ? 0 : 1;
+}
@@ -0,0 +1,188 @@
+//
+// Triangle rasterization benchmark
+//
+// Compares the block based half-space drawTriangle with the old scanline version
+// (with its vertex sorting fixed, so both of them fill the same triangles)
+// rasterizeTriangle is also timed alone, the rest of drawTriangle is the submit overhead (bounds, clipping, dirty rectangles)
+// The three versions are timed in turns and the results are the fastest samples, the small triangles take tens of nanoseconds
+// and the averages of separate runs drift more than the submit overhead is
+// The meshes of 4 and 8 px cells are the small triangle path, the last line says if drawTriangle keeps up with the old version on them
+//
+// Usage: triangle
+//
+
+#include "../RenderTarget.hpp"
+#include "bench.hpp"
+#include <vector>
+
+// Scanline triangles before the half-space rasterizer, every scanline drawn pixel by pixel
+struct OldTriangles {
+	RenderTarget& target;
+
+	void drawPixel(int x, int y, UINT32 color) {
+		if (x < target.bitmapWidth && y < target.bitmapHeight && x > 0 && y > 0)
+			target.getPixels()[y * target.bitmapWidth + x] = color;
+	}
+
+	void drawScanline(int x1, int x2, int y, UINT32 color) {
+		if (x1 > x2) {
+			int temp = x1;
+			x1 = x2;
+			x2 = temp;
+		}
+		for (int x = x1; x <= x2; x++)
+			drawPixel(x, y, color);
+	}
+
+	void fillBottomFlatTriangle(vec2<int> v1, vec2<int> v2, vec2<int> v3, UINT32 color) {
+		float invslope1 = (float)(v2.x - v1.x) / (float)(v2.y - v1.y);
+		float invslope2 = (float)(v3.x - v1.x) / (float)(v3.y - v1.y);
+		float curx1 = (float)v1.x;
+		float curx2 = (float)v1.x;
+		for (int scanlineY = v1.y; scanlineY <= v2.y; scanlineY++) {
+			drawScanline((int)curx1, (int)curx2, scanlineY, color);
+			curx1 += invslope1;
+			curx2 += invslope2;
+		}
+	}
+
+	void fillTopFlatTriangle(vec2<int> v1, vec2<int> v2, vec2<int> v3, UINT32 color) {
+		float invslope1 = (float)(v3.x - v1.x) / (float)(v3.y - v1.y);
+		float invslope2 = (float)(v3.x - v2.x) / (float)(v3.y - v2.y);
+		float curx1 = (float)v3.x;
+		float curx2 = (float)v3.x;
+		for (int scanlineY = v3.y; scanlineY > v1.y; scanlineY--) {
+			drawScanline((int)curx1, (int)curx2, scanlineY, color);
+			curx1 -= invslope1;
+			curx2 -= invslope2;
+		}
+	}
+
+	void drawTriangle(vec2<int> v1, vec2<int> v2, vec2<int> v3, UINT32 color) {
+		vec2<int> v4;
+		if (v1.y > v2.y) { v4 = v1; v1 = v2; v2 = v4; }
+		if (v2.y > v3.y) { v4 = v2; v2 = v3; v3 = v4; }
+		if (v1.y > v2.y) { v4 = v1; v1 = v2; v2 = v4; }
+		if (v2.y == v3.y)
+			fillBottomFlatTriangle(v1, v2, v3, color);
+		else if (v1.y == v2.y)
+			fillTopFlatTriangle(v1, v2, v3, color);
+		else {
+			v4 = vec2<int>((int)(v1.x + (float)(v2.y - v1.y) / (float)(v3.y - v1.y) * (v3.x - v1.x)), v2.y);
+			fillBottomFlatTriangle(v1, v2, v4, color);
+			fillTopFlatTriangle(v2, v4, v3, color);
+		}
+	}
+};
+
+// Rasterizes the triangle without drawTriangle around it
+void rasterize(RenderTarget& target, vec2<int> v1, vec2<int> v2, vec2<int> v3, UINT32 color) {
+	rasterizeTriangle<BGRA32>(target.getPixels(), target.bitmapWidth, 0, 0, target.bitmapWidth, target.bitmapHeight,
+		vec2<int>(v1.x << subpixelBits, v1.y << subpixelBits), vec2<int>(v2.x << subpixelBits, v2.y << subpixelBits),
+		vec2<int>(v3.x << subpixelBits, v3.y << subpixelBits), color);
+}
+
+// Fastest time of one call (in nanoseconds) of the old triangles, drawTriangle and rasterizeTriangle, timed in turns
+struct TriangleTimes {
+	double old, draw, rasterize;
+};
+
+template<class Old, class Draw, class Rasterize>
+TriangleTimes timeInTurns(const char* name, Old&& old, Draw&& draw, Rasterize&& rasterize, int samples = 15, double sampleSeconds = 0.02) {
+	// The calls per sample are picked by the slowest of them
+	long long batch = 1;
+	for (;;) {
+		auto start = std::chrono::steady_clock::now();
+		for (long long i = 0; i < batch; i++) {
+			old();
+			draw();
+			rasterize();
+		}
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		if (elapsed.count() >= sampleSeconds) break;
+		batch = elapsed.count() > sampleSeconds / 16 ? (long long)(batch * sampleSeconds / elapsed.count()) + 1 : batch * 16;
+	}
+
+	auto sample = [batch](auto&& function) {
+		auto start = std::chrono::steady_clock::now();
+		for (long long i = 0; i < batch; i++)
+			function();
+		return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / (double)batch;
+	};
+	TriangleTimes times = { 0.0, 0.0, 0.0 };
+	for (int i = 0; i < samples; i++) {
+		double oldTime = sample(old), drawTime = sample(draw), rasterizeTime = sample(rasterize);
+		times.old = i == 0 ? oldTime : fmin(times.old, oldTime);
+		times.draw = i == 0 ? drawTime : fmin(times.draw, drawTime);
+		times.rasterize = i == 0 ? rasterizeTime : fmin(times.rasterize, rasterizeTime);
+	}
+	printf("%-40s %14.1f %14.1f %14.1f ns/call\n", name, times.old, times.draw, times.rasterize);
+	return times;
+}
+
+int main() {
+	RenderTarget target(1920, 1080);
+	OldTriangles old = { target };
+
+	printf("Partial blocks: %s\n", cpuHasAVX2() ? "AVX2" : "SSE2 or scalar");
+	printf("%-40s %14s %14s %14s\n", "", "old", "drawTriangle", "rasterize");
+
+	// Single triangles, half of a size x size square
+	const int sizes[] = { 4, 8, 16, 64, 256, 1000 };
+	for (int size : sizes) {
+		printf("\nTriangle %dx%d\n", size, size);
+		vec2<int> v1 = vec2<int>(100, 50);
+		vec2<int> v2 = vec2<int>(100 + size, 50 + size / 3);
+		vec2<int> v3 = vec2<int>(100 + size / 4, 50 + size);
+		TriangleTimes times = timeInTurns("triangle", [&] { old.drawTriangle(v1, v2, v3, RED); }, [&] { target.drawTriangle(v1, v2, v3, RED); },
+			[&] { rasterize(target, v1, v2, v3, RED); });
+		printf("%-40s %14.1f ns\n", "submit overhead", times.draw - times.rasterize);
+		printf("%-40s %14.1fx\n", "speedup", times.old / times.draw);
+	}
+
+	// Meshes of small triangles covering the whole target, 2 triangles per cell
+	const int cells[] = { 4, 8, 16, 32 };
+	bool smallMeshes = true;
+	for (int cell : cells) {
+		int columns = target.bitmapWidth / cell;
+		int rows = target.bitmapHeight / cell;
+		int triangles = columns * rows * 2;
+		printf("\nMesh of %d triangles (%dx%d cells)\n", triangles, cell, cell);
+		std::vector<vec2<int>> grid((size_t)(columns + 1) * (rows + 1));
+		srand(1);
+		for (int y = 0; y <= rows; y++)
+			for (int x = 0; x <= columns; x++) {
+				// Jitter the inner vertices, so the edges aren't axis aligned
+				int jitter = cell / 4;
+				bool inner = x > 0 && x < columns && y > 0 && y < rows;
+				grid[y * (columns + 1) + x] = vec2<int>(x * cell + (inner && jitter ? rand() % (2 * jitter) - jitter : 0),
+					y * cell + (inner && jitter ? rand() % (2 * jitter) - jitter : 0));
+			}
+		auto drawMesh = [&](auto&& drawTriangle) {
+			for (int y = 0; y < rows; y++)
+				for (int x = 0; x < columns; x++) {
+					const vec2<int>& a = grid[y * (columns + 1) + x];
+					const vec2<int>& b = grid[y * (columns + 1) + x + 1];
+					const vec2<int>& c = grid[(y + 1) * (columns + 1) + x + 1];
+					const vec2<int>& d = grid[(y + 1) * (columns + 1) + x];
+					drawTriangle(a, b, c, (UINT32)(x * 997 + y * 7919));
+					drawTriangle(a, c, d, (UINT32)(x * 7919 + y * 997));
+				}
+		};
+		TriangleTimes times = timeInTurns("mesh",
+			[&] { drawMesh([&](vec2<int> a, vec2<int> b, vec2<int> c, UINT32 color) { old.drawTriangle(a, b, c, color); }); },
+			[&] { drawMesh([&](vec2<int> a, vec2<int> b, vec2<int> c, UINT32 color) { target.drawTriangle(a, b, c, color); }); },
+			[&] { drawMesh([&](vec2<int> a, vec2<int> b, vec2<int> c, UINT32 color) { rasterize(target, a, b, c, color); }); });
+		printf("%-40s %14.1f Mtriangles/s\n", "old", triangles / times.old * 1e3);
+		printf("%-40s %14.1f Mtriangles/s\n", "new", triangles / times.draw * 1e3);
+		printf("%-40s %14.1f Mtriangles/s\n", "rasterizeTriangle", triangles / times.rasterize * 1e3);
+		printf("%-40s %14.1f ns/triangle\n", "submit overhead", (times.draw - times.rasterize) / triangles);
+		printf("%-40s %14.1fx\n", "speedup", times.old / times.draw);
+		if (cell <= 8 && times.draw > times.old)
+			smallMeshes = false;
+	}
+	printf("\n%s\n", smallMeshes ? "Meshes of 4 and 8 px cells are at least as fast as the old version"
+		: "Meshes of 4 and 8 px cells are SLOWER than the old version");
+
+	return 0;
+}
@@ -0,0 +1,94 @@
+//
+// Upscaler benchmark
+//
+// Times drawing a frame at the lower internal resolutions plus upscaling it to the full resolution with both filters,
+// checks that upscaling at the full resolution copies the frame and that the dynamic resolution settles
+// around the target frame time when the frames take time proportional to their pixels
+//
+// Usage: upscale [width] [height]
+// (g++ -O2 -std=c++17 src/bench/upscale.cpp -o upscale)
+//
+
+#include "../RenderTarget.hpp"
+#include "../Scale.hpp"
+#include "../DynamicResolution.hpp"
+#include "bench.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+// Draws a frame full of triangles and curves, the coordinates are in the pixels of the full resolution
+void drawScene(RenderTarget& target, float scale) {
+	srand(9);
+	target.clearScreen(0x202020);
+	auto scaled = [scale](int x, int y) { return vec2<int>((int)(x * scale), (int)(y * scale)); };
+	int width = (int)(target.bitmapWidth / scale);
+	int height = (int)(target.bitmapHeight / scale);
+	for (int i = 0; i < 3000; i++) {
+		int x = rand() % width;
+		int y = rand() % height;
+		target.drawTriangle(scaled(x, y), scaled(x + rand() % 81 - 40, y + rand() % 81 - 40), scaled(x + rand() % 81 - 40, y + rand() % 81 - 40), (UINT32)(rand() & 0xFFFFFF));
+	}
+	for (int i = 0; i < 300; i++)
+		target.drawBezierCurve(scaled(rand() % width, rand() % height), scaled(rand() % width, rand() % height), scaled(rand() % width, rand() % height),
+			(UINT32)(rand() & 0xFFFFFF), 2);
+}
+
+int main(int argc, char** argv) {
+	int width = argc > 1 ? atoi(argv[1]) : 1920;
+	int height = argc > 2 ? atoi(argv[2]) : 1080;
+	if (width <= 100 || height <= 100) {
+		fprintf(stderr, "The resolution has to be bigger than 100x100\n");
+		return 1;
+	}
+	printf("Full resolution: %dx%d, %s kernels\n", width, height, scaleKernels().name);
+
+	std::vector<UINT32> output((size_t)width * height);
+	Rect whole(vec2<int>(0, 0), vec2<int>(width, height));
+	Upscaler upscaler;
+	const float scales[] = { 1.0f, 0.75f, 0.5f };
+	double full = 0.0;
+	for (float scale : scales) {
+		vec2<int> size = DynamicResolution::scaledSize(vec2<int>(width, height), scale);
+		RenderTarget target(size.x, size.y);
+		char name[64];
+		printf("\nScale %.2f (%dx%d)\n", scale, size.x, size.y);
+		BenchResult frame = runBenchmark("draw", [&] { drawScene(target, scale); });
+		if (scale == 1.0f) full = frame.nsPerCall;
+		const struct {
+			const char* name;
+			ScaleFilter filter;
+		} filters[] = { { "nearest", ScaleFilter::Nearest }, { "bilinear", ScaleFilter::Bilinear } };
+		for (const auto& filter : filters) {
+			snprintf(name, sizeof(name), "upscale %s", filter.name);
+			BenchResult upscale = runBenchmark(name, [&] { upscaler.scale(target.getPixels(), size.x, size.y, output.data(), width, height, whole, filter.filter); });
+			printf("%-40s %14.2f Gpixels/s %8.2fx faster than the full resolution frame\n", "", (double)width * height / upscale.nsPerCall,
+				full / (frame.nsPerCall + upscale.nsPerCall));
+		}
+	}
+
+	// Upscaling to the same size copies the frame
+	RenderTarget target(width, height);
+	drawScene(target, 1.0f);
+	bool copied = true;
+	for (ScaleFilter filter : { ScaleFilter::Nearest, ScaleFilter::Bilinear }) {
+		upscaler.scale(target.getPixels(), width, height, output.data(), width, height, whole, filter);
+		copied = copied && memcmp(output.data(), target.getPixels(), output.size() * sizeof(UINT32)) == 0;
+	}
+
+	// Frames taking twice the target at the full resolution should settle around a scale of 0.7
+	DynamicResolution resolution;
+	resolution.minScale = 0.25f;
+	for (int frame = 0; frame < 400; frame++) {
+		float scale = resolution.getScale();
+		resolution.addFrame(resolution.targetFrameTime * 2.0f * scale * scale);
+	}
+	float settled = resolution.getScale();
+	float settledTime = resolution.targetFrameTime * 2.0f * settled * settled;
+	bool settles = settledTime > resolution.targetFrameTime * 0.75f && settledTime < resolution.targetFrameTime * 1.05f;
+	printf("\nDynamic resolution settled at the scale %.2f, %.2f ms frames for the target of %.2f ms\n", settled, settledTime, resolution.targetFrameTime);
+
+	printf("\n%s\n", copied ? "Upscaling to the same size copies the frame" : "Upscaling to the same size CHANGES the frame");
+	printf("%s\n", settles ? "Dynamic resolution reaches the target frame time" : "Dynamic resolution MISSES the target frame time");
+	return copied && settles ? 0 : 1;
+}
@@ -3,12 +3,16 @@
 
 #include "../GraphicsEngine.hpp"
 #include<math.h>
+#include<vector>
 
 bool running = true;
 GraphicsEngine e;
 
 int BezierDemoMain(_In_ HINSTANCE curInst, _In_opt_ HINSTANCE prevInst, _In_ PSTR cmdLine, _In_ INT cmdCount) {
 	e.createWindow(curInst, 900, 900);
+	// The curves move 60 times a second whatever the frame rate, the frames are paced at 60 too
+	e.setFixedTimestep(1.0 / 60.0);
+	e.setTargetFrameRate(60.0);
 
 	// Create points for the bezier curves
 	vec2<int> bezier1Points[3] = {
@@ -29,9 +33,24 @@ int BezierDemoMain(_In_ HINSTANCE curInst, _In_opt_ HINSTANCE prevInst, _In_ PST
 
 	bool fullscreenHeld = false;
 
+	// Swarm of curves following the blue one, drawn with a single batched call
+	const int swarmSize = 10000;
+	std::vector<vec2<int>> swarmPoints(swarmSize * 4);
+	bool showSwarm = false;
+	bool swarmHeld = false;
+	bool deferredHeld = false;
+	bool buffersHeld = false;
+	bool resolutionHeld = false;
+	bool captureHeld = false;
+#ifdef GRAPHICS_PROFILE
+	bool graphHeld = false;
+#endif
+
 	// Main program loop
 	while (running) {
-		e.handleMessages();
+		// The window was closed
+		if (!e.handleMessages())
+			break;
 
 		if (e.keys[VK_ESCAPE].isHeld)
 			e.destroy();
@@ -43,27 +62,97 @@ int BezierDemoMain(_In_ HINSTANCE curInst, _In_opt_ HINSTANCE prevInst, _In_ PST
 		else if (!e.keys[VK_F11].isHeld)
 			fullscreenHeld = false;
 
+		if (e.keys[VK_SPACE].isHeld && !swarmHeld) {
+			showSwarm = !showSwarm;
+			swarmHeld = true;
+		}
+		else if (!e.keys[VK_SPACE].isHeld)
+			swarmHeld = false;
+
+		// Draw the curves with all of the cores
+		if (e.keys['T'].isHeld && !deferredHeld) {
+			e.setDeferred(!e.isDeferred());
+			deferredHeld = true;
+		}
+		else if (!e.keys['T'].isHeld)
+			deferredHeld = false;
+
+		// Cycle through 1 - 3 framebuffers, the entire frame is redrawn so the buffers don't have to be kept up to date
+		if (e.keys['B'].isHeld && !buffersHeld) {
+			e.setBufferCount(e.getBufferCount() % SwapChain::maxBuffers + 1, false);
+			buffersHeld = true;
+		}
+		else if (!e.keys['B'].isHeld)
+			buffersHeld = false;
+
+		// Lower the internal resolution when the frames take too long (the swarm is slow enough)
+		if (e.keys['R'].isHeld && !resolutionHeld) {
+			e.setDynamicResolution(!e.isDynamicResolution());
+			resolutionHeld = true;
+		}
+		else if (!e.keys['R'].isHeld)
+			resolutionHeld = false;
+
+		// Capture the frames to a stream, it can be replayed with src/bench/replay.cpp
+		if (e.keys['C'].isHeld && !captureHeld) {
+			if (e.isCapturing())
+				e.stopCapture();
+			else
+				e.startCapture("bezier.gds");
+			captureHeld = true;
+		}
+		else if (!e.keys['C'].isHeld)
+			captureHeld = false;
+
+#ifdef GRAPHICS_PROFILE
+		// Show the frame times
+		if (e.keys['G'].isHeld && !graphHeld) {
+			e.showFrameGraph = !e.showFrameGraph;
+			graphHeld = true;
+		}
+		else if (!e.keys['G'].isHeld)
+			graphHeld = false;
+#endif
+
 		// Clear screen
 		e.clearScreen(0x333333);
 
 		// Update bezier curves
-		x++;
+		while (e.stepFixedUpdate()) {
+			x++;
 
-		bezier1Points[0].x += (int)(2.0 * sin((double)(5.0 * (x - 2))) + 0.1);
-		bezier1Points[1].y += (int)(2.0 * sin((double)(5.0 * (x - 2))) + 0.2);
+			bezier1Points[0].x += (int)(2.0 * sin((double)(5.0 * (x - 2))) + 0.1);
+			bezier1Points[1].y += (int)(2.0 * sin((double)(5.0 * (x - 2))) + 0.2);
 
-		bezier2Points[1].x += (int)(2.0 * sin((double)(5.0 * (x - 2))) + 0.3);
-		bezier2Points[2].y -= (int)(2.0 * sin((double)(5.0 * (x - 2))) + 0.4);
-		bezier2Points[3].y += (int)(2.0 * sin((double)(5.0 * (x - 2))) + 0.5);
+			bezier2Points[1].x += (int)(2.0 * sin((double)(5.0 * (x - 2))) + 0.3);
+			bezier2Points[2].y -= (int)(2.0 * sin((double)(5.0 * (x - 2))) + 0.4);
+			bezier2Points[3].y += (int)(2.0 * sin((double)(5.0 * (x - 2))) + 0.5);
+		}
+
+		// The points are in the pixels of the full resolution
+		float scale = e.getRenderScale();
+		auto scaled = [scale](vec2<int> point) { return vec2<int>((int)(point.x * scale), (int)(point.y * scale)); };
 
 		// Draw bezier curves
-		e.drawBezierCurve(bezier1Points[0], bezier1Points[1], bezier1Points[2], RED, 1);
-		e.drawBezierCurve(bezier2Points[0], bezier2Points[1], bezier2Points[2], bezier2Points[3], BLUE, 1);
-		e.drawBezierCurve(bezier2Points[1], bezier2Points[0], bezier2Points[3], bezier2Points[2], GREEN, 1);
+		if (showSwarm) {
+			for (int i = 0; i < swarmSize; i++) {
+				vec2<int> offset = vec2<int>(i % 100 - 50, i / 100 - 50);
+				for (int j = 0; j < 4; j++)
+					swarmPoints[i * 4 + j] = scaled(vec2<int>(bezier2Points[j].x + offset.x * (j + 1), bezier2Points[j].y + offset.y * (4 - j)));
+			}
+			e.drawBezierCurves(swarmPoints.data(), swarmSize, 3, 0x555555, 0);
+		}
+		e.drawBezierCurve(scaled(bezier1Points[0]), scaled(bezier1Points[1]), scaled(bezier1Points[2]), RED, 1);
+		e.drawBezierCurve(scaled(bezier2Points[0]), scaled(bezier2Points[1]), scaled(bezier2Points[2]), scaled(bezier2Points[3]), BLUE, 1);
+		e.drawBezierCurve(scaled(bezier2Points[1]), scaled(bezier2Points[0]), scaled(bezier2Points[3]), scaled(bezier2Points[2]), GREEN, 1);
 
 		e.mainLoopEndEvents();
 	}
 
+#ifdef GRAPHICS_PROFILE
+	// The last frames can be opened in chrome://tracing or ui.perfetto.dev
+	profiler().writeChromeTrace("bezier_trace.json");
+#endif
 	return 0;
 }
 
@@ -171,9 +171,14 @@ int GraphDemoMain(_In_ HINSTANCE curInst, _In_opt_ HINSTANCE prevInst, _In_ PSTR
 
 	std::wstring labels[7] = { L"Bbelkowe", L"Wstawianie", L"Wybr", L"sort()", L"Bbelkowe 2", L"Bbelkowe 3", L"Scalanie"};
 
+	// The screens only change with input, so the frames are only drawn when there is some
+	e.setOnDemand(true);
+
 	// Main program loop
 	while (running) {
-		e.handleMessages();
+		// The window was closed
+		if (!e.handleMessages())
+			break;
 
 		if (!e.keys[VK_ESCAPE].isHeld && back) {
 			e.clearScreen();
@@ -207,6 +212,8 @@ int GraphDemoMain(_In_ HINSTANCE curInst, _In_opt_ HINSTANCE prevInst, _In_ PSTR
 			else if (e.keys['R'].isHeld) {
 				tempScreenState = screen;
 				screen = 0;
+				// The graph is measured again in the next frame
+				e.invalidate();
 			}
 			else if (e.keys['G'].isHeld)
 				toggleGraph = true;
@@ -57,9 +57,14 @@ int MazeDemoMain(_In_ HINSTANCE curInst, _In_opt_ HINSTANCE prevInst, _In_ PSTR
 		}
 	}
 
+	// The maze doesn't change, the frames are only drawn when the window needs them
+	e.setOnDemand(true);
+
 	// Main program loop
 	while (running) {
-		e.handleMessages();
+		// The window was closed
+		if (!e.handleMessages())
+			break;
 
 		e.mainLoopEndEvents();
 	}
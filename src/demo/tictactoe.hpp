@@ -261,9 +261,14 @@ int TicTacToeDemoMain(_In_ HINSTANCE curInst, _In_opt_ HINSTANCE prevInst, _In_
 
 	bool fullscreenHeld = false;
 
+	// Nothing changes without input, so the frames are only drawn when there is some
+	e.setOnDemand(true);
+
 	// Main program loop
 	while (running) {
-		e.handleMessages();
+		// The window was closed
+		if (!e.handleMessages())
+			break;
 
 		if (e.keys[VK_ESCAPE].isHeld)
 			e.destroy();
@@ -312,6 +317,9 @@ int TicTacToeDemoMain(_In_ HINSTANCE curInst, _In_opt_ HINSTANCE prevInst, _In_
 				Move move = getPlayerMove(board, squares, playerTurn);
 				board[move.row][move.col] = 1;
 				boardValue = move.moveVal;
+				// The AI moves in the next frame
+				if (!playerTurn)
+					e.invalidate();
 			}
 			// AI
 			else {
@@ -319,6 +327,8 @@ int TicTacToeDemoMain(_In_ HINSTANCE curInst, _In_opt_ HINSTANCE prevInst, _In_
 				Move move = findBestMove(board, playerTurn);
 				board[move.row][move.col] = -1;
 				boardValue = move.moveVal;
+				// The board with its move is drawn in the next frame
+				e.invalidate();
 			}
 		}
 